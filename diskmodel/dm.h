@@ -165,6 +165,17 @@ struct dm_layout_zone {
 };
 
 
+// A run of consecutive lbns stored on consecutive sectors of a
+// single track, as produced by dm_translate_ltop_range().
+struct dm_track_run {
+  int lbn;           // first lbn of the run
+  int len;           // number of lbns (and sectors) in the run
+  struct dm_pbn pbn; // location of the first lbn
+  dm_angle_t skew;   // dm_pbn_skew() of pbn
+  int remapped;      // nonzero if the run is a remapped defect
+};
+
+
 // 'if' because its an interface, not the real struct which has
 // other data members ...
 struct dm_layout_if {
@@ -305,9 +316,36 @@ struct dm_layout_if {
 		     struct dm_pbn *track,
 		     int *result);
 
+
+  // Map the len blocks starting at lbn onto the tracks holding them
+  // in one call.  Stores up to runs_len track runs in runs, in lbn
+  // order, and returns the number stored.  This covers fewer than
+  // len blocks if runs fills up or the extent runs off the end of
+  // the disk; the caller can continue after the last run.  Returns
+  // DM_NX if lbn itself isn't mapped.
+  int
+  (*dm_translate_ltop_range)(struct dm_disk_if *,
+			     int lbn,
+			     int len,
+			     dm_layout_maptype,
+			     struct dm_track_run *runs,
+			     int runs_len);
 };
 
 
+// Generic dm_translate_ltop_range() in terms of the layout's single
+// lbn methods.  first_remap(d, lbn, len) must return the lowest
+// block in [lbn, lbn+len) that may be remapped away from its track,
+// or lbn+len if there are none; it may be conservative.
+int dm_ltop_range_generic(struct dm_disk_if *d,
+			  int lbn,
+			  int len,
+			  dm_layout_maptype mt,
+			  struct dm_track_run *runs,
+			  int runs_len,
+			  int (*first_remap)(struct dm_disk_if *, int, int));
+
+
 
 // Anatomy of a mech-model access and related terminology
 // (bucy 5/2002)
@@ -502,6 +540,13 @@ struct lp_block;
 typedef struct dm_mech_if *(*dm_mech_loader_t)(struct lp_block *, struct dm_disk_if *);
 typedef struct dm_layout_if *(*dm_layout_loader_t)(struct lp_block *, struct dm_disk_if *);
 
+// cache of loaded models (dm_cache.c).  The key covers the model's
+// parameter block and the contents of any files it references.
+// lookup returns a private copy of the model or NULL on a miss.
+uint64_t dm_cache_key(struct lp_block *);
+struct dm_disk_if *dm_cache_lookup(uint64_t key);
+void dm_cache_insert(uint64_t key, struct dm_disk_if *);
+
 
 #ifdef __cplusplus
 }
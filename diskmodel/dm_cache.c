@@ -0,0 +1,377 @@
+
+/* diskmodel (version 1.0)
+ * Authors: John Bucy, Greg Ganger
+ * Contributors: John Griffin, Jiri Schindler, Steve Schlosser
+ *
+ * Copyright (c) of Carnegie Mellon University, 2001-2008.
+ *
+ * This software is being provided by the copyright holders under the
+ * following license. By obtaining, using and/or copying this
+ * software, you agree that you have read, understood, and will comply
+ * with the following terms and conditions:
+ *
+ * Permission to reproduce, use, and prepare derivative works of this
+ * software is granted provided the copyright and "No Warranty"
+ * statements are included with all reproductions and derivative works
+ * and associated documentation. This software may also be
+ * redistributed without charge provided that the copyright and "No
+ * Warranty" statements are included in all redistributions.
+ *
+ * NO WARRANTY. THIS SOFTWARE IS FURNISHED ON AN "AS IS" BASIS.
+ * CARNEGIE MELLON UNIVERSITY MAKES NO WARRANTIES OF ANY KIND, EITHER
+ * EXPRESSED OR IMPLIED AS TO THE MATTER INCLUDING, BUT NOT LIMITED
+ * TO: WARRANTY OF FITNESS FOR PURPOSE OR MERCHANTABILITY, EXCLUSIVITY
+ * OF RESULTS OR RESULTS OBTAINED FROM USE OF THIS SOFTWARE. CARNEGIE
+ * MELLON UNIVERSITY DOES NOT MAKE ANY WARRANTY OF ANY KIND WITH
+ * RESPECT TO FREEDOM FROM PATENT, TRADEMARK, OR COPYRIGHT
+ * INFRINGEMENT.  COPYRIGHT HOLDERS WILL BEAR NO LIABILITY FOR ANY USE
+ * OF THIS SOFTWARE OR DOCUMENTATION.
+ */
+
+
+// Cache of loaded disk models.
+//
+// Loading a dm_disk block builds zone tables, reads extracted seek
+// curves, etc.  A configuration that instantiates many copies of the
+// same drive does this once per copy and a parameter sweep does it
+// again on every run.  We key each model on a hash of its parameter
+// block plus the contents of any files it names and keep the
+// marshaled image around (see marshal.c) so later loads only have to
+// unmarshal it.
+//
+// If DM_MODEL_CACHE is set in the environment, it names a directory
+// where images are also written as <key>.dmc so subsequent runs can
+// pick them up.  Only models whose layout and mechanics implement
+// marshaling (currently the g1, g2 and g4 layouts with g1 mechanics)
+// are cached; anything else is loaded from the parameters every time.
+
+#include "dm.h"
+#include "marshal.h"
+
+#include <libparam/libparam.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+
+#ifndef WIN32
+#include <unistd.h> // getpid()
+#else
+#include <process.h>
+#define getpid _getpid
+#endif
+
+
+// bump this whenever the marshaled format of any model changes
+#define DM_CACHE_VERSION 3
+#define DM_CACHE_MAGIC   0x434d4464  // "dDMC"
+
+struct dm_cache_filehdr {
+  int magic;
+  int version;
+  int ptrsize;   // images contain raw structs; don't mix ABIs
+  int len;       // of the image that follows
+  uint64_t key;
+};
+
+struct dm_cache_ent {
+  uint64_t key;
+  struct dm_marshal_hdr *img;
+  struct dm_cache_ent *next;
+};
+
+static struct dm_cache_ent *dm_cache = 0;
+static char *dm_cache_dir = 0;
+static int dm_cache_dir_inited = 0;
+
+
+// 64-bit FNV-1a
+
+#define FNV_OFFSET 0xcbf29ce484222325ULL
+#define FNV_PRIME  0x100000001b3ULL
+
+static uint64_t
+hash_bytes(uint64_t h, const void *buf, int len) {
+  const unsigned char *p = buf;
+  int c;
+
+  for(c = 0; c < len; c++) {
+    h ^= p[c];
+    h *= FNV_PRIME;
+  }
+  return h;
+}
+
+static uint64_t
+hash_string(uint64_t h, const char *s) {
+  // include the terminator so "ab","c" != "a","bc"
+  return hash_bytes(h, s, strlen(s) + 1);
+}
+
+// Strings in model blocks are frequently the names of other files,
+// e.g. "Full seek curve" or "Layout Map File".  Fold their contents
+// into the key so editing such a file invalidates the entry.  Every
+// disk instantiation computes a key, so each name is only looked up
+// and read once per run; files aren't expected to change under a
+// running simulation.
+struct dm_cache_file {
+  char *cwd;
+  char *name;
+  int found;
+  uint64_t h;   // of the contents
+  struct dm_cache_file *next;
+};
+
+static struct dm_cache_file *dm_cache_files = 0;
+
+static struct dm_cache_file *
+dm_cache_file_lookup(char *name) {
+  char buf[4096];
+  struct dm_cache_file *e;
+  char *path;
+  FILE *f;
+  int n;
+
+  for(e = dm_cache_files; e; e = e->next) {
+    if(!strcmp(e->name, name) && !strcmp(e->cwd, lp_cwd)) {
+      return e;
+    }
+  }
+
+  e = calloc(1, sizeof(*e));
+  e->cwd = strdup(lp_cwd);
+  e->name = strdup(name);
+  e->next = dm_cache_files;
+  dm_cache_files = e;
+
+  path = lp_search_path(lp_cwd, name);
+  if(!path) return e;
+
+  f = fopen(path, "r");
+  free(path);
+  if(!f) return e;
+
+  e->found = 1;
+  e->h = FNV_OFFSET;
+  while((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+    e->h = hash_bytes(e->h, buf, n);
+  }
+
+  fclose(f);
+  return e;
+}
+
+static uint64_t
+hash_file(uint64_t h, char *name) {
+  struct dm_cache_file *e = dm_cache_file_lookup(name);
+
+  if(e->found) {
+    h = hash_bytes(h, &e->h, sizeof(e->h));
+  }
+  return h;
+}
+
+static uint64_t hash_block(uint64_t h, struct lp_block *b);
+
+static uint64_t
+hash_value(uint64_t h, struct lp_value *v) {
+  int c;
+
+  h = hash_bytes(h, &v->t, sizeof(v->t));
+
+  switch(v->t) {
+  case I:
+    h = hash_bytes(h, &v->v.i, sizeof(v->v.i));
+    break;
+  case D:
+    h = hash_bytes(h, &v->v.d, sizeof(v->v.d));
+    break;
+  case S:
+    h = hash_string(h, v->v.s);
+    h = hash_file(h, v->v.s);
+    break;
+  case LIST:
+    for(c = 0; c < v->v.l->values_len; c++) {
+      if(!v->v.l->values[c]) continue;
+      h = hash_value(h, v->v.l->values[c]);
+    }
+    break;
+  case BLOCK:
+    h = hash_block(h, v->v.b);
+    break;
+  default:
+    ddbg_assert2(0, "unexpected value type in model block");
+    break;
+  }
+
+  return h;
+}
+
+static uint64_t
+hash_block(uint64_t h, struct lp_block *b) {
+  int c;
+
+  h = hash_bytes(h, &b->type, sizeof(b->type));
+
+  for(c = 0; c < b->params_len; c++) {
+    if(!b->params[c]) continue;
+    h = hash_string(h, b->params[c]->name);
+    h = hash_value(h, b->params[c]->v);
+  }
+
+  return h;
+}
+
+
+uint64_t
+dm_cache_key(struct lp_block *b) {
+  uint64_t h = FNV_OFFSET;
+  int version = DM_CACHE_VERSION;
+
+  h = hash_bytes(h, &version, sizeof(version));
+  return hash_block(h, b);
+}
+
+
+static void
+dm_cache_init_dir(void) {
+  char *dir;
+
+  if(dm_cache_dir_inited) return;
+  dm_cache_dir_inited = 1;
+
+  dir = getenv("DM_MODEL_CACHE");
+  if(dir && *dir) {
+    dm_cache_dir = strdup(dir);
+  }
+}
+
+
+static void
+dm_cache_filename(uint64_t key, char *buf, int len) {
+  snprintf(buf, len, "%s/%016llx.dmc", dm_cache_dir, (unsigned long long)key);
+}
+
+
+static struct dm_marshal_hdr *
+dm_cache_read_file(uint64_t key) {
+  char path[LP_PATH_MAX];
+  struct dm_cache_filehdr fh;
+  struct dm_marshal_hdr *img;
+  FILE *f;
+
+  dm_cache_filename(key, path, sizeof(path));
+  f = fopen(path, "rb");
+  if(!f) return 0;
+
+  if(fread(&fh, sizeof(fh), 1, f) != 1
+     || fh.magic != DM_CACHE_MAGIC
+     || fh.version != DM_CACHE_VERSION
+     || fh.ptrsize != sizeof(void *)
+     || fh.key != key
+     || fh.len < (int)sizeof(struct dm_marshal_hdr))
+  {
+    fclose(f);
+    return 0;
+  }
+
+  img = malloc(fh.len);
+  if(fread(img, fh.len, 1, f) != 1 || img->len != fh.len) {
+    free(img);
+    img = 0;
+  }
+
+  fclose(f);
+  return img;
+}
+
+
+// write to a temporary and rename so concurrent runs in a sweep
+// never see a partial image
+static void
+dm_cache_write_file(uint64_t key, struct dm_marshal_hdr *img) {
+  char path[LP_PATH_MAX];
+  char tmppath[LP_PATH_MAX + 16];
+  struct dm_cache_filehdr fh;
+  FILE *f;
+  int ok;
+
+  dm_cache_filename(key, path, sizeof(path));
+  snprintf(tmppath, sizeof(tmppath), "%s.%d", path, (int)getpid());
+
+  f = fopen(tmppath, "wb");
+  if(!f) {
+    fprintf(stderr, "*** warning: can't write model cache %s: %s\n",
+	    tmppath, strerror(errno));
+    return;
+  }
+
+  memset(&fh, 0, sizeof(fh));
+  fh.magic = DM_CACHE_MAGIC;
+  fh.version = DM_CACHE_VERSION;
+  fh.ptrsize = sizeof(void *);
+  fh.len = img->len;
+  fh.key = key;
+
+  ok = (fwrite(&fh, sizeof(fh), 1, f) == 1)
+    && (fwrite(img, img->len, 1, f) == 1);
+  ok = (fclose(f) == 0) && ok;
+
+  if(!ok || rename(tmppath, path)) {
+    remove(tmppath);
+  }
+}
+
+
+// Returns a new copy of the model with the given key or NULL
+// if we haven't seen it.
+struct dm_disk_if *
+dm_cache_lookup(uint64_t key) {
+  struct dm_cache_ent *e;
+
+  for(e = dm_cache; e; e = e->next) {
+    if(e->key == key) {
+      return dm_unmarshal(e->img, e->img->len);
+    }
+  }
+
+  dm_cache_init_dir();
+  if(dm_cache_dir) {
+    struct dm_marshal_hdr *img = dm_cache_read_file(key);
+    if(img) {
+      e = malloc(sizeof(*e));
+      e->key = key;
+      e->img = img;
+      e->next = dm_cache;
+      dm_cache = e;
+      return dm_unmarshal(img, img->len);
+    }
+  }
+
+  return 0;
+}
+
+
+// Remember the freshly-loaded model d under key.
+void
+dm_cache_insert(uint64_t key, struct dm_disk_if *d) {
+  struct dm_cache_ent *e;
+
+  // marshal is only implemented for some layouts
+  if(!d->layout || !d->mech
+     || !d->layout->dm_marshal || !d->mech->dm_marshal)
+  {
+    return;
+  }
+
+  e = malloc(sizeof(*e));
+  e->key = key;
+  e->img = dm_marshal(d);
+  e->next = dm_cache;
+  dm_cache = e;
+
+  dm_cache_init_dir();
+  if(dm_cache_dir) {
+    dm_cache_write_file(key, e->img);
+  }
+}
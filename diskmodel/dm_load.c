@@ -45,12 +45,20 @@
 struct dm_disk_if *
 dm_disk_loadparams(struct lp_block *b, int *junk)
 {
-  struct dm_disk_if *result = calloc(1, sizeof(*result));
+  struct dm_disk_if *result;
+  uint64_t key = dm_cache_key(b);
 
+  result = dm_cache_lookup(key);
+  if(result) {
+    return result;
+  }
+
+  result = calloc(1, sizeof(*result));
 
   //#include "modules/dm_disk_param.c"
   lp_loadparams(result, b, &dm_disk_mod);
 
+  dm_cache_insert(key, result);
   return result;
 }
 
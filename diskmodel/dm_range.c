@@ -0,0 +1,149 @@
+
+/* diskmodel (version 1.0)
+ * Authors: John Bucy, Greg Ganger
+ * Contributors: John Griffin, Jiri Schindler, Steve Schlosser
+ *
+ * Copyright (c) of Carnegie Mellon University, 2001-2008.
+ *
+ * This software is being provided by the copyright holders under the
+ * following license. By obtaining, using and/or copying this
+ * software, you agree that you have read, understood, and will comply
+ * with the following terms and conditions:
+ *
+ * Permission to reproduce, use, and prepare derivative works of this
+ * software is granted provided the copyright and "No Warranty"
+ * statements are included with all reproductions and derivative works
+ * and associated documentation. This software may also be
+ * redistributed without charge provided that the copyright and "No
+ * Warranty" statements are included in all redistributions.
+ *
+ * NO WARRANTY. THIS SOFTWARE IS FURNISHED ON AN "AS IS" BASIS.
+ * CARNEGIE MELLON UNIVERSITY MAKES NO WARRANTIES OF ANY KIND, EITHER
+ * EXPRESSED OR IMPLIED AS TO THE MATTER INCLUDING, BUT NOT LIMITED
+ * TO: WARRANTY OF FITNESS FOR PURPOSE OR MERCHANTABILITY, EXCLUSIVITY
+ * OF RESULTS OR RESULTS OBTAINED FROM USE OF THIS SOFTWARE. CARNEGIE
+ * MELLON UNIVERSITY DOES NOT MAKE ANY WARRANTY OF ANY KIND WITH
+ * RESPECT TO FREEDOM FROM PATENT, TRADEMARK, OR COPYRIGHT
+ * INFRINGEMENT.  COPYRIGHT HOLDERS WILL BEAR NO LIABILITY FOR ANY USE
+ * OF THIS SOFTWARE OR DOCUMENTATION.
+ */
+
+
+
+// Translation of lbn extents into track runs.
+//
+// Request setup, media transfer and prefetch all walk an extent one
+// sector at a time, retranslating each lbn even though all but a few
+// of them sit right after their predecessor on the same track.
+// dm_ltop_range_generic() translates a track's worth at a time
+// instead: it maps the first lbn of a run, bounds the run by the end
+// of the track, the end of the extent and the first possibly
+// remapped block, and then checks the far end of the run with one
+// more ltop.  Layouts place the lbns of a track in increasing sector
+// order, so if the last lbn lands exactly len-1 sectors after the
+// first on the same track, so does everything in between.  Slips
+// break that and are found by a binary search for the end of the
+// run.  Remapped blocks are always returned as runs of one.
+
+#include "dm.h"
+
+static inline int
+min(int x, int y) {
+  return x < y ? x : y;
+}
+
+
+// Is lbn + k - 1 at sector r->pbn.sector + k - 1 of r's track?
+static int
+dm_range_contig(struct dm_disk_if *d,
+		struct dm_track_run *r,
+		int k,
+		dm_layout_maptype mt)
+{
+  struct dm_pbn p;
+  int remap = 0;
+  dm_ptol_result_t rv;
+
+  rv = d->layout->dm_translate_ltop(d, r->lbn + k - 1, mt, &p, &remap);
+
+  return rv == DM_OK 
+    && !remap
+    && p.cyl == r->pbn.cyl
+    && p.head == r->pbn.head
+    && p.sector == r->pbn.sector + k - 1;
+}
+
+
+int
+dm_ltop_range_generic(struct dm_disk_if *d,
+		      int lbn,
+		      int len,
+		      dm_layout_maptype mt,
+		      struct dm_track_run *runs,
+		      int runs_len,
+		      int (*first_remap)(struct dm_disk_if *, int, int))
+{
+  int n = 0;
+  int end;
+
+  if(lbn < 0 || d->dm_sectors <= lbn || len <= 0) {
+    return DM_NX;
+  }
+
+  end = lbn + min(len, d->dm_sectors - lbn);
+
+  while(lbn < end && n < runs_len) {
+    struct dm_track_run *r = &runs[n];
+    int remap = 0;
+    int max, good, bad;
+    dm_ptol_result_t rv;
+
+    rv = d->layout->dm_translate_ltop(d, lbn, mt, &r->pbn, &remap);
+    if(rv != DM_OK) {
+      break;
+    }
+
+    r->lbn = lbn;
+    r->len = 1;
+    r->remapped = remap;
+
+    if(!remap) {
+      max = d->layout->dm_get_sectors_pbn(d, &r->pbn) - r->pbn.sector;
+      max = min(max, end - lbn);
+      if(max > 1) {
+	max = min(max, first_remap(d, lbn + 1, max - 1) - lbn);
+      }
+
+      // good is known to be contiguous, bad known not to be
+      good = 1;
+      bad = max + 1;
+      if(max > 1) {
+	if(dm_range_contig(d, r, max, mt)) {
+	  good = max;
+	}
+	else {
+	  bad = max;
+	}
+      }
+
+      while(bad - good > 1) {
+	int mid = good + (bad - good) / 2;
+	if(dm_range_contig(d, r, mid, mt)) {
+	  good = mid;
+	}
+	else {
+	  bad = mid;
+	}
+      }
+
+      r->len = good;
+    }
+
+    r->skew = d->layout->dm_pbn_skew ? d->layout->dm_pbn_skew(d, &r->pbn) : 0;
+
+    lbn += r->len;
+    n++;
+  }
+
+  return n > 0 ? n : DM_NX;
+}
@@ -1890,6 +1890,7 @@ layout_g1_unmarshal(struct dm_marshal_hdr *hdr,
     ptr += sizeof(struct dm_layout_g1_band);
 
     // slips
+    b->slip = 0;
     if(b->numslips != 0) {
       b->slip = malloc(b->numslips * sizeof(int));
       memcpy(b->slip, ptr, b->numslips * sizeof(int));
@@ -1897,6 +1898,8 @@ layout_g1_unmarshal(struct dm_marshal_hdr *hdr,
     }
 
     // defect locations
+    b->defect = 0;
+    b->remap = 0;
     if(b->numdefects != 0) {
       b->defect = malloc(b->numdefects * sizeof(int));
       memcpy(b->defect, ptr, b->numdefects * sizeof(int));
@@ -1958,6 +1961,98 @@ g1_get_zone(struct dm_disk_if *d,
 }
 
 
+// The lbn remapped by the ith defect of band b, found by translating
+// its spare location back with ptol and confirmed with ltop.  Returns
+// -1 if that doesn't pin it down.
+static int
+g1_remapped_lbn(struct dm_disk_if *d, 
+		struct dm_layout_g1_band *b, 
+		int i)
+{
+  struct dm_layout_g1 *l = (struct dm_layout_g1 *)d->layout;
+  struct dm_pbn p, q;
+  int remap = 0;
+  int track = b->remap[i] / b->blkspertrack;
+  int lbn;
+
+  p.cyl = b->startcyl + track / d->dm_surfaces;
+  p.head = track % d->dm_surfaces;
+  p.head = g1_surfno_on_cyl(l, b, &p);
+  p.sector = b->remap[i] % b->blkspertrack;
+
+  lbn = d->layout->dm_translate_ptol(d, &p, &remap);
+  if(lbn < 0 || !remap) {
+    return -1;
+  }
+
+  remap = 0;
+  if(d->layout->dm_translate_ltop(d, lbn, MAP_FULL, &q, &remap) != DM_OK
+     || !remap
+     || q.cyl != p.cyl || q.head != p.head || q.sector != p.sector)
+  {
+    return -1;
+  }
+
+  return lbn;
+}
+
+// Remapped sectors are listed per band by their home and spare
+// locations.  Track sparing moves whole tracks, which keeps every
+// track's lbns in one run, so only the sector schemes have remapped
+// blocks to look for.  A band with a remap that can't be resolved is
+// translated a sector at a time.
+static int
+g1_first_remap(struct dm_disk_if *d, int lbn, int len)
+{
+  struct dm_layout_g1 *l = (struct dm_layout_g1 *)d->layout;
+  int first = lbn + len;
+  int i;
+
+  if((l->sparescheme == NO_SPARING) || (l->sparescheme == TRACK_SPARING)) {
+    return first;
+  }
+
+  while(lbn < first) {
+    struct dm_layout_g1_band *b = find_band_lbn(l, lbn);
+
+    for(i = 0; i < b->numdefects; i++) {
+      int x;
+
+      // these sectors stay put, except with one spare per track
+      if((b->remap[i] == b->defect[i]) 
+	 && (l->sparescheme != SECTPERTRACK_SPARING)) 
+      {
+	continue;
+      }
+
+      x = g1_remapped_lbn(d, b, i);
+      if(x < 0) {
+	return lbn;
+      }
+      if((x >= lbn) && (x < first)) {
+	first = x;
+      }
+    }
+
+    lbn = l->band_blknos[b->num] + b->blksinband;
+  }
+
+  return first;
+}
+
+static int
+g1_ltop_range(struct dm_disk_if *d,
+	      int lbn,
+	      int len,
+	      dm_layout_maptype mt,
+	      struct dm_track_run *runs,
+	      int runs_len)
+{
+  return dm_ltop_range_generic(d, lbn, len, mt, runs, runs_len, 
+			       g1_first_remap);
+}
+
+
 // any function that appears in the interface must be listed here
 void *layout_g1_fns[] = {
   g1_ltop_nosparing,
@@ -1998,7 +2093,8 @@ void *layout_g1_fns[] = {
   layout_g1_marshal,
   g1_lbn_offset,
   g1_get_numzones,
-  g1_get_zone
+  g1_get_zone,
+  g1_ltop_range
 };
 
 struct dm_marshal_module dm_layout_g1_marshal_mod =
@@ -2029,7 +2125,9 @@ struct dm_layout_if g1_layout_nosparing = {
   layout_g1_marshaled_len,
   layout_g1_marshal,
   g1_get_numzones,
-  g1_get_zone
+  g1_get_zone,
+  0, // defect count
+  g1_ltop_range
 };
 
 struct dm_layout_if g1_layout_tracksparing = {
@@ -2050,7 +2148,9 @@ struct dm_layout_if g1_layout_tracksparing = {
   layout_g1_marshaled_len,
   layout_g1_marshal,
   g1_get_numzones,
-  g1_get_zone
+  g1_get_zone,
+  0, // defect count
+  g1_ltop_range
 };
 
 struct dm_layout_if g1_layout_sectpertrackspare = {
@@ -2071,7 +2171,9 @@ struct dm_layout_if g1_layout_sectpertrackspare = {
   layout_g1_marshaled_len,
   layout_g1_marshal,
   g1_get_numzones,
-  g1_get_zone
+  g1_get_zone,
+  0, // defect count
+  g1_ltop_range
 };
 
 struct dm_layout_if g1_layout_sectpercylspare = {
@@ -2092,7 +2194,9 @@ struct dm_layout_if g1_layout_sectpercylspare = {
   layout_g1_marshaled_len,
   layout_g1_marshal,
   g1_get_numzones,
-  g1_get_zone
+  g1_get_zone,
+  0, // defect count
+  g1_ltop_range
 };
 
 struct dm_layout_if g1_layout_sectperrangespare = {
@@ -2113,7 +2217,9 @@ struct dm_layout_if g1_layout_sectperrangespare = {
   layout_g1_marshaled_len,
   layout_g1_marshal,
   g1_get_numzones,
-  g1_get_zone
+  g1_get_zone,
+  0, // defect count
+  g1_ltop_range
 };
 
 struct dm_layout_if g1_layout_sectperzonespare = {
@@ -2134,7 +2240,9 @@ struct dm_layout_if g1_layout_sectperzonespare = {
   layout_g1_marshaled_len,
   layout_g1_marshal,
   g1_get_numzones,
-  g1_get_zone
+  g1_get_zone,
+  0, // defect count
+  g1_ltop_range
 };
 
 
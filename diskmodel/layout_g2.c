@@ -28,8 +28,10 @@
  */
 
 #include "layout_g2.h"
+#include "marshal.h"
 
 #include <stdlib.h>
+#include <string.h>
 
 
 #define min(x,y) (x) < (y) ? (x) : (y)
@@ -412,6 +414,61 @@ atop(struct dm_disk_if *d,
 }
 
 
+// The ltop map is already a sorted list of extents, so runs are just
+// the pieces of the extents covering [lbn, lbn+len).
+static int
+ltop_range(struct dm_disk_if *d,
+	   int lbn,
+	   int len,
+	   dm_layout_maptype mt,
+	   struct dm_track_run *runs,
+	   int runs_len)
+{
+  struct dm_layout_g2_node keynode, *rn, *rend;
+  struct dm_layout_g2 *l = (struct dm_layout_g2 *)d->layout;
+  int n = 0;
+  int end;
+
+  if(lbn < 0 || d->dm_sectors <= lbn || len <= 0) {
+    return DM_NX;
+  }
+
+  memset(&keynode, 0, sizeof(keynode));
+  keynode.lbn = lbn;
+  keynode.len = 1;
+
+  rn = bsearch(&keynode, 
+	       l->ltop_map, 
+	       l->ltop_map_len, 
+	       sizeof(struct dm_layout_g2_node),
+	       g2_nodecmp);
+
+  if(!rn) {
+    return DM_NX;
+  }
+
+  rend = l->ltop_map + l->ltop_map_len;
+  end = (len < d->dm_sectors - lbn) ? lbn + len : d->dm_sectors;
+
+  // stop at a hole in the lbn space
+  for( ; lbn < end && n < runs_len && rn < rend && rn->lbn <= lbn; rn++) {
+    struct dm_track_run *r = &runs[n++];
+    int extend = rn->lbn + rn->len;
+
+    r->lbn = lbn;
+    r->len = (extend < end ? extend : end) - lbn;
+    r->pbn = rn->loc;
+    r->pbn.sector += (lbn - rn->lbn);
+    r->skew = pbn_skew_new(d, &r->pbn);
+    r->remapped = 0;
+
+    lbn += r->len;
+  }
+
+  return n;
+}
+
+
 static dm_ptol_result_t
 g2_seek_distance(struct dm_disk_if *d,
 		 int start_lbn,
@@ -470,6 +527,172 @@ g2_get_zone(struct dm_disk_if *d, int n, struct dm_layout_zone *result)
 }
 
 
+static int
+layout_g2_marshaled_len(struct dm_disk_if *d) {
+  int i, j;
+  struct dm_layout_g2 *l = (struct dm_layout_g2 *)d->layout;
+  int result = sizeof(struct dm_marshal_hdr) + sizeof(struct dm_layout_g2);
+
+  result += l->ltop_map_len * sizeof(struct dm_layout_g2_node);
+  result += l->zones_len * sizeof(struct dm_layout_g2_zone);
+  result += l->defects_len * sizeof(struct dm_pbn);
+
+  result += l->ptol_map_len * sizeof(struct dm_layout_g2_cyl);
+  for(i = 0; i < l->ptol_map_len; i++) {
+    struct dm_layout_g2_cyl *c = &l->ptol_map[i];
+    result += c->surfaces_len * sizeof(struct dm_layout_g2_surf);
+    for(j = 0; j < c->surfaces_len; j++) {
+      result += c->surfaces[j].extents_len * sizeof(struct dm_layout_g2_node);
+    }
+  }
+
+  return result;
+}
+
+static void *
+layout_g2_marshal(struct dm_disk_if *d, char *buff) {
+  int i, j, n;
+  struct dm_layout_g2 *l = (struct dm_layout_g2 *)d->layout;
+  char *ptr = buff;
+  struct dm_marshal_hdr *hdr = (struct dm_marshal_hdr *)buff;
+  hdr->type = DM_LAYOUT_G2_TYP;
+  hdr->len = layout_g2_marshaled_len(d);
+
+  ptr += sizeof(struct dm_marshal_hdr);
+  memcpy(ptr, l, sizeof(struct dm_layout_g2));
+  marshal_fns((void **)&l->hdr,
+	      sizeof(l->hdr) / sizeof(void *),
+	      ptr,
+	      DM_LAYOUT_G2_TYP);
+  ptr += sizeof(struct dm_layout_g2);
+
+  n = l->ltop_map_len * sizeof(struct dm_layout_g2_node);
+  memcpy(ptr, l->ltop_map, n);
+  ptr += n;
+
+  n = l->zones_len * sizeof(struct dm_layout_g2_zone);
+  memcpy(ptr, l->zones, n);
+  ptr += n;
+
+  n = l->defects_len * sizeof(struct dm_pbn);
+  memcpy(ptr, l->defects, n);
+  ptr += n;
+
+  // the cylinders, then each cylinder's surfaces and their extents
+  n = l->ptol_map_len * sizeof(struct dm_layout_g2_cyl);
+  memcpy(ptr, l->ptol_map, n);
+  ptr += n;
+
+  for(i = 0; i < l->ptol_map_len; i++) {
+    struct dm_layout_g2_cyl *c = &l->ptol_map[i];
+
+    n = c->surfaces_len * sizeof(struct dm_layout_g2_surf);
+    memcpy(ptr, c->surfaces, n);
+    ptr += n;
+
+    for(j = 0; j < c->surfaces_len; j++) {
+      n = c->surfaces[j].extents_len * sizeof(struct dm_layout_g2_node);
+      memcpy(ptr, c->surfaces[j].extents, n);
+      ptr += n;
+    }
+  }
+
+  return ptr;
+}
+
+static char *
+layout_g2_unmarshal(struct dm_marshal_hdr *hdr, 
+		    void **result,
+		    void *parent)
+{
+  int i, j, n;
+  struct dm_layout_g2 *l = malloc(sizeof(struct dm_layout_g2));
+  char *ptr = (char *)hdr;
+
+  ddbg_assert(hdr->type == DM_LAYOUT_G2_TYP);
+
+  ptr += sizeof(struct dm_marshal_hdr);
+  memcpy(l, ptr, sizeof(struct dm_layout_g2));
+  unmarshal_fns((void **)&l->hdr,
+		sizeof(l->hdr) / sizeof(void *),
+		ptr,
+		DM_LAYOUT_G2_TYP);
+  ptr += sizeof(struct dm_layout_g2);
+
+  l->mapfile = 0;
+
+  // the loader leaves a zeroed extent past the end of the ltop map
+  n = l->ltop_map_len * sizeof(struct dm_layout_g2_node);
+  l->ltop_map = calloc(l->ltop_map_len + 1, sizeof(struct dm_layout_g2_node));
+  memcpy(l->ltop_map, ptr, n);
+  ptr += n;
+
+  n = l->zones_len * sizeof(struct dm_layout_g2_zone);
+  l->zones = malloc(n);
+  memcpy(l->zones, ptr, n);
+  ptr += n;
+
+  n = l->defects_len * sizeof(struct dm_pbn);
+  l->defects = malloc(n);
+  memcpy(l->defects, ptr, n);
+  ptr += n;
+
+  n = l->ptol_map_len * sizeof(struct dm_layout_g2_cyl);
+  l->ptol_map = malloc(n);
+  memcpy(l->ptol_map, ptr, n);
+  ptr += n;
+
+  for(i = 0; i < l->ptol_map_len; i++) {
+    struct dm_layout_g2_cyl *c = &l->ptol_map[i];
+
+    n = c->surfaces_len * sizeof(struct dm_layout_g2_surf);
+    c->surfaces = malloc(n);
+    memcpy(c->surfaces, ptr, n);
+    ptr += n;
+
+    for(j = 0; j < c->surfaces_len; j++) {
+      n = c->surfaces[j].extents_len * sizeof(struct dm_layout_g2_node);
+      c->surfaces[j].extents = malloc(n);
+      memcpy(c->surfaces[j].extents, ptr, n);
+      ptr += n;
+    }
+  }
+
+  *result = l;
+  return ptr;
+}
+
+
+// any function that appears in the interface must be listed here
+void *layout_g2_fns[] = {
+  ltop,
+  ltop_0t,
+  ptol,
+  ptol_0t,
+  st_lbn,
+  st_pbn,
+  track_boundaries,
+  g2_seek_distance,
+  pbn_skew_new,
+  ptoa,
+  atop,
+  sector_width,
+  layout_g2_marshaled_len,
+  layout_g2_marshal,
+  g2_get_numzones,
+  g2_get_zone,
+  g2_defect_count,
+  ltop_range
+};
+
+struct dm_marshal_module dm_layout_g2_marshal_mod =
+{ 
+  layout_g2_unmarshal, 
+  layout_g2_fns, 
+  sizeof(layout_g2_fns) / sizeof(void *) 
+};
+
+
 struct dm_layout_if layout_g2 = {
   ltop,
   ltop_0t,
@@ -485,9 +708,10 @@ struct dm_layout_if layout_g2 = {
   atop, // atop
   sector_width,
   0, // lbn offset
-  0, // marshall -- probably not implemented for g2
-  0, // unmarshall
+  layout_g2_marshaled_len,
+  layout_g2_marshal,
   g2_get_numzones,
   g2_get_zone,
-  g2_defect_count
+  g2_defect_count,
+  ltop_range
 };
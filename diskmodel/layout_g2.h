@@ -38,6 +38,7 @@ struct dm_layout_g2 {
   struct dm_layout_g2_node *ltop_map;
   struct dm_layout_g2_cyl *ptol_map;
   int ltop_map_len;
+  int ptol_map_len;
 
   struct dm_layout_g2_zone *zones;
   int zones_len;
@@ -129,9 +129,11 @@ static int layout_g2_loadmap(struct dm_layout_g2 *l)
   curr = &l->ltop_map[0];
 
   l->ptol_map = calloc(cyls, sizeof(struct dm_layout_g2_cyl));
+  l->ptol_map_len = cyls;
 
   for(i = 0; i < cyls; i++) {
     l->ptol_map[i].surfaces = calloc(heads, sizeof(struct dm_layout_g2_surf));
+    l->ptol_map[i].surfaces_len = heads;
   }
 
   track_ext_counts = calloc(cyls, sizeof(int *));
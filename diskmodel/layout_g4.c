@@ -31,6 +31,10 @@
 
 #include "layout_g4.h"
 #include "layout_g4_private.h"
+#include "marshal.h"
+
+#include <stdlib.h>
+#include <string.h>
 
 #ifdef _WIN32
 #define inline __inline
@@ -137,42 +141,125 @@ slipcount_rev(struct dm_layout_g4 *l,
 }
 
 
-struct remap *
-remap_lbn(struct dm_layout_g4 *l,
-	  int lbn)
+// Returns the position in the source array of the first interval
+// containing x in the (c,h) group, or -1.
+static int
+g4_ival_find(struct g4_ival *v, int n, int c, int h, int x)
 {
-  int i;
-  struct remap *r, *result = 0;
+  int lo = 0, hi = n;
+  int j, best = -1;
+
+  // find the first entry past (c,h,x)
+  while(lo < hi) {
+    int mid = lo + ((hi - lo) / 2);
+    struct g4_ival *m = &v[mid];
+    if(m->c < c 
+       || (m->c == c && (m->h < h || (m->h == h && m->low <= x)))) 
+    {
+      lo = mid + 1;
+    }
+    else {
+      hi = mid;
+    }
+  }
 
-  for(i = 0, r = &l->remaps[i]; i < l->remaps_len; i++, r++) {
-    if(r->off <= lbn && lbn < (r->off + r->count)) {
-      result = r;
+  for(j = lo - 1; j >= 0; j--) {
+    struct g4_ival *e = &v[j];
+    if(e->c != c || e->h != h || e->maxhigh <= x) {
       break;
     }
+    if(x < e->high && (best < 0 || e->i < best)) {
+      best = e->i;
+    }
   }
 
-  return result;
+  return best;
+}
+
+
+struct remap *
+remap_lbn(struct dm_layout_g4 *l,
+	  int lbn)
+{
+  int i = g4_ival_find(l->remap_lbnidx, l->remap_lbnidx_len, 0, 0, lbn);
+  return i < 0 ? 0 : &l->remaps[i];
 }
 
 // is p the destination of a remap?
 struct remap *
 remap_pbn(struct dm_layout_g4 *l,
 	  struct dm_pbn *p)
+{
+  int i = g4_ival_find(l->remap_pbnidx, l->remap_pbnidx_len, 
+		       p->cyl, p->head, p->sector);
+  return i < 0 ? 0 : &l->remaps[i];
+}
+
+
+// Returns the lowest point of [low, high) covered by any interval in
+// the (c,h) group, or high if there are none.
+static int
+g4_ival_first(struct g4_ival *v, int n, int c, int h, int low, int high)
+{
+  int lo = 0, hi = n;
+
+  // find the first entry at or past (c,h,low)
+  while(lo < hi) {
+    int mid = lo + ((hi - lo) / 2);
+    struct g4_ival *m = &v[mid];
+    if(m->c < c 
+       || (m->c == c && (m->h < h || (m->h == h && m->low < low)))) 
+    {
+      lo = mid + 1;
+    }
+    else {
+      hi = mid;
+    }
+  }
+
+  // something starting before low reaches it
+  if(lo > 0 
+     && v[lo-1].c == c && v[lo-1].h == h 
+     && v[lo-1].maxhigh > low) 
+  {
+    return low;
+  }
+
+  if(lo < n && v[lo].c == c && v[lo].h == h && v[lo].low < high) {
+    return v[lo].low;
+  }
+
+  return high;
+}
+
+
+// The entry of n containing lbn or the cylinder (and head) of p.
+static int
+g4_idx_find(struct idx *n, int *lbn, struct dm_pbn *p)
 {
   int i;
-  struct remap *r, *result = 0;
-  for(i = 0, r = &l->remaps[i]; i < l->remaps_len; i++, r++) {
-    if(r->dest.cyl == p->cyl 
-       && r->dest.head == p->head
-       && r->dest.sector <= p->sector 
-       && p->sector < (r->dest.sector + r->count))
+  struct idx_ent *e;
+
+  if(lbn) {
+    return g4_ival_find(n->lbnidx, n->lbnidx_len, 0, 0, *lbn);
+  }
+  else if(n->cylidx) {
+    int h = n->ents_len > 0 && n->ents[0].childtype == TRACK ? p->head : 0;
+    return g4_ival_find(n->cylidx, n->cylidx_len, 0, h, p->cyl);
+  }
+
+  // mixed children; see g4_build_index()
+  for(i = 0, e = &n->ents[0]; i < n->ents_len; i++, e++) {
+    int low = e->cylrunlen > 0 ? e->cyl : e->cyl + e->cylrunlen + 1;
+    int high = e->cylrunlen < 0 ? e->cyl : e->cyl + e->cylrunlen - 1;
+    if(low <= p->cyl && p->cyl <= high
+       && (e->childtype != TRACK || p->head == e->head))
     {
-      result = r;
-      break;
+      return i;
     }
   }
 
-  return result;
+  return -1;
 }
 
 
@@ -180,7 +267,7 @@ remap_pbn(struct dm_layout_g4 *l,
 // of "recurse" routines that take exactly one of a
 // lbn or pbn and build the path to the tp containing it.
 
-void
+static void
 g4_path_append(struct g4_path *p, 
 	       union g4_node n, 
 	       g4_node_t t, 
@@ -188,8 +275,9 @@ g4_path_append(struct g4_path *p,
 	       int quot,
 	       int resid) 
 {
-//ddbg_assert(p->length < G4_ALLOC_PATH);
   struct g4_path_node *pp = &p->path[p->length];
+
+  ddbg_assert(p->length < G4_ALLOC_PATH);
   
   pp->n = n;
   pp->type = t;
@@ -202,11 +290,13 @@ g4_path_append(struct g4_path *p,
 }
 
 
+// Walk down from n to the track containing exactly one of lbn or p,
+// appending each step to acc.
 // For ptol, have to keep track of the size of the enclosing thing so
 // we don't map past the end of it.
-struct g4_path *
+static struct g4_path *
 g4_r(struct dm_layout_g4 *l, 
-     union g4_node *n,
+     union g4_node n,
      g4_node_t t,
      int *lbn,
      int max,
@@ -214,127 +304,103 @@ g4_r(struct dm_layout_g4 *l,
      struct g4_path *acc) // accumlator
 {
   int i;
-  union g4_node *nn; // where we're going to recurse
-  g4_node_t tt;
-
-  int quot = 0;
-  int resid = 1;
+  int quot;
+  int resid;
 
   ddbg_assert(lbn || p);
 
-  switch(t) {
-  case TRACK:
-    if(lbn) {
-      if(n->t->low <= *lbn && *lbn <= n->t->high) {
+  for(;;) {
+    quot = 0;
+    resid = 1;
 
-	// ?
-	resid = *lbn - n->t->low;
-
-	nn = 0;
-	goto out;
-      }
-      else {
-	goto out_err;
-      }
-    }
-    else {
-      if(n->t->low <= p->sector && p->sector <= n->t->high) {
-	if(p->sector > max) {
-	  goto out_err;
+    switch(t) {
+    case TRACK:
+      if(lbn) {
+	if(n.t->low <= *lbn && *lbn <= n.t->high) {
+	  // ?
+	  resid = *lbn - n.t->low;
+	}
+	else {
+	  return 0;
 	}
-
-	// quot/resid?
-	resid = p->sector - n->t->low;
-	 
-	nn = 0;
-	goto out;
       }
       else {
-	goto out_err;
+	if(n.t->low <= p->sector && p->sector <= n.t->high) {
+	  if(p->sector > max) {
+	    return 0;
+	  }
+
+	  // quot/resid?
+	  resid = p->sector - n.t->low;
+	}
+	else {
+	  return 0;
+	}
       }
-    }
-    break;
 
-  case IDX:
-  {
-    struct idx_ent *e;
-    for(i = 0, e = &n->i->ents[0]; i < n->i->ents_len; i++, e++) 
+      g4_path_append(acc, n, t, 0, quot, resid);
+      return acc;
+
+    case IDX:
     {
-      if(lbn) {
-	if(e->lbn <= *lbn && *lbn < (e->lbn + e->runlen)) {
-	  *lbn -= e->lbn;
+      struct idx_ent *e;
 
-	  quot = *lbn / e->len;
-	  // XXX
-	  quot = e->cylrunlen < 0 ? -quot : quot;
-	  resid = *lbn % e->len;
+      i = g4_idx_find(n.i, lbn, p);
+      if(i < 0) {
+	return 0;
+      }
+      e = &n.i->ents[i];
 
-	  nn = &e->child;
-	  tt = e->childtype;
+      if(lbn) {
+	*lbn -= e->lbn;
+
+	quot = *lbn / e->len;
+	// XXX
+	quot = e->cylrunlen < 0 ? -quot : quot;
+	resid = *lbn % e->len;
 
-	  *lbn = resid;
-	  goto out;
-	}	
+	*lbn = resid;
       }
       else {
-	int low = e->cylrunlen > 0 ? e->cyl : e->cyl + e->cylrunlen + 1;
-	int high = e->cylrunlen < 0 ? e->cyl : e->cyl + e->cylrunlen - 1;
-	if(low <= p->cyl && p->cyl <= high
-	   && (e->childtype != TRACK || p->head == e->head))
-
-	{ 
-	  p->cyl -= e->cyl;
+	p->cyl -= e->cyl;
 
-	  quot = p->cyl / e->cyllen;
-	  resid = p->cyl % e->cyllen;
+	max = min(max, e->lbn + e->runlen - 1);
+	max -= e->lbn;
 
-	  max = min(max, e->lbn + e->runlen - 1);
-	  max -= e->lbn;
+	// cut down again for RLE
+	quot = p->cyl / e->cyllen;
+	// XXX
+	quot = e->cylrunlen < 0 ? -quot : quot;
+	max = min(max, (quot+1) * e->len - 1);
+	max -= quot * e->len;
 
-	  // cut down again for RLE
-	  quot = p->cyl / e->cyllen;
-	  // XXX
-	  quot = e->cylrunlen < 0 ? -quot : quot;
-	  max = min(max, (quot+1) * e->len - 1);
-	  max -= quot * e->len;
-
-	  resid = p->cyl % e->cyllen;
+	resid = p->cyl % e->cyllen;
 	  
-	  p->cyl = resid;
-	 
-	  nn = &e->child;
-	  tt = e->childtype;
-	  goto out;
-	}
+	p->cyl = resid;
       }
-    }
-    goto out_err;
-  } break;
-  default:
-    ddbg_assert(0);
-    break;
-  }
 
- out:
-  g4_path_append(acc, *n, t, i, quot, resid);
-  if(nn) {
-    return g4_r(l, nn, tt, lbn, max, p, acc);
-  }
-  else {
-    return acc;
-  }
+      g4_path_append(acc, n, t, i, quot, resid);
+      n = e->child;
+      t = e->childtype;
+    } break;
 
- out_err:
-  free(acc);
-  return 0;
+    default:
+      ddbg_assert(0);
+      return 0;
+    }
+  }
 }
 
-struct g4_path *
-g4_recurse(struct dm_layout_g4 *l, int *lbn, struct dm_pbn *p) 
+// Fills in acc with the path from the root to the track containing
+// lbn or p.  Returns acc or 0 if it isn't mapped.
+static struct g4_path *
+g4_recurse(struct dm_layout_g4 *l, 
+	   int *lbn, 
+	   struct dm_pbn *p, 
+	   struct g4_path *acc) 
 {
   int lbncopy;
   struct dm_pbn pbncopy;
-  struct g4_path *acc = calloc(1, sizeof(*acc));
   union g4_node n;
   int max;
 
@@ -348,6 +414,7 @@ g4_recurse(struct dm_layout_g4 *l, int *lbn, struct dm_pbn *p)
     p = &pbncopy;
   }
   
+  acc->length = 0;
   n.i = l->root;
   g4_path_append(acc, n, IDX, 
 		 0,  // i
@@ -356,7 +423,7 @@ g4_recurse(struct dm_layout_g4 *l, int *lbn, struct dm_pbn *p)
 
   max = l->parent->dm_sectors-1;
   max += slipcount_rev(l, max, 0);
-  return g4_r(l, &n, IDX, lbn, max, p, acc);
+  return g4_r(l, n, IDX, lbn, max, p, acc);
 }
 
 
@@ -383,13 +450,14 @@ ltop(struct dm_disk_if *d,
   }
   else {
     int i;
+    struct g4_path pathbuf;
     struct g4_path *p;
     struct g4_path_node *n;
 
     // fiddle lbn according to slips/spares
     lbn += slipcount(l, lbn);
     
-    p = g4_recurse(l, &lbn, 0);
+    p = g4_recurse(l, &lbn, 0, &pathbuf);
     if(!p) {
       return DM_NX;
     }
@@ -423,13 +491,33 @@ ltop(struct dm_disk_if *d,
       default: ddbg_assert(0); break;
       }
     }
-    free(p);
   }
 
   return DM_OK;
 }
 
 
+static int
+g4_first_remap(struct dm_disk_if *d, int lbn, int len)
+{
+  struct dm_layout_g4 *l = (struct dm_layout_g4 *)d->layout;
+  return g4_ival_first(l->remap_lbnidx, l->remap_lbnidx_len, 
+		       0, 0, lbn, lbn + len);
+}
+
+static int
+g4_ltop_range(struct dm_disk_if *d,
+	      int lbn,
+	      int len,
+	      dm_layout_maptype mt,
+	      struct dm_track_run *runs,
+	      int runs_len)
+{
+  return dm_ltop_range_generic(d, lbn, len, mt, runs, runs_len, 
+			       g4_first_remap);
+}
+
+
 dm_ptol_result_t
 ptol(struct dm_disk_if *d,
      struct dm_pbn *pbn,
@@ -449,10 +537,11 @@ ptol(struct dm_disk_if *d,
   else {
     int rv = 0;
     int i;
+    struct g4_path pathbuf;
     struct g4_path *path;
     struct g4_path_node *n;
 
-    path = g4_recurse(l, 0, pbn);
+    path = g4_recurse(l, 0, pbn, &pathbuf);
 
     if(!path) {
       return DM_NX;
@@ -494,8 +583,6 @@ ptol(struct dm_disk_if *d,
     else {
       result -= rv;
     }
-
-    free(path);
   }
 
   return result;
@@ -507,17 +594,17 @@ g4_spt(struct dm_layout_g4 *l,
        int *lbn,
        struct dm_pbn *pbn)
 {
+  struct g4_path pathbuf;
   struct g4_path *p;
   struct g4_path_node *n;
   int rv;
 
-  p = g4_recurse(l, lbn, pbn);
+  p = g4_recurse(l, lbn, pbn, &pathbuf);
 
   if(p) {
     n = &p->path[p->length - 1];
     ddbg_assert(n->type == TRACK);
     rv = n->n.t->spt;
-    free(p);
   }
   else {
     rv = -1;
@@ -636,9 +723,10 @@ g4_sector_width(struct dm_disk_if *d,
     result = r->sw;
   }
   else {
+    struct g4_path pathbuf;
     struct g4_path *p;
     struct g4_path_node *n;
-    p = g4_recurse(l, 0, track);
+    p = g4_recurse(l, 0, track, &pathbuf);
 
     if(!p) {
       // DM_NX
@@ -648,7 +736,6 @@ g4_sector_width(struct dm_disk_if *d,
       n = &p->path[p->length - 1];
       ddbg_assert(n->type == TRACK);
       result = n->n.t->sw;
-      free(p);
     }
   }
 
@@ -662,12 +749,13 @@ g4_skew(struct dm_disk_if *d,
 	struct dm_pbn *pbn)
 {
   struct dm_layout_g4 *l = (struct dm_layout_g4 *)d->layout;
+  struct g4_path pathbuf;
   struct g4_path *p;
   struct g4_path_node *n;
   int i;
   dm_angle_t result;
 
-  p = g4_recurse(l, 0, pbn);
+  p = g4_recurse(l, 0, pbn, &pathbuf);
   if(!p) { 
     // DM_NX
     return 0; 
@@ -699,7 +787,6 @@ g4_skew(struct dm_disk_if *d,
     }
   }
 
-  free(p);
   return result;
 }
 
@@ -773,6 +860,188 @@ g4_get_zone(struct dm_disk_if *d, int n, struct dm_layout_zone *z)
 }
 
 
+// The marshaled image is the layout struct followed by each of its
+// arrays in turn.  Index entries refer to their children by position
+// in the track/idx arrays.
+
+static int
+layout_g4_marshaled_len(struct dm_disk_if *d) {
+  int i;
+  struct dm_layout_g4 *l = (struct dm_layout_g4 *)d->layout;
+  int result = sizeof(struct dm_marshal_hdr) + sizeof(struct dm_layout_g4);
+
+  result += l->track_len * sizeof(struct track);
+  result += l->slips_len * sizeof(struct slip);
+  result += l->remaps_len * sizeof(struct remap);
+  result += (l->remap_lbnidx_len + l->remap_pbnidx_len) * sizeof(struct g4_ival);
+
+  result += l->idx_len * sizeof(struct idx);
+  for(i = 0; i < l->idx_len; i++) {
+    struct idx *x = &l->idx[i];
+    result += x->ents_len * (sizeof(struct idx_ent) + sizeof(int));
+    result += (x->lbnidx_len + x->cylidx_len) * sizeof(struct g4_ival);
+  }
+
+  return result;
+}
+
+static char *
+g4_marshal_array(char *ptr, void *a, int n, int size) {
+  memcpy(ptr, a, n * size);
+  return ptr + n * size;
+}
+
+// n + 1 so that empty arrays still come back non-NULL
+static char *
+g4_unmarshal_array(char *ptr, void **a, int n, int size) {
+  *a = calloc(n + 1, size);
+  memcpy(*a, ptr, n * size);
+  return ptr + n * size;
+}
+
+static void *
+layout_g4_marshal(struct dm_disk_if *d, char *buff) {
+  int i, j;
+  struct dm_layout_g4 *l = (struct dm_layout_g4 *)d->layout;
+  char *ptr = buff;
+  struct dm_marshal_hdr *hdr = (struct dm_marshal_hdr *)buff;
+  hdr->type = DM_LAYOUT_G4_TYP;
+  hdr->len = layout_g4_marshaled_len(d);
+
+  ptr += sizeof(struct dm_marshal_hdr);
+  memcpy(ptr, l, sizeof(struct dm_layout_g4));
+  marshal_fns((void **)&l->hdr,
+	      sizeof(l->hdr) / sizeof(void *),
+	      ptr,
+	      DM_LAYOUT_G4_TYP);
+  ptr += sizeof(struct dm_layout_g4);
+
+  ptr = g4_marshal_array(ptr, l->track, l->track_len, sizeof(struct track));
+  ptr = g4_marshal_array(ptr, l->slips, l->slips_len, sizeof(struct slip));
+  ptr = g4_marshal_array(ptr, l->remaps, l->remaps_len, sizeof(struct remap));
+  ptr = g4_marshal_array(ptr, l->remap_lbnidx, l->remap_lbnidx_len, 
+			 sizeof(struct g4_ival));
+  ptr = g4_marshal_array(ptr, l->remap_pbnidx, l->remap_pbnidx_len, 
+			 sizeof(struct g4_ival));
+
+  ptr = g4_marshal_array(ptr, l->idx, l->idx_len, sizeof(struct idx));
+  for(i = 0; i < l->idx_len; i++) {
+    struct idx *x = &l->idx[i];
+    ptr = g4_marshal_array(ptr, x->ents, x->ents_len, sizeof(struct idx_ent));
+
+    for(j = 0; j < x->ents_len; j++) {
+      struct idx_ent *e = &x->ents[j];
+      int child = (e->childtype == TRACK) 
+	? e->child.t - l->track : e->child.i - l->idx;
+      memcpy(ptr, &child, sizeof(int));
+      ptr += sizeof(int);
+    }
+
+    ptr = g4_marshal_array(ptr, x->lbnidx, x->lbnidx_len, sizeof(struct g4_ival));
+    ptr = g4_marshal_array(ptr, x->cylidx, x->cylidx_len, sizeof(struct g4_ival));
+  }
+
+  return ptr;
+}
+
+static char *
+layout_g4_unmarshal(struct dm_marshal_hdr *hdr, 
+		    void **result,
+		    void *parent)
+{
+  int i, j;
+  struct dm_layout_g4 *l = malloc(sizeof(struct dm_layout_g4));
+  char *ptr = (char *)hdr;
+
+  ddbg_assert(hdr->type == DM_LAYOUT_G4_TYP);
+
+  ptr += sizeof(struct dm_marshal_hdr);
+  memcpy(l, ptr, sizeof(struct dm_layout_g4));
+  unmarshal_fns((void **)&l->hdr,
+		sizeof(l->hdr) / sizeof(void *),
+		ptr,
+		DM_LAYOUT_G4_TYP);
+  ptr += sizeof(struct dm_layout_g4);
+
+  ptr = g4_unmarshal_array(ptr, (void **)&l->track, l->track_len, 
+			   sizeof(struct track));
+  ptr = g4_unmarshal_array(ptr, (void **)&l->slips, l->slips_len, 
+			   sizeof(struct slip));
+  ptr = g4_unmarshal_array(ptr, (void **)&l->remaps, l->remaps_len, 
+			   sizeof(struct remap));
+  ptr = g4_unmarshal_array(ptr, (void **)&l->remap_lbnidx, l->remap_lbnidx_len, 
+			   sizeof(struct g4_ival));
+  ptr = g4_unmarshal_array(ptr, (void **)&l->remap_pbnidx, l->remap_pbnidx_len, 
+			   sizeof(struct g4_ival));
+
+  ptr = g4_unmarshal_array(ptr, (void **)&l->idx, l->idx_len, 
+			   sizeof(struct idx));
+  for(i = 0; i < l->idx_len; i++) {
+    struct idx *x = &l->idx[i];
+    int mixed = (x->cylidx == 0);
+
+    ptr = g4_unmarshal_array(ptr, (void **)&x->ents, x->ents_len, 
+			     sizeof(struct idx_ent));
+
+    for(j = 0; j < x->ents_len; j++) {
+      struct idx_ent *e = &x->ents[j];
+      int child;
+      memcpy(&child, ptr, sizeof(int));
+      ptr += sizeof(int);
+
+      if(e->childtype == TRACK) {
+	e->child.t = &l->track[child];
+      }
+      else {
+	e->child.i = &l->idx[child];
+      }
+    }
+
+    ptr = g4_unmarshal_array(ptr, (void **)&x->lbnidx, x->lbnidx_len, 
+			     sizeof(struct g4_ival));
+    ptr = g4_unmarshal_array(ptr, (void **)&x->cylidx, x->cylidx_len, 
+			     sizeof(struct g4_ival));
+    // no cylinder index means the ents have to be scanned
+    if(mixed) {
+      free(x->cylidx);
+      x->cylidx = 0;
+    }
+  }
+
+  l->root = &l->idx[l->idx_len - 1];
+  l->parent = parent;
+
+  *result = l;
+  return ptr;
+}
+
+
+// any function that appears in the interface must be listed here
+void *layout_g4_fns[] = {
+  ltop,
+  ptol,
+  g4_spt_lbn,
+  g4_spt_pbn,
+  g4_track_bound,
+  g4_skew,
+  g4_atop,
+  g4_sector_width,
+  layout_g4_marshaled_len,
+  layout_g4_marshal,
+  g4_defect_count,
+  g4_get_numzones,
+  g4_get_zone,
+  g4_ltop_range
+};
+
+struct dm_marshal_module dm_layout_g4_marshal_mod =
+{ 
+  layout_g4_unmarshal, 
+  layout_g4_fns, 
+  sizeof(layout_g4_fns) / sizeof(void *) 
+};
+
+
 struct dm_layout_if layout_g4 = {
 #ifdef WIN32
   ltop,
@@ -800,8 +1069,12 @@ struct dm_layout_if layout_g4 = {
   .dm_convert_atop = g4_atop,
   .dm_get_sector_width = g4_sector_width, 
 
+  .dm_marshaled_len = layout_g4_marshaled_len,
+  .dm_marshal = layout_g4_marshal,
+
   .dm_defect_count = g4_defect_count,
   .dm_get_numzones = g4_get_numzones,
-  .dm_get_zone = g4_get_zone
+  .dm_get_zone = g4_get_zone,
+  .dm_translate_ltop_range = g4_ltop_range
 #endif
 };
@@ -55,6 +55,24 @@ struct remap {
   dm_angle_t sw;  // sector_width
 };
 
+// Load-time index over a set of intervals [low, high) so lookups
+// don't have to scan the whole set.  Entries are sorted by (c, h,
+// low); c and h must match the key exactly (cylinder and head of a
+// remap destination, head of a track child) and are 0 when unused.
+// maxhigh is the largest high of this entry and every earlier entry
+// in the same (c, h) group, so a lookup can stop walking backwards as
+// soon as nothing earlier can reach the key.  Intervals may overlap;
+// lookups return the match with the smallest position in the source
+// array so the result is the same as a front-to-back scan.
+struct g4_ival {
+  int c;
+  int h;
+  int low;
+  int high;
+  int maxhigh;
+  int i;     // position in the source array
+};
+
 struct track;
 struct idx;
 
@@ -108,6 +126,14 @@ struct idx {
   // IDX or TRACK
   struct idx_ent *ents;
   int ents_len;
+
+  // ents indexed by lbn range and by cylinder range (and head for
+  // track children); cylidx is 0 if the children are of mixed
+  // types and the ents have to be scanned.
+  struct g4_ival *lbnidx;
+  int lbnidx_len;
+  struct g4_ival *cylidx;
+  int cylidx_len;
 };
 
 struct dm_layout_g4 {
@@ -133,6 +159,11 @@ struct dm_layout_g4 {
   struct remap *remaps;
   int remaps_len;
 
+  // remaps indexed by lbn range and by destination
+  struct g4_ival *remap_lbnidx;
+  int remap_lbnidx_len;
+  struct g4_ival *remap_pbnidx;
+  int remap_pbnidx_len;
 
 };
 
@@ -442,6 +442,118 @@ g4_load_remaps(struct dm_layout_g4 *r,
 
 
 
+static int
+g4_ival_cmp(const void *a, const void *b) {
+  const struct g4_ival *x = a, *y = b;
+
+  if(x->c != y->c) return x->c < y->c ? -1 : 1;
+  if(x->h != y->h) return x->h < y->h ? -1 : 1;
+  if(x->low != y->low) return x->low < y->low ? -1 : 1;
+  if(x->i != y->i) return x->i < y->i ? -1 : 1;
+  return 0;
+}
+
+// Sort v and fill in the running maxhigh for each (c,h) group.
+static void
+g4_ival_finish(struct g4_ival *v, int n) {
+  int i;
+
+  qsort(v, n, sizeof(*v), g4_ival_cmp);
+
+  for(i = 0; i < n; i++) {
+    v[i].maxhigh = v[i].high;
+    if(i > 0 
+       && v[i-1].c == v[i].c 
+       && v[i-1].h == v[i].h
+       && v[i-1].maxhigh > v[i].maxhigh) 
+    {
+      v[i].maxhigh = v[i-1].maxhigh;
+    }
+  }
+}
+
+// Empty intervals can never match so they're left out.
+static int
+g4_ival_add(struct g4_ival *v, int n, int c, int h, int low, int high, int i) {
+  if(low < high) {
+    v[n].c = c;
+    v[n].h = h;
+    v[n].low = low;
+    v[n].high = high;
+    v[n].i = i;
+    n++;
+  }
+  return n;
+}
+
+static void
+g4_build_idx_index(struct idx *x) {
+  int i;
+  int tracks = 0;
+  struct idx_ent *e;
+
+  x->lbnidx = calloc(x->ents_len + 1, sizeof(*x->lbnidx));
+  x->lbnidx_len = 0;
+  for(i = 0, e = x->ents; i < x->ents_len; i++, e++) {
+    x->lbnidx_len = g4_ival_add(x->lbnidx, x->lbnidx_len, 0, 0, 
+				e->lbn, e->lbn + e->runlen, i);
+    if(e->childtype == TRACK) {
+      tracks++;
+    }
+  }
+  g4_ival_finish(x->lbnidx, x->lbnidx_len);
+
+  // track children also have to match on head
+  if(tracks != 0 && tracks != x->ents_len) {
+    x->cylidx = 0;
+    x->cylidx_len = 0;
+    return;
+  }
+
+  x->cylidx = calloc(x->ents_len + 1, sizeof(*x->cylidx));
+  x->cylidx_len = 0;
+  for(i = 0, e = x->ents; i < x->ents_len; i++, e++) {
+    int low = e->cylrunlen > 0 ? e->cyl : e->cyl + e->cylrunlen + 1;
+    int high = e->cylrunlen < 0 ? e->cyl : e->cyl + e->cylrunlen - 1;
+    x->cylidx_len = g4_ival_add(x->cylidx, x->cylidx_len, 
+				0, tracks ? e->head : 0, 
+				low, high + 1, i);
+  }
+  g4_ival_finish(x->cylidx, x->cylidx_len);
+}
+
+// Build the lookup indices used by the translation routines.  Done
+// once at load time; none of the tables change afterwards.
+void
+g4_build_index(struct dm_layout_g4 *l) {
+  int i;
+  struct remap *r;
+
+  for(i = 0; i < l->idx_len; i++) {
+    g4_build_idx_index(&l->idx[i]);
+  }
+
+  l->remap_lbnidx = calloc(l->remaps_len + 1, sizeof(*l->remap_lbnidx));
+  l->remap_pbnidx = calloc(l->remaps_len + 1, sizeof(*l->remap_pbnidx));
+  l->remap_lbnidx_len = 0;
+  l->remap_pbnidx_len = 0;
+
+  for(i = 0, r = l->remaps; i < l->remaps_len; i++, r++) {
+    l->remap_lbnidx_len = g4_ival_add(l->remap_lbnidx, l->remap_lbnidx_len,
+				      0, 0, 
+				      r->off, r->off + r->count, i);
+    l->remap_pbnidx_len = g4_ival_add(l->remap_pbnidx, l->remap_pbnidx_len,
+				      r->dest.cyl, r->dest.head, 
+				      r->dest.sector, 
+				      r->dest.sector + r->count, i);
+  }
+
+  g4_ival_finish(l->remap_lbnidx, l->remap_lbnidx_len);
+  g4_ival_finish(l->remap_pbnidx, l->remap_pbnidx_len);
+}
+
+
+
 struct dm_layout_if *
 dm_layout_g4_loadparams(struct lp_block *b,
 			struct dm_disk_if *parent)
@@ -457,6 +569,8 @@ dm_layout_g4_loadparams(struct lp_block *b,
   // XXX ick
   result->root = &result->idx[result->idx_len - 1];
 
+  g4_build_index(result);
+
   // XXX shouldn't do this
   parent->layout = (struct dm_layout_if *)result;
 
@@ -40,8 +40,12 @@ struct g4_path_node {
   int resid; 
 };
 
+// Paths are small and live on the caller's stack.
 struct g4_path {
   struct g4_path_node path[G4_ALLOC_PATH];
   int length;
 };
 
+// layout_g4_load.c
+void g4_build_index(struct dm_layout_g4 *l);
+
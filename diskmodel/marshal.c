@@ -41,7 +41,7 @@ dm_unmarshal(struct dm_marshal_hdr *h, int bufflen) {
 
   /* malformed */
   if(bufflen < sizeof(struct dm_marshal_hdr)) return 0;
-  if(h->len < bufflen) return 0;
+  if(h->len > bufflen) return 0;
   // don't know what this is
   if(h->type != DM_DISK_TYP) return 0;
 
@@ -68,9 +68,11 @@ dm_unmarshal_disk(struct dm_marshal_hdr *h,
 
   switch(hdrtmp->type) {
   case DM_LAYOUT_G1_TYP:
-    ptr = dm_marshal_mods[DM_LAYOUT_G1_TYP]->unmarshal((void *)ptr,
-							 (void **)&d->layout, 
-							 d);
+  case DM_LAYOUT_G2_TYP:
+  case DM_LAYOUT_G4_TYP:
+    ptr = dm_marshal_mods[hdrtmp->type]->unmarshal((void *)ptr,
+						     (void **)&d->layout, 
+						     d);
     break;
     
   default:
@@ -103,7 +105,7 @@ dm_marshal(struct dm_disk_if *d) {
   alloc_size += d->mech->dm_marshaled_len(d);
   alloc_size += sizeof(struct dm_marshal_hdr);
 
-  result = malloc(alloc_size);
+  result = calloc(1, alloc_size);
 
   result->type = DM_DISK_TYP;
   result->len = alloc_size;
@@ -127,6 +129,8 @@ struct dm_marshal_module *dm_marshal_mods[] = {
   &dm_disk_marshal_mod,
   &dm_layout_g1_marshal_mod,
   &dm_mech_g1_marshal_mod,
+  &dm_layout_g2_marshal_mod,
+  &dm_layout_g4_marshal_mod,
 };
 
 
@@ -139,11 +143,19 @@ struct marshaled_fn {
   uint16_t code;
 };
 
+// code for an unset (NULL) slot in an interface struct
+#define DM_MARSHAL_NULL_FN 0xffff
+
 void marshal_fn(void *fn, int typ, struct marshaled_fn *result) {
   int c;
 
   result->typ = typ;
 
+  if(!fn) {
+    result->code = DM_MARSHAL_NULL_FN;
+    return;
+  }
+
   for(c = 0; c < dm_marshal_mods[typ]->fn_table_len; c++) {
     if(dm_marshal_mods[typ]->fn_table[c] == fn) {
       result->code = c;
@@ -156,6 +168,10 @@ void marshal_fn(void *fn, int typ, struct marshaled_fn *result) {
 
 void *unmarshal_fn(int *buff, int typ) {
   struct marshaled_fn *dmf = (struct marshaled_fn *)buff;
+  if(dmf->code == DM_MARSHAL_NULL_FN) {
+    return 0;
+  }
+  ddbg_assert(dmf->code < dm_marshal_mods[typ]->fn_table_len);
   return dm_marshal_mods[typ]->fn_table[dmf->code];
 }
 
@@ -58,6 +58,8 @@ struct dm_marshal_module {
 
 extern struct dm_marshal_module dm_disk_marshal_mod;
 extern struct dm_marshal_module dm_layout_g1_marshal_mod;
+extern struct dm_marshal_module dm_layout_g2_marshal_mod;
+extern struct dm_marshal_module dm_layout_g4_marshal_mod;
 extern struct dm_marshal_module dm_mech_g1_marshal_mod;
 
 extern struct dm_marshal_module *dm_marshal_mods[];
@@ -75,9 +77,11 @@ typedef enum {
   DM_DISK_TYP,
   DM_LAYOUT_G1_TYP,
   DM_MECH_G1_TYP,
+  DM_LAYOUT_G2_TYP,
+  DM_LAYOUT_G4_TYP,
 } dm_marshal_type_t;
 
-#define DM_MARSHAL_MOD_MAX 3
+#define DM_MARSHAL_MOD_MAX 5
 
 
 #endif /* _DM_MARSHAL_H */
@@ -105,6 +105,8 @@
 #include "mech_g1.h"
 #include "mech_g1_private.h"
 
+#include <stddef.h> // offsetof()
+
 
 // Port of first generation (disksim) disk mechanics implementation
 
@@ -827,13 +829,13 @@ mech_g1_marshal(struct dm_disk_if *d, char *b) {
 	       DM_MECH_G1_TYP);
 
   {
-    int *seekfnoffset = (int *)ptr + sizeof(struct dm_mech_if);
+    char *seekfnoffset = ptr + offsetof(struct dm_mech_g1, seekfn);
     
     marshal_fn((void *)m->seekfn, DM_MECH_G1_TYP, 
 		(struct marshaled_fn *)seekfnoffset);
   }
 
-  ptr += sizeof(struct dm_mech_g1) + sizeof(void*);
+  ptr += sizeof(struct dm_mech_g1);
   if(m->xseekcnt != 0) {
     int distsize = m->xseekcnt * sizeof(int);
     int timesize = m->xseekcnt * sizeof(dm_time_t);
@@ -863,12 +865,14 @@ mech_g1_unmarshal(struct dm_marshal_hdr *h,
 		 DM_MECH_G1_TYP);
 
   {
-    int *seekfnoffset = (int *)ptr + sizeof(struct dm_mech_if);
-    m->seekfn = unmarshal_fn(seekfnoffset,
+    char *seekfnoffset = ptr + offsetof(struct dm_mech_g1, seekfn);
+    m->seekfn = unmarshal_fn((int *)seekfnoffset,
 			      DM_MECH_G1_TYP);
   }
-  ptr += sizeof(struct dm_mech_g1) + sizeof(void*);
+  ptr += sizeof(struct dm_mech_g1);
 
+  m->xseekdists = 0;
+  m->xseektimes = 0;
   if(m->xseekcnt != 0) {
     int distsize = m->xseekcnt * sizeof(int);
     int timesize = m->xseekcnt * sizeof(dm_time_t);
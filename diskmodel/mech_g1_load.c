@@ -128,7 +128,7 @@ int do_hpl_seek(struct dm_mech_g1 *result, struct lp_list *l);
 struct dm_mech_if *
 dm_mech_g1_loadparams(struct lp_block *b, int *junk) {
   
-  struct dm_mech_g1 *result = malloc(sizeof(*result));
+  struct dm_mech_g1 *result = calloc(1, sizeof(*result));
   result->hdr = dm_mech_g1;
   //  #include "modules/dm_mech_g1_param.c"
   lp_loadparams(result, b, &dm_mech_g1_mod);
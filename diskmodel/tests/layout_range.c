@@ -0,0 +1,205 @@
+/* diskmodel (version 1.1)
+ * Authors: John Bucy, Greg Ganger
+ * Contributors: John Griffin, Jiri Schindler, Steve Schlosser
+ *
+ * Copyright (c) of Carnegie Mellon University, 2003-2005
+ *
+ * This software is being provided by the copyright holders under the
+ * following license. By obtaining, using and/or copying this
+ * software, you agree that you have read, understood, and will comply
+ * with the following terms and conditions:
+ *
+ * Permission to reproduce, use, and prepare derivative works of this
+ * software is granted provided the copyright and "No Warranty"
+ * statements are included with all reproductions and derivative works
+ * and associated documentation. This software may also be
+ * redistributed without charge provided that the copyright and "No
+ * Warranty" statements are included in all redistributions.
+ *
+ * NO WARRANTY. THIS SOFTWARE IS FURNISHED ON AN "AS IS" BASIS.
+ * CARNEGIE MELLON UNIVERSITY MAKES NO WARRANTIES OF ANY KIND, EITHER
+ * EXPRESSED OR IMPLIED AS TO THE MATTER INCLUDING, BUT NOT LIMITED
+ * TO: WARRANTY OF FITNESS FOR PURPOSE OR MERCHANTABILITY, EXCLUSIVITY
+ * OF RESULTS OR RESULTS OBTAINED FROM USE OF THIS SOFTWARE. CARNEGIE
+ * MELLON UNIVERSITY DOES NOT MAKE ANY WARRANTY OF ANY KIND WITH
+ * RESPECT TO FREEDOM FROM PATENT, TRADEMARK, OR COPYRIGHT
+ * INFRINGEMENT.  COPYRIGHT HOLDERS WILL BEAR NO LIABILITY FOR ANY USE
+ * OF THIS SOFTWARE OR DOCUMENTATION.  
+ */
+
+#include "test.h"
+
+#include <stdlib.h>
+
+
+// Compare dm_translate_ltop_range() with lbn-at-a-time
+// dm_translate_ltop(): walk the whole disk and a batch of random
+// extents, check every lbn of every run against ltop and check that
+// each run only ends where the next lbn doesn't continue it on the
+// same track.
+
+void testsUsage(void) {
+  fprintf(stderr, "usage: layout_range <model> <model name>\n");
+}
+
+#define RUNS_MAX 16
+
+static int runs_ct = 0;
+static int remapped_ct = 0;
+static int midtrack_ct = 0;   // runs cut short by a slip or remap
+
+
+static int
+same_track(struct dm_pbn *p1, struct dm_pbn *p2) {
+  return (p1->cyl == p2->cyl) && (p1->head == p2->head);
+}
+
+
+// every lbn in the run against ltop
+static int
+check_run(struct dm_disk_if *d, struct dm_track_run *r) {
+  int i;
+  int bad = 0;
+
+  for(i = 0; i < r->len; i++) {
+    struct dm_pbn pbn;
+    int remap = 0;
+    int rv;
+
+    rv = d->layout->dm_translate_ltop(d, r->lbn + i, MAP_FULL, &pbn, &remap);
+    if((rv != DM_OK)
+       || !same_track(&pbn, &r->pbn)
+       || (pbn.sector != r->pbn.sector + i)
+       || (!remap != !r->remapped)) 
+    {
+      printf("lbn %d: run %d at (%d,%d,%d)+%d remapped %d, "
+	     "ltop (%d,%d,%d) remapped %d\n",
+	     r->lbn + i, r->lbn, r->pbn.cyl, r->pbn.head, r->pbn.sector, i,
+	     r->remapped, pbn.cyl, pbn.head, pbn.sector, remap);
+      bad++;
+    }
+  }
+
+  if(d->layout->dm_pbn_skew && (r->skew != d->layout->dm_pbn_skew(d, &r->pbn))) {
+    printf("run %d: skew %u != %u\n", r->lbn, r->skew, 
+	   d->layout->dm_pbn_skew(d, &r->pbn));
+    bad++;
+  }
+
+  return bad;
+}
+
+
+// a run must not stop where the next lbn would still continue it
+static int
+check_end(struct dm_disk_if *d, struct dm_track_run *r, int end) {
+  struct dm_pbn pbn;
+  int remap = 0;
+  int next = r->lbn + r->len;
+
+  if(r->remapped) {
+    remapped_ct++;
+    return 0;
+  }
+  if(next >= end) {
+    return 0;
+  }
+  if(d->layout->dm_translate_ltop(d, next, MAP_FULL, &pbn, &remap) != DM_OK) {
+    return 0;
+  }
+
+  if(!remap 
+     && same_track(&pbn, &r->pbn) 
+     && (pbn.sector == r->pbn.sector + r->len)) 
+  {
+    printf("run %d at (%d,%d,%d) stops short at %d\n", 
+	   r->lbn, r->pbn.cyl, r->pbn.head, r->pbn.sector, next);
+    return 1;
+  }
+
+  if(r->pbn.sector + r->len < d->layout->dm_get_sectors_pbn(d, &r->pbn)) {
+    midtrack_ct++;
+  }
+  return 0;
+}
+
+
+// translate [lbn, lbn+len) runs_len runs at a time
+static int
+walk(struct dm_disk_if *d, int lbn, int len, int runs_len) {
+  struct dm_track_run runs[RUNS_MAX];
+  int end = (len < d->dm_sectors - lbn) ? lbn + len : d->dm_sectors;
+  int bad = 0;
+
+  while(lbn < end) {
+    int i, n;
+
+    n = d->layout->dm_translate_ltop_range(d, lbn, end - lbn, MAP_FULL, 
+					   runs, runs_len);
+    if((n <= 0) || (n > runs_len)) {
+      printf("ltop_range(%d, %d, %d) returned %d\n", 
+	     lbn, end - lbn, runs_len, n);
+      return bad + 1;
+    }
+
+    for(i = 0; i < n; i++) {
+      struct dm_track_run *r = &runs[i];
+
+      if((r->lbn != lbn) || (r->len <= 0) || (lbn + r->len > end)) {
+	printf("ltop_range(%d, %d): run %d is %d+%d\n", 
+	       lbn, end - lbn, i, r->lbn, r->len);
+	return bad + 1;
+      }
+
+      bad += check_run(d, r);
+      bad += check_end(d, r, end);
+      lbn += r->len;
+      runs_ct++;
+    }
+  }
+
+  return bad;
+}
+
+
+int 
+layout_test_range(struct dm_disk_if *d) {
+  struct dm_track_run run;
+  int bad = 0;
+  int c;
+
+  if(!d->layout->dm_translate_ltop_range) {
+    printf("layout has no dm_translate_ltop_range\n");
+    return 0;
+  }
+
+  bad += walk(d, 0, d->dm_sectors, RUNS_MAX);
+  printf("whole disk: %d zones, %d runs, %d remapped, %d ending mid-track\n",
+	 d->layout->dm_get_numzones(d), runs_ct, remapped_ct, midtrack_ct);
+
+  srand(1);
+  for(c = 0; c < 10000; c++) {
+    int lbn = rand() % d->dm_sectors;
+    int len = 1 + rand() % 4096;
+    bad += walk(d, lbn, len, 1 + rand() % RUNS_MAX);
+  }
+
+  if(d->layout->dm_translate_ltop_range(d, d->dm_sectors, 1, MAP_FULL, &run, 1) > 0) {
+    printf("ltop_range past the end of the disk\n");
+    bad++;
+  }
+  if(d->layout->dm_translate_ltop_range(d, -1, 1, MAP_FULL, &run, 1) > 0) {
+    printf("ltop_range before the start of the disk\n");
+    bad++;
+  }
+
+  return bad;
+}
+
+
+int minargs = 1;
+
+int doTests(struct dm_disk_if *d, int argc, char **argv)
+{
+  return layout_test_range(d);
+}
@@ -0,0 +1,987 @@
+/* libparam (version 1.0)
+ * Authors: John Bucy, Greg Ganger
+ * Contributors: John Griffin, Jiri Schindler, Steve Schlosser
+ *
+ * Copyright (c) of Carnegie Mellon University, 2001-2008.
+ *
+ * This software is being provided by the copyright holders under the
+ * following license. By obtaining, using and/or copying this
+ * software, you agree that you have read, understood, and will comply
+ * with the following terms and conditions:
+ *
+ * Permission to reproduce, use, and prepare derivative works of this
+ * software is granted provided the copyright and "No Warranty"
+ * statements are included with all reproductions and derivative works
+ * and associated documentation. This software may also be
+ * redistributed without charge provided that the copyright and "No
+ * Warranty" statements are included in all redistributions.
+ *
+ * NO WARRANTY. THIS SOFTWARE IS FURNISHED ON AN "AS IS" BASIS.
+ * CARNEGIE MELLON UNIVERSITY MAKES NO WARRANTIES OF ANY KIND, EITHER
+ * EXPRESSED OR IMPLIED AS TO THE MATTER INCLUDING, BUT NOT LIMITED
+ * TO: WARRANTY OF FITNESS FOR PURPOSE OR MERCHANTABILITY, EXCLUSIVITY
+ * OF RESULTS OR RESULTS OBTAINED FROM USE OF THIS SOFTWARE. CARNEGIE
+ * MELLON UNIVERSITY DOES NOT MAKE ANY WARRANTY OF ANY KIND WITH
+ * RESPECT TO FREEDOM FROM PATENT, TRADEMARK, OR COPYRIGHT
+ * INFRINGEMENT.  COPYRIGHT HOLDERS WILL BEAR NO LIABILITY FOR ANY USE
+ * OF THIS SOFTWARE OR DOCUMENTATION.
+ */
+
+
+// Cache of parse trees.
+//
+// A parameter sweep runs the same configuration, usually a top-level
+// file plus a pile of sourced diskspecs, hundreds of times.  If
+// LP_CACHE is set in the environment, it names a directory where
+// lp_loadfile() keeps the parse tree of each input as <key>.lpc,
+// along with the subtypes the input defined and the text
+// lp_unparse_tlts() echoes for it.  The key covers the top-level
+// file's name and contents, LP_PATH and the registered modules; the
+// entry records every file that was sourced and is only used if each
+// still resolves to the same path with the same contents.
+//
+// A hit skips the lexer and parser.  Top-level topologies and
+// instantiations are still handed to the application in file order,
+// so every object is built (and its parameters checked) exactly as
+// on a miss.  Inputs loaded after another file in the same process
+// see that file's types, so those are never cached.
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <libddbg/libddbg.h>
+
+#ifndef WIN32
+#include <unistd.h> // getpid()
+#else
+#include <process.h>
+#define getpid _getpid
+#endif
+
+#include <libgen.h> // dirname()
+
+#include "libparam.h"
+
+// bump this whenever the format below changes
+#define LP_CACHE_VERSION 1
+#define LP_CACHE_MAGIC   0x4350416c  // "lAPC"
+
+// sanity bound on counts read back from a cache file
+#define LP_CACHE_MAXLEN  (1 << 24)
+
+extern int lp_max_mod;
+
+
+// 64-bit FNV-1a
+
+#define FNV_OFFSET 0xcbf29ce484222325ULL
+#define FNV_PRIME  0x100000001b3ULL
+
+static uint64_t
+hash_bytes(uint64_t h, const void *buf, int len) {
+  const unsigned char *p = buf;
+  int c;
+
+  for(c = 0; c < len; c++) {
+    h ^= p[c];
+    h *= FNV_PRIME;
+  }
+  return h;
+}
+
+static uint64_t
+hash_string(uint64_t h, const char *s) {
+  if(!s) s = "";
+  // include the terminator so "ab","c" != "a","bc"
+  return hash_bytes(h, s, strlen(s) + 1);
+}
+
+// hashes the rest of f; returns -1 on a read error
+static int
+hash_stream(uint64_t *h, FILE *f) {
+  char buf[4096];
+  int n;
+
+  while((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+    *h = hash_bytes(*h, buf, n);
+  }
+  return ferror(f) ? -1 : 0;
+}
+
+static int
+hash_file(uint64_t *h, char *path) {
+  FILE *f = fopen(path, "r");
+  int rv;
+
+  if(!f) return -1;
+  *h = FNV_OFFSET;
+  rv = hash_stream(h, f);
+  fclose(f);
+  return rv;
+}
+
+
+// a file sourced by the input, as the lexer found it
+struct lp_cache_src {
+  char *cwd;
+  char *name;
+  char *path;
+  struct lp_cache_src *next;
+};
+
+static char *lp_cache_dir = 0;
+static int lp_cache_dir_inited = 0;
+
+// key of the file being loaded; only meaningful when lp_cache_keyed
+static uint64_t lp_cache_key;
+static int lp_cache_keyed = 0;
+
+static struct lp_cache_src *lp_cache_srcs = 0;
+static struct lp_cache_src **lp_cache_srcs_tail = &lp_cache_srcs;
+
+// echo text for the tree from the last load
+static struct lp_tlt **lp_cache_echo_tlts = 0;
+static char *lp_cache_echo_infile = 0;
+static char *lp_cache_echo_buf = 0;
+static int lp_cache_echo_len = 0;
+
+
+void
+lp_cache_note_source(char *cwd, char *name, char *path) {
+  struct lp_cache_src *s;
+
+  if(!lp_cache_keyed) return;
+
+  s = calloc(1, sizeof(*s));
+  s->cwd = strdup(cwd);
+  s->name = strdup(name);
+  s->path = strdup(path);
+  *lp_cache_srcs_tail = s;
+  lp_cache_srcs_tail = &s->next;
+}
+
+
+static void
+lp_cache_reset(void) {
+  struct lp_cache_src *s, *next;
+
+  for(s = lp_cache_srcs; s; s = next) {
+    next = s->next;
+    free(s->cwd);
+    free(s->name);
+    free(s->path);
+    free(s);
+  }
+  lp_cache_srcs = 0;
+  lp_cache_srcs_tail = &lp_cache_srcs;
+  lp_cache_keyed = 0;
+
+  free(lp_cache_echo_infile);
+  free(lp_cache_echo_buf);
+  lp_cache_echo_tlts = 0;
+  lp_cache_echo_infile = 0;
+  lp_cache_echo_buf = 0;
+  lp_cache_echo_len = 0;
+}
+
+
+// The parse depends on the subtypes already in the table; only a
+// table holding nothing but the registered modules is cacheable.
+static int
+lp_cache_typetbl_clean(void) {
+  int c;
+
+  for(c = 0; c < lp_typetbl_len; c++) {
+    if(!lp_typetbl[c]) continue;
+    if(c >= lp_max_mod || lp_typetbl[c]->spec) return 0;
+  }
+  return 1;
+}
+
+
+static uint64_t
+hash_modules(uint64_t h) {
+  int c, d;
+
+  h = hash_bytes(h, &lp_max_mod, sizeof(lp_max_mod));
+  for(c = 0; c < lp_max_mod; c++) {
+    struct lp_mod *m = lp_modules[c];
+    h = hash_string(h, m->name);
+    h = hash_bytes(h, &m->modvars_len, sizeof(m->modvars_len));
+    for(d = 0; d < m->modvars_len; d++) {
+      h = hash_string(h, m->modvars[d].name);
+      h = hash_bytes(h, &m->modvars[d].type, sizeof(m->modvars[d].type));
+      h = hash_bytes(h, &m->modvars[d].req, sizeof(m->modvars[d].req));
+    }
+  }
+
+  return h;
+}
+
+
+// hashes the rest of in and puts it back where it was
+static int
+lp_cache_compute_key(FILE *in, char *infile) {
+  uint64_t h = FNV_OFFSET;
+  int version = LP_CACHE_VERSION;
+  long pos;
+  int rv;
+
+  h = hash_bytes(h, &version, sizeof(version));
+  h = hash_modules(h);
+  h = hash_string(h, infile);
+  h = hash_string(h, getenv("LP_PATH"));
+
+  pos = ftell(in);
+  if(pos < 0) return -1;
+  rv = hash_stream(&h, in);
+  clearerr(in);
+  if(fseek(in, pos, SEEK_SET) || rv) return -1;
+
+  lp_cache_key = h;
+  return 0;
+}
+
+
+static void
+lp_cache_filename(char *buf, int len) {
+  snprintf(buf, len, "%s/%016llx.lpc", lp_cache_dir,
+	   (unsigned long long)lp_cache_key);
+}
+
+
+
+// Writing.  Every pointer in the tree is written once; later
+// references to it are written as the index it was given the first
+// time, so subtypes keep sharing their parents' params and every
+// object from a file keeps sharing its source_file.
+
+struct lp_cache_wr {
+  FILE *f;
+  void **keys;
+  int *ids;
+  int size;   // of keys, ids; a power of 2
+  int n;      // objects written
+  int err;
+};
+
+static void
+put_bytes(struct lp_cache_wr *w, const void *buf, int len) {
+  if(len && fwrite(buf, len, 1, w->f) != 1) w->err = 1;
+}
+
+static void
+put_int(struct lp_cache_wr *w, int i) {
+  put_bytes(w, &i, sizeof(i));
+}
+
+static int
+ptr_slot(void **keys, int size, void *p) {
+  int c = (int)((((uintptr_t)p >> 3) * 2654435761u) & (size - 1));
+
+  while(keys[c] && keys[c] != p) {
+    c = (c + 1) & (size - 1);
+  }
+  return c;
+}
+
+// Writes the reference to p.  Returns nonzero if this is the first
+// time p has been seen and the caller must write its contents next.
+static int
+put_ref(struct lp_cache_wr *w, void *p) {
+  int c;
+
+  if(!p) {
+    put_int(w, -1);
+    return 0;
+  }
+
+  if(2 * (w->n + 1) > w->size) {
+    int newsize = w->size ? 2 * w->size : 256;
+    void **keys = calloc(newsize, sizeof(void *));
+    int *ids = calloc(newsize, sizeof(int));
+    int d;
+
+    for(d = 0; d < w->size; d++) {
+      if(w->keys[d]) {
+	int e = ptr_slot(keys, newsize, w->keys[d]);
+	keys[e] = w->keys[d];
+	ids[e] = w->ids[d];
+      }
+    }
+    free(w->keys);
+    free(w->ids);
+    w->keys = keys;
+    w->ids = ids;
+    w->size = newsize;
+  }
+
+  c = ptr_slot(w->keys, w->size, p);
+  if(w->keys[c]) {
+    put_int(w, w->ids[c]);
+    return 0;
+  }
+
+  w->keys[c] = p;
+  w->ids[c] = w->n;
+  put_int(w, w->n++);
+  return 1;
+}
+
+static void
+put_str(struct lp_cache_wr *w, char *s) {
+  if(put_ref(w, s)) {
+    int len = strlen(s);
+    put_int(w, len);
+    put_bytes(w, s, len);
+  }
+}
+
+static void put_block(struct lp_cache_wr *w, struct lp_block *b);
+static void put_list(struct lp_cache_wr *w, struct lp_list *l);
+
+static void
+put_topo(struct lp_cache_wr *w, struct lp_topospec *t, int len) {
+  int c;
+
+  if(!put_ref(w, t)) return;
+
+  put_int(w, len);
+  for(c = 0; c < len; c++) {
+    put_str(w, t[c].source_file);
+    put_str(w, t[c].type);
+    put_str(w, t[c].name);
+    put_list(w, t[c].l);
+  }
+}
+
+static void
+put_value(struct lp_cache_wr *w, struct lp_value *v) {
+  if(!put_ref(w, v)) return;
+
+  put_int(w, v->t);
+  put_str(w, v->source_file);
+
+  switch(v->t) {
+  case I:
+    put_int(w, v->v.i);
+    break;
+  case D:
+    put_bytes(w, &v->v.d, sizeof(v->v.d));
+    break;
+  case S:
+    put_str(w, v->v.s);
+    break;
+  case LIST:
+    put_list(w, v->v.l);
+    break;
+  case BLOCK:
+    put_block(w, v->v.b);
+    break;
+  case TOPOSPEC:
+    put_topo(w, v->v.t.l, v->v.t.len);
+    break;
+  default:
+    w->err = 1;
+    break;
+  }
+}
+
+static void
+put_list(struct lp_cache_wr *w, struct lp_list *l) {
+  int c;
+
+  if(!put_ref(w, l)) return;
+
+  put_str(w, l->source_file);
+  put_int(w, l->values_len);
+  put_int(w, l->values_pop);
+  put_int(w, l->linelen);
+  for(c = 0; c < l->values_len; c++) {
+    put_value(w, l->values[c]);
+  }
+}
+
+static void
+put_param(struct lp_cache_wr *w, struct lp_param *p) {
+  if(!put_ref(w, p)) return;
+
+  put_str(w, p->source_file);
+  put_str(w, p->name);
+  put_value(w, p->v);
+}
+
+static void
+put_block(struct lp_cache_wr *w, struct lp_block *b) {
+  int c;
+
+  if(!put_ref(w, b)) return;
+
+  put_str(w, b->source_file);
+  put_str(w, b->name);
+  put_int(w, b->type);
+  // the loader, if any, is always the module's
+  put_int(w, b->loader != 0);
+  put_int(w, b->params_len);
+  for(c = 0; c < b->params_len; c++) {
+    put_param(w, b->params[c]);
+  }
+}
+
+static void
+put_inst(struct lp_cache_wr *w, struct lp_inst *i) {
+  if(!put_ref(w, i)) return;
+
+  put_str(w, i->source_file);
+  put_list(w, i->l);
+  put_str(w, i->name);
+}
+
+static void
+put_tlt(struct lp_cache_wr *w, struct lp_tlt *t) {
+  if(!put_ref(w, t)) return;
+
+  put_str(w, t->source_file);
+  put_int(w, t->what);
+  switch(t->what) {
+  case TLT_BLOCK: put_block(w, t->it.block); break;
+  case TLT_TOPO:  put_topo(w, t->it.topo, 1); break;
+  case TLT_INST:  put_inst(w, t->it.inst); break;
+  default:        w->err = 1; break;
+  }
+}
+
+
+
+// Reading mirrors the above.  Any inconsistency just sets err and
+// the entry is ignored.
+
+struct lp_cache_rd {
+  FILE *f;
+  void **objs;
+  int objs_len;
+  int n;
+  int err;
+};
+
+static void
+get_bytes(struct lp_cache_rd *r, void *buf, int len) {
+  if(r->err) {
+    memset(buf, 0, len);
+  }
+  else if(len && fread(buf, len, 1, r->f) != 1) {
+    memset(buf, 0, len);
+    r->err = 1;
+  }
+}
+
+static int
+get_int(struct lp_cache_rd *r) {
+  int i;
+  get_bytes(r, &i, sizeof(i));
+  return i;
+}
+
+static int
+get_len(struct lp_cache_rd *r) {
+  int len = get_int(r);
+  if(len < 0 || len > LP_CACHE_MAXLEN) {
+    r->err = 1;
+    return 0;
+  }
+  return len;
+}
+
+// Reads a reference.  Returns nonzero if it names a new object, in
+// which case the caller allocates it, passes it to add_obj() and
+// then reads its contents.  Otherwise *p is the object (or NULL).
+static int
+get_ref(struct lp_cache_rd *r, void **p) {
+  int id = get_int(r);
+
+  *p = 0;
+  if(r->err || id == -1) return 0;
+
+  if(id >= 0 && id < r->n) {
+    *p = r->objs[id];
+    return 0;
+  }
+  if(id == r->n) return 1;
+
+  r->err = 1;
+  return 0;
+}
+
+static void
+add_obj(struct lp_cache_rd *r, void *p) {
+  if(r->n == r->objs_len) {
+    r->objs_len = r->objs_len ? 2 * r->objs_len : 256;
+    r->objs = realloc(r->objs, r->objs_len * sizeof(void *));
+  }
+  r->objs[r->n++] = p;
+}
+
+static char *
+get_str(struct lp_cache_rd *r) {
+  void *p;
+  char *s;
+  int len;
+
+  if(!get_ref(r, &p)) return p;
+
+  len = get_len(r);
+  s = calloc(len + 1, sizeof(char));
+  add_obj(r, s);
+  get_bytes(r, s, len);
+  return s;
+}
+
+static struct lp_block *get_block(struct lp_cache_rd *r);
+static struct lp_list *get_list(struct lp_cache_rd *r);
+
+static struct lp_topospec *
+get_topo(struct lp_cache_rd *r, int *lenp) {
+  struct lp_topospec *t;
+  void *p;
+  int len, c;
+
+  // the length lives with the first reference; later ones (there
+  // are none in practice) must agree with the caller's
+  if(!get_ref(r, &p)) return p;
+
+  len = get_len(r);
+  t = calloc(len ? len : 1, sizeof(*t));
+  add_obj(r, t);
+  for(c = 0; c < len; c++) {
+    t[c].source_file = get_str(r);
+    t[c].type = get_str(r);
+    t[c].name = get_str(r);
+    t[c].l = get_list(r);
+  }
+  if(lenp) *lenp = len;
+  return t;
+}
+
+static struct lp_value *
+get_value(struct lp_cache_rd *r) {
+  struct lp_value *v;
+  void *p;
+
+  if(!get_ref(r, &p)) return p;
+
+  v = calloc(1, sizeof(*v));
+  add_obj(r, v);
+  v->t = get_int(r);
+  v->source_file = get_str(r);
+
+  switch(v->t) {
+  case I:
+    v->v.i = get_int(r);
+    break;
+  case D:
+    get_bytes(r, &v->v.d, sizeof(v->v.d));
+    break;
+  case S:
+    v->v.s = get_str(r);
+    break;
+  case LIST:
+    v->v.l = get_list(r);
+    break;
+  case BLOCK:
+    v->v.b = get_block(r);
+    break;
+  case TOPOSPEC:
+    v->v.t.l = get_topo(r, &v->v.t.len);
+    break;
+  default:
+    r->err = 1;
+    break;
+  }
+
+  return v;
+}
+
+static struct lp_list *
+get_list(struct lp_cache_rd *r) {
+  struct lp_list *l;
+  void *p;
+  int c;
+
+  if(!get_ref(r, &p)) return p;
+
+  l = calloc(1, sizeof(*l));
+  add_obj(r, l);
+  l->source_file = get_str(r);
+  l->values_len = get_len(r);
+  l->values_pop = get_int(r);
+  l->linelen = get_int(r);
+  l->values = calloc(l->values_len ? l->values_len : 1, sizeof(*l->values));
+  for(c = 0; c < l->values_len; c++) {
+    l->values[c] = get_value(r);
+  }
+
+  return l;
+}
+
+static struct lp_param *
+get_param(struct lp_cache_rd *r) {
+  struct lp_param *pa;
+  void *p;
+
+  if(!get_ref(r, &p)) return p;
+
+  pa = calloc(1, sizeof(*pa));
+  add_obj(r, pa);
+  pa->source_file = get_str(r);
+  pa->name = get_str(r);
+  pa->v = get_value(r);
+
+  return pa;
+}
+
+static struct lp_block *
+get_block(struct lp_cache_rd *r) {
+  struct lp_block *b;
+  void *p;
+  int c;
+
+  if(!get_ref(r, &p)) return p;
+
+  b = calloc(1, sizeof(*b));
+  add_obj(r, b);
+  b->source_file = get_str(r);
+  b->name = get_str(r);
+  b->type = get_int(r);
+  if(b->type < 0 || b->type >= lp_max_mod) {
+    r->err = 1;
+    return b;
+  }
+  if(get_int(r)) {
+    b->loader = lp_modules[b->type]->fn;
+  }
+  b->params_len = get_len(r);
+  b->params = calloc(b->params_len ? b->params_len : 1, sizeof(*b->params));
+  for(c = 0; c < b->params_len; c++) {
+    b->params[c] = get_param(r);
+  }
+
+  return b;
+}
+
+static struct lp_inst *
+get_inst(struct lp_cache_rd *r) {
+  struct lp_inst *i;
+  void *p;
+
+  if(!get_ref(r, &p)) return p;
+
+  i = calloc(1, sizeof(*i));
+  add_obj(r, i);
+  i->source_file = get_str(r);
+  i->l = get_list(r);
+  i->name = get_str(r);
+
+  return i;
+}
+
+static struct lp_tlt *
+get_tlt(struct lp_cache_rd *r) {
+  struct lp_tlt *t;
+  void *p;
+
+  if(!get_ref(r, &p)) return p;
+
+  t = calloc(1, sizeof(*t));
+  add_obj(r, t);
+  t->source_file = get_str(r);
+  t->what = get_int(r);
+  switch(t->what) {
+  case TLT_BLOCK: t->it.block = get_block(r); break;
+  case TLT_TOPO:  t->it.topo = get_topo(r, 0); break;
+  case TLT_INST:  t->it.inst = get_inst(r); break;
+  default:        r->err = 1; break;
+  }
+
+  return t;
+}
+
+
+
+// The sourced files must still resolve to what they did when the
+// entry was written and still hash the same.
+static int
+lp_cache_check_sources(struct lp_cache_rd *r) {
+  int c, n = get_len(r);
+
+  for(c = 0; c < n && !r->err; c++) {
+    char *cwd = get_str(r);
+    char *name = get_str(r);
+    char *path = get_str(r);
+    uint64_t h, want;
+    char *found;
+
+    get_bytes(r, &want, sizeof(want));
+    if(r->err) break;
+
+    found = lp_search_path(cwd, name);
+    if(!found || strcmp(found, path) || hash_file(&h, path) || h != want) {
+      free(found);
+      return -1;
+    }
+    free(found);
+  }
+
+  return r->err ? -1 : 0;
+}
+
+
+// Hands the top-level things to the application again, with
+// lp_filename and lp_cwd as the parser had them.
+static void
+lp_cache_replay(char *infile) {
+  char *top_cwd = lp_cwd;
+  char *src = 0;
+  int c;
+
+  for(c = 0; c < lp_tlts_len; c++) {
+    struct lp_tlt *t = lp_tlts[c];
+    if(!t) continue;
+
+    if(t->source_file != src) {
+      char *dirc = strdup(t->source_file);
+      src = t->source_file;
+      lp_filename = src;
+      lp_cwd = strdup(dirname(dirc));
+      free(dirc);
+    }
+
+    switch(t->what) {
+    case TLT_TOPO: load_topo(t->it.topo, 1); break;
+    case TLT_INST: lp_inst_list(t->it.inst); break;
+    default:       break;
+    }
+  }
+
+  lp_filename = infile;
+  lp_cwd = top_cwd;
+}
+
+
+// Called by lp_loadfile() before parsing <in>.  Returns nonzero if
+// the tree was restored from the cache and replayed, in which case
+// lp_tlts holds it and there is nothing left to parse.
+int
+lp_cache_load(FILE *in, char *infile) {
+  char path[LP_PATH_MAX];
+  struct lp_cache_rd r;
+  struct lp_tlt **tlts;
+  struct lp_subtype *types = 0;
+  int tlts_len, types_len;
+  uint64_t key;
+  char *echo;
+  int echo_len;
+  int magic, version;
+  int c;
+  FILE *f;
+
+  if(!lp_cache_dir_inited) {
+    char *dir = getenv("LP_CACHE");
+    lp_cache_dir_inited = 1;
+    if(dir && *dir) {
+      lp_cache_dir = strdup(dir);
+    }
+  }
+
+  lp_cache_reset();
+  if(!lp_cache_dir || !lp_cache_typetbl_clean()) return 0;
+  if(lp_cache_compute_key(in, infile)) return 0;
+  lp_cache_keyed = 1;
+
+  lp_cache_filename(path, sizeof(path));
+  f = fopen(path, "rb");
+  if(!f) return 0;
+
+  memset(&r, 0, sizeof(r));
+  r.f = f;
+
+  magic = get_int(&r);
+  version = get_int(&r);
+  get_bytes(&r, &key, sizeof(key));
+  if(r.err || magic != LP_CACHE_MAGIC || version != LP_CACHE_VERSION
+     || key != lp_cache_key || lp_cache_check_sources(&r))
+  {
+    goto out;
+  }
+
+  echo_len = get_len(&r);
+  echo = malloc(echo_len + 1);
+  get_bytes(&r, echo, echo_len);
+
+  tlts_len = get_len(&r);
+  tlts = calloc(tlts_len ? tlts_len : 1, sizeof(*tlts));
+  for(c = 0; c < tlts_len; c++) {
+    tlts[c] = get_tlt(&r);
+  }
+
+  types_len = get_len(&r);
+  types = calloc(types_len ? types_len : 1, sizeof(*types));
+  for(c = 0; c < types_len; c++) {
+    types[c].sub = get_str(&r);
+    types[c].super = get_str(&r);
+    types[c].spec = get_block(&r);
+    if(!types[c].sub || !types[c].super) r.err = 1;
+  }
+
+  if(r.err) {
+    free(echo);
+    goto out;
+  }
+
+  // everything's been read; now it's safe to touch the type table
+  for(c = 0; c < types_len; c++) {
+    int n;
+    lp_add_type(types[c].sub, types[c].super);
+    lp_lookup_type(types[c].sub, &n);
+    lp_typetbl[n]->spec = types[c].spec;
+  }
+
+  lp_tlts = tlts;
+  lp_tlts_len = tlts_len;
+
+  lp_cache_echo_tlts = tlts;
+  lp_cache_echo_infile = strdup(infile);
+  lp_cache_echo_buf = echo;
+  lp_cache_echo_len = echo_len;
+
+  lp_cache_replay(infile);
+
+ out:
+  free(types);
+  free(r.objs);
+  fclose(f);
+  return lp_cache_echo_tlts != 0;
+}
+
+
+// Renders the echo of the tree just parsed into memory.
+static int
+lp_cache_render_echo(char *infile) {
+  FILE *tmp = tmpfile();
+  long len;
+
+  if(!tmp) return -1;
+
+  lp_unparse_tlts(lp_tlts, lp_tlts_len, tmp, infile);
+  len = ftell(tmp);
+  rewind(tmp);
+
+  if(len < 0 || len > LP_CACHE_MAXLEN) {
+    fclose(tmp);
+    return -1;
+  }
+
+  lp_cache_echo_buf = malloc(len + 1);
+  lp_cache_echo_len = len;
+  if(len && fread(lp_cache_echo_buf, len, 1, tmp) != 1) {
+    free(lp_cache_echo_buf);
+    lp_cache_echo_buf = 0;
+    fclose(tmp);
+    return -1;
+  }
+
+  fclose(tmp);
+  lp_cache_echo_tlts = lp_tlts;
+  lp_cache_echo_infile = strdup(infile);
+  return 0;
+}
+
+
+// Called by lp_loadfile() after <infile> parsed cleanly.  Writes the
+// entry to a temporary and renames it so concurrent runs in a sweep
+// never see a partial one.
+void
+lp_cache_save(char *infile) {
+  char path[LP_PATH_MAX];
+  char tmppath[LP_PATH_MAX + 16];
+  struct lp_cache_wr w;
+  struct lp_cache_src *s;
+  int c, n;
+
+  if(!lp_cache_keyed) return;
+  lp_cache_keyed = 0;
+
+  // a block was defined over a module's own name; leave it alone
+  for(c = 0; c < lp_max_mod && c < lp_typetbl_len; c++) {
+    if(lp_typetbl[c] && lp_typetbl[c]->spec) return;
+  }
+
+  if(lp_cache_render_echo(infile)) return;
+
+  lp_cache_filename(path, sizeof(path));
+  snprintf(tmppath, sizeof(tmppath), "%s.%d", path, (int)getpid());
+
+  memset(&w, 0, sizeof(w));
+  w.f = fopen(tmppath, "wb");
+  if(!w.f) {
+    fprintf(stderr, "*** warning: can't write parse cache %s: %s\n",
+	    tmppath, strerror(errno));
+    return;
+  }
+
+  put_int(&w, LP_CACHE_MAGIC);
+  put_int(&w, LP_CACHE_VERSION);
+  put_bytes(&w, &lp_cache_key, sizeof(lp_cache_key));
+
+  for(n = 0, s = lp_cache_srcs; s; s = s->next) n++;
+  put_int(&w, n);
+  for(s = lp_cache_srcs; s; s = s->next) {
+    uint64_t h;
+    if(hash_file(&h, s->path)) w.err = 1;
+    put_str(&w, s->cwd);
+    put_str(&w, s->name);
+    put_str(&w, s->path);
+    put_bytes(&w, &h, sizeof(h));
+  }
+
+  put_int(&w, lp_cache_echo_len);
+  put_bytes(&w, lp_cache_echo_buf, lp_cache_echo_len);
+
+  put_int(&w, lp_tlts_len);
+  for(c = 0; c < lp_tlts_len; c++) {
+    put_tlt(&w, lp_tlts[c]);
+  }
+
+  // the subtypes this file defined, in the order it defined them
+  for(n = 0, c = lp_max_mod; c < lp_typetbl_len; c++) {
+    if(lp_typetbl[c]) n++;
+  }
+  put_int(&w, n);
+  for(c = lp_max_mod; c < lp_typetbl_len; c++) {
+    if(!lp_typetbl[c]) continue;
+    put_str(&w, lp_typetbl[c]->sub);
+    put_str(&w, lp_typetbl[c]->super);
+    put_block(&w, lp_typetbl[c]->spec);
+  }
+
+  free(w.keys);
+  free(w.ids);
+
+  c = (fclose(w.f) == 0) && !w.err;
+  if(!c || rename(tmppath, path)) {
+    remove(tmppath);
+  }
+}
+
+
+// lp_unparse_tlts() calls this first; returns nonzero if it wrote
+// the saved echo of <tlts>.
+int
+lp_cache_echo(struct lp_tlt **tlts, FILE *outfile, char *infile) {
+  if(!lp_cache_echo_tlts || tlts != lp_cache_echo_tlts) return 0;
+  if(!infile || strcmp(infile, lp_cache_echo_infile)) return 0;
+
+  fwrite(lp_cache_echo_buf, lp_cache_echo_len, 1, outfile);
+  return 1;
+}
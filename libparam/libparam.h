@@ -381,6 +381,12 @@ char *lp_search_path(char *cwd, char *name);
 
 int lp_inst_list(struct lp_inst *i);
 
+// parse tree cache (cache.c); see LP_CACHE in the DOC
+int lp_cache_load(FILE *in, char *infile);
+void lp_cache_save(char *infile);
+void lp_cache_note_source(char *cwd, char *name, char *path);
+int lp_cache_echo(struct lp_tlt **tlts, FILE *outfile, char *infile);
+
 int dumb_split(char *s, char **t, int *i);
     
 
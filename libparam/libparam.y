@@ -229,9 +229,7 @@ EXPS: { $$.p = 0; $$.plen = 0; }
   for(c = 0; c < $1->values_len; c++) {
     if(!$1->values[c]) continue;
     ddbg_assert($1->values[c]->t == S);
-    tmp = malloc(sizeof(struct lp_param));
-    tmp->name = $1->values[c]->v.s;
-    tmp->v = $3;
+    tmp = lp_new_param($1->values[c]->v.s, 0, $3);
     if(lp_add_param(&($$.p), &($$.plen), tmp)) YYABORT;
   }
 
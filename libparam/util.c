@@ -98,7 +98,7 @@ int dumb_split(char *s, char **t, int *i);
 int dumb_split2(char *s, char **s1, char **s2);
 
 
-static int lp_max_mod = 0;
+int lp_max_mod = 0;  // also used by cache.c
 static int lp_mod_size = 0;
 struct lp_mod **lp_modules = 0;
 
@@ -549,6 +549,9 @@ void lp_unparse_tlts(struct lp_tlt **tlts,
 		     char *infile) 
 {
   int c;
+
+  if(lp_cache_echo(tlts, outfile, infile)) return;
+
   for(c = 0; c < tlts_len; c++) {
     if(tlts[c] != 0) {
       unparse_tlt(tlts[c], outfile, infile);
@@ -1187,7 +1190,7 @@ int *lp_override_inst(struct lp_block *spec,
 }
 
 
-extern void libparamparse(void);
+extern int libparamparse(void);
 
 int lp_loadfile(FILE *in, 
 		struct lp_tlt ***tlts, 
@@ -1202,6 +1205,7 @@ int lp_loadfile(FILE *in,
   
   int stdout_save;
   int devnull;
+  int rv = 0;
   top_file = 0;
   lp_lineno = 1;
 
@@ -1270,7 +1274,12 @@ int lp_loadfile(FILE *in,
   dup2(devnull, 1);
 #endif
 
-  libparamparse();
+  if(!lp_cache_load(in, infile)) {
+    rv = libparamparse();
+    if(!rv) {
+      lp_cache_save(infile);
+    }
+  }
 
   fflush(stdout);
 
@@ -6,11 +6,191 @@
  *
  * FIXME: This is by no means a good/comprehensive way to account
  * for block buffering, but it works for quick comparisons with disks.
+ *
+ * Segments live on two structures at once: a doubly-linked LRU list
+ * (dev->seglist is the most recently used end, dev->segtail the least)
+ * and an interval index over [startblkno, endblkno].  The index is a
+ * treap keyed by (startblkno, id) and augmented with the largest
+ * endblkno in each subtree, so a lookup only visits the segments that
+ * could contain the block it is looking for.  Every use of a segment
+ * gives it a fresh stamp, which lets a lookup that finds several
+ * candidates pick the one nearest the head of the LRU list -- the same
+ * segment the old linear walk would have found first.
  ************************************************************************/
 
+static int
+seg_before (struct mems_segment *a,
+	    struct mems_segment *b)
+{
+  return ((a->startblkno < b->startblkno) ||
+	  ((a->startblkno == b->startblkno) && (a->id < b->id)));
+}
+
+static void
+seg_fix (struct mems_segment *s)
+{
+  s->maxend = s->endblkno;
+  if (s->left && (s->left->maxend > s->maxend))
+    s->maxend = s->left->maxend;
+  if (s->right && (s->right->maxend > s->maxend))
+    s->maxend = s->right->maxend;
+}
+
+/* Splits t into the segments before key (*l) and the rest (*r). */
+static void
+seg_split (struct mems_segment *t,
+	   struct mems_segment *key,
+	   struct mems_segment **l,
+	   struct mems_segment **r)
+{
+  if (!t)
+    {
+      *l = *r = NULL;
+      return;
+    }
+  if (seg_before(t, key))
+    {
+      seg_split(t->right, key, &t->right, r);
+      *l = t;
+    }
+  else
+    {
+      seg_split(t->left, key, l, &t->left);
+      *r = t;
+    }
+  seg_fix(t);
+}
+
+/* Joins two treaps; everything in a sorts before everything in b. */
+static struct mems_segment *
+seg_merge (struct mems_segment *a,
+	   struct mems_segment *b)
+{
+  if (!a) return b;
+  if (!b) return a;
+  if (a->prio > b->prio)
+    {
+      a->right = seg_merge(a->right, b);
+      seg_fix(a);
+      return a;
+    }
+  b->left = seg_merge(a, b->left);
+  seg_fix(b);
+  return b;
+}
+
+static struct mems_segment *
+seg_index_insert (struct mems_segment *t,
+		  struct mems_segment *seg)
+{
+  if (!t) return seg;
+  if (seg->prio > t->prio)
+    {
+      seg_split(t, seg, &seg->left, &seg->right);
+      seg_fix(seg);
+      return seg;
+    }
+  if (seg_before(seg, t))
+    t->left = seg_index_insert(t->left, seg);
+  else
+    t->right = seg_index_insert(t->right, seg);
+  seg_fix(t);
+  return t;
+}
+
+static struct mems_segment *
+seg_index_remove (struct mems_segment *t,
+		  struct mems_segment *seg)
+{
+  if (t == seg) return seg_merge(t->left, t->right);
+  if (seg_before(seg, t))
+    t->left = seg_index_remove(t->left, seg);
+  else
+    t->right = seg_index_remove(t->right, seg);
+  seg_fix(t);
+  return t;
+}
+
+/* Changes the block range held by seg, keeping the index in order. */
+static void
+seg_set_range (struct mems_segment *seg,
+	       int startblkno,
+	       int endblkno,
+	       mems_t *dev)
+{
+  dev->segroot = seg_index_remove(dev->segroot, seg);
+  seg->startblkno = startblkno;
+  seg->endblkno = endblkno;
+  seg->left = seg->right = NULL;
+  seg_fix(seg);
+  dev->segroot = seg_index_insert(dev->segroot, seg);
+}
+
+static void
+seg_stab (struct mems_segment *t,
+	  int blk,
+	  int minend,
+	  struct mems_segment **best)
+{
+  while (t && (t->maxend >= minend))
+    {
+      seg_stab(t->left, blk, minend, best);
+      if (t->startblkno > blk) return;
+      if ((t->endblkno >= minend) && (!*best || (t->stamp > (*best)->stamp)))
+	*best = t;
+      t = t->right;
+    }
+}
+
+/* Returns the most recently used segment with startblkno <= blk and
+ * endblkno >= minend, or NULL if there is none. */
+static struct mems_segment *
+mems_buffer_lookup (int blk,
+		    int minend,
+		    mems_t *dev)
+{
+  struct mems_segment *best = NULL;
+
+  seg_stab(dev->segroot, blk, minend, &best);
+  return best;
+}
+
+void
+mems_buffer_initialize (mems_t *dev)
+{
+  struct mems_segment *seg;
+  int k;
+
+  if ((dev->numsegs > 0) && (dev->seglist == NULL)) {
+    dev->segtail = NULL;
+    dev->segroot = NULL;
+    for (k = 0; k < dev->numsegs; k++) {
+      seg = (struct mems_segment *)DISKSIM_malloc(sizeof(struct mems_segment));
+      seg->time = 0.0;
+      seg->startblkno = 0;
+      seg->endblkno   = 0;
+      seg->id = k;
+      seg->stamp = k + 1;
+      seg->prio = (unsigned int)(k + 1) * 2654435761u;
+      seg->left = seg->right = NULL;
+      seg_fix(seg);
+      seg->prev = NULL;
+      seg->next = dev->seglist;
+      if (dev->seglist)
+	dev->seglist->prev = seg;
+      else
+	dev->segtail = seg;
+      dev->seglist = seg;
+      dev->segroot = seg_index_insert(dev->segroot, seg);
+    }
+    dev->segclock = dev->numsegs;
+  }
+  if (dev->numsegs == 0) addlisttoextraq((event **)&dev->seglist);
+}
+
 void
 move_segment_to_head (struct mems_segment *tmpseg,
-		      mems_t *dev) 
+		      mems_t *dev)
 {
   if ((dev->numsegs > 1) && (tmpseg != dev->seglist))
     {
@@ -19,11 +199,26 @@ move_segment_to_head (struct mems_segment *tmpseg,
 	{
 	  tmpseg->next->prev = tmpseg->prev;
 	}
+      else
+	{
+	  dev->segtail = tmpseg->prev;
+	}
 
       tmpseg->next = dev->seglist;
       dev->seglist = tmpseg;
       tmpseg->next->prev = tmpseg;
       tmpseg->prev = NULL;
+
+      tmpseg->stamp = ++dev->segclock;
+      if (dev->segclock == 0)
+	{
+	  /* The clock wrapped; renumber the segments in LRU order */
+	  struct mems_segment *seg;
+	  for (seg = dev->segtail; seg; seg = seg->prev)
+	    {
+	      seg->stamp = ++dev->segclock;
+	    }
+	}
     }
 }
 
@@ -42,29 +237,39 @@ mems_buffer_check (int firstblock,
 
   /* For each block in the range [firstblock,lastblock], check to
    * see if the block is cached.  If ALL blocks are cached, return
-   * success.
-   *
-   * This looks convoluted but really isn't. */
+   * success.  Each step follows the most recently used segment
+   * holding the next uncovered block. */
 
-  seg = dev->seglist;
-  while (seg)
+  while ((seg = mems_buffer_lookup(blk, blk + 1, dev)) != NULL)
     {
-      if ((blk >= seg->startblkno && blk < seg->endblkno))
+      blk = seg->endblkno;
+      move_segment_to_head(seg, dev);
+      if (blk >= lastblock)
 	{
-	  blk = seg->endblkno;
-	  move_segment_to_head(seg, dev);	/* seg points to head of list */
-	  if (blk >= lastblock)
-	    {
-	      dev->stat.num_buffer_hits++;
-	      return 1;
-	    }
+	  dev->stat.num_buffer_hits++;
+	  return 1;
 	}
-      seg = seg->next;	/* seg now points to second element in list */
     }
 
   return 0;	/* Failure */
 }
 
+/* Puts [firstblock,lastblock] in the least recently used segment,
+ * without trying to append it to a segment that already holds the
+ * preceding blocks. */
+void
+mems_buffer_replace (int firstblock,
+		     int lastblock,
+		     mems_t *dev)
+{
+  struct mems_segment *seg = dev->segtail;
+
+  if (!dev->numsegs) return;
+
+  move_segment_to_head(seg, dev);
+  seg_set_range(seg, firstblock, lastblock, dev);
+}
+
 void
 mems_buffer_insert (int firstblock,
 		    int lastblock,
@@ -81,16 +286,12 @@ mems_buffer_insert (int firstblock,
 	     lastblock, firstblock, (lastblock - firstblock + 1), dev->segsize);
     }
   assert((lastblock - firstblock + 1) <= dev->segsize);
-  
+
   /* First, check if any segments contain firstblock, or if firstblock
    * is the "next" block for a segment.  For example, if a segment
    * contains blocks 10--20, then firstblock==[10,21] matches the
    * segment. */
-  for (seg = dev->seglist; seg; seg = seg->next)
-    {
-      if ((firstblock >= seg->startblkno) && 
-	  (firstblock <= (seg->endblkno + 1))) break;
-    }
+  seg = mems_buffer_lookup(firstblock, firstblock - 1, dev);
   if (seg)
     {
       /* If the segment already contains firstblock--lastblock,
@@ -100,33 +301,32 @@ mems_buffer_insert (int firstblock,
 	  move_segment_to_head(seg, dev);
 	  return;
 	}
-      
+
       /* Else, add these blocks to the segment.  If we fill up the segment
        * while doing this, we move this segment to the front, then skip
        * to below to put the rest of the blocks in the LRU segment. */
       if ((seg->endblkno - seg->startblkno + 1) < dev->segsize)
 	{
+	  int endblkno = seg->endblkno;
+
 	  move_segment_to_head(seg, dev);
 	  for (blk = firstblock; blk <= lastblock; blk++)
 	    {
-	      if (seg->endblkno < blk)
+	      if (endblkno < blk)
 		{
-		  seg->endblkno = blk;
-		  if ((seg->endblkno - seg->startblkno + 1) >= dev->segsize)
+		  endblkno = blk;
+		  if ((endblkno - seg->startblkno + 1) >= dev->segsize)
 		    break;
 		}
 	    }
+	  seg_set_range(seg, seg->startblkno, endblkno, dev);
 	  if (blk >= lastblock) return;
 	}
     }
 
   /* If we reach here, there are still blocks to put in the buffer.
    * Find the LRU segment, and put the remaining blocks there. */
-  seg = dev->seglist;
-  while (seg->next) seg = seg->next;
-  move_segment_to_head(seg, dev);
-  seg->startblkno = blk;
-  seg->endblkno = lastblock;
+  mems_buffer_replace(blk, lastblock, dev);
 
   return;
 }
@@ -3,6 +3,9 @@
 
 #include "mems_global.h"
 
+void
+mems_buffer_initialize (mems_t *dev);
+
 void
 move_segment_to_head (struct mems_segment *tmpseg,
 		      mems_t *dev);
@@ -17,4 +20,9 @@ mems_buffer_insert (int firstblock,
 		    int lastblock,
 		    mems_t *dev);
 
+void
+mems_buffer_replace (int firstblock,
+		     int lastblock,
+		     mems_t *dev);
+
 #endif
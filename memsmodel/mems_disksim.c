@@ -41,6 +41,7 @@
 #include "mems_global.h"
 #include "mems_internals.h"
 #include "mems_mapping.h"
+#include "mems_buffer.h"
 #include "disksim_ioqueue.h"	/* Provides ioqueue_cleanstats() */
 #include "disksim_bus.h"	/* Provides bus_get_transfer_time() */
 
@@ -199,8 +200,8 @@ mems_get_seektime (int devno, ioreq_event *req, int checkcache, double maxtime)
   // fprintf(stderr, "Entering mems_get_seektime()\n");
 
   mems_lbn_to_position(req->blkno, sled, &up, &dn, &tipset, NULL, NULL, NULL);
-  up_time = mems_seek_time(sled, &sled->pos, &up.servo_start, NULL, NULL, NULL, NULL);
-  dn_time = mems_seek_time(sled, &sled->pos, &dn.servo_start, NULL, NULL, NULL, NULL);
+  up_time = mems_seek_time_seekcache(sled, &sled->pos, &up.servo_start, NULL, NULL, NULL, NULL);
+  dn_time = mems_seek_time_seekcache(sled, &sled->pos, &dn.servo_start, NULL, NULL, NULL, NULL);
   return min(up_time, dn_time);
 }
 
@@ -1235,6 +1236,7 @@ struct mems *memsmodel_mems_loadparams(struct lp_block *b,
   result = malloc(sizeof(mems_t));
   if(!result) return 0;
   bzero(result, sizeof(mems_t));
+  result->writecomb = 1;
 
   ((struct device_header *)result)->device_type = DEVICETYPE_MEMS;
 
@@ -1315,7 +1317,6 @@ mems_initialize (void)
 {
   int i;
   int j;
-  int k;
   mems_t *dev;
 
   if (disksim->memsinfo == NULL) return;
@@ -1333,24 +1334,7 @@ mems_initialize (void)
       dev->dataxfer_queue = NULL;
 
       /* Segment initialization stuff taken in part from disksim_disk.c */
-      if ((dev->numsegs > 0) && (dev->seglist == NULL)) {
-	dev->seglist = (struct mems_segment *)DISKSIM_malloc(sizeof(struct mems_segment));
-	dev->seglist->next = NULL;
-	dev->seglist->prev = NULL;
-	dev->seglist->time = 0.0;
-	dev->seglist->startblkno = 0;
-	dev->seglist->endblkno   = 0;
-	for (k = 1; k < dev->numsegs; k++) {
-	  struct mems_segment *tmpseg = (struct mems_segment *)DISKSIM_malloc(sizeof(struct mems_segment));
-	  tmpseg->next = dev->seglist;
-	  dev->seglist = tmpseg;
-	  tmpseg->next->prev = tmpseg;
-	  tmpseg->prev = NULL;
-	  tmpseg->startblkno = 0;
-	  tmpseg->endblkno   = 0;
-	}
-      }
-      if (dev->numsegs == 0) addlisttoextraq((event **)&dev->seglist);
+      mems_buffer_initialize(dev);
 
       mems_check_numblocks(dev);
 
@@ -1368,12 +1352,16 @@ mems_initialize (void)
 	/* Initialize sled position, velocity at centermost LBN */
 	mems_lbn_to_position(dev->sled[j].lastreq_lbn, &dev->sled[j], &dev->sled[j].coordset_up, &dev->sled[j].coordset_dn, &dev->sled[j].tipset, NULL, NULL, NULL);
 	mems_coord_t_copy(&dev->sled[j].coordset_up.servo_start, &dev->sled[j].pos);
+	mems_seekcache_init(&dev->sled[j], (dev->seekcache_size > 0) ? dev->seekcache_size : MEMS_SEEKCACHE);
 
       }
       mems_statinit(i, TRUE);
       if (dev->precompute_seek_count > 0) {
 	mems_precompute_seek_curve(dev);
       }
+      if ((dev->seek_table_points > 0) && (dev->seek_table_x == NULL)) {
+	mems_precompute_seek_table(dev);
+      }
     }
   }
 }
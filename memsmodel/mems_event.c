@@ -175,7 +175,7 @@ mems_bus_delay_complete (int devno,
 
   if (depth == 0)
     {
-      intr_request ((event *)curr);
+      bus_interrupt_host (curr);
     }
   else
     {
@@ -205,6 +205,7 @@ mems_get_new_extent(ioreq_event *curr)
   new_extent->request = curr;
   new_extent->next_block_start = -1;
   new_extent->next_block_end = -1;
+  new_extent->readahead_end = -1;
 
   return new_extent;
 }
@@ -353,6 +354,63 @@ mems_get_prefetch_info (ioreq_event *curr)
 }
 
 
+/* Extends the sweep that finishes each read extent with the sectors
+ * that follow it at the same sled position, as long as there are tips
+ * left over.  Those sectors come off the media at no extra cost and are
+ * put in the buffer along with the requested data. */
+static void
+mems_schedule_readahead (mems_sled_t *sled,
+			 mems_reqinfo_t *reqinfo)
+{
+  mems_t *dev = sled->dev;
+  mems_extent_t *extent_ptr = reqinfo->extents;
+  tipsector_coord_set_t tmp_coordset_up, tmp_coordset_dn;
+  struct tipset tmp_tipset;
+  int extent;
+  int block;
+  int lastblock;
+
+  for (extent = 0; extent < reqinfo->num_extents; extent++)
+    {
+      extent_ptr->readahead_end = -1;
+      if ((dev->readahead > 0) &&
+	  (dev->numsegs > 0) &&
+	  (extent_ptr->request->flags & READ) &&
+	  (extent_ptr->media_done == FALSE) &&
+	  (extent_ptr->next_block_end == extent_ptr->lastblock))
+	{
+	  lastblock = min((extent_ptr->lastblock + dev->readahead),
+			  (extent_ptr->next_block_start + dev->segsize - 1));
+	  lastblock = min(lastblock, (dev->numblocks - 1));
+	  for (block = extent_ptr->lastblock + 1; block <= lastblock; block++)
+	    {
+	      if (mems_lbn_to_sled(dev, block) != sled)
+		{
+		  break;
+		}
+	      mems_lbn_to_position(block,
+				   sled,
+				   &tmp_coordset_up,
+				   &tmp_coordset_dn,
+				   &tmp_tipset,
+				   NULL, NULL, NULL);
+	      if ((mems_equal_coord_sets(&sled->coordset_up,
+					 &tmp_coordset_up) == FALSE) ||
+		  (sled->tipset.num_tips + tmp_tipset.num_tips
+		   >
+		   sled->tips_simultaneous))
+		{
+		  break;
+		}
+	      sled->tipset.num_tips += tmp_tipset.num_tips;
+	      extent_ptr->readahead_end = block;
+	    }
+	}
+      extent_ptr = extent_ptr->next;
+    }
+}
+
+
 static void
 send_disconnect (ioreq_event *curr,
 		 double latency)
@@ -704,7 +762,10 @@ mems_device_overhead_complete(ioreq_event *curr)
 	      addtointq((event *)busreq);
 	      reqinfo->bus_pending = TRUE;
 	    }
-	    addtoextraq((event *)curr);  // I think curr gets freed later...
+	    /* As with a sled's active request, the bus copy now owns
+	     * the reqinfo; curr stays on the extent until the bus
+	     * completion frees it. */
+	    curr->mems_reqinfo = NULL;
 	    return;
 	  }
 
@@ -1097,6 +1158,10 @@ mems_sled_schedule(ioreq_event *curr)
 	    }
 	  extent_ptr = extent_ptr->next;
 	}
+
+      /* Read ahead into the buffer on any tips this sweep leaves idle */
+      mems_schedule_readahead(sled, reqinfo);
+
       /* If we've started prefetching, update prefetch info */
       /*
 	if (reqinfo->next_block_end > reqinfo->lastblock) {
@@ -1439,8 +1504,16 @@ mems_sled_update(ioreq_event *curr)
 	  extent_ptr->completed_block_media = extent_ptr->next_block_end;
 	  /* BUFFER - insert the blocks into the buffer */
 	  if (extent_ptr->request->flags & READ) {
+	    int endblkno = extent_ptr->next_block_end;
+	    if (extent_ptr->readahead_end > endblkno) {
+	      stat_update(&sled->stat.prefetched_blocks,
+			  (extent_ptr->readahead_end - endblkno));
+	      stat_update(&sled->dev->stat.prefetched_blocks,
+			  (extent_ptr->readahead_end - endblkno));
+	      endblkno = extent_ptr->readahead_end;
+	    }
 	    mems_buffer_insert(extent_ptr->next_block_start, 
-			       extent_ptr->next_block_end, sled->dev);      
+			       endblkno, sled->dev);      
 	  }
 	  
 	  // if this extent is a read and the bus is not pending,
@@ -1702,8 +1775,14 @@ mems_bus_update(ioreq_event *curr)
 
   /* BUFFER - insert blocks into buffer */
   if (!isread) {
-    mems_buffer_insert(bus_extent->completed_block_bus,
-                       bus_extent->completed_block_bus, dev);
+    if (!dev->writecomb &&
+	(bus_extent->completed_block_bus == bus_extent->firstblock)) {
+      mems_buffer_replace(bus_extent->completed_block_bus,
+			  bus_extent->completed_block_bus, dev);
+    } else {
+      mems_buffer_insert(bus_extent->completed_block_bus,
+			 bus_extent->completed_block_bus, dev);
+    }
   }
 
 #ifdef VERBOSE_EVENTLOOP
@@ -38,7 +38,8 @@
 #include "disksim_stat.h"
 
 #define MEMS_MAXSLEDS		9
-#define MEMS_SEEKCACHE		2	/* Number of entries in seekcache */
+#define MEMS_SEEKCACHE		1024	/* Default number of entries in seekcache */
+#define MEMS_SEEKCACHE_WAYS	4	/* Associativity of seekcache */
 
 #define getmems(d) (disksim->memsinfo->devices[d])
 
@@ -88,15 +89,22 @@ struct mems_seekcache {
   double  y_seek_time;		/* stat returned for Y seek time */
   double  turnaround_time;	/* stat returned for turnaround time */
   int     turnaround_number;	/* stat returned for num turnarounds */
+  unsigned int stamp;		/* time of last use (0 if entry is empty) */
 };
 
 
 struct mems_segment {
   double time;
-  struct mems_segment *next;
+  struct mems_segment *next;	/* LRU list, most recently used first */
   struct mems_segment *prev;
   int    startblkno;
   int    endblkno;
+  int    id;			/* Tie-breaker for equal start blocks */
+  unsigned int stamp;		/* Time of last use (larger is more recent) */
+  unsigned int prio;		/* Heap priority in the interval index */
+  int    maxend;		/* Largest endblkno in this subtree */
+  struct mems_segment *left;	/* Interval index, keyed by startblkno */
+  struct mems_segment *right;
 };
 
 
@@ -185,8 +193,9 @@ typedef struct {
 			 * memsdevice_mapping.c  */
 
   /* Variables used by mems_seek_time_seekcache */
-  struct mems_seekcache seekcache[MEMS_SEEKCACHE];
-  int seekcache_next;		/* Next available cache entry */
+  struct mems_seekcache *seekcache;	/* Set-associative result cache */
+  int seekcache_sets;		/* Number of sets (a power of two) */
+  unsigned int seekcache_clock;	/* Use counter for LRU replacement */
 
   double active_power_mw;	/* Per-sled power when sled active */
   double inactive_power_mw;	/* Per-sled power when sled inactive */
@@ -224,6 +233,11 @@ typedef struct mems {
   int numsegs;			/* Number of buffer segments */
   int segsize;			/* Segment size (in blks) */
   struct mems_segment *seglist;	/* Buffer segments */
+  struct mems_segment *segtail;	/* Least recently used segment */
+  struct mems_segment *segroot;	/* Root of the segment interval index */
+  unsigned int segclock;	/* Last stamp handed out to a segment */
+  int readahead;		/* Max blocks read ahead on spare tips */
+  int writecomb;		/* Sequential writes may share a segment */
 
   int seek_function;
 
@@ -232,6 +246,11 @@ typedef struct mems {
   double *precompute_x_seek_times; /* X seek times in precomputed seek curve */
   double *precompute_y_seek_times; /* Y seek times in precomputed seek curve */
 
+  int seekcache_size;		/* Entries in each sled's seek cache */
+  int seek_table_points;	/* Start positions (and distances) in the seek table */
+  double *seek_table_x;		/* X seek times by start position and distance */
+  double *seek_table_y;		/* Y seek times by start position and distance */
+
 } mems_t;
 
 
@@ -259,6 +278,7 @@ typedef struct mems_x {
   int completed_block_bus;
   int next_block_start;
   int next_block_end;
+  int readahead_end;	/* Last spare-tip block read with this sweep */
 
   int bus_done;
   int media_done;
@@ -474,7 +474,14 @@ mems_seek_time (mems_sled_t *sled,
 
     /*  find the base seek time in x  */
 
-    if (sled->dev->seek_function == MEMS_SEEK_HONG) {
+    if (sled->dev->seek_table_points > 0) {
+      seek_time_x =
+	mems_find_seek_table_time(sled,
+				  (begin->x_pos * bit_width), (end->x_pos * bit_width),
+				  _X_SEEK_)
+	+
+	settling_time_x;
+    } else if (sled->dev->seek_function == MEMS_SEEK_HONG) {
       seek_time_x = find_seek_time_hong_x((begin->x_pos * bit_width),
 					  (end->x_pos * bit_width),
 					  spring_factor, x_accel,
@@ -665,7 +672,14 @@ mems_seek_time (mems_sled_t *sled,
 	  y_begin_nm, y_end_nm);
   */
 
-  if (sled->dev->seek_function == MEMS_SEEK_HONG) {
+  if (sled->dev->seek_table_points > 0) {
+    seek_time_y =
+      mems_find_seek_table_time(sled,
+				(begin->y_pos * bit_width), (end->y_pos * bit_width),
+				_Y_SEEK_)
+      +
+      turnaround_time;
+  } else if (sled->dev->seek_function == MEMS_SEEK_HONG) {
     seek_time_y =
       find_seek_time_hong_y((begin->y_pos * bit_width),
 			    (end->y_pos * bit_width),
@@ -735,9 +749,41 @@ mems_seek_time (mems_sled_t *sled,
 }
 
 /*-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
- *  This implements the seek cache.
+ *  This implements the seek cache.  Seek results are kept in a
+ *  set-associative cache indexed by a hash of the begin and end
+ *  coordinates, with LRU replacement within each set.
  *-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-*/
 
+void
+mems_seekcache_init (mems_sled_t *sled, int entries)
+{
+  int sets = 1;
+
+  while ((sets * 2 * MEMS_SEEKCACHE_WAYS) <= entries) {
+    sets *= 2;
+  }
+  if (sled->seekcache != NULL) {
+    free(sled->seekcache);
+  }
+  sled->seekcache = (struct mems_seekcache *)calloc(sets * MEMS_SEEKCACHE_WAYS, sizeof(struct mems_seekcache));
+  sled->seekcache_sets = sets;
+  sled->seekcache_clock = 0;
+}
+
+static unsigned int
+mems_seekcache_hash (coord_t *begin, coord_t *end)
+{
+  unsigned int h = 2166136261u;
+
+  h = (h ^ (unsigned int)begin->x_pos) * 16777619u;
+  h = (h ^ (unsigned int)begin->y_pos) * 16777619u;
+  h = (h ^ (unsigned int)begin->y_vel) * 16777619u;
+  h = (h ^ (unsigned int)end->x_pos) * 16777619u;
+  h = (h ^ (unsigned int)end->y_pos) * 16777619u;
+  h = (h ^ (unsigned int)end->y_vel) * 16777619u;
+  return h ^ (h >> 16);
+}
+
 double
 mems_seek_time_seekcache (mems_sled_t *sled,
 			  coord_t *begin, 
@@ -747,32 +793,46 @@ mems_seek_time_seekcache (mems_sled_t *sled,
 			  double *return_turnaround_time,
 			  int *return_turnaround_number)
 {
+  struct mems_seekcache *set;
   struct mems_seekcache *s;
   int i;
 
+  if (sled->seekcache == NULL) {
+    mems_seekcache_init(sled, MEMS_SEEKCACHE);
+  }
+  set = &sled->seekcache[(mems_seekcache_hash(begin, end) & (sled->seekcache_sets - 1)) * MEMS_SEEKCACHE_WAYS];
+  if (++sled->seekcache_clock == 0) {
+    sled->seekcache_clock = 1;
+  }
+
   /* First check if value is cached */
-  for (i = 0; i < MEMS_SEEKCACHE; i++) {
-    s = &sled->seekcache[i];
-    if (mems_equal_coords(begin, &s->begin) &&
-	mems_equal_coords(end, &s->end)) {
+  s = &set[0];
+  for (i = 0; i < MEMS_SEEKCACHE_WAYS; i++) {
+    if ((set[i].stamp != 0) &&
+	mems_equal_coords(begin, &set[i].begin) &&
+	mems_equal_coords(end, &set[i].end)) {
+      s = &set[i];
+      s->stamp = sled->seekcache_clock;
       if (return_x_seek_time) *return_x_seek_time = s->x_seek_time;
       if (return_y_seek_time) *return_y_seek_time = s->y_seek_time;
       if (return_turnaround_time) *return_turnaround_time = s->turnaround_time;
       if (return_turnaround_number) *return_turnaround_number = s->turnaround_number;
       return s->time;
     }
+    if (set[i].stamp < s->stamp) {
+      s = &set[i];
+    }
   }
 
-  s = &sled->seekcache[sled->seekcache_next];
+  /* Otherwise replace the least recently used entry of the set */
   mems_coord_t_copy(begin, &s->begin);
   mems_coord_t_copy(end, &s->end);
   s->time = mems_seek_time(sled, &s->begin, &s->end, &s->x_seek_time, &s->y_seek_time, &s->turnaround_time, &s->turnaround_number);
+  s->stamp = sled->seekcache_clock;
   if (return_x_seek_time) *return_x_seek_time = s->x_seek_time;
   if (return_y_seek_time) *return_y_seek_time = s->y_seek_time;
   if (return_turnaround_time) *return_turnaround_time = s->turnaround_time;
   if (return_turnaround_number) *return_turnaround_number = s->turnaround_number;
-  sled->seekcache_next++;
-  if (sled->seekcache_next == MEMS_SEEKCACHE) sled->seekcache_next = 0;
   // fprintf(stderr, "mems_seek_time_seekcache::  s->time = %f\n", s->time);
   return s->time;
 }
@@ -1007,3 +1067,102 @@ mems_precompute_seek_curve(mems_t *dev) {
   dev->precompute_seek_count = precompute_seek_count;
 
 }
+
+
+/*-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+ *  These implement the pre-computed seek table.  Unlike the
+ *  seek curve above, which depends only on seek distance, the
+ *  table holds the seek time in each dimension for a grid of
+ *  start positions and (signed) distances, so that the effect of
+ *  the springs is kept.  Times in between are interpolated
+ *  linearly in both start position and distance.
+ *-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-*/
+
+static double
+mems_axis_seek_time(mems_sled_t *sled, double start_offset_nm, double end_offset_nm,
+		    int direction) {
+
+  double y_access_speed_nm_s = sled->y_access_speed_bit_s * sled->bit_length_nm;
+
+  if (start_offset_nm == end_offset_nm) {
+    return 0.0;
+  }
+  if (direction == _X_SEEK_) {
+    if (sled->dev->seek_function == MEMS_SEEK_HONG) {
+      return find_seek_time_hong_x(start_offset_nm, end_offset_nm,
+				   sled->spring_factor, sled->x_accel_nm_s2,
+				   sled->x_length_nm);
+    }
+    return find_seek_time_piecewise(start_offset_nm, end_offset_nm,
+				    sled->spring_factor, sled->x_accel_nm_s2,
+				    sled->x_length_nm, 0.0);
+  }
+  if (sled->dev->seek_function == MEMS_SEEK_HONG) {
+    return find_seek_time_hong_y(start_offset_nm, end_offset_nm,
+				 sled->spring_factor, sled->y_accel_nm_s2,
+				 sled->y_length_nm, y_access_speed_nm_s);
+  }
+  return find_seek_time_piecewise(start_offset_nm, end_offset_nm,
+				  sled->spring_factor, sled->y_accel_nm_s2,
+				  sled->y_length_nm, y_access_speed_nm_s);
+}
+
+void
+mems_precompute_seek_table(mems_t *dev) {
+
+  mems_sled_t *sled = &dev->sled[0];
+  int n = dev->seek_table_points;
+  int width = 2 * n + 1;
+  double x_length_nm = sled->x_length_nm;
+  double y_length_nm = sled->y_length_nm;
+  double start_nm, end_nm;
+  int i, j;
+
+  dev->seek_table_x = (double *)malloc((n + 1) * width * sizeof(double));
+  dev->seek_table_y = (double *)malloc((n + 1) * width * sizeof(double));
+
+  for (i = 0; i <= n; i++) {
+    for (j = -n; j <= n; j++) {
+      start_nm = (i * x_length_nm / n) - (x_length_nm / 2.0);
+      end_nm = min(max((start_nm + (j * x_length_nm / n)), -(x_length_nm / 2.0)), (x_length_nm / 2.0));
+      dev->seek_table_x[(i * width) + j + n] = mems_axis_seek_time(sled, start_nm, end_nm, _X_SEEK_);
+
+      start_nm = (i * y_length_nm / n) - (y_length_nm / 2.0);
+      end_nm = min(max((start_nm + (j * y_length_nm / n)), -(y_length_nm / 2.0)), (y_length_nm / 2.0));
+      dev->seek_table_y[(i * width) + j + n] = mems_axis_seek_time(sled, start_nm, end_nm, _Y_SEEK_);
+    }
+  }
+}
+
+double
+mems_find_seek_table_time(mems_sled_t *sled,
+			  double start_offset_nm, double end_offset_nm,
+			  int direction) {
+
+  mems_t *dev = sled->dev;
+  int n = dev->seek_table_points;
+  int width = 2 * n + 1;
+  double length_nm = (direction == _X_SEEK_) ? sled->x_length_nm : sled->y_length_nm;
+  double *table = (direction == _X_SEEK_) ? dev->seek_table_x : dev->seek_table_y;
+  double step = length_nm / n;
+  double fs = (start_offset_nm + (length_nm / 2.0)) / step;
+  double fd = (end_offset_nm - start_offset_nm) / step;
+  int i = (int)floor(fs);
+  int j = (int)floor(fd);
+  double row0, row1;
+
+  if (start_offset_nm == end_offset_nm) {
+    return 0.0;
+  }
+  i = min(max(i, 0), (n - 1));
+  j = min(max(j, -n), (n - 1));
+  fs -= i;
+  fd -= j;
+
+  table += (i * width) + j + n;
+  row0 = table[0] + fd * (table[1] - table[0]);
+  table += width;
+  row1 = table[0] + fd * (table[1] - table[0]);
+
+  return row0 + fs * (row1 - row0);
+}
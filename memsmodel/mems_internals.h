@@ -215,6 +215,15 @@ void mems_commit_move(mems_sled_t *sled,
 
 void mems_precompute_seek_curve(mems_t *dev);
 
+void mems_precompute_seek_table(mems_t *dev);
+
+double mems_find_seek_table_time(mems_sled_t *sled,
+				 double start_offset_nm,
+				 double end_offset_nm,
+				 int direction);
+
+void mems_seekcache_init(mems_sled_t *sled, int entries);
+
 double mems_find_precomputed_seek_time(mems_sled_t *sled,
 				       double start_offset_nm,
 				       double end_offset_nm,
@@ -101,7 +101,9 @@
 #include "disksim_global.h"
 #include "disksim_ioface.h"
 #include "disksim_pfface.h"
+#include "disksim_synthfast.h"
 #include "disksim_iotrace.h"
+#include "disksim_checkpoint.h"
 #include "config.h"
 
 #include "modules/disksim_global_param.h"
@@ -110,10 +112,10 @@
 #include <signal.h>
 #include <stdarg.h>
 
-#ifdef SUPPORT_CHECKPOINTS
+#ifndef _WIN32
 #include <unistd.h>
+#include <sys/wait.h>
 #include <fcntl.h>
-#include <sys/mman.h>
 #endif
 
 
@@ -493,12 +495,15 @@ void getparam_bool (FILE *parfile, char *parname, int *parptr)
 
 void resetstats ()
 {
-   if (disksim->external_control | disksim->synthgen | disksim->iotrace) {
+   if (disksim->external_control | disksim->synthgen | disksim->synthfast | disksim->iotrace) {
       io_resetstats();
    }
    if (disksim->synthgen) {
       pf_resetstats();
    }
+   if (disksim->synthfast) {
+      synthfast_resetstats();
+   }
 }
 
 
@@ -506,6 +511,9 @@ static void stat_warmup_done (timer_event *timer)
 {
    warmuptime = simtime;
    resetstats();
+   if (disksim->checkpoint_warmup) {
+      disksim_register_checkpoint(simtime);
+   }
    addtoextraq((event *)timer);
 }
 
@@ -541,7 +549,10 @@ void disksim_printstats2()
    if (disksim->synthgen) {
       pf_printstats();
    }
-   if (disksim->external_control | disksim->synthgen | disksim->iotrace) {
+   if (disksim->synthfast) {
+      synthfast_printstats();
+   }
+   if (disksim->external_control | disksim->synthgen | disksim->synthfast | disksim->iotrace) {
       io_printstats();
    }
 }
@@ -556,14 +567,23 @@ static void setcallbacks ()
    disksim->donefunc_ctlrsmart_write = NULL;
    disksim->donefunc_cachemem_empty = NULL;
    disksim->donefunc_cachedev_empty = NULL;
+   disksim->donefunc_cacheflash_empty = NULL;
    disksim->idlework_cachemem = NULL;
    disksim->idlework_cachedev = NULL;
+   disksim->idlework_cacheflash = NULL;
+   disksim->idlework_ssd = NULL;
    disksim->concatok_cachemem = NULL;
    disksim->enablement_disk = NULL;
    disksim->timerfunc_disksim = NULL;
    disksim->timerfunc_ioqueue = NULL;
    disksim->timerfunc_cachemem = NULL;
    disksim->timerfunc_cachedev = NULL;
+   disksim->timerfunc_ssd_wbuf = NULL;
+   disksim->timerfunc_logorg = NULL;
+   disksim->timerfunc_ctlrmq_engine = NULL;
+   disksim->timerfunc_ctlrmq_coalesce = NULL;
+   disksim->timerfunc_bus_deliver = NULL;
+   disksim->timerfunc_bus_coalesce = NULL;
 
    disksim->timerfunc_disksim = stat_warmup_done;
    disksim->external_io_done_notify = NULL;
@@ -581,7 +601,7 @@ static void initialize ()
    while (disksim->intq) {
       addtoextraq(getfromintq());
    }
-   if (disksim->external_control | disksim->synthgen | disksim->iotrace) {
+   if (disksim->external_control | disksim->synthgen | disksim->synthfast | disksim->iotrace) {
       io_initialize(val);
    }
    if (disksim->synthgen) {
@@ -589,18 +609,24 @@ static void initialize ()
    } else {
       DISKSIM_srand48(disksim->seedval);
    }
+   if (disksim->synthfast) {
+      synthfast_initialize();
+   }
    simtime = 0.0;
 }
 
 
 void disksim_cleanstats ()
 {
-   if (disksim->external_control | disksim->synthgen | disksim->iotrace) {
+   if (disksim->external_control | disksim->synthgen | disksim->synthfast | disksim->iotrace) {
       io_cleanstats();
    }
    if (disksim->synthgen) {
       pf_cleanstats();
    }
+   if (disksim->synthfast) {
+      synthfast_cleanstats();
+   }
 }
 
 
@@ -615,6 +641,10 @@ event *io_done_notify (ioreq_event *curr)
    if (disksim->synthgen) {
       return pf_io_done_notify(curr, 0);
    }
+   if (disksim->synthfast) {
+      synthfast_io_done_notify(curr);
+      return(NULL);
+   }
    if (disksim->external_control) {
       disksim->external_io_done_notify (curr, disksim->notify_ctx);
    }
@@ -631,7 +661,11 @@ getnextevent(void)
    if (curr) {
       simtime = curr->time;
 
-      if (curr->type == NULL_EVENT) {
+      if ((curr->type == NULL_EVENT) && (disksim->synthfast)) {
+	/* the generator schedules the stream's next arrival itself */
+	synthfast_request_arrive((ioreq_event *) curr);
+      }
+      else if (curr->type == NULL_EVENT) {
 	if ((disksim->iotrace) && io_using_external_event(curr)) {
 	  temp = io_get_next_external_event(disksim->iotracefile);
 	  if (!temp) {
@@ -662,44 +696,283 @@ getnextevent(void)
 }
 
 
+/* Checkpoints are only taken when nothing is in flight: no host */
+/* request outstanding and no events pending other than the next  */
+/* trace arrival and timers.  See disksim_checkpoint.c.           */
+
+static int disksim_quiescent (void)
+{
+   event *tmp;
+
+   if (io_get_number_outstanding() != 0) {
+      return(FALSE);
+   }
+   for (tmp = disksim->intq; tmp; tmp = tmp->next) {
+      if ((tmp->type != NULL_EVENT) && (tmp->type != TIMER_EXPIRED) &&
+          (tmp->type != CHECKPOINT) && (tmp->type != STOP_SIM)) {
+         return(FALSE);
+      }
+   }
+   return(TRUE);
+}
+
+
+static char *disksim_checkpoint_unsupported (void)
+{
+   if (disksim->iotrace == 0) {
+      return("the workload is not a trace");
+   }
+   if (strcmp(disksim->iotracefilename, "stdin") == 0) {
+      return("iotrace comes from stdin");
+   }
+   if ((disksim->traceformat == VALIDATE) || (disksim->closedios)) {
+      return("the trace is replayed closed-loop");
+   }
+   if (disksim->memsinfo) {
+      return("MEMS devices are not supported");
+   }
+   if (io_models_failure()) {
+      return("a logorg models a device failure");
+   }
+   return(NULL);
+}
+
+
+/* Branches: at the first checkpoint the warm state is captured once in */
+/* memory and the process forks one child per branch.  A child rebuilds */
+/* the configuration from the original command line plus its branch's   */
+/* overrides, overlays the warm state and carries on, writing to        */
+/* <outfile>.<branch>.  The parent continues unchanged as the baseline. */
+/* All of them report statistics from the branch point on.              */
+
+int disksim_load_branches (struct lp_list *l)
+{
+   int c, d;
+
+   disksim->branches = DISKSIM_malloc(l->values_len * sizeof(disksim_branch_t));
+   bzero(disksim->branches, l->values_len * sizeof(disksim_branch_t));
+   disksim->numbranches = 0;
+
+   for (c = 0; c < l->values_len; c++) {
+      struct lp_list *o;
+      disksim_branch_t *b;
+
+      if (!l->values[c]) continue;
+      if ((l->values[c]->t != LIST) || (l->values[c]->v.l->values_pop % 3)) {
+	 fprintf(stderr, "*** error: each branch must be a list of (component, parameter, value) triples\n");
+	 return 0;
+      }
+
+      o = l->values[c]->v.l;
+      b = &disksim->branches[disksim->numbranches++];
+      b->overrides = DISKSIM_malloc(o->values_pop * sizeof(char *));
+      for (d = 0; d < o->values_len; d++) {
+	 char buf[64];
+	 struct lp_value *v = o->values[d];
+
+	 if (!v) continue;
+	 switch (v->t) {
+	 case S: 
+	    b->overrides[b->overrides_len++] = strdup(v->v.s);
+	    break;
+	 case I:
+	    sprintf(buf, "%d", v->v.i);
+	    b->overrides[b->overrides_len++] = strdup(buf);
+	    break;
+	 case D:
+	    sprintf(buf, "%.17g", v->v.d);
+	    b->overrides[b->overrides_len++] = strdup(buf);
+	    break;
+	 default:
+	    fprintf(stderr, "*** error: branch overrides must be strings or numbers\n");
+	    return 0;
+	 }
+      }
+   }
+
+   return 1;
+}
+
+
+/* Per-run output files of a branch child get the branch number appended. */
+
+char * disksim_branch_filename (char *filename)
+{
+   char *name;
+
+   if (disksim->branchno == 0) {
+      return(filename);
+   }
+   name = DISKSIM_malloc(strlen(filename) + 16);
+   sprintf(name, "%s.%d", filename, disksim->branchno);
+   return(name);
+}
+
+
+#ifndef _WIN32
+
+static void disksim_branch_child (int branchno, char *image, long imagelen)
+{
+   disksim_t *parent = disksim;
+   disksim_branch_t *b = &parent->branches[branchno - 1];
+   int argc = parent->argc + b->overrides_len;
+   char **argv = DISKSIM_malloc((argc + 1) * sizeof(char *));
+   int c;
+
+   for (c = 0; c < parent->argc; c++) {
+      argv[c] = parent->argv[c];
+   }
+   for (c = 0; c < b->overrides_len; c++) {
+      argv[parent->argc + c] = b->overrides[c];
+   }
+   argv[argc] = NULL;
+
+   /* the inherited trace descriptor shares its offset with the parent */
+   /* and stdio seeks back over unread input when streams are closed,  */
+   /* so point it at /dev/null before anything can move the parent     */
+   if (parent->iotracefile) {
+      int fd = open("/dev/null", O_RDONLY);
+      if (fd >= 0) {
+	 dup2(fd, fileno(parent->iotracefile));
+	 close(fd);
+      }
+   }
+
+   /* the parent's state stays behind untouched (and shared until */
+   /* written); build a fresh simulator next to it                 */
+   disksim = calloc(1, sizeof(struct disksim));
+   disksim_initialize_disksim_structure(disksim);
+   disksim->branchno = branchno;
+   if ((disksim->branchimage = fmemopen(image, imagelen, "rb")) == NULL) {
+      fprintf(stderr, "*** error: branch %d: cannot read the branch point state\n", branchno);
+      exit(1);
+   }
+   argv[2] = disksim_branch_filename(argv[2]);
+
+   disksim_setup_disksim(argc, argv);
+
+   fclose(disksim->branchimage);
+   disksim->branchimage = NULL;
+}
+
+
+static void disksim_branch (void)
+{
+   FILE *file;
+   char *image;
+   long imagelen;
+   int i;
+
+   disksim->branched = TRUE;
+
+   if (((file = tmpfile()) == NULL) || (checkpoint_write_file(file, "branch point") != 0)) {
+      fprintf (outputfile, "Branching at simtime %f skipped because the state cannot be saved\n", simtime);
+      return;
+   }
+   imagelen = ftell(file);
+   image = DISKSIM_malloc(imagelen);
+   rewind(file);
+   if (fread(image, 1, imagelen, file) != (size_t) imagelen) {
+      fprintf (outputfile, "Branching at simtime %f skipped because the state cannot be saved\n", simtime);
+      fclose(file);
+      return;
+   }
+   fclose(file);
+
+   /* don't let children inherit (and later repeat) buffered output */
+   fflush(NULL);
+
+   for (i = 0; i < disksim->numbranches; i++) {
+      int pid = fork();
+      if (pid == 0) {
+	 disksim_branch_child(i + 1, image, imagelen);
+	 return;
+      }
+      if (pid < 0) {
+	 fprintf (stderr, "*** error: cannot fork branch %d\n", i + 1);
+	 break;
+      }
+      disksim->branches[i].pid = pid;
+   }
+   free(image);
+
+   fprintf (outputfile, "Branched %d variants at simtime %f\n", i, simtime);
+   warmuptime = simtime;
+   resetstats();
+}
+
+
+static void disksim_branch_wait (void)
+{
+   int i;
+
+   for (i = 0; i < disksim->numbranches; i++) {
+      int status;
+      if (disksim->branches[i].pid <= 0) {
+	 continue;
+      }
+      if ((waitpid(disksim->branches[i].pid, &status, 0) < 0) ||
+	  !WIFEXITED(status) || (WEXITSTATUS(status) != 0)) {
+	 fprintf (stderr, "*** error: branch %d did not complete\n", i + 1);
+      }
+   }
+}
+
+#else
+
+static void disksim_branch (void)
+{
+   disksim->branched = TRUE;
+   fprintf (outputfile, "Branching at simtime %f skipped because it is not supported on this platform\n", simtime);
+}
+
+
+static void disksim_branch_wait (void)
+{
+}
+
+#endif
+
+
 void disksim_checkpoint (char *checkpointfilename)
 {
-   FILE *checkpointfile;
+   int branch = (disksim->numbranches > 0) && (!disksim->branched);
+   char *why;
 
-//printf ("disksim_checkpoint: simtime %f, totalreqs %d\n", simtime, disksim->totalreqs);
    if (disksim->checkpoint_disable) {
       fprintf (outputfile, "Checkpoint at simtime %f skipped because checkpointing is disabled\n", simtime);
       return;
    }
-
-   if ((checkpointfile = fopen(checkpointfilename, "w")) == NULL) {
-      fprintf (outputfile, "Checkpoint at simtime %f skipped because checkpointfile cannot be opened for write access\n", simtime);
+   if ((!branch) && (checkpointfilename[0] == 0)) {
+      fprintf (outputfile, "Checkpoint at simtime %f skipped because no checkpoint file is given\n", simtime);
+      return;
+   }
+   if ((why = disksim_checkpoint_unsupported())) {
+      fprintf (outputfile, "Checkpoint at simtime %f skipped because %s\n", simtime, why);
+      return;
+   }
+   if (!disksim_quiescent()) {
+      /* try again after each event until everything has drained */
+      disksim->checkpoint_pending = TRUE;
       return;
    }
+   disksim->checkpoint_pending = FALSE;
 
-   if (disksim->iotracefile) {
-      if (strcmp (disksim->iotracefilename, "stdin") == 0) {
-         fprintf (outputfile, "Checkpoint at simtime %f skipped because iotrace comes from stdin\n", simtime);
-         return;
+   if (branch) {
+      disksim_branch();
+      if ((disksim->branchno) || (checkpointfilename[0] == 0)) {
+	 return;
       }
-      fflush (disksim->iotracefile);
-      fgetpos (disksim->iotracefile, &disksim->iotracefileposition);
    }
 
-   if (outios) {
-      fflush (outios);
-      fgetpos (outios, &disksim->outiosfileposition);
+   if (checkpoint_write(checkpointfilename) != 0) {
+      fprintf (outputfile, "Checkpoint at simtime %f skipped because %s cannot be written\n", simtime, checkpointfilename);
+      return;
    }
-
-   if (outputfile) {
-      fflush (outputfile);
-      fgetpos (outputfile, &disksim->outputfileposition);
+   fprintf (outputfile, "Checkpoint written at simtime %f, %d requests\n", simtime, disksim->totalreqs);
+   if (disksim->checkpoint_stop) {
+      disksim_simstop();
    }
-
-   rewind (checkpointfile);
-   fwrite (disksim, disksim->totallength, 1, checkpointfile);
-   fflush (checkpointfile);
-   fclose (checkpointfile);
 }
 
 
@@ -727,9 +1000,10 @@ static void prime_simulation ()
       disksim->warmup_event = NULL;
    }
    if (disksim->checkpoint_interval > 0.0) {
-      disksim_register_checkpoint (disksim->checkpoint_interval);
+      disksim_register_checkpoint (simtime + disksim->checkpoint_interval);
    }
-   if (disksim->iotrace) {
+   /* a restored checkpoint already holds the next trace arrival */
+   if ((disksim->iotrace) && (!disksim->checkpoint_restored)) {
       if ((curr = io_get_next_external_event(disksim->iotracefile)) == NULL) {
          disksim_cleanstats();
          return;
@@ -818,6 +1092,7 @@ void disksim_simulate_event (int num)
       if (disksim->checkpoint_interval) {
 	disksim_register_checkpoint(simtime + disksim->checkpoint_interval);
       }
+      addtoextraq(curr);
       disksim_checkpoint (disksim->checkpointfilename);
     } 
     else if (curr->type == STOP_SIM) 
@@ -839,6 +1114,10 @@ void disksim_simulate_event (int num)
     fprintf (outputfile, "Event handled, going for next\n");
     fflush (outputfile);
 #endif
+
+    if (disksim->checkpoint_pending) {
+      disksim_checkpoint (disksim->checkpointfilename);
+    }
   }
 
   
@@ -959,6 +1238,8 @@ void disksim_setup_disksim (int argc, char **argv)
 
   disksim->overrides = argv + 6;
   disksim->overrides_len = argc - 6;
+  disksim->argv = argv;
+  disksim->argc = argc;
 
    // asserts go to stderr by default
   ddbg_assert_setfile(stderr);
@@ -1006,6 +1287,36 @@ void disksim_setup_disksim (int argc, char **argv)
   initialize();
   fprintf(outputfile, "Initialization complete\n");
   fflush(outputfile);
+  if (((disksim->branchno) || (disksim->restorefilename)) && (io_models_failure())) {
+    /* failure and rebuild state is not part of a checkpoint */
+    fprintf(stderr, "*** error: a checkpoint cannot be restored while a logorg models a device failure\n");
+    exit(1);
+  }
+  if (disksim->branchno) {
+    /* the branch point is the only checkpoint a branch sees, and */
+    /* statistics start there */
+    disksim->checkpoint_interval = 0.0;
+    disksim->checkpoint_iocnt = 0;
+    disksim->checkpoint_warmup = 0;
+    disksim->checkpointfilename[0] = 0;
+    disksim->numbranches = 0;
+    disksim->warmup_event = NULL;
+    disksim->warmup_iocnt = 0;
+    checkpoint_restore_file(disksim->branchimage, "branch point");
+    disksim->checkpoint_restored = TRUE;
+    resetstats();
+    fprintf(outputfile, "Branch %d started at simtime %f\n", 
+	    disksim->branchno, simtime);
+    fflush(outputfile);
+  }
+  else if (disksim->restorefilename) {
+    checkpoint_restore(disksim->restorefilename);
+    disksim->checkpoint_restored = TRUE;
+    resetstats();
+    fprintf(outputfile, "Restored checkpoint %s at simtime %f\n", 
+	    disksim->restorefilename, simtime);
+    fflush(outputfile);
+  }
   prime_simulation();
 
 
@@ -1015,54 +1326,13 @@ void disksim_setup_disksim (int argc, char **argv)
 }
 
 
-void disksim_restore_from_checkpoint (char *filename)
-{
-#ifdef SUPPORT_CHECKPOINTS
-   int fd;
-   void *startaddr;
-   int totallength;
-   int ret;
-
-   fd = open (filename, O_RDWR);
-   assert (fd >= 0);
-   ret = read (fd, &startaddr, sizeof (void *));
-   assert (ret == sizeof(void *));
-   ret = read (fd, &totallength, sizeof (int));
-   assert (ret == sizeof(int));
-   disksim = (disksim_t *) mmap (startaddr, totallength, (PROT_READ|PROT_WRITE), (MAP_PRIVATE), fd, 0);
-   //printf ("mmap at %p, ret %d, len %d, addr %p\n", disksim, ret, totallength, startaddr);
-   //perror("");
-   assert (disksim == startaddr);
-
-   disksim_setup_outputfile (disksim->outputfilename, "r+");
-   if (outputfile != NULL) {
-      ret = fsetpos (outputfile, &disksim->outputfileposition);
-      assert (ret >= 0);
-   }
-   disksim_setup_iotracefile (disksim->iotracefilename);
-   if (disksim->iotracefile != NULL) {
-      ret = fsetpos (disksim->iotracefile, &disksim->iotracefileposition);
-      assert (ret >= 0);
-   }
-   if ((strcmp(disksim->outiosfilename, "0") != 0) && (strcmp(disksim->outiosfilename, "null") != 0)) {
-      if ((outios = fopen(disksim->outiosfilename, "r+")) == NULL) {
-         fprintf(stderr, "Outios %s cannot be opened for write access\n", disksim->outiosfilename);
-         exit(1);
-      }
-      ret = fsetpos (outios, &disksim->outiosfileposition);
-      assert (ret >= 0);
-   }
-#else
-   assert ("Checkpoint/restore not supported on this platform" == 0);
-#endif
-   setcallbacks();
-}
-
-
 void disksim_run_simulation ()
 {
   int event_count = 0;
-  DISKSIM_srand48(1000003);
+  /* a restored run continues the checkpointed random sequence */
+  if (!disksim->checkpoint_restored) {
+    DISKSIM_srand48(1000003);
+  }
   while (disksim->stop_sim == FALSE) {
     disksim_simulate_event(event_count);
     //    printf("disksim_run_simulation: event %d\n", event_count);
@@ -1090,6 +1360,8 @@ void disksim_cleanup(void)
   
   
   iodriver_cleanup();
+
+  disksim_branch_wait();
   
   if(outios) 
   {
@@ -116,14 +116,17 @@
 #define BUS_TYPE_MIN	1
 #define EXCLUSIVE	1
 #define INTERLEAVED	2
-#define BUS_TYPE_MAX	2
+#define QUEUEPAIR	3
+#define BUS_TYPE_MAX	3
 
 /* Bus arbitration types */
 
 #define BUS_ARB_TYPE_MIN	1
 #define SLOTPRIORITY_ARB	1
 #define FIFO_ARB		2
-#define BUS_ARB_TYPE_MAX	2
+#define ROUNDROBIN_ARB		3
+#define WEIGHTEDFAIR_ARB	4
+#define BUS_ARB_TYPE_MAX	4
 
 /* Bus states */
 
@@ -253,6 +256,9 @@ double bus_get_transfer_time(int busno, int bcount, int read)
    struct bus *currbus = getbus(busno);
 
    blktranstime = (read) ? currbus->readblktranstime : currbus->writeblktranstime;
+   if (currbus->lanes > 1) {
+      blktranstime /= (double) currbus->lanes;
+   }
    return((double) bcount * blktranstime);
 }
 
@@ -284,6 +290,8 @@ void bus_event_arrive(ioreq_event *ptr)
       ASSERT(curr == currbus->arbwinner);
       currbus->arbwinner = NULL;
       stat_update (&currbus->arbwaitstats, (simtime - curr->wait_start));
+      currbus->slotgrants[curr->slotno]++;
+      currbus->slotwaittime[curr->slotno] += simtime - curr->wait_start;
    }
 
    switch (curr->devtype) {
@@ -312,62 +320,247 @@ void bus_event_arrive(ioreq_event *ptr)
 }
 
 
-static bus_event * bus_fifo_arbitration(bus *currbus)
+/* Waiter bookkeeping.  See the comment on struct bus. */
+
+#define BUS_SLOTMAP_WORDS(n)	(((n) + 31) / 32)
+
+static const int bus_debruijn[32] = {
+   0, 1, 28, 2, 29, 14, 24, 3, 30, 22, 20, 15, 25, 17, 4, 8,
+   31, 27, 13, 23, 21, 19, 16, 7, 26, 12, 18, 6, 11, 5, 10, 9
+};
+
+static int bus_lowest_bit (unsigned int w)
 {
-   bus_event *ret = currbus->owners;
-   ASSERT(currbus->owners != NULL);
-   currbus->owners = ret->next;
-   return(ret);
+   return(bus_debruijn[((w & -w) * 0x077CB531U) >> 27]);
 }
 
+static int bus_highest_bit (unsigned int w)
+{
+   w |= w >> 1;
+   w |= w >> 2;
+   w |= w >> 4;
+   w |= w >> 8;
+   w |= w >> 16;
+   return(bus_lowest_bit(w ^ (w >> 1)));
+}
 
-static bus_event * bus_slotpriority_arbitration(bus *currbus)
+
+/* Highest-numbered slot with a waiter, or -1 */
+
+static int bus_highest_waiting_slot (bus *currbus)
 {
-   bus_event *ret = currbus->owners;
+   int i;
 
-   ASSERT(currbus->owners != NULL);
-   if (currbus->owners->next == NULL) {
-      currbus->owners = NULL;
-      return(ret);
+   for (i = BUS_SLOTMAP_WORDS(currbus->numslots) - 1; i >= 0; i--) {
+      if (currbus->slotmap[i]) {
+	 return((i * 32) + bus_highest_bit(currbus->slotmap[i]));
+      }
+   }
+   return(-1);
+}
+
+
+/* Lowest-numbered slot at or above slotno with a waiter, or -1 */
+
+static int bus_next_waiting_slot (bus *currbus, int slotno)
+{
+   int i = slotno / 32;
+   unsigned int w;
+
+   if (slotno >= currbus->numslots) {
+      return(-1);
+   }
+   w = currbus->slotmap[i] & ~((1U << (slotno % 32)) - 1);
+   while (1) {
+      if (w) {
+	 return((i * 32) + bus_lowest_bit(w));
+      }
+      if (++i >= BUS_SLOTMAP_WORDS(currbus->numslots)) {
+	 return(-1);
+      }
+      w = currbus->slotmap[i];
+   }
+}
+
+
+static double bus_slot_weight (bus *currbus, int slotno)
+{
+   if (slotno < currbus->slotweights_len) {
+      return(currbus->slotweights[slotno]);
+   }
+   return(1.0);
+}
+
+
+static void bus_waiters_changed (bus *currbus, int delta)
+{
+   currbus->waitersarea += currbus->waiters * (simtime - currbus->lastwaiterchange);
+   currbus->lastwaiterchange = simtime;
+   currbus->waiters += delta;
+   if (currbus->waiters > currbus->maxwaiters) {
+      currbus->maxwaiters = currbus->waiters;
+   }
+}
+
+
+static void bus_add_waiter (bus *currbus, bus_event *tmp)
+{
+   int slotno = tmp->slotno;
+
+   tmp->next = NULL;
+   tmp->slot_next = NULL;
+
+   /* arrival order */
+   if (currbus->owners) {
+      bus_event *tail = currbus->owners->prev;
+      tail->next = tmp;
+      tmp->prev = tail;
    } else {
-      bus_event *trv = ret;
-      while (trv->next) {
-         if (trv->next->slotno > ret->slotno) {
-            ret = trv->next;
-         }
-         trv = trv->next;
+      currbus->owners = tmp;
+      tmp->prev = tmp;
+   }
+   currbus->owners->prev = tmp;
+
+   /* slot FIFO */
+   if (currbus->slothead[slotno]) {
+      currbus->slottail[slotno]->slot_next = tmp;
+   } else {
+      currbus->slothead[slotno] = tmp;
+      currbus->slotmap[slotno / 32] |= 1U << (slotno % 32);
+      if (currbus->slotpass[slotno] < currbus->pass) {
+	 /* no credit for time spent idle */
+	 currbus->slotpass[slotno] = currbus->pass;
+      }
+   }
+   currbus->slottail[slotno] = tmp;
+
+   bus_waiters_changed(currbus, 1);
+}
+
+
+/* Unlinks tmp, which follows prevslot in its slot's FIFO (NULL if it */
+/* is at the head).                                                   */
+
+static void bus_unlink_waiter (bus *currbus, bus_event *tmp, bus_event *prevslot)
+{
+   int slotno = tmp->slotno;
+
+   /* owners->prev is the tail; the tail's next is NULL */
+   if (tmp == currbus->owners) {
+      currbus->owners = tmp->next;
+      if (currbus->owners) {
+	 currbus->owners->prev = tmp->prev;
       }
-      if (ret == currbus->owners) {
-         currbus->owners = ret->next;
-         ret->next = NULL;
+   } else {
+      tmp->prev->next = tmp->next;
+      if (tmp->next) {
+	 tmp->next->prev = tmp->prev;
       } else {
-	 trv = currbus->owners;
-         while ((trv->next != NULL) && (trv->next != ret)) {
-            trv = trv->next;
-         }
-	 ASSERT(trv->next == ret);
-         trv->next = ret->next;
-         ret->next = NULL;
+	 currbus->owners->prev = tmp->prev;
       }
    }
-   return(ret);
+
+   if (prevslot) {
+      prevslot->slot_next = tmp->slot_next;
+   } else {
+      currbus->slothead[slotno] = tmp->slot_next;
+   }
+   if (currbus->slottail[slotno] == tmp) {
+      currbus->slottail[slotno] = prevslot;
+   }
+   if (currbus->slothead[slotno] == NULL) {
+      currbus->slotmap[slotno / 32] &= ~(1U << (slotno % 32));
+   }
+
+   tmp->next = NULL;
+   tmp->prev = NULL;
+   tmp->slot_next = NULL;
+   bus_waiters_changed(currbus, -1);
+}
+
+
+static bus_event * bus_fifo_arbitration(bus *currbus)
+{
+   return(currbus->owners);
+}
+
+
+/* The highest slot wins; requests from one slot are served in order. */
+
+static bus_event * bus_slotpriority_arbitration(bus *currbus)
+{
+   return(currbus->slothead[bus_highest_waiting_slot(currbus)]);
+}
+
+
+/* Slots with waiters take turns in slot order. */
+
+static bus_event * bus_roundrobin_arbitration(bus *currbus)
+{
+   int slotno = bus_next_waiting_slot(currbus, currbus->lastslot + 1);
+
+   if (slotno < 0) {
+      slotno = bus_next_waiting_slot(currbus, 0);
+   }
+   return(currbus->slothead[slotno]);
+}
+
+
+/* Stride scheduling: each grant advances the winning slot's pass by  */
+/* the inverse of its weight and the slot with the lowest pass wins,  */
+/* so over a busy period slots get ownership in proportion to their   */
+/* weights.  Ties go to the higher slot.                              */
+
+static bus_event * bus_weightedfair_arbitration(bus *currbus)
+{
+   int slotno = -1;
+   int i;
+
+   for (i = bus_next_waiting_slot(currbus, 0); i >= 0; i = bus_next_waiting_slot(currbus, i + 1)) {
+      if ((slotno < 0) || (currbus->slotpass[i] <= currbus->slotpass[slotno])) {
+	 slotno = i;
+      }
+   }
+   return(currbus->slothead[slotno]);
 }
 
 
 static bus_event * bus_arbitrate_for_ownership(bus *currbus)
 {
+   bus_event *ret;
+
+   ASSERT(currbus->owners != NULL);
+
    switch (currbus->arbtype) {
 
       case SLOTPRIORITY_ARB:
-          return(bus_slotpriority_arbitration(currbus));
+          ret = bus_slotpriority_arbitration(currbus);
+          break;
 
       case FIFO_ARB:
-          return(bus_fifo_arbitration(currbus));
+          ret = bus_fifo_arbitration(currbus);
+          break;
+
+      case ROUNDROBIN_ARB:
+          ret = bus_roundrobin_arbitration(currbus);
+          break;
+
+      case WEIGHTEDFAIR_ARB:
+          ret = bus_weightedfair_arbitration(currbus);
+          break;
 
       default:
           fprintf(stderr, "Unrecognized bus arbitration type in bus_arbitrate_for_ownership\n");
           exit(1);
    }
+
+   /* every policy picks the head of some slot's FIFO */
+   ASSERT(ret == currbus->slothead[ret->slotno]);
+   bus_unlink_waiter(currbus, ret, NULL);
+   currbus->lastslot = ret->slotno;
+   currbus->pass = currbus->slotpass[ret->slotno];
+   currbus->slotpass[ret->slotno] += 1.0 / bus_slot_weight(currbus, ret->slotno);
+   return(ret);
 }
 
 
@@ -398,13 +591,14 @@ int bus_ownership_get(int busno, int slotno, ioreq_event *curr)
    bus_event *tmp;
    struct bus *currbus = getbus (busno);
 
-   if (currbus->type == INTERLEAVED) {
+   if ((currbus->type == INTERLEAVED) || (currbus->type == QUEUEPAIR)) {
       return(TRUE);
    }
    tmp = (bus_event *) getfromextraq();
    tmp->type = BUS_OWNERSHIP_GRANTED;
    tmp->devno = currbus->slots[slotno].devno;
    tmp->busno = busno;
+   tmp->slotno = slotno;
    tmp->delayed_event = curr;
    tmp->wait_start = simtime;
    if (currbus->state == BUS_FREE) {
@@ -418,21 +612,12 @@ fprintf (outputfile, "Granting ownership immediately - devno %d, devtype %d, bus
       currbus->state = BUS_OWNED;
       currbus->runidletime += simtime - currbus->lastowned;
       stat_update (&currbus->busidlestats, (simtime - currbus->lastowned));
+      currbus->busystart = simtime;
    } else {
-      tmp->slotno = slotno;
 /*
 fprintf (outputfile, "Must wait for bus to become free - devno %d, slotno %d, busno %d\n", tmp->devno, tmp->slotno, tmp->busno);
 */
-      tmp->next = NULL;
-      if (currbus->owners) {
-         bus_event *tail = currbus->owners;
-         while (tail->next) {
-            tail = tail->next;
-         }
-         tail->next = tmp;
-      } else {
-         currbus->owners = tmp;
-      }
+      bus_add_waiter(currbus, tmp);
    }
    return(FALSE);
 }
@@ -452,6 +637,10 @@ fprintf (outputfile, "Bus has become free - %d\n", busno);
 */
       currbus->state = BUS_FREE;
       currbus->lastowned = simtime;
+      currbus->busyperiods++;
+      if ((simtime - currbus->busystart) > currbus->maxbusyperiod) {
+	 currbus->maxbusyperiod = simtime - currbus->busystart;
+      }
    } else {
       tmp = bus_arbitrate_for_ownership(currbus);
       tmp->devtype = currbus->slots[tmp->slotno].devtype;
@@ -465,10 +654,10 @@ fprintf (outputfile, "Bus ownership transfered - devno %d, devtype %d, busno %d\
 }
 
 
-void bus_remove_from_arbitration(int busno, ioreq_event *curr)
+void bus_remove_from_arbitration(int busno, int slotno, ioreq_event *curr)
 {
    bus_event *tmp;
-   bus_event *trv;
+   bus_event *prevslot = NULL;
    struct bus *currbus = getbus(busno);
 
    if (currbus->arbwinner) {
@@ -483,18 +672,15 @@ void bus_remove_from_arbitration(int busno, ioreq_event *curr)
          return;
       }
    }
-   if (curr == currbus->owners->delayed_event) {
-      tmp = currbus->owners;
-      currbus->owners = tmp->next;
-   } else {
-      trv = currbus->owners;
-      while ((trv->next) && (curr != trv->next->delayed_event)) {
-         trv = trv->next;
-      }
-      ASSERT(trv->next != NULL);
-      tmp = trv->next;
-      trv->next = tmp->next;
+   ASSERT2((slotno >= 0) && (slotno < currbus->numslots), 
+	   "slotno", slotno, "busno", busno);
+   tmp = currbus->slothead[slotno];
+   while ((tmp != NULL) && (curr != tmp->delayed_event)) {
+      prevslot = tmp;
+      tmp = tmp->slot_next;
    }
+   ASSERT(tmp != NULL);
+   bus_unlink_waiter(currbus, tmp, prevslot);
    addtoextraq((event *) tmp);
 }
 
@@ -529,6 +715,184 @@ fprintf (outputfile, "In middle of bus_deliver_event\n");
 }
 
 
+/* Queue-pair (PCIe-style) host interface.  The host posts a command to  */
+/* a submission queue and writes that queue's doorbell; the device then */
+/* fetches the entry.  Completions go to the paired completion queue    */
+/* and are signalled by a per-queue (MSI-X) interrupt, which may be     */
+/* coalesced.  Posting a completion ends the device's part in the       */
+/* request, so the device is answered then rather than by the host.     */
+/* A request's queue pair is chosen by its opid, standing in for the    */
+/* submitting CPU.                                                      */
+
+static bus_qpair * bus_get_qpair (struct bus *currbus, ioreq_event *curr)
+{
+   return(&currbus->qpairs[(unsigned int) curr->opid % currbus->numqpairs]);
+}
+
+
+/* hand curr to the component on the host bus it is addressed to */
+
+static void bus_queuepair_deliver (timer_event *timer)
+{
+   ioreq_event *curr = timer->ptr;
+   int busno = timer->val;
+   intchar slotno;
+
+   addtoextraq((event *) timer);
+   slotno.value = curr->slotno;
+   bus_deliver_event(busno, (slotno.byte[0] & 0x0F), curr);
+}
+
+
+static void bus_queuepair_schedule_delivery (int busno, ioreq_event *curr, double time)
+{
+   timer_event *timer = (timer_event *) getfromextraq();
+
+   timer->type = TIMER_EXPIRED;
+   timer->func = &disksim->timerfunc_bus_deliver;
+   timer->val = busno;
+   timer->ptr = curr;
+   timer->time = time;
+   addtointq((event *) timer);
+}
+
+
+/* Returns TRUE if the host-to-device event curr has been taken over */
+/* (to be delivered once its command is fetched), FALSE if it should */
+/* be delivered as usual.                                            */
+
+int bus_queuepair_submit (int busno, ioreq_event *curr)
+{
+   struct bus *currbus = getbus(busno);
+   bus_qpair *qp;
+
+   if ((currbus->type != QUEUEPAIR) || (curr->type != IO_ACCESS_ARRIVE)) {
+      return(FALSE);
+   }
+   qp = bus_get_qpair(currbus, curr);
+   qp->commands++;
+   if (qp->doorbelldone <= simtime) {
+      /* no doorbell write in flight to carry this one */
+      qp->doorbells++;
+      qp->doorbelldone = simtime + currbus->doorbelltime;
+   }
+   bus_queuepair_schedule_delivery(busno, curr, (qp->doorbelldone + currbus->fetchtime));
+   return(TRUE);
+}
+
+
+static void bus_queuepair_cancel_coalescing (bus_qpair *qp)
+{
+   if (qp->coalescetimer) {
+      removefromintq((event *) qp->coalescetimer);
+      addtoextraq((event *) qp->coalescetimer);
+      qp->coalescetimer = NULL;
+   }
+}
+
+
+/* raise the interrupt for everything in the completion queue */
+
+static void bus_queuepair_interrupt (bus_qpair *qp)
+{
+   ioreq_event *curr = qp->held;
+   ioreq_event *next;
+
+   bus_queuepair_cancel_coalescing(qp);
+   qp->held = NULL;
+   qp->heldtail = NULL;
+   qp->numheld = 0;
+   qp->interrupts++;
+
+   while (curr) {
+      next = curr->next;
+      curr->next = NULL;
+      intr_request((event *) curr);
+      curr = next;
+   }
+}
+
+
+static void bus_queuepair_coalesce_timeout (timer_event *timer)
+{
+   bus_qpair *qp = timer->ptr;
+
+   ASSERT(qp->coalescetimer == timer);
+   qp->coalescetimer = NULL;
+   addtoextraq((event *) timer);
+   bus_queuepair_interrupt(qp);
+}
+
+
+/* Every event that reaches the host from a component on the host bus */
+/* comes through here.                                                */
+
+void bus_interrupt_host (ioreq_event *curr)
+{
+   intchar busno;
+   struct bus *currbus;
+   bus_qpair *qp;
+   timer_event *timer;
+   ioreq_event *ack;
+
+   busno.value = curr->busno;
+   currbus = getbus(busno.byte[0]);
+   if ((currbus == NULL) || (currbus->type != QUEUEPAIR)
+       || (curr->type != IO_INTERRUPT_ARRIVE) || (curr->cause != COMPLETION)) {
+      intr_request((event *) curr);
+      return;
+   }
+
+   ack = ioreq_copy(curr);
+   ack->type = IO_INTERRUPT_COMPLETE;
+   bus_queuepair_schedule_delivery(busno.byte[0], ack, simtime);
+
+   qp = bus_get_qpair(currbus, curr);
+   qp->completions++;
+   curr->next = NULL;
+   if (qp->heldtail) {
+      qp->heldtail->next = curr;
+   } else {
+      qp->held = curr;
+   }
+   qp->heldtail = curr;
+   qp->numheld++;
+
+   if (qp->numheld >= currbus->coalesce_count) {
+      bus_queuepair_interrupt(qp);
+   } else if (qp->coalescetimer == NULL) {
+      timer = (timer_event *) getfromextraq();
+      timer->type = TIMER_EXPIRED;
+      timer->func = &disksim->timerfunc_bus_coalesce;
+      timer->ptr = qp;
+      timer->time = simtime + currbus->coalesce_time;
+      addtointq((event *) timer);
+      qp->coalescetimer = timer;
+   }
+}
+
+
+int bus_is_queuepair (int busno)
+{
+   struct bus *currbus = getbus(busno);
+   return((currbus != NULL) && (currbus->type == QUEUEPAIR));
+}
+
+
+/* The most requests the host may have outstanding through busno, or */
+/* 0 if the bus imposes no limit.                                    */
+
+int bus_get_queue_limit (int busno)
+{
+   struct bus *currbus = getbus(busno);
+
+   if (!bus_is_queuepair(busno)) {
+      return(0);
+   }
+   return(currbus->numqpairs * currbus->qdepth);
+}
+
+
 int bus_get_data_transfered(ioreq_event *curr, int depth)
 {
    intchar slotno;
@@ -589,7 +953,7 @@ int disksim_bus_stats_loadparams(struct lp_block *b) {
 
 void bus_resetstats()
 {
-   int i;
+   int i, j;
 
    for (i=0; i<numbuses; i++) {
       struct bus *currbus = getbus(i);
@@ -597,12 +961,29 @@ void bus_resetstats()
       currbus->runidletime = 0.0;
       stat_reset (&currbus->busidlestats);
       stat_reset (&currbus->arbwaitstats);
+      currbus->waitersarea = 0.0;
+      currbus->lastwaiterchange = simtime;
+      currbus->maxwaiters = currbus->waiters;
+      currbus->busyperiods = 0;
+      currbus->busystart = simtime;
+      currbus->maxbusyperiod = 0.0;
+      bzero(currbus->slotgrants, currbus->numslots * sizeof(int));
+      bzero(currbus->slotwaittime, currbus->numslots * sizeof(double));
+      for (j = 0; (currbus->type == QUEUEPAIR) && (j < currbus->numqpairs); j++) {
+	 bus_qpair *qp = &currbus->qpairs[j];
+	 qp->commands = 0;
+	 qp->doorbells = 0;
+	 qp->completions = 0;
+	 qp->interrupts = 0;
+      }
    }
 }
 
 
 void bus_setcallbacks ()
 {
+   disksim->timerfunc_bus_deliver = bus_queuepair_deliver;
+   disksim->timerfunc_bus_coalesce = bus_queuepair_coalesce_timeout;
 }
 
 
@@ -611,10 +992,41 @@ void bus_initialize()
    int i;
 
    StaticAssert (sizeof(bus_event) <= DISKSIM_EVENT_SIZE);
+   bus_setcallbacks();
    for (i=0; i<numbuses; i++) {
       struct bus *currbus = getbus(i);
       currbus->state = BUS_FREE;
       addlisttoextraq((event **) &currbus->owners);
+      if (currbus->slothead == NULL) {
+	 currbus->slothead = DISKSIM_malloc(currbus->numslots * sizeof(bus_event *));
+	 currbus->slottail = DISKSIM_malloc(currbus->numslots * sizeof(bus_event *));
+	 currbus->slotmap = DISKSIM_malloc(BUS_SLOTMAP_WORDS(currbus->numslots) * sizeof(unsigned int));
+	 currbus->slotpass = DISKSIM_malloc(currbus->numslots * sizeof(double));
+	 currbus->slotgrants = DISKSIM_malloc(currbus->numslots * sizeof(int));
+	 currbus->slotwaittime = DISKSIM_malloc(currbus->numslots * sizeof(double));
+      }
+      bzero(currbus->slothead, currbus->numslots * sizeof(bus_event *));
+      bzero(currbus->slottail, currbus->numslots * sizeof(bus_event *));
+      bzero(currbus->slotmap, BUS_SLOTMAP_WORDS(currbus->numslots) * sizeof(unsigned int));
+      bzero(currbus->slotpass, currbus->numslots * sizeof(double));
+      currbus->pass = 0.0;
+      currbus->lastslot = -1;
+      currbus->waiters = 0;
+      if (currbus->type == QUEUEPAIR) {
+	 if (currbus->numqpairs <= 0) {
+	    currbus->numqpairs = 1;
+	 }
+	 if (currbus->qdepth <= 0) {
+	    currbus->qdepth = 65536;
+	 }
+	 if (currbus->coalesce_count <= 0) {
+	    currbus->coalesce_count = 1;
+	 }
+	 if (currbus->qpairs == NULL) {
+	    currbus->qpairs = DISKSIM_malloc(currbus->numqpairs * sizeof(bus_qpair));
+	 }
+	 bzero(currbus->qpairs, currbus->numqpairs * sizeof(bus_qpair));
+      }
       stat_initialize (statdeffile, "Arbitration wait time", &currbus->arbwaitstats);
       stat_initialize (statdeffile, "Bus idle period length", &currbus->busidlestats);
    }
@@ -622,6 +1034,58 @@ void bus_initialize()
 }
 
 
+static void bus_print_util_stats (bus *currbus, int busno)
+{
+   double busytime = simtime - warmuptime - currbus->runidletime;
+   double waitersarea;
+   int busyperiods = currbus->busyperiods;
+   int i;
+
+   waitersarea = currbus->waitersarea + (currbus->waiters * (simtime - currbus->lastwaiterchange));
+   if (currbus->state == BUS_OWNED) {
+      busyperiods++;
+   }
+
+   fprintf (outputfile, "Bus #%d Busy periods: \t%d\n", busno, busyperiods);
+   fprintf (outputfile, "Bus #%d Average busy period length: \t%f\n", busno, (busyperiods ? (busytime / busyperiods) : 0.0));
+   fprintf (outputfile, "Bus #%d Maximum busy period length: \t%f\n", busno, currbus->maxbusyperiod);
+   fprintf (outputfile, "Bus #%d Average arbitration queue length: \t%f\n", busno, ((simtime > warmuptime) ? (waitersarea / (simtime - warmuptime)) : 0.0));
+   fprintf (outputfile, "Bus #%d Maximum arbitration queue length: \t%d\n", busno, currbus->maxwaiters);
+   for (i = 0; i < currbus->numslots; i++) {
+      fprintf (outputfile, "Bus #%d Slot #%d arbitrations: \t%d\n", busno, i, currbus->slotgrants[i]);
+      fprintf (outputfile, "Bus #%d Slot #%d average arbitration wait: \t%f\n", busno, i, (currbus->slotgrants[i] ? (currbus->slotwaittime[i] / currbus->slotgrants[i]) : 0.0));
+   }
+}
+
+
+static void bus_print_queuepair_stats (bus *currbus, int busno)
+{
+   int commands = 0;
+   int doorbells = 0;
+   int completions = 0;
+   int interrupts = 0;
+   int i;
+
+   for (i = 0; i < currbus->numqpairs; i++) {
+      commands += currbus->qpairs[i].commands;
+      doorbells += currbus->qpairs[i].doorbells;
+      completions += currbus->qpairs[i].completions;
+      interrupts += currbus->qpairs[i].interrupts;
+   }
+   fprintf (outputfile, "Bus #%d Commands submitted: \t%d\n", busno, commands);
+   fprintf (outputfile, "Bus #%d Doorbell writes: \t%d\n", busno, doorbells);
+   fprintf (outputfile, "Bus #%d Commands per doorbell: \t%f\n", busno, (doorbells ? ((double) commands / (double) doorbells) : 0.0));
+   fprintf (outputfile, "Bus #%d Completion interrupts: \t%d\n", busno, interrupts);
+   fprintf (outputfile, "Bus #%d Completions per interrupt: \t%f\n", busno, (interrupts ? ((double) completions / (double) interrupts) : 0.0));
+   if (currbus->numqpairs > 1) {
+      for (i = 0; i < currbus->numqpairs; i++) {
+	 fprintf (outputfile, "Bus #%d Queue pair #%d commands: \t%d\n", busno, i, currbus->qpairs[i].commands);
+	 fprintf (outputfile, "Bus #%d Queue pair #%d interrupts: \t%d\n", busno, i, currbus->qpairs[i].interrupts);
+      }
+   }
+}
+
+
 void bus_printstats()
 {
    int i;
@@ -643,6 +1107,12 @@ void bus_printstats()
             fprintf (outputfile, "Bus #%d Number of arbitrations: \t%d\n", i, stat_get_count (&currbus->arbwaitstats));
             stat_print (&currbus->arbwaitstats, prefix);
          }
+         if (disksim->businfo->bus_printutilstats) {
+            bus_print_util_stats (currbus, i);
+         }
+         if (currbus->type == QUEUEPAIR) {
+            bus_print_queuepair_stats (currbus, i);
+         }
          fprintf (outputfile, "\n");
       }
    }
@@ -658,10 +1128,45 @@ void bus_cleanstats()
       if (currbus->state == BUS_FREE) {
          currbus->runidletime += simtime - currbus->lastowned;
          stat_update (&currbus->busidlestats, (simtime - currbus->lastowned));
+      } else if ((simtime - currbus->busystart) > currbus->maxbusyperiod) {
+         currbus->maxbusyperiod = simtime - currbus->busystart;
       }
    }
 }
 
+int bus_load_slot_weights(struct bus *b, struct lp_list *l)
+{
+  int c;
+
+  b->slotweights = DISKSIM_malloc(l->values_len * sizeof(double));
+  b->slotweights_len = 0;
+
+  for(c = 0; c < l->values_len; c++) {
+    if(!l->values[c]) continue;
+
+    switch(l->values[c]->t) {
+    case I:
+      b->slotweights[b->slotweights_len] = l->values[c]->v.i;
+      break;
+    case D:
+      b->slotweights[b->slotweights_len] = l->values[c]->v.d;
+      break;
+    default:
+      fprintf(stderr, "*** error: bus slot weights must be numbers\n");
+      return 0;
+    }
+
+    if(b->slotweights[b->slotweights_len] <= 0.0) {
+      fprintf(stderr, "*** error: bus slot weights must be positive\n");
+      return 0;
+    }
+    b->slotweights_len++;
+  }
+
+  return 1;
+}
+
+
 bus *bus_copy(bus *orig) {
   bus *result = malloc(sizeof(bus));
   if(result) return memcpy(result, orig, sizeof(bus));
@@ -126,6 +126,7 @@ typedef struct bus_ev {
    int slotno;
    ioreq_event *delayed_event;
    double wait_start;
+   struct bus_ev *slot_next;	/* next waiter from the same slot */
 } bus_event;
 
 
@@ -136,15 +137,45 @@ typedef struct businfo {
    int numbuses;
    int bus_printidlestats;
    int bus_printarbwaitstats;
+   int bus_printutilstats;
 } businfo_t;
 
 #define numbuses	(disksim->businfo->numbuses)
 
+/* One submission/completion queue pair of a queue-pair (PCIe-style)  */
+/* bus.  Commands a doorbell write is already carrying share it;       */
+/* completions are held for a coalesced MSI-X interrupt.               */
+
+typedef struct bus_qpair {
+   double        doorbelldone;	/* doorbell write in flight until */
+   ioreq_event  *held;
+   ioreq_event  *heldtail;
+   int           numheld;
+   timer_event  *coalescetimer;
+   int           commands;
+   int           doorbells;
+   int           completions;
+   int           interrupts;
+} bus_qpair;
+
+/* Requests waiting for ownership are kept in arrival order on owners */
+/* (doubly linked) and, through slot_next, in a FIFO per slot.  A bit  */
+/* per slot in slotmap marks the non-empty FIFOs so that arbitration   */
+/* never has to walk the waiters.                                      */
+
 typedef struct bus {
   int           state;
   int           type;
   int           arbtype;
   bus_event    *owners;
+  bus_event   **slothead;
+  bus_event   **slottail;
+  unsigned int *slotmap;
+  int           lastslot;	/* last winner, for round-robin */
+  double       *slotweights;	/* for weighted fair arbitration */
+  int           slotweights_len;
+  double       *slotpass;
+  double        pass;
   double        arbtime;
   double        readblktranstime;
   double        writeblktranstime;
@@ -157,6 +188,23 @@ typedef struct bus {
   double	runidletime;
   statgen	arbwaitstats;
   statgen	busidlestats;
+  int           waiters;
+  int           maxwaiters;
+  double        waitersarea;	/* integral of waiters over time */
+  double        lastwaiterchange;
+  int           busyperiods;
+  double        busystart;
+  double        maxbusyperiod;
+  int          *slotgrants;
+  double       *slotwaittime;
+  int           lanes;
+  int           numqpairs;
+  int           qdepth;
+  double        doorbelltime;
+  double        fetchtime;
+  int           coalesce_count;
+  double        coalesce_time;
+  bus_qpair    *qpairs;
   char         *name;
 } bus;
 
@@ -169,13 +217,17 @@ void    bus_read_physorg (FILE *parfile);
 void    bus_param_override (char *paramname, char *parval, int first, int last);
 int     bus_ownership_get (int busno, int slotno, ioreq_event *curr);
 void    bus_ownership_release (int busno);
-void    bus_remove_from_arbitration (int busno, ioreq_event *curr);
+void    bus_remove_from_arbitration (int busno, int slotno, ioreq_event *curr);
 void    bus_delay (int busno, int devtype, int devno, double delay, ioreq_event *curr);
 void    bus_event_arrive (ioreq_event *curr);
 double  bus_get_transfer_time (int busno, int bcount, int read);
 int     bus_get_data_transfered (ioreq_event *curr, int depth);
 int     bus_get_controller_slot (int busno, int ctlno);
 void    bus_deliver_event (int busno, int slotno, ioreq_event *curr);
+int     bus_queuepair_submit (int busno, ioreq_event *curr);
+void    bus_interrupt_host (ioreq_event *curr);
+int     bus_is_queuepair (int busno);
+int     bus_get_queue_limit (int busno);
 void    bus_set_depths (void);
 void    bus_set_to_zero_depth (int busno);
 void    bus_print_phys_config (void);
@@ -185,6 +237,7 @@ void    bus_resetstats (void);
 void    bus_printstats (void);
 void    bus_cleanstats (void);
 struct bus *getbusbyname(char *name, int *num);
+int     bus_load_slot_weights (struct bus *b, struct lp_list *l);
 
 int load_bus_topo(struct lp_topospec *t, int *parentctlno); 
 
@@ -104,6 +104,7 @@
 #include "disksim_cache.h"
 #include "disksim_cachemem.h"
 #include "disksim_cachedev.h"
+#include "disksim_cacheflash.h"
 #include "config.h"
 
 #include "modules/modules.h"
@@ -111,6 +112,7 @@
 void cache_setcallbacks(void) {
   cachemem_setcallbacks();
   cachedev_setcallbacks();
+  cacheflash_setcallbacks();
 }
 
 struct cache_if *disksim_cache_loadparams(struct lp_block *b)
@@ -126,6 +128,9 @@ struct cache_if *disksim_cache_loadparams(struct lp_block *b)
   case DISKSIM_MOD_CACHEDEV:
     result = disksim_cachedev_loadparams(b);
     break;
+  case DISKSIM_MOD_CACHEFLASH:
+    result = disksim_cacheflash_loadparams(b);
+    break;
   default:
     fprintf(stderr, "*** error: Invalid cache type (%d) specified.\n", IVAL(b->params[c]));
     return 0;
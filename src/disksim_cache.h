@@ -103,6 +103,8 @@
 
 #include "config.h"
 
+struct checkpoint;
+
 // Made this real interfaces since the way it worked before was
 // driving me crazy!  bucy 20030401
 
@@ -149,6 +151,13 @@ struct cache_if {
   int (*cache_sync)(struct cache_if *cache);
 
   int (*cache_get_maxreqsize)(struct cache_if *cache);
+
+  // save/restore the cache contents (see disksim_checkpoint.c)
+  void (*cache_checkpoint)(struct cache_if *cache, 
+			   struct checkpoint *ckpt);
+
+  void (*cache_restore)(struct cache_if *cache, 
+			struct checkpoint *ckpt);
 };
 
 struct cache_if *disksim_cache_loadparams(struct lp_block *b);
@@ -124,6 +124,7 @@
 
 #include "modules/modules.h"
 #include "disksim_cachedev.h"
+#include "disksim_checkpoint.h"
 
 
 
@@ -764,6 +765,30 @@ cachedev_copy (struct cache_if *c)
   return (struct cache_if *)new;
 }
 
+
+/* the cache device's own contents are saved with that device; here */
+/* we only need to know which of its blocks are valid and dirty      */
+
+static void cachedev_checkpoint (struct cache_if *c, checkpoint_t *ckpt)
+{
+   struct cache_dev *cache = (struct cache_dev *)c;
+
+   ASSERT(cache->ongoing_requests == NULL);
+   checkpoint_put_int(ckpt, cache->size);
+   checkpoint_put_bytes(ckpt, cache->validmap, bitstr_size(cache->size));
+   checkpoint_put_bytes(ckpt, cache->dirtymap, bitstr_size(cache->size));
+}
+
+
+static void cachedev_restore (struct cache_if *c, checkpoint_t *ckpt)
+{
+   struct cache_dev *cache = (struct cache_dev *)c;
+
+   checkpoint_check(ckpt, "cache size", checkpoint_get_int(ckpt), cache->size);
+   checkpoint_get_bytes(ckpt, cache->validmap, bitstr_size(cache->size));
+   checkpoint_get_bytes(ckpt, cache->dirtymap, bitstr_size(cache->size));
+}
+
 static struct cache_if disksim_cache_dev = {
   cachedev_setcallbacks,
   cachedev_initialize,
@@ -777,7 +802,9 @@ static struct cache_if disksim_cache_dev = {
   cachedev_disk_access_complete,
   cachedev_wakeup_complete,
   cachedev_sync,
-  cachedev_get_maxreqsize
+  cachedev_get_maxreqsize,
+  cachedev_checkpoint,
+  cachedev_restore
 };
 
 struct cache_if *disksim_cachedev_loadparams(struct lp_block *b)
@@ -0,0 +1,1383 @@
+/*
+ * DiskSim Storage Subsystem Simulation Environment (Version 4.0)
+ * Revision Authors: John Bucy, Greg Ganger
+ * Contributors: John Griffin, Jiri Schindler, Steve Schlosser
+ *
+ * Copyright (c) of Carnegie Mellon University, 2001-2008.
+ *
+ * This software is being provided by the copyright holders under the
+ * following license. By obtaining, using and/or copying this software,
+ * you agree that you have read, understood, and will comply with the
+ * following terms and conditions:
+ *
+ * Permission to reproduce, use, and prepare derivative works of this
+ * software is granted provided the copyright and "No Warranty" statements
+ * are included with all reproductions and derivative works and associated
+ * documentation. This software may also be redistributed without charge
+ * provided that the copyright and "No Warranty" statements are included
+ * in all redistributions.
+ *
+ * NO WARRANTY. THIS SOFTWARE IS FURNISHED ON AN "AS IS" BASIS.
+ * CARNEGIE MELLON UNIVERSITY MAKES NO WARRANTIES OF ANY KIND, EITHER
+ * EXPRESSED OR IMPLIED AS TO THE MATTER INCLUDING, BUT NOT LIMITED
+ * TO: WARRANTY OF FITNESS FOR PURPOSE OR MERCHANTABILITY, EXCLUSIVITY
+ * OF RESULTS OR RESULTS OBTAINED FROM USE OF THIS SOFTWARE. CARNEGIE
+ * MELLON UNIVERSITY DOES NOT MAKE ANY WARRANTY OF ANY KIND WITH RESPECT
+ * TO FREEDOM FROM PATENT, TRADEMARK, OR COPYRIGHT INFRINGEMENT.
+ * COPYRIGHT HOLDERS WILL BEAR NO LIABILITY FOR ANY USE OF THIS SOFTWARE
+ * OR DOCUMENTATION.
+ *
+ */
+
+
+/***************************************************************************
+  A write-back cache kept on a (typically flash) device in front of
+  another device.  Unlike cachedev, blocks of the cached device are not
+  pinned to the same LBNs on the cache device:
+
+	1. The cache device is divided into lines of "Line size" blocks.
+	   Lines are placed set-associatively, or anywhere at all when
+	   "Associativity" is 0, and replaced LRU within their set.
+	2. With "Log-structured writes", every write of new data is
+	   appended at the head of a circular log over the whole cache
+	   device instead of being written in place, and the head
+	   reclaims whatever clean line it finds next.
+	3. Requests that continue a long sequential stream bypass the
+	   cache, and read misses only populate the cache once a line
+	   has missed "Admission threshold" times.
+	4. Dirty lines are destaged in batches, sorted and coalesced by
+	   their address on the cached device, when too many lines are
+	   dirty or the cached device has been idle for a while.
+
+  As with cachedev there is no locking: overlapping requests may be in
+  progress at once.  A line with accesses in flight is never reclaimed,
+  though, so the mapping itself always stays consistent.
+***************************************************************************/
+
+#include "modules/modules.h"
+#include "disksim_cacheflash.h"
+#include "disksim_checkpoint.h"
+
+
+static int 
+cacheflash_get_maxreqsize (struct cache_if *c)
+{
+  struct cache_flash *cache = (struct cache_flash *)c;
+  return(cache->maxreqsize);
+}
+
+
+static void cacheflash_empty_donefunc (void *doneparam, ioreq_event *req)
+{
+   addtoextraq((event *) req);
+}
+
+
+static void 
+cacheflash_add_ongoing_request (struct cache_flash *cache, 
+				struct cacheflash_event *cachereq)
+{
+   cachereq->next = cache->ongoing_requests;
+   cachereq->prev = NULL;
+   if (cachereq->next) {
+      cachereq->next->prev = cachereq;
+   }
+   cache->ongoing_requests = cachereq;
+}
+
+
+static void 
+cacheflash_remove_ongoing_request (struct cache_flash *cache, 
+				   struct cacheflash_event *cachereq)
+{
+   if (cachereq->next) {
+      cachereq->next->prev = cachereq->prev;
+   }
+   if (cachereq->prev) {
+      cachereq->prev->next = cachereq->next;
+   }
+   if (cache->ongoing_requests == cachereq) {
+      cache->ongoing_requests = cachereq->next;
+   }
+}
+
+
+static struct cacheflash_event * cacheflash_find_ongoing_request (struct cache_flash *cache, ioreq_event *req)
+{
+   struct cacheflash_event *tmp = cache->ongoing_requests;
+
+   while ((tmp != NULL) && ((req->opid != tmp->req->opid) || (req->blkno != tmp->req->blkno) || (req->bcount != tmp->req->bcount) || (req->buf != tmp->req->buf))) {
+      tmp = tmp->next;
+   }
+
+   return (tmp);
+}
+
+
+static void cacheflash_use_bufferspace (struct cache_flash *cache, int blocks)
+{
+   cache->bufferspace += blocks;
+   if (cache->bufferspace > cache->stat.maxbufferspace) {
+      cache->stat.maxbufferspace = cache->bufferspace;
+   }
+}
+
+
+/* bits first..first+count-1 of a line mask */
+
+static unsigned int cacheflash_mask (int first, int count)
+{
+   if (count >= CACHEFLASH_MAXLINESIZE) {
+      return (~0U);
+   }
+   return (((1U << count) - 1) << first);
+}
+
+
+/*** line lookup ***/
+
+static int cacheflash_hashfn (struct cache_flash *cache, int tag)
+{
+   return ((int) (((unsigned int) tag * 2654435761U) & cache->hashmask));
+}
+
+
+static int cacheflash_lookup (struct cache_flash *cache, int tag)
+{
+   int slot = cache->hash[cacheflash_hashfn(cache, tag)];
+
+   while ((slot != -1) && (cache->lines[slot].tag != tag)) {
+      slot = cache->lines[slot].hashnext;
+   }
+   return (slot);
+}
+
+
+static void cacheflash_hash_insert (struct cache_flash *cache, int slot)
+{
+   int bucket = cacheflash_hashfn(cache, cache->lines[slot].tag);
+
+   cache->lines[slot].hashnext = cache->hash[bucket];
+   cache->hash[bucket] = slot;
+}
+
+
+static void cacheflash_hash_remove (struct cache_flash *cache, int slot)
+{
+   int *prevp = &cache->hash[cacheflash_hashfn(cache, cache->lines[slot].tag)];
+
+   while (*prevp != slot) {
+      ASSERT(*prevp != -1);
+      prevp = &cache->lines[*prevp].hashnext;
+   }
+   *prevp = cache->lines[slot].hashnext;
+}
+
+
+/*** replacement ***/
+
+static void cacheflash_lru_remove (struct cache_flash *cache, int slot)
+{
+   struct cacheflash_line *line = &cache->lines[slot];
+   int set = slot / cache->setsize;
+
+   if (line->lruprev != -1) {
+      cache->lines[line->lruprev].lrunext = line->lrunext;
+   } else {
+      cache->lruhead[set] = line->lrunext;
+   }
+   if (line->lrunext != -1) {
+      cache->lines[line->lrunext].lruprev = line->lruprev;
+   } else {
+      cache->lrutail[set] = line->lruprev;
+   }
+}
+
+
+/* put slot at the MRU end of its set, or at the LRU end if !mru */
+
+static void cacheflash_lru_insert (struct cache_flash *cache, int slot, int mru)
+{
+   struct cacheflash_line *line = &cache->lines[slot];
+   int set = slot / cache->setsize;
+
+   if (mru) {
+      line->lruprev = -1;
+      line->lrunext = cache->lruhead[set];
+      if (line->lrunext != -1) {
+         cache->lines[line->lrunext].lruprev = slot;
+      } else {
+         cache->lrutail[set] = slot;
+      }
+      cache->lruhead[set] = slot;
+   } else {
+      line->lrunext = -1;
+      line->lruprev = cache->lrutail[set];
+      if (line->lruprev != -1) {
+         cache->lines[line->lruprev].lrunext = slot;
+      } else {
+         cache->lruhead[set] = slot;
+      }
+      cache->lrutail[set] = slot;
+   }
+}
+
+
+static void cacheflash_touch (struct cache_flash *cache, int slot)
+{
+   cacheflash_lru_remove(cache, slot);
+   cacheflash_lru_insert(cache, slot, 1);
+}
+
+
+/* drop whatever the slot holds and make it the next one reused */
+
+static void cacheflash_free_line (struct cache_flash *cache, int slot)
+{
+   struct cacheflash_line *line = &cache->lines[slot];
+
+   if (line->tag != -1) {
+      cacheflash_hash_remove(cache, slot);
+      line->tag = -1;
+   }
+   if (line->dirty) {
+      cache->ndirty--;
+   }
+   line->valid = 0;
+   line->dirty = 0;
+   cacheflash_lru_remove(cache, slot);
+   cacheflash_lru_insert(cache, slot, 0);
+}
+
+
+static int cacheflash_reclaimable (struct cache_flash *cache, int slot)
+{
+   return ((cache->lines[slot].busy == 0) && (cache->lines[slot].dirty == 0));
+}
+
+
+/* Find a slot for line tag, evicting a clean idle line if need be.    */
+/* Returns -1 if every candidate is dirty or busy; the caller has to   */
+/* go around the cache then.                                           */
+
+static int cacheflash_alloc (struct cache_flash *cache, int tag)
+{
+   int slot = -1;
+   int i;
+
+   if (cache->logstructured) {
+      for (i=0; i<cache->nlines; i++) {
+         int cand = cache->loghead;
+         cache->loghead = (cache->loghead + 1) % cache->nlines;
+         if (cacheflash_reclaimable(cache, cand)) {
+            slot = cand;
+            break;
+         }
+      }
+   } else {
+      int cand = cache->lrutail[tag % cache->nsets];
+      while ((cand != -1) && (!cacheflash_reclaimable(cache, cand))) {
+         cand = cache->lines[cand].lruprev;
+      }
+      slot = cand;
+   }
+
+   if (slot == -1) {
+      return (-1);
+   }
+   if (cache->lines[slot].valid) {
+      cache->stat.evictions++;
+   }
+   cacheflash_free_line(cache, slot);
+   cache->lines[slot].tag = tag;
+   cacheflash_hash_insert(cache, slot);
+   cacheflash_touch(cache, slot);
+   return (slot);
+}
+
+
+/*** admission ***/
+
+/* Does req continue a sequential stream that is already long enough */
+/* to be kept out of the cache?                                      */
+
+static int cacheflash_sequential (struct cache_flash *cache, ioreq_event *req)
+{
+   struct cacheflash_stream *victim = &cache->streams[0];
+   int i;
+
+   if (cache->seqthreshold == 0) {
+      return (0);
+   }
+
+   cache->streamclock++;
+   for (i=0; i<CACHEFLASH_STREAMS; i++) {
+      struct cacheflash_stream *s = &cache->streams[i];
+      if ((s->len != 0) && (s->nextblkno == req->blkno)) {
+         int seq = (s->len >= cache->seqthreshold);
+         s->len += req->bcount;
+         s->nextblkno += req->bcount;
+         s->lastuse = cache->streamclock;
+         return (seq);
+      }
+      if (s->lastuse < victim->lastuse) {
+         victim = s;
+      }
+   }
+
+   victim->nextblkno = req->blkno + req->bcount;
+   victim->len = req->bcount;
+   victim->lastuse = cache->streamclock;
+   return (0);
+}
+
+
+/* Count a read miss on line tag; admit it once it has missed often enough. */
+
+static int cacheflash_admit (struct cache_flash *cache, int tag)
+{
+   int i;
+
+   if (cache->admitthreshold <= 1) {
+      return (1);
+   }
+
+   i = cacheflash_hashfn(cache, tag);
+   if (cache->ghost[i] != tag) {
+      cache->ghost[i] = tag;
+      cache->ghostcnt[i] = 0;
+   }
+   cache->ghostcnt[i]++;
+   if (cache->ghostcnt[i] >= cache->admitthreshold) {
+      cache->ghost[i] = -1;
+      return (1);
+   }
+   return (0);
+}
+
+
+/*** device accesses ***/
+
+static struct cacheflash_event * cacheflash_new_event (int type, ioreq_event *req)
+{
+   struct cacheflash_event *desc = (struct cacheflash_event *) getfromextraq();
+
+   desc->type = type;
+   desc->donefunc = NULL;
+   desc->doneparam = NULL;
+   desc->req = req;
+   desc->pending = 0;
+   desc->bypass = 0;
+   desc->blkno = 0;
+   desc->bcount = 0;
+   desc->first = 0;
+   desc->count = 0;
+   return (desc);
+}
+
+
+static void cacheflash_issue (struct cache_flash *cache, struct cacheflash_event *desc, int devno, int blkno, int bcount, int flags)
+{
+   ioreq_event *req;
+
+   if (desc->req) {
+      req = ioreq_copy(desc->req);
+      req->flags = (desc->req->flags & ~READ) | flags;
+   } else {
+      req = (ioreq_event *) getfromextraq();
+      bzero(req, sizeof(ioreq_event));
+      req->time = simtime;
+      req->batchno = -1;
+      req->flags = flags;
+   }
+   req->type = IO_ACCESS_ARRIVE;
+   req->devno = devno;
+   req->blkno = blkno;
+   req->bcount = bcount;
+   req->buf = desc;
+   desc->pending++;
+   (*cache->issuefunc)(cache->issueparam, req);
+}
+
+
+/* Accesses to the cache device are built up a line at a time and */
+/* merged when consecutive lines sit in consecutive slots.          */
+
+struct cacheflash_run {
+   int devno;
+   int blkno;
+   int bcount;
+};
+
+
+static void cacheflash_run_flush (struct cache_flash *cache, struct cacheflash_event *desc, struct cacheflash_run *run, int flags)
+{
+   if (run->bcount) {
+      cacheflash_issue(cache, desc, run->devno, run->blkno, run->bcount, flags);
+      run->bcount = 0;
+   }
+}
+
+
+static void cacheflash_run_add (struct cache_flash *cache, struct cacheflash_event *desc, struct cacheflash_run *run, int blkno, int bcount, int flags)
+{
+   if ((run->bcount) && (run->blkno + run->bcount != blkno)) {
+      cacheflash_run_flush(cache, desc, run, flags);
+   }
+   if (run->bcount == 0) {
+      run->blkno = blkno;
+   }
+   run->bcount += bcount;
+}
+
+
+#define CACHEFLASH_RELEASE      0
+#define CACHEFLASH_SETVALID     1
+#define CACHEFLASH_SETDIRTY     2
+
+/* An access to cache device blocks cblkno..cblkno+bcount-1 finished. */
+
+static void cacheflash_release (struct cache_flash *cache, int cblkno, int bcount, int how)
+{
+   while (bcount > 0) {
+      int slot = cblkno / cache->linesize;
+      int off = cblkno % cache->linesize;
+      int n = min(cache->linesize - off, bcount);
+      unsigned int m = cacheflash_mask(off, n);
+      struct cacheflash_line *line = &cache->lines[slot];
+
+      if (how != CACHEFLASH_RELEASE) {
+         line->valid |= m;
+      }
+      if (how == CACHEFLASH_SETDIRTY) {
+         if (line->dirty == 0) {
+            cache->ndirty++;
+         }
+         line->dirty |= m;
+         if (line->flags & CACHEFLASH_DESTAGING) {
+            line->flags |= CACHEFLASH_REWRITTEN;
+         }
+      }
+      line->busy--;
+      ASSERT(line->busy >= 0);
+      cblkno += n;
+      bcount -= n;
+   }
+}
+
+
+/* Drop any cached copy of blocks of line tag that are about to be */
+/* written straight to the cached device.                          */
+
+static void cacheflash_invalidate (struct cache_flash *cache, int tag, unsigned int m)
+{
+   int slot = cacheflash_lookup(cache, tag);
+
+   if (slot != -1) {
+      struct cacheflash_line *line = &cache->lines[slot];
+      line->valid &= ~m;
+      if ((line->dirty) && ((line->dirty & ~m) == 0)) {
+         cache->ndirty--;
+      }
+      line->dirty &= ~m;
+   }
+}
+
+
+static void cacheflash_invalidate_range (struct cache_flash *cache, int blkno, int bcount)
+{
+   int end = blkno + bcount;
+
+   while (blkno < end) {
+      int off = blkno % cache->linesize;
+      int n = min(cache->linesize - off, end - blkno);
+      cacheflash_invalidate(cache, blkno / cache->linesize, cacheflash_mask(off, n));
+      blkno += n;
+   }
+}
+
+
+/*** destaging ***/
+
+static int cacheflash_destage_cmp (const void *a, const void *b)
+{
+   const struct cacheflash_destage *da = a;
+   const struct cacheflash_destage *db = b;
+
+   if (da->tag != db->tag) {
+      return ((da->tag < db->tag) ? -1 : 1);
+   }
+   return ((da->mask < db->mask) ? -1 : (da->mask > db->mask));
+}
+
+
+static int cacheflash_destage_blkno (struct cache_flash *cache, struct cacheflash_destage *d, int *bcountp)
+{
+   int off = 0;
+   int n = 0;
+
+   while (!(d->mask & (1U << off))) {
+      off++;
+   }
+   while ((off + n < cache->linesize) && (d->mask & (1U << (off + n)))) {
+      n++;
+   }
+   *bcountp = n;
+   return (d->tag * cache->linesize + off);
+}
+
+
+/* Start a batch: gather up to "Destage batch size" idle dirty lines,  */
+/* sort their dirty runs by address on the cached device and write     */
+/* each group of adjacent runs with a single access.                   */
+
+static void cacheflash_destage (struct cache_flash *cache)
+{
+   int lines = 0;
+   int n = 0;
+   int scanned;
+   int i, j, k;
+
+   if (cache->batchops) {
+      return;
+   }
+
+   for (scanned=0; (scanned < cache->nlines) && (lines < cache->destagebatch); scanned++) {
+      int slot = cache->destagecursor;
+      struct cacheflash_line *line = &cache->lines[slot];
+      unsigned int dirty = line->dirty;
+      int off = 0;
+
+      cache->destagecursor = (cache->destagecursor + 1) % cache->nlines;
+      if ((dirty == 0) || (line->busy)) {
+         continue;
+      }
+      while (off < cache->linesize) {
+         int len = 0;
+         if (!(dirty & (1U << off))) {
+            off++;
+            continue;
+         }
+         while ((off + len < cache->linesize) && (dirty & (1U << (off + len)))) {
+            len++;
+         }
+         cache->batch[n].slot = slot;
+         cache->batch[n].tag = line->tag;
+         cache->batch[n].mask = cacheflash_mask(off, len);
+         n++;
+         off += len;
+      }
+      lines++;
+   }
+
+   if (n == 0) {
+      return;
+   }
+
+   qsort(cache->batch, n, sizeof(struct cacheflash_destage), cacheflash_destage_cmp);
+   cache->batchlen = n;
+   cache->stat.destagebatches++;
+
+   for (i=0; i<n; i=j) {
+      struct cacheflash_event *desc = cacheflash_new_event(CACHEFLASH_EVENT_DESTAGE_READ, NULL);
+      struct cacheflash_run run;
+      int blkno, bcount, next, nextcount;
+
+      desc->blkno = cacheflash_destage_blkno(cache, &cache->batch[i], &desc->bcount);
+      for (j=i+1; j<n; j++) {
+         next = cacheflash_destage_blkno(cache, &cache->batch[j], &nextcount);
+         if (next != desc->blkno + desc->bcount) {
+            break;
+         }
+         desc->bcount += nextcount;
+      }
+      desc->first = i;
+      desc->count = j - i;
+
+      run.devno = cache->cache_devno;
+      run.bcount = 0;
+      for (k=i; k<j; k++) {
+         struct cacheflash_destage *d = &cache->batch[k];
+         struct cacheflash_line *line = &cache->lines[d->slot];
+         blkno = cacheflash_destage_blkno(cache, d, &bcount);
+         line->busy++;
+         line->flags |= CACHEFLASH_DESTAGING;
+         cacheflash_run_add(cache, desc, &run, d->slot * cache->linesize + (blkno % cache->linesize), bcount, READ);
+      }
+      cacheflash_use_bufferspace(cache, desc->bcount);
+      cache->batchops++;
+      cacheflash_run_flush(cache, desc, &run, READ);
+      cache->stat.destagereads += desc->pending;
+      cache->stat.destagereadblocks += desc->bcount;
+   }
+}
+
+
+static int cacheflash_too_dirty (struct cache_flash *cache, double fraction)
+{
+   return ((double) cache->ndirty > fraction * (double) cache->nlines);
+}
+
+
+static int cacheflash_backing_idle (struct cache_flash *cache)
+{
+   struct ioq *queue;
+
+   queue = (*cache->queuefind)(cache->queuefindparam, cache->real_devno);
+   if (ioqueue_get_number_in_queue (queue) != 0) {
+      return (0);
+   }
+   queue = (*cache->queuefind)(cache->queuefindparam, cache->cache_devno);
+   return (ioqueue_get_number_in_queue (queue) == 0);
+}
+
+
+static void cacheflash_destage_done (struct cache_flash *cache, struct cacheflash_event *desc)
+{
+   int i;
+
+   for (i=desc->first; i<(desc->first + desc->count); i++) {
+      struct cacheflash_destage *d = &cache->batch[i];
+      struct cacheflash_line *line = &cache->lines[d->slot];
+
+      ASSERT(line->tag == d->tag);
+      /* if it was written again meanwhile, the new data may not be on */
+      /* the cached device yet; leave it dirty for the next batch       */
+      if (!(line->flags & CACHEFLASH_REWRITTEN) && (line->dirty)) {
+         line->dirty &= ~d->mask;
+         if (line->dirty == 0) {
+            cache->ndirty--;
+         }
+      }
+      line->busy--;
+   }
+
+   cache->batchops--;
+   if (cache->batchops) {
+      return;
+   }
+
+   /* nothing is in flight now; forget which lines were in the batch */
+   for (i=0; i<cache->batchlen; i++) {
+      cache->lines[cache->batch[i].slot].flags = 0;
+   }
+   cache->batchlen = 0;
+
+   if (cacheflash_too_dirty(cache, cache->lowwater)) {
+      cacheflash_destage(cache);
+   } else if ((cache->idledestage) && (cache->ndirty) && (cacheflash_backing_idle(cache))) {
+      cacheflash_destage(cache);
+   } else {
+      cache->idledestage = 0;
+   }
+}
+
+
+static void cacheflash_idlework_callback (void *idleworkparam, int idledevno)
+{
+   struct cache_flash *cache = idleworkparam;
+
+   ASSERT (idledevno == cache->real_devno);
+
+   if ((cache->ndirty == 0) || (!cacheflash_backing_idle(cache))) {
+      return;
+   }
+   cache->idledestage = 1;
+   cacheflash_destage(cache);
+}
+
+
+/*** the cache interface ***/
+
+/* Reads are split by line: lines whose requested blocks are all valid */
+/* are read from the cache device, the rest from the cached device.    */
+
+static void 
+cacheflash_read (struct cache_flash *cache, struct cacheflash_event *rwdesc)
+{
+   ioreq_event *req = rwdesc->req;
+   struct cacheflash_run hit, miss;
+   int blkno = req->blkno;
+   int end = req->blkno + req->bcount;
+   int hits = 0;
+   int misses = 0;
+
+   hit.devno = cache->cache_devno;
+   hit.bcount = 0;
+   miss.devno = cache->real_devno;
+   miss.bcount = 0;
+
+   while (blkno < end) {
+      int tag = blkno / cache->linesize;
+      int off = blkno % cache->linesize;
+      int n = min(cache->linesize - off, end - blkno);
+      unsigned int m = cacheflash_mask(off, n);
+      int slot = cacheflash_lookup(cache, tag);
+
+      if ((slot != -1) && ((cache->lines[slot].valid & m) == m)) {
+         cacheflash_run_flush(cache, rwdesc, &miss, READ);
+         cache->lines[slot].busy++;
+         cacheflash_touch(cache, slot);
+         cacheflash_run_add(cache, rwdesc, &hit, slot * cache->linesize + off, n, READ);
+         hits += n;
+      } else {
+         cacheflash_run_flush(cache, rwdesc, &hit, READ);
+         cacheflash_run_add(cache, rwdesc, &miss, blkno, n, READ);
+         misses += n;
+      }
+      blkno += n;
+   }
+   cacheflash_run_flush(cache, rwdesc, &hit, READ);
+   cacheflash_run_flush(cache, rwdesc, &miss, READ);
+
+   if (misses == 0) {
+      cache->stat.readhitsfull++;
+   } else if (hits) {
+      cache->stat.readhitspartial++;
+   } else {
+      cache->stat.readmisses++;
+   }
+}
+
+
+/* Copy blocks just read from the cached device into the cache, for */
+/* the lines that pass admission and have room.                     */
+
+static void 
+cacheflash_populate (struct cache_flash *cache, int blkno, int bcount)
+{
+   struct cacheflash_event *desc = cacheflash_new_event(CACHEFLASH_EVENT_POPULATE, NULL);
+   struct cacheflash_run run;
+   int end = blkno + bcount;
+
+   run.devno = cache->cache_devno;
+   run.bcount = 0;
+
+   while (blkno < end) {
+      int tag = blkno / cache->linesize;
+      int off = blkno % cache->linesize;
+      int n = min(cache->linesize - off, end - blkno);
+      unsigned int m = cacheflash_mask(off, n);
+      int slot = cacheflash_lookup(cache, tag);
+
+      if (slot == -1) {
+         if (!cacheflash_admit(cache, tag)) {
+            cache->stat.admitrejects++;
+            slot = -1;
+         } else {
+            slot = cacheflash_alloc(cache, tag);
+         }
+      } else if (cache->lines[slot].valid & m) {
+         /* some of it is cached already, possibly dirty */
+         slot = -1;
+      }
+
+      if (slot == -1) {
+         cacheflash_run_flush(cache, desc, &run, WRITE);
+      } else {
+         cache->lines[slot].busy++;
+         cacheflash_run_add(cache, desc, &run, slot * cache->linesize + off, n, WRITE);
+         desc->bcount += n;
+      }
+      blkno += n;
+   }
+   cacheflash_run_flush(cache, desc, &run, WRITE);
+
+   if (desc->pending == 0) {
+      addtoextraq((event *) desc);
+      return;
+   }
+   cacheflash_use_bufferspace(cache, desc->bcount);
+   cache->stat.popwrites += desc->pending;
+   cache->stat.popwriteblocks += desc->bcount;
+}
+
+
+/* Writes go to the line's slot if it is cached (or, when log-structured, */
+/* to a fresh slot at the log head), and around the cache for any line   */
+/* that can't be given a slot because its set is all dirty or busy.       */
+
+static void 
+cacheflash_write (struct cache_flash *cache, struct cacheflash_event *rwdesc)
+{
+   ioreq_event *req = rwdesc->req;
+   struct cacheflash_run hit, miss;
+   int blkno = req->blkno;
+   int end = req->blkno + req->bcount;
+   int thru = (cache->writescheme == CACHEFLASH_WRITE_THRU);
+   int bypassed = 0;
+
+   hit.devno = cache->cache_devno;
+   hit.bcount = 0;
+   miss.devno = cache->real_devno;
+   miss.bcount = 0;
+
+   while (blkno < end) {
+      int tag = blkno / cache->linesize;
+      int off = blkno % cache->linesize;
+      int n = min(cache->linesize - off, end - blkno);
+      unsigned int m = cacheflash_mask(off, n);
+      int slot = cacheflash_lookup(cache, tag);
+
+      if (slot != -1) {
+         struct cacheflash_line *line = &cache->lines[slot];
+         cache->stat.writehits++;
+         /* dirty blocks outside the write would be lost by moving */
+         /* the line, so those are updated in place                */
+         if ((cache->logstructured) && (line->busy == 0) && ((line->valid & line->dirty & ~m) == 0)) {
+            cacheflash_free_line(cache, slot);
+            slot = cacheflash_alloc(cache, tag);
+            cache->stat.logappends++;
+         } else if (cache->logstructured) {
+            cache->stat.loginplace++;
+            cacheflash_touch(cache, slot);
+         } else {
+            cacheflash_touch(cache, slot);
+         }
+      } else {
+         cache->stat.writemisses++;
+         slot = cacheflash_alloc(cache, tag);
+         if ((slot != -1) && (cache->logstructured)) {
+            cache->stat.logappends++;
+         }
+      }
+
+      if (slot == -1) {
+         cacheflash_invalidate(cache, tag, m);
+         cacheflash_run_flush(cache, rwdesc, &hit, WRITE);
+         if (!thru) {
+            cacheflash_run_add(cache, rwdesc, &miss, blkno, n, WRITE);
+         }
+         bypassed = 1;
+      } else {
+         cacheflash_run_flush(cache, rwdesc, &miss, WRITE);
+         cache->lines[slot].busy++;
+         cacheflash_run_add(cache, rwdesc, &hit, slot * cache->linesize + off, n, WRITE);
+      }
+      blkno += n;
+   }
+   cacheflash_run_flush(cache, rwdesc, &hit, WRITE);
+   cacheflash_run_flush(cache, rwdesc, &miss, WRITE);
+
+   if (thru) {
+      cacheflash_issue(cache, rwdesc, cache->real_devno, req->blkno, req->bcount, WRITE);
+   }
+   if (bypassed) {
+      cache->stat.writebypass++;
+      /* nothing could be reclaimed; get some lines cleaned */
+      cacheflash_destage(cache);
+   }
+}
+
+
+/* Gets the appropriate block, locked and ready to be accessed read or write */
+
+static int 
+cacheflash_get_block (struct cache_if *c, 
+		      ioreq_event *req, 
+		      void (**donefunc)(void *, ioreq_event *), 
+		      void *doneparam)
+{
+   struct cache_flash *cache = (struct cache_flash *)c;
+   struct cacheflash_event *rwdesc;
+
+   if (req->devno != cache->real_devno) {
+      fprintf (stderr, "cacheflash_get_block trying to cache blocks for wrong device (%d should be %d)\n", req->devno, cache->real_devno);
+      ASSERT(0);
+      exit(1);
+   }
+
+   cacheflash_use_bufferspace(cache, req->bcount);
+
+   rwdesc = cacheflash_new_event((req->flags & READ) ? CACHEFLASH_EVENT_READ : CACHEFLASH_EVENT_WRITE, req);
+   rwdesc->donefunc = donefunc;
+   rwdesc->doneparam = doneparam;
+   req->next = NULL;
+   req->prev = NULL;
+   cacheflash_add_ongoing_request (cache, rwdesc);
+
+   if (req->flags & READ) {
+      cache->stat.reads++;
+      cache->stat.readblocks += req->bcount;
+
+      if (cacheflash_sequential(cache, req)) {
+         cache->stat.readbypass++;
+         rwdesc->bypass = 1;
+         cacheflash_issue(cache, rwdesc, cache->real_devno, req->blkno, req->bcount, READ);
+      } else {
+         cacheflash_read(cache, rwdesc);
+      }
+      return (1);
+
+   } else {
+      /* Grab buffer space and let the controller fill in data to be written. */
+      /* (for now, just assume that there is buffer space available)          */
+
+      (*donefunc)(doneparam, req);
+      return (0);
+   }
+}
+
+
+/* frees the block after access complete */
+
+static void 
+cacheflash_free_block_clean (struct cache_if *c, 
+			     ioreq_event *req)
+{
+   struct cache_flash *cache = (struct cache_flash *)c;
+   struct cacheflash_event *rwdesc;
+
+   rwdesc = cacheflash_find_ongoing_request (cache, req);
+   ASSERT (rwdesc != NULL);
+   ASSERT (rwdesc->type == CACHEFLASH_EVENT_READ);
+   ASSERT (rwdesc->pending == 0);
+
+   cache->bufferspace -= req->bcount;
+   cacheflash_remove_ongoing_request (cache, rwdesc);
+   addtoextraq ((event *) rwdesc);
+}
+
+
+/* the data to be written has arrived; send it to the cache device, */
+/* around it, or both                                               */
+
+static int 
+cacheflash_free_block_dirty (struct cache_if *c, 
+			     ioreq_event *req, 
+			     void (**donefunc)(void *, ioreq_event *), 
+			     void *doneparam)
+{
+   struct cache_flash *cache = (struct cache_flash *)c;
+   struct cacheflash_event *writedesc;
+
+   cache->stat.writes++;
+   cache->stat.writeblocks += req->bcount;
+
+   writedesc = cacheflash_find_ongoing_request (cache, req);
+   ASSERT (writedesc != NULL);
+   ASSERT (writedesc->type == CACHEFLASH_EVENT_WRITE);
+
+   writedesc->donefunc = donefunc;
+   writedesc->doneparam = doneparam;
+   writedesc->req = req;
+   req->type = IO_REQUEST_ARRIVE;
+   req->next = NULL;
+   req->prev = NULL;
+
+   if (cacheflash_sequential(cache, req)) {
+      cache->stat.writebypass++;
+      writedesc->bypass = 1;
+      cacheflash_invalidate_range(cache, req->blkno, req->bcount);
+      cacheflash_issue(cache, writedesc, cache->real_devno, req->blkno, req->bcount, WRITE);
+   } else {
+      cacheflash_write(cache, writedesc);
+   }
+
+   return(1);
+}
+
+
+int cacheflash_sync (struct cache_if *c)
+{
+  return(0);
+}
+
+
+static void *
+cacheflash_disk_access_complete (struct cache_if *c,
+				 ioreq_event *curr)
+{
+   struct cache_flash *cache = (struct cache_flash *)c;
+   struct cacheflash_event *desc = curr->buf;
+
+   switch(desc->type) {
+   case CACHEFLASH_EVENT_READ:
+      if (curr->devno == cache->cache_devno) {
+         cacheflash_release(cache, curr->blkno, curr->bcount, CACHEFLASH_RELEASE);
+      } else if (!desc->bypass) {
+         cacheflash_populate(cache, curr->blkno, curr->bcount);
+      }
+      desc->pending--;
+      if (desc->pending == 0) {
+         /* read can now proceed; free_block_clean will free desc */
+         (*desc->donefunc)(desc->doneparam, desc->req);
+      }
+      break;
+
+   case CACHEFLASH_EVENT_WRITE:
+      if (curr->devno == cache->cache_devno) {
+         cacheflash_release(cache, curr->blkno, curr->bcount, (cache->writescheme == CACHEFLASH_WRITE_BACK) ? CACHEFLASH_SETDIRTY : CACHEFLASH_SETVALID);
+      }
+      desc->pending--;
+      if (desc->pending == 0) {
+         cache->bufferspace -= desc->req->bcount;
+         cacheflash_remove_ongoing_request (cache, desc);
+         (*desc->donefunc)(desc->doneparam, desc->req);
+         addtoextraq ((event *) desc);
+         if (cacheflash_too_dirty(cache, cache->highwater)) {
+            cacheflash_destage(cache);
+         }
+      }
+      break;
+
+   case CACHEFLASH_EVENT_POPULATE:
+      cacheflash_release(cache, curr->blkno, curr->bcount, CACHEFLASH_SETVALID);
+      desc->pending--;
+      if (desc->pending == 0) {
+         cache->bufferspace -= desc->bcount;
+         addtoextraq ((event *) desc);
+      }
+      break;
+
+   case CACHEFLASH_EVENT_DESTAGE_READ:
+      desc->pending--;
+      if (desc->pending == 0) {
+         desc->type = CACHEFLASH_EVENT_DESTAGE_WRITE;
+         cacheflash_issue(cache, desc, cache->real_devno, desc->blkno, desc->bcount, WRITE);
+         cache->stat.destagewrites++;
+         cache->stat.destagewriteblocks += desc->bcount;
+      }
+      break;
+
+   case CACHEFLASH_EVENT_DESTAGE_WRITE:
+      desc->pending--;
+      ASSERT(desc->pending == 0);
+      cache->bufferspace -= desc->bcount;
+      cacheflash_destage_done(cache, desc);
+      addtoextraq ((event *) desc);
+      break;
+
+   default:
+     ddbg_assert2(0, "Unknown cacheflash event type");
+     break;
+   }
+
+   addtoextraq((event *) curr);
+
+   /* everything is handled through donefuncs; nothing to wake up */
+   return(NULL);
+}
+
+
+static void 
+cacheflash_wakeup_complete (struct cache_if *c, 
+			    void *d)
+{
+   ASSERT (0);
+}
+
+
+static void 
+cacheflash_resetstats (struct cache_if *c)
+{
+   struct cache_flash *cache = (struct cache_flash *)c;
+   bzero(&cache->stat, sizeof(struct cacheflash_stats));
+}
+
+
+void 
+cacheflash_setcallbacks(void)
+{
+  disksim->donefunc_cacheflash_empty = cacheflash_empty_donefunc;
+  disksim->idlework_cacheflash = cacheflash_idlework_callback;
+}
+
+
+/* (re)build the hash chains from the slots' tags */
+
+static void cacheflash_rehash (struct cache_flash *cache)
+{
+   int i;
+
+   for (i=0; i<=cache->hashmask; i++) {
+      cache->hash[i] = -1;
+   }
+   cache->ndirty = 0;
+   for (i=0; i<cache->nlines; i++) {
+      cache->lines[i].busy = 0;
+      cache->lines[i].flags = 0;
+      if (cache->lines[i].tag != -1) {
+         cacheflash_hash_insert(cache, i);
+      }
+      if (cache->lines[i].dirty) {
+         cache->ndirty++;
+      }
+   }
+}
+
+
+static void 
+cacheflash_initialize (struct cache_if *c, 
+		       void (**issuefunc)(void *,ioreq_event *), 
+		       void *issueparam, 
+		       struct ioq * (**queuefind)(void *,int), 
+		       void *queuefindparam, 
+		       void (**wakeupfunc)(void *, struct cacheevent *), 
+		       void *wakeupparam, 
+		       int numdevs)
+{
+   struct cache_flash *cache = (struct cache_flash *)c;
+   int hashsize;
+   int i;
+   StaticAssert (sizeof(struct cacheflash_event) <= DISKSIM_EVENT_SIZE);
+
+   cache->issuefunc = issuefunc;
+   cache->issueparam = issueparam;
+   cache->queuefind = queuefind;
+   cache->queuefindparam = queuefindparam;
+   cache->wakeupfunc = wakeupfunc;
+   cache->wakeupparam = wakeupparam;
+   cache->bufferspace = 0;
+   cache->ongoing_requests = NULL;
+   cache->batchops = 0;
+   cache->batchlen = 0;
+   cache->idledestage = 0;
+
+   if ((cache->logstructured) && (cache->assoc != 0)) {
+      fprintf (stderr, "cacheflash: log-structured writes need fully-associative placement (Associativity = 0)\n");
+      ddbg_assert(0);
+   }
+   if (cache->lowwater > cache->highwater) {
+      fprintf (stderr, "cacheflash: destage low watermark %f exceeds high watermark %f\n", cache->lowwater, cache->highwater);
+      ddbg_assert(0);
+   }
+   if (device_get_number_of_blocks(cache->cache_devno) < cache->size) {
+      fprintf (stderr, "Size of cacheflash exceeds that of actual cache device (devno %d): %d > %d\n", cache->cache_devno, cache->size, device_get_number_of_blocks(cache->cache_devno));
+      ddbg_assert(0);
+   }
+
+   cache->nlines = cache->size / cache->linesize;
+   cache->setsize = (cache->assoc == 0) ? cache->nlines : cache->assoc;
+   cache->nsets = cache->nlines / cache->setsize;
+   cache->nlines = cache->nsets * cache->setsize;
+   if (cache->nlines == 0) {
+      fprintf (stderr, "cacheflash: cache of %d blocks holds no lines\n", cache->size);
+      ddbg_assert(0);
+   }
+
+   for (hashsize = 1; hashsize < cache->nlines; hashsize <<= 1)
+      ;
+   cache->hashmask = hashsize - 1;
+
+   if (cache->lines == NULL) {
+      cache->lines = DISKSIM_malloc(cache->nlines * sizeof(struct cacheflash_line));
+      cache->hash = DISKSIM_malloc(hashsize * sizeof(int));
+      cache->lruhead = DISKSIM_malloc(cache->nsets * sizeof(int));
+      cache->lrutail = DISKSIM_malloc(cache->nsets * sizeof(int));
+      cache->ghost = DISKSIM_malloc(hashsize * sizeof(int));
+      cache->ghostcnt = DISKSIM_malloc(hashsize);
+      cache->batch = DISKSIM_malloc(cache->destagebatch * ((cache->linesize + 1) / 2) * sizeof(struct cacheflash_destage));
+      ASSERT ((cache->lines != NULL) && (cache->hash != NULL) && (cache->lruhead != NULL) && (cache->lrutail != NULL) && (cache->ghost != NULL) && (cache->ghostcnt != NULL) && (cache->batch != NULL));
+   }
+
+   for (i=0; i<cache->nsets; i++) {
+      cache->lruhead[i] = -1;
+      cache->lrutail[i] = -1;
+   }
+   for (i=0; i<cache->nlines; i++) {
+      cache->lines[i].tag = -1;
+      cache->lines[i].valid = 0;
+      cache->lines[i].dirty = 0;
+      cacheflash_lru_insert(cache, i, 0);
+   }
+   cacheflash_rehash(cache);
+   for (i=0; i<hashsize; i++) {
+      cache->ghost[i] = -1;
+      cache->ghostcnt[i] = 0;
+   }
+   bzero(cache->streams, sizeof(cache->streams));
+   cache->streamclock = 0;
+   cache->loghead = 0;
+   cache->destagecursor = 0;
+   cacheflash_resetstats(c);
+
+   if (cache->flush_idledelay >= 0.0) {
+      struct ioq *queue = (*queuefind)(queuefindparam,cache->real_devno);
+      ASSERT (queue != NULL);
+      ioqueue_set_idlework_function (queue, 
+				     &disksim->idlework_cacheflash, 
+				     cache, 
+				     cache->flush_idledelay);
+   }
+}
+
+
+static void 
+cacheflash_cleanstats (struct cache_if *cache)
+{
+}
+
+
+static void 
+cacheflash_printstats (struct cache_if *c, char *prefix)
+{
+   struct cache_flash *cache = (struct cache_flash *)c;
+   int reqs = cache->stat.reads + cache->stat.writes;
+   int blocks = cache->stat.readblocks + cache->stat.writeblocks;
+
+   fprintf (outputfile, "%scache requests:             %6d\n", prefix, reqs);
+   if (reqs == 0) {
+      return;
+   }
+
+   fprintf (outputfile, "%scache read requests:        %6d  \t%6.4f\n", prefix, cache->stat.reads, ((double) cache->stat.reads / (double) reqs));
+
+   if (cache->stat.reads) {
+      fprintf(outputfile, "%scache blocks read:           %6d  \t%6.4f\n", prefix, cache->stat.readblocks, ((double) cache->stat.readblocks / (double) blocks));
+      fprintf(outputfile, "%scache read misses:          %6d  \t%6.4f  \t%6.4f\n", prefix, cache->stat.readmisses, ((double) cache->stat.readmisses / (double) reqs), ((double) cache->stat.readmisses / (double) cache->stat.reads));
+      fprintf(outputfile, "%scache read full hits:       %6d  \t%6.4f  \t%6.4f\n", prefix, cache->stat.readhitsfull, ((double) cache->stat.readhitsfull / (double) reqs), ((double) cache->stat.readhitsfull / (double) cache->stat.reads));
+      fprintf(outputfile, "%scache read partial hits:    %6d  \t%6.4f  \t%6.4f\n", prefix, cache->stat.readhitspartial, ((double) cache->stat.readhitspartial / (double) reqs), ((double) cache->stat.readhitspartial / (double) cache->stat.reads));
+      fprintf(outputfile, "%scache read bypasses:        %6d  \t%6.4f  \t%6.4f\n", prefix, cache->stat.readbypass, ((double) cache->stat.readbypass / (double) reqs), ((double) cache->stat.readbypass / (double) cache->stat.reads));
+      fprintf(outputfile, "%scache population writes:    %6d  \t%6.4f  \t%6.4f\n", prefix, cache->stat.popwrites, ((double) cache->stat.popwrites / (double) reqs), ((double) cache->stat.popwrites / (double) cache->stat.reads));
+      fprintf(outputfile, "%scache block population writes: %6d  \t%6.4f  \t%6.4f\n", prefix, cache->stat.popwriteblocks, ((double) cache->stat.popwriteblocks / (double) blocks), ((double) cache->stat.popwriteblocks / (double) cache->stat.readblocks));
+      fprintf(outputfile, "%scache admission rejects:    %6d\n", prefix, cache->stat.admitrejects);
+   }
+
+   fprintf(outputfile, "%scache write requests:       %6d  \t%6.4f\n", prefix, cache->stat.writes, ((double) cache->stat.writes / (double) reqs));
+
+   if (cache->stat.writes) {
+      fprintf(outputfile, "%scache blocks written:        %6d  \t%6.4f\n", prefix, cache->stat.writeblocks, ((double) cache->stat.writeblocks / (double) blocks));
+      fprintf(outputfile, "%scache write line hits:      %6d\n", prefix, cache->stat.writehits);
+      fprintf(outputfile, "%scache write line misses:    %6d\n", prefix, cache->stat.writemisses);
+      fprintf(outputfile, "%scache write bypasses:       %6d  \t%6.4f  \t%6.4f\n", prefix, cache->stat.writebypass, ((double) cache->stat.writebypass / (double) reqs), ((double) cache->stat.writebypass / (double) cache->stat.writes));
+      if (cache->logstructured) {
+         fprintf(outputfile, "%scache log appends:          %6d\n", prefix, cache->stat.logappends);
+         fprintf(outputfile, "%scache log in-place updates: %6d\n", prefix, cache->stat.loginplace);
+      }
+      fprintf(outputfile, "%scache destage batches:      %6d\n", prefix, cache->stat.destagebatches);
+      fprintf(outputfile, "%scache destage reads:        %6d  \t%6.4f  \t%6.4f\n", prefix, cache->stat.destagereads, ((double) cache->stat.destagereads / (double) reqs), ((double) cache->stat.destagereads / (double) cache->stat.writes));
+      fprintf(outputfile, "%scache block destage reads:  %6d  \t%6.4f  \t%6.4f\n", prefix, cache->stat.destagereadblocks, ((double) cache->stat.destagereadblocks / (double) blocks), ((double) cache->stat.destagereadblocks / (double) cache->stat.writeblocks));
+      fprintf(outputfile, "%scache destages (write):     %6d  \t%6.4f  \t%6.4f\n", prefix, cache->stat.destagewrites, ((double) cache->stat.destagewrites / (double) reqs), ((double) cache->stat.destagewrites / (double) cache->stat.writes));
+      fprintf(outputfile, "%scache block destages (write): %6d  \t%6.4f  \t%6.4f\n", prefix, cache->stat.destagewriteblocks, ((double) cache->stat.destagewriteblocks / (double) blocks), ((double) cache->stat.destagewriteblocks / (double) cache->stat.writeblocks));
+      fprintf(outputfile, "%scache end dirty lines:      %6d  \t%6.4f\n", prefix, cache->ndirty, ((double) cache->ndirty / (double) cache->nlines));
+   }
+
+   fprintf(outputfile, "%scache line evictions:       %6d\n", prefix, cache->stat.evictions);
+   fprintf (outputfile, "%scache bufferspace use end:             %6d\n", prefix, cache->bufferspace);
+   fprintf (outputfile, "%scache bufferspace use max:             %6d\n", prefix, cache->stat.maxbufferspace);
+}
+
+
+static struct cache_if * 
+cacheflash_copy (struct cache_if *c)
+{
+   struct cache_flash *cache = (struct cache_flash *)c;
+   struct cache_flash *new = (struct cache_flash *) DISKSIM_malloc(sizeof(struct cache_flash));
+
+   ASSERT(new != NULL);
+   memcpy(new, cache, sizeof(struct cache_flash));
+
+   /* tables are sized and built by initialize */
+   new->lines = NULL;
+   new->hash = NULL;
+   new->lruhead = NULL;
+   new->lrutail = NULL;
+   new->ghost = NULL;
+   new->ghostcnt = NULL;
+   new->batch = NULL;
+   new->ongoing_requests = NULL;
+   new->bufferspace = 0;
+
+   return (struct cache_if *)new;
+}
+
+
+/* the cache device's own contents are saved with that device; here  */
+/* we save the line map, replacement order and admission history      */
+
+static void cacheflash_checkpoint (struct cache_if *c, checkpoint_t *ckpt)
+{
+   struct cache_flash *cache = (struct cache_flash *)c;
+   int i;
+
+   ASSERT(cache->ongoing_requests == NULL);
+   ASSERT(cache->batchops == 0);
+   checkpoint_put_int(ckpt, cache->nlines);
+   checkpoint_put_int(ckpt, cache->linesize);
+   checkpoint_put_int(ckpt, cache->setsize);
+   for (i=0; i<cache->nlines; i++) {
+      struct cacheflash_line *line = &cache->lines[i];
+      checkpoint_put_int(ckpt, line->tag);
+      checkpoint_put_int(ckpt, (int) line->valid);
+      checkpoint_put_int(ckpt, (int) line->dirty);
+      checkpoint_put_int(ckpt, line->lruprev);
+      checkpoint_put_int(ckpt, line->lrunext);
+   }
+   checkpoint_put_ints(ckpt, cache->lruhead, cache->nsets);
+   checkpoint_put_ints(ckpt, cache->lrutail, cache->nsets);
+   checkpoint_put_int(ckpt, cache->loghead);
+   checkpoint_put_int(ckpt, cache->destagecursor);
+   for (i=0; i<CACHEFLASH_STREAMS; i++) {
+      checkpoint_put_int(ckpt, cache->streams[i].nextblkno);
+      checkpoint_put_int(ckpt, cache->streams[i].len);
+      checkpoint_put_int(ckpt, cache->streams[i].lastuse);
+   }
+   checkpoint_put_int(ckpt, cache->streamclock);
+   checkpoint_put_ints(ckpt, cache->ghost, cache->hashmask + 1);
+   checkpoint_put_bytes(ckpt, cache->ghostcnt, cache->hashmask + 1);
+}
+
+
+static void cacheflash_restore (struct cache_if *c, checkpoint_t *ckpt)
+{
+   struct cache_flash *cache = (struct cache_flash *)c;
+   int i;
+
+   checkpoint_check(ckpt, "cache lines", checkpoint_get_int(ckpt), cache->nlines);
+   checkpoint_check(ckpt, "cache line size", checkpoint_get_int(ckpt), cache->linesize);
+   checkpoint_check(ckpt, "cache set size", checkpoint_get_int(ckpt), cache->setsize);
+   for (i=0; i<cache->nlines; i++) {
+      struct cacheflash_line *line = &cache->lines[i];
+      line->tag = checkpoint_get_int(ckpt);
+      line->valid = (unsigned int) checkpoint_get_int(ckpt);
+      line->dirty = (unsigned int) checkpoint_get_int(ckpt);
+      line->lruprev = checkpoint_get_int(ckpt);
+      line->lrunext = checkpoint_get_int(ckpt);
+   }
+   checkpoint_get_ints(ckpt, cache->lruhead, cache->nsets);
+   checkpoint_get_ints(ckpt, cache->lrutail, cache->nsets);
+   cache->loghead = checkpoint_get_int(ckpt);
+   cache->destagecursor = checkpoint_get_int(ckpt);
+   for (i=0; i<CACHEFLASH_STREAMS; i++) {
+      cache->streams[i].nextblkno = checkpoint_get_int(ckpt);
+      cache->streams[i].len = checkpoint_get_int(ckpt);
+      cache->streams[i].lastuse = checkpoint_get_int(ckpt);
+   }
+   cache->streamclock = checkpoint_get_int(ckpt);
+   checkpoint_get_ints(ckpt, cache->ghost, cache->hashmask + 1);
+   checkpoint_get_bytes(ckpt, cache->ghostcnt, cache->hashmask + 1);
+   cacheflash_rehash(cache);
+}
+
+static struct cache_if disksim_cache_flash = {
+  cacheflash_setcallbacks,
+  cacheflash_initialize,
+  cacheflash_resetstats,
+  cacheflash_printstats,
+  cacheflash_cleanstats,
+  cacheflash_copy,
+  cacheflash_get_block,
+  cacheflash_free_block_clean,
+  cacheflash_free_block_dirty,
+  cacheflash_disk_access_complete,
+  cacheflash_wakeup_complete,
+  cacheflash_sync,
+  cacheflash_get_maxreqsize,
+  cacheflash_checkpoint,
+  cacheflash_restore
+};
+
+struct cache_if *disksim_cacheflash_loadparams(struct lp_block *b)
+{
+  struct cache_flash *result;
+
+  result = calloc(1, sizeof(struct cache_flash));
+  result->hdr = disksim_cache_flash;
+
+  result->name = b->name ? strdup(b->name) : 0;
+
+  lp_loadparams(result, b, &disksim_cacheflash_mod);
+
+  return (struct cache_if *)result;
+}
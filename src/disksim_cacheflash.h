@@ -0,0 +1,188 @@
+/*
+ * DiskSim Storage Subsystem Simulation Environment (Version 4.0)
+ * Revision Authors: John Bucy, Greg Ganger
+ * Contributors: John Griffin, Jiri Schindler, Steve Schlosser
+ *
+ * Copyright (c) of Carnegie Mellon University, 2001-2008.
+ *
+ * This software is being provided by the copyright holders under the
+ * following license. By obtaining, using and/or copying this software,
+ * you agree that you have read, understood, and will comply with the
+ * following terms and conditions:
+ *
+ * Permission to reproduce, use, and prepare derivative works of this
+ * software is granted provided the copyright and "No Warranty" statements
+ * are included with all reproductions and derivative works and associated
+ * documentation. This software may also be redistributed without charge
+ * provided that the copyright and "No Warranty" statements are included
+ * in all redistributions.
+ *
+ * NO WARRANTY. THIS SOFTWARE IS FURNISHED ON AN "AS IS" BASIS.
+ * CARNEGIE MELLON UNIVERSITY MAKES NO WARRANTIES OF ANY KIND, EITHER
+ * EXPRESSED OR IMPLIED AS TO THE MATTER INCLUDING, BUT NOT LIMITED
+ * TO: WARRANTY OF FITNESS FOR PURPOSE OR MERCHANTABILITY, EXCLUSIVITY
+ * OF RESULTS OR RESULTS OBTAINED FROM USE OF THIS SOFTWARE. CARNEGIE
+ * MELLON UNIVERSITY DOES NOT MAKE ANY WARRANTY OF ANY KIND WITH RESPECT
+ * TO FREEDOM FROM PATENT, TRADEMARK, OR COPYRIGHT INFRINGEMENT.
+ * COPYRIGHT HOLDERS WILL BEAR NO LIABILITY FOR ANY USE OF THIS SOFTWARE
+ * OR DOCUMENTATION.
+ *
+ */
+
+#ifndef DISKSIM_CACHEFLASH_H
+#define DISKSIM_CACHEFLASH_H
+
+#include "disksim_global.h"
+#include "disksim_iosim.h"
+#include "disksim_ioqueue.h"
+#include "config.h"
+#include "disksim_cache.h"
+
+/* cacheflash event types */
+
+#define CACHEFLASH_EVENT_READ           1
+#define CACHEFLASH_EVENT_WRITE          2
+#define CACHEFLASH_EVENT_POPULATE       3
+#define CACHEFLASH_EVENT_DESTAGE_READ   4
+#define CACHEFLASH_EVENT_DESTAGE_WRITE  5
+
+/* write schemes (same values as the other caches) */
+
+#define CACHEFLASH_WRITE_MIN    2
+#define CACHEFLASH_WRITE_THRU   2
+#define CACHEFLASH_WRITE_BACK   3
+#define CACHEFLASH_WRITE_MAX    3
+
+/* line flags */
+
+#define CACHEFLASH_DESTAGING    0x1	/* a destage is reading the line   */
+#define CACHEFLASH_REWRITTEN    0x2	/* ... and it was written meanwhile */
+
+#define CACHEFLASH_MAXLINESIZE  32	/* blocks; masks are one word      */
+#define CACHEFLASH_STREAMS      8	/* sequential streams tracked      */
+
+
+struct cacheflash_event {
+   double time;
+   int type;
+   struct cacheflash_event *next;
+   struct cacheflash_event *prev;
+   void (**donefunc)(void *,ioreq_event *);	/* Function to call when complete */
+   void *doneparam;		/* parameter for donefunc */
+   ioreq_event *req;
+   int pending;			/* device accesses still outstanding */
+   int bypass;			/* kept out of the cache */
+   int blkno;			/* destage: extent on the cached device */
+   int bcount;
+   int first;			/* destage: lines are batch[first..first+count) */
+   int count;
+};
+
+/* One slot on the cache device, holding one line of the cached device. */
+/* valid and dirty have a bit per block of the line.                    */
+
+struct cacheflash_line {
+   int tag;			/* line number on cached device, -1 if free */
+   unsigned int valid;
+   unsigned int dirty;
+   int busy;			/* device accesses in flight on this slot */
+   int flags;
+   int hashnext;
+   int lruprev;			/* toward MRU */
+   int lrunext;			/* toward LRU */
+};
+
+struct cacheflash_stream {
+   int nextblkno;		/* where the stream will continue */
+   int len;			/* blocks seen so far */
+   int lastuse;
+};
+
+struct cacheflash_destage {
+   int slot;
+   int tag;
+   unsigned int mask;
+};
+
+struct cacheflash_stats {
+   int reads;
+   int readblocks;
+   int readhitsfull;
+   int readhitspartial;
+   int readmisses;
+   int readbypass;
+   int popwrites;
+   int popwriteblocks;
+   int admitrejects;
+   int writes;
+   int writeblocks;
+   int writehits;
+   int writemisses;
+   int writebypass;
+   int logappends;
+   int loginplace;
+   int evictions;
+   int destagebatches;
+   int destagereads;
+   int destagereadblocks;
+   int destagewrites;
+   int destagewriteblocks;
+   int maxbufferspace;
+};
+
+
+struct cache_flash {
+  struct cache_if hdr;
+   void (**issuefunc)(void *,ioreq_event *);	/* to issue a disk access    */
+   void *issueparam;				/* first param for issuefunc */
+   struct ioq * (**queuefind)(void *,int);	/* to get ioqueue ptr for dev*/
+   void *queuefindparam;			/* first param for queuefind */
+   void (**wakeupfunc)(void *, struct cacheevent *);	/* to re-activate slept proc */
+   void *wakeupparam;				/* first param for wakeupfunc */
+   int size;					/* in 512B blks  */
+   int cache_devno;				/* device used for cache */
+   int real_devno;				/* device for which cache is used */
+   int maxreqsize;
+   int writescheme;
+   int linesize;				/* blocks per line */
+   int assoc;					/* lines per set, 0 = fully */
+   int logstructured;
+   int seqthreshold;				/* blocks, 0 = no bypass */
+   int admitthreshold;				/* misses before admission */
+   int destagebatch;				/* lines per destage batch */
+   double highwater;				/* fraction of lines dirty */
+   double lowwater;
+   double flush_idledelay;
+
+   int nlines;
+   int nsets;
+   int setsize;
+   struct cacheflash_line *lines;
+   int *hash;					/* line number -> slot */
+   int hashmask;
+   int *lruhead;				/* per set */
+   int *lrutail;
+   int loghead;					/* next slot to (re)use */
+   int ndirty;					/* lines with any dirty blocks */
+
+   struct cacheflash_stream streams[CACHEFLASH_STREAMS];
+   int streamclock;
+   int *ghost;					/* misses by line, for admission */
+   unsigned char *ghostcnt;
+
+   struct cacheflash_destage *batch;		/* current destage batch */
+   int batchlen;
+   int batchops;				/* its accesses in flight */
+   int destagecursor;
+   int idledestage;
+
+   int bufferspace;
+   struct cacheflash_event *ongoing_requests;
+   struct cacheflash_stats stat;
+   char *name;
+};
+
+void cacheflash_setcallbacks(void);
+
+
+#endif // DISKSIM_CACHEFLASH_H
@@ -102,6 +102,7 @@
 
 #include "modules/modules.h"
 #include "disksim_cachemem.h"
+#include "disksim_checkpoint.h"
 
 
 /* state components of atom */
@@ -431,7 +432,7 @@ static cache_atom *cache_get_replace_startpoint (struct cache_mem *cache, int se
 
    if (line) {
       if (cache->replacepolicy == CACHE_REPLACE_RANDOM) {
-         int choice = cache->map[set].numactive[0] * DISKSIM_drand48();
+         int choice = cache->map[set].numactive[0] * disksim_rng_uniform(&cache->rng);
          int i;
          for (i=0; i<choice; i++) {
             line = line->lru_prev;
@@ -1439,6 +1440,7 @@ static int cache_read_continue (struct cache_mem *cache, struct cache_mem_event
    if (cache->size == 0) {
       cache_waitfor_IO(cache, 1, readdesc, readdesc->req);
       cache->stat.readmisses++;
+      iosim_sample_cache_access(readdesc->req, FALSE);
       cache->stat.fillreads++;
       cache->stat.fillreadatoms += readdesc->req->bcount;
       readdesc->req->type = IO_ACCESS_ARRIVE;
@@ -1556,6 +1558,7 @@ read_cont_loop:
    } else {
       cache->stat.readhitsfull++;
    }
+   iosim_sample_cache_access(readdesc->req, (readdesc->allocstop == 0));
    if (readdesc->flags & CACHE_FLAG_WASBLOCKED) {
       /* callback to say done */
       (*readdesc->donefunc)(readdesc->doneparam, readdesc->req);
@@ -2158,6 +2161,7 @@ cachemem_initialize (struct cache_if *c,
 {
   struct cache_mem *cache = (struct cache_mem *)c;
    int i, j;
+   int scale;
    cache_atom *tmp;
 
    StaticAssert (sizeof(cache_atom) <= DISKSIM_EVENT_SIZE);
@@ -2171,6 +2175,7 @@ cachemem_initialize (struct cache_if *c,
    cache->queuefindparam = queuefindparam;
    cache->wakeupfunc = wakeupfunc;
    cache->wakeupparam = wakeupparam;
+   disksim_rng_init(&cache->rng, "cachemem", -1);
    cache->IOwaiters = NULL;
    cache->partwrites = NULL;
    cache->linewaiters = NULL;
@@ -2178,6 +2183,19 @@ cachemem_initialize (struct cache_if *c,
    for (i=0; i<CACHE_HASHSIZE; i++) {
       cache->hash[i] = 0;
    }
+   /* a spatially sampled trace sees a proportionally smaller cache */
+   if ((cache->size) && (cache->map[0].freelist == NULL) &&
+       ((scale = iosim_sample_capacity_divisor()) > 1)) {
+      int unit = max(1, cache->linesize) * (cache->mapmask+1);
+      cache->size = max(unit, (((cache->size / scale) / unit) * unit));
+      for (j=0; j<(cache->mapmask+1); j++) {
+         for (i=0; i<CACHE_MAXSEGMENTS; i++) {
+            if (cache->map[j].maxactive[i]) {
+               cache->map[j].maxactive[i] = max(1, (cache->map[j].maxactive[i] / scale));
+            }
+         }
+      }
+   }
    for (j=0; j<(cache->mapmask+1); j++) {
       cache_mapentry *mapentry = &cache->map[j];
       for (i=0; i<CACHE_MAXSEGMENTS; i++) {
@@ -2411,6 +2429,85 @@ void cachemem_setup_segs(struct cache_mem *result, struct lp_list *l) {
 }
 
 
+/* Checkpoints hold the mapped lines of each set, in replacement order, */
+/* with their valid/dirty state.  Only fixed-size lines are saved; with */
+/* variable-size lines (line size 0) the cache is restored empty.       */
+
+static void cachemem_checkpoint (struct cache_if *c, checkpoint_t *ckpt)
+{
+   struct cache_mem *cache = (struct cache_mem *)c;
+   int set, segnum;
+
+   ASSERT((cache->IOwaiters == NULL) && (cache->partwrites == NULL) && (cache->linewaiters == NULL));
+   checkpoint_put_int(ckpt, cache->size);
+   checkpoint_put_int(ckpt, cache->linesize);
+   checkpoint_put_int(ckpt, cache->mapmask);
+   checkpoint_put_int(ckpt, cache->numsegs);
+   if (cache->linesize <= 0) {
+      return;
+   }
+
+   for (set=0; set<(cache->mapmask+1); set++) {
+      cache_mapentry *mapentry = &cache->map[set];
+      for (segnum=0; segnum<cache->numsegs; segnum++) {
+         cache_atom *line = mapentry->lru[segnum];
+         checkpoint_put_int(ckpt, mapentry->numactive[segnum]);
+         if (line == NULL) {
+            continue;
+         }
+         do {
+            cache_atom *tmp;
+            for (tmp = line; tmp; tmp = tmp->line_next) {
+               ASSERT((!tmp->writelock) && (!tmp->readlocks) && (!tmp->lockwaiters));
+               checkpoint_put_int(ckpt, tmp->devno);
+               checkpoint_put_int(ckpt, tmp->lbn);
+               checkpoint_put_int(ckpt, (tmp->state & ~CACHE_SEGNUM));
+            }
+            line = line->lru_next;
+         } while (line != mapentry->lru[segnum]);
+      }
+   }
+}
+
+
+static void cachemem_restore (struct cache_if *c, checkpoint_t *ckpt)
+{
+   struct cache_mem *cache = (struct cache_mem *)c;
+   int set, segnum;
+   int i;
+
+   checkpoint_check(ckpt, "cache size", checkpoint_get_int(ckpt), cache->size);
+   checkpoint_check(ckpt, "cache line size", checkpoint_get_int(ckpt), cache->linesize);
+   checkpoint_check(ckpt, "cache set mask", checkpoint_get_int(ckpt), cache->mapmask);
+   checkpoint_check(ckpt, "cache segments", checkpoint_get_int(ckpt), cache->numsegs);
+   if (cache->linesize <= 0) {
+      return;
+   }
+
+   for (set=0; set<(cache->mapmask+1); set++) {
+      cache_mapentry *mapentry = &cache->map[set];
+      for (segnum=0; segnum<cache->numsegs; segnum++) {
+         int numlines = checkpoint_get_int(ckpt);
+         for (i=0; i<numlines; i++) {
+            cache_atom *line = mapentry->freelist;
+            cache_atom *tmp;
+            if (line == NULL) {
+               checkpoint_mismatch(ckpt, "cache contents");
+            }
+            cache_remove_from_lrulist(mapentry, line, CACHE_SEGNUM);
+            for (tmp = line; tmp; tmp = tmp->line_next) {
+               tmp->devno = checkpoint_get_int(ckpt);
+               tmp->lbn = checkpoint_get_int(ckpt);
+               tmp->state = checkpoint_get_int(ckpt);
+               cache_insert_new_into_hash(cache, tmp);
+            }
+            cache_add_to_lrulist(mapentry, line, segnum);
+         }
+      }
+   }
+}
+
+
 static struct cache_if disksim_cache_mem = {
   cachemem_setcallbacks,
   cachemem_initialize,
@@ -2424,7 +2521,9 @@ static struct cache_if disksim_cache_mem = {
   cachemem_disk_access_complete,
   cachemem_wakeup_complete,
   cachemem_sync,
-  cachemem_get_maxreqsize
+  cachemem_get_maxreqsize,
+  cachemem_checkpoint,
+  cachemem_restore
 };
 
 
@@ -213,6 +213,7 @@ struct cache_mem {
    int sharedreadlocks;
    int maxreqsize;
    int replacepolicy;
+   disksim_rng rng;				/* for random replacement */
    int mapmask;
    int writescheme;
    int read_prefetch_type;
@@ -0,0 +1,443 @@
+/*
+ * DiskSim Storage Subsystem Simulation Environment (Version 4.0)
+ * Revision Authors: John Bucy, Greg Ganger
+ * Contributors: John Griffin, Jiri Schindler, Steve Schlosser
+ *
+ * Copyright (c) of Carnegie Mellon University, 2001-2008.
+ *
+ * This software is being provided by the copyright holders under the
+ * following license. By obtaining, using and/or copying this software,
+ * you agree that you have read, understood, and will comply with the
+ * following terms and conditions:
+ *
+ * Permission to reproduce, use, and prepare derivative works of this
+ * software is granted provided the copyright and "No Warranty" statements
+ * are included with all reproductions and derivative works and associated
+ * documentation. This software may also be redistributed without charge
+ * provided that the copyright and "No Warranty" statements are included
+ * in all redistributions.
+ *
+ * NO WARRANTY. THIS SOFTWARE IS FURNISHED ON AN "AS IS" BASIS.
+ * CARNEGIE MELLON UNIVERSITY MAKES NO WARRANTIES OF ANY KIND, EITHER
+ * EXPRESSED OR IMPLIED AS TO THE MATTER INCLUDING, BUT NOT LIMITED
+ * TO: WARRANTY OF FITNESS FOR PURPOSE OR MERCHANTABILITY, EXCLUSIVITY
+ * OF RESULTS OR RESULTS OBTAINED FROM USE OF THIS SOFTWARE. CARNEGIE
+ * MELLON UNIVERSITY DOES NOT MAKE ANY WARRANTY OF ANY KIND WITH RESPECT
+ * TO FREEDOM FROM PATENT, TRADEMARK, OR COPYRIGHT INFRINGEMENT.
+ * COPYRIGHT HOLDERS WILL BEAR NO LIABILITY FOR ANY USE OF THIS SOFTWARE
+ * OR DOCUMENTATION.
+ *
+ */
+
+
+/*
+ * Checkpoints hold the "warm" state of a simulation: SSD mapping and
+ * wear state, disk buffer contents and head position, controller cache
+ * contents, scheduler position, the random number generator and the
+ * position in the trace.  They are only taken when the storage
+ * subsystem is idle (see disksim_checkpoint() in disksim.c), so the
+ * only events that need saving are the next trace arrival; module
+ * timers are recreated by initialization.
+ *
+ * A checkpoint is restored on top of a freshly initialized simulator
+ * built from the (possibly different) parameter file of the restoring
+ * run.  Each module checks that the saved state fits the new
+ * configuration -- e.g. same SSD geometry -- and gives up otherwise,
+ * so a warmed-up state can be reused by many experiment variants that
+ * differ in scheduling, timing, etc.  Statistics are not saved; a
+ * restored run reports only what happens after the checkpoint.
+ */
+
+#include "disksim_global.h"
+#include "disksim_checkpoint.h"
+#include "disksim_iosim.h"
+#include "disksim_iotrace.h"
+#include "disksim_disk.h"
+#include "disksim_controller.h"
+#include "disksim_rand48.h"
+#include "config.h"
+
+#include "ssdmodel/ssd.h"
+
+
+static void checkpoint_save_core (checkpoint_t *ckpt);
+static void checkpoint_restore_core (checkpoint_t *ckpt, int instance);
+static void checkpoint_save_rng (checkpoint_t *ckpt);
+static void checkpoint_restore_rng (checkpoint_t *ckpt, int instance);
+
+static struct {
+   char *tag;
+   void (*save)(checkpoint_t *);
+   void (*restore)(checkpoint_t *, int);
+} checkpoint_sections[] = {
+   { "CORE", checkpoint_save_core,  checkpoint_restore_core },
+   { "RNG ", checkpoint_save_rng,   checkpoint_restore_rng },
+   { "IOTR", iotrace_checkpoint,    iotrace_restore },
+   { "IOSM", io_checkpoint,         io_restore },
+   { "DISK", disk_checkpoint,       disk_restore },
+   { "SSD ", ssd_checkpoint,        ssd_restore },
+   { "CTLR", controller_checkpoint, controller_restore },
+};
+
+#define NUM_CHECKPOINT_SECTIONS \
+   (sizeof(checkpoint_sections) / sizeof(checkpoint_sections[0]))
+
+
+static void checkpoint_fatal (checkpoint_t *ckpt, char *msg)
+{
+   fprintf(stderr, "Checkpoint %s: %s", ckpt->filename, msg);
+   if (ckpt->tag[0]) {
+      fprintf(stderr, " (section %s #%d)", ckpt->tag, ckpt->instance);
+   }
+   fprintf(stderr, "\n");
+   exit(1);
+}
+
+
+/* Raw access.  Byte order is fixed here; nothing above cares. */
+
+void checkpoint_put_bytes (checkpoint_t *ckpt, void *buf, int len)
+{
+   fwrite(buf, 1, len, ckpt->file);
+}
+
+
+void checkpoint_get_bytes (checkpoint_t *ckpt, void *buf, int len)
+{
+   if (len > ckpt->remaining) {
+      checkpoint_fatal(ckpt, "section is shorter than expected");
+   }
+   if (fread(buf, 1, len, ckpt->file) != (size_t)len) {
+      checkpoint_fatal(ckpt, "file is truncated");
+   }
+   ckpt->remaining -= len;
+}
+
+
+static void checkpoint_put_u64 (checkpoint_t *ckpt, uint64_t val, int len)
+{
+   unsigned char b[8];
+   int i;
+
+   for (i=0; i<len; i++) {
+      b[i] = (unsigned char) (val >> (8*i));
+   }
+   checkpoint_put_bytes(ckpt, b, len);
+}
+
+
+static uint64_t checkpoint_get_u64 (checkpoint_t *ckpt, int len)
+{
+   unsigned char b[8];
+   uint64_t val = 0;
+   int i;
+
+   checkpoint_get_bytes(ckpt, b, len);
+   for (i=0; i<len; i++) {
+      val |= ((uint64_t) b[i]) << (8*i);
+   }
+   return(val);
+}
+
+
+void checkpoint_put_int (checkpoint_t *ckpt, int val)
+{
+   checkpoint_put_u64(ckpt, (uint32_t) val, 4);
+}
+
+
+int checkpoint_get_int (checkpoint_t *ckpt)
+{
+   return((int32_t) checkpoint_get_u64(ckpt, 4));
+}
+
+
+void checkpoint_put_int64 (checkpoint_t *ckpt, int64_t val)
+{
+   checkpoint_put_u64(ckpt, (uint64_t) val, 8);
+}
+
+
+int64_t checkpoint_get_int64 (checkpoint_t *ckpt)
+{
+   return((int64_t) checkpoint_get_u64(ckpt, 8));
+}
+
+
+void checkpoint_put_double (checkpoint_t *ckpt, double val)
+{
+   uint64_t bits;
+
+   StaticAssert (sizeof(double) == sizeof(uint64_t));
+   memcpy(&bits, &val, sizeof(bits));
+   checkpoint_put_u64(ckpt, bits, 8);
+}
+
+
+double checkpoint_get_double (checkpoint_t *ckpt)
+{
+   uint64_t bits = checkpoint_get_u64(ckpt, 8);
+   double val;
+
+   memcpy(&val, &bits, sizeof(val));
+   return(val);
+}
+
+
+void checkpoint_put_ints (checkpoint_t *ckpt, int *vals, int cnt)
+{
+   int i;
+
+   for (i=0; i<cnt; i++) {
+      checkpoint_put_int(ckpt, vals[i]);
+   }
+}
+
+
+void checkpoint_get_ints (checkpoint_t *ckpt, int *vals, int cnt)
+{
+   int i;
+
+   for (i=0; i<cnt; i++) {
+      vals[i] = checkpoint_get_int(ckpt);
+   }
+}
+
+
+/* Sections are framed as tag, instance number and payload length so */
+/* that a restore can skip sections it doesn't know about.            */
+
+void checkpoint_begin_section (checkpoint_t *ckpt, char *tag, int instance)
+{
+   ASSERT(strlen(tag) == 4);
+   strcpy(ckpt->tag, tag);
+   ckpt->instance = instance;
+   checkpoint_put_bytes(ckpt, tag, 4);
+   checkpoint_put_int(ckpt, instance);
+   ckpt->sectstart = ftell(ckpt->file);
+   checkpoint_put_int(ckpt, 0);
+}
+
+
+void checkpoint_end_section (checkpoint_t *ckpt)
+{
+   long end = ftell(ckpt->file);
+
+   fseek(ckpt->file, ckpt->sectstart, SEEK_SET);
+   checkpoint_put_int(ckpt, (int) (end - ckpt->sectstart - 4));
+   fseek(ckpt->file, end, SEEK_SET);
+   ckpt->tag[0] = 0;
+}
+
+
+/* For restore functions: the saved state must fit the configuration. */
+
+void checkpoint_check (checkpoint_t *ckpt, char *what, int saved, int current)
+{
+   if (saved != current) {
+      char msg[200];
+      sprintf(msg, "saved %s %d does not match configured %d", what, saved, current);
+      checkpoint_fatal(ckpt, msg);
+   }
+}
+
+
+void checkpoint_mismatch (checkpoint_t *ckpt, char *what)
+{
+   char msg[200];
+   sprintf(msg, "%s does not match the configuration", what);
+   checkpoint_fatal(ckpt, msg);
+}
+
+
+static void checkpoint_save_core (checkpoint_t *ckpt)
+{
+   unsigned short rngstate[7];
+   int i;
+
+   checkpoint_begin_section(ckpt, "CORE", 0);
+   checkpoint_put_double(ckpt, simtime);
+   checkpoint_put_int(ckpt, disksim->totalreqs);
+   checkpoint_put_double(ckpt, disksim->lastphystime);
+   DISKSIM_rand48_getstate(rngstate);
+   for (i=0; i<7; i++) {
+      checkpoint_put_int(ckpt, rngstate[i]);
+   }
+   checkpoint_end_section(ckpt);
+}
+
+
+/* Everything initialization put on the event queue (e.g. periodic */
+/* cache flushes) was scheduled relative to time 0; move it to the  */
+/* checkpoint time along with the clock.                            */
+
+static void checkpoint_restore_core (checkpoint_t *ckpt, int instance)
+{
+   unsigned short rngstate[7];
+   event *tmp;
+   int i;
+
+   simtime = checkpoint_get_double(ckpt);
+   warmuptime = simtime;	/* statistics start here */
+   disksim->totalreqs = checkpoint_get_int(ckpt);
+   disksim->lastphystime = checkpoint_get_double(ckpt);
+   for (i=0; i<7; i++) {
+      rngstate[i] = (unsigned short) checkpoint_get_int(ckpt);
+   }
+   DISKSIM_rand48_setstate(rngstate);
+
+   for (tmp = disksim->intq; tmp; tmp = tmp->next) {
+      tmp->time += simtime;
+   }
+   if (disksim->warmup_event) {
+      disksim->warmup_event->time += simtime;
+   }
+}
+
+
+/* Per-module random streams, in initialization order (which the */
+/* configuration fixes).                                           */
+
+static void checkpoint_save_rng (checkpoint_t *ckpt)
+{
+   disksim_rng *rng;
+   int cnt = 0;
+   int i;
+
+   for (rng = disksim_rng_streams(); rng; rng = rng->next) {
+      cnt++;
+   }
+   checkpoint_begin_section(ckpt, "RNG ", 0);
+   checkpoint_put_int(ckpt, cnt);
+   for (rng = disksim_rng_streams(); rng; rng = rng->next) {
+      checkpoint_put_int(ckpt, rng->kind);
+      for (i=0; i<4; i++) {
+         checkpoint_put_int64(ckpt, (int64_t) rng->s[i]);
+      }
+   }
+   checkpoint_end_section(ckpt);
+}
+
+
+static void checkpoint_restore_rng (checkpoint_t *ckpt, int instance)
+{
+   disksim_rng *rng;
+   int cnt = 0;
+   int i;
+
+   for (rng = disksim_rng_streams(); rng; rng = rng->next) {
+      cnt++;
+   }
+   checkpoint_check(ckpt, "random stream count", checkpoint_get_int(ckpt), cnt);
+   for (rng = disksim_rng_streams(); rng; rng = rng->next) {
+      checkpoint_check(ckpt, "random stream kind", checkpoint_get_int(ckpt), rng->kind);
+      for (i=0; i<4; i++) {
+         rng->s[i] = (uint64_t) checkpoint_get_int64(ckpt);
+      }
+   }
+}
+
+
+/* Writes a checkpoint to an open, seekable stream.  Returns 0 on */
+/* success.                                                        */
+
+int checkpoint_write_file (FILE *file, char *name)
+{
+   checkpoint_t ckpt;
+   int i;
+
+   memset(&ckpt, 0, sizeof(ckpt));
+   ckpt.filename = name;
+   ckpt.file = file;
+
+   checkpoint_put_int(&ckpt, CHECKPOINT_MAGIC);
+   checkpoint_put_int(&ckpt, CHECKPOINT_VERSION);
+   for (i=0; i<NUM_CHECKPOINT_SECTIONS; i++) {
+      (*checkpoint_sections[i].save)(&ckpt);
+   }
+   return(ferror(file) ? -1 : 0);
+}
+
+
+/* Returns 0 on success.  Written to a temporary and renamed so that */
+/* periodic checkpoints never leave a partial file behind.           */
+
+int checkpoint_write (char *filename)
+{
+   FILE *file;
+   char tmpname[300];
+   int ret;
+
+   sprintf(tmpname, "%s.tmp", filename);
+   if ((file = fopen(tmpname, "wb")) == NULL) {
+      return(-1);
+   }
+
+   ret = checkpoint_write_file(file, filename);
+   ret |= fclose(file);
+   if ((ret == 0) && (rename(tmpname, filename) == 0)) {
+      return(0);
+   }
+   remove(tmpname);
+   return(-1);
+}
+
+
+/* Called after initialization and before the simulation is primed. */
+/* The stream is left open.                                         */
+
+void checkpoint_restore_file (FILE *file, char *name)
+{
+   checkpoint_t ckpt;
+   char tag[5];
+   int i;
+
+   memset(&ckpt, 0, sizeof(ckpt));
+   ckpt.filename = name;
+   ckpt.file = file;
+
+   ckpt.remaining = 8;
+   if (checkpoint_get_int(&ckpt) != CHECKPOINT_MAGIC) {
+      checkpoint_fatal(&ckpt, "not a DiskSim checkpoint");
+   }
+   if (checkpoint_get_int(&ckpt) != CHECKPOINT_VERSION) {
+      checkpoint_fatal(&ckpt, "written by an incompatible version of DiskSim");
+   }
+
+   while (fread(tag, 1, 4, ckpt.file) == 4) {
+      tag[4] = 0;
+      ckpt.remaining = 8;
+      ckpt.instance = checkpoint_get_int(&ckpt);
+      ckpt.remaining = checkpoint_get_int(&ckpt);
+      strcpy(ckpt.tag, tag);
+
+      for (i=0; i<NUM_CHECKPOINT_SECTIONS; i++) {
+         if (strcmp(tag, checkpoint_sections[i].tag) == 0) {
+            break;
+         }
+      }
+      if (i == NUM_CHECKPOINT_SECTIONS) {
+         fprintf(stderr, "Checkpoint %s: skipping unknown section %s\n", name, tag);
+         fseek(ckpt.file, ckpt.remaining, SEEK_CUR);
+         continue;
+      }
+
+      (*checkpoint_sections[i].restore)(&ckpt, ckpt.instance);
+      if (ckpt.remaining != 0) {
+         checkpoint_fatal(&ckpt, "section is longer than expected");
+      }
+   }
+}
+
+
+void checkpoint_restore (char *filename)
+{
+   FILE *file;
+
+   if ((file = fopen(filename, "rb")) == NULL) {
+      fprintf(stderr, "Checkpoint %s: cannot be opened for read access\n", filename);
+      exit(1);
+   }
+   checkpoint_restore_file(file, filename);
+   fclose(file);
+}
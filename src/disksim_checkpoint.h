@@ -0,0 +1,78 @@
+/*
+ * DiskSim Storage Subsystem Simulation Environment (Version 4.0)
+ * Revision Authors: John Bucy, Greg Ganger
+ * Contributors: John Griffin, Jiri Schindler, Steve Schlosser
+ *
+ * Copyright (c) of Carnegie Mellon University, 2001-2008.
+ *
+ * This software is being provided by the copyright holders under the
+ * following license. By obtaining, using and/or copying this software,
+ * you agree that you have read, understood, and will comply with the
+ * following terms and conditions:
+ *
+ * Permission to reproduce, use, and prepare derivative works of this
+ * software is granted provided the copyright and "No Warranty" statements
+ * are included with all reproductions and derivative works and associated
+ * documentation. This software may also be redistributed without charge
+ * provided that the copyright and "No Warranty" statements are included
+ * in all redistributions.
+ *
+ * NO WARRANTY. THIS SOFTWARE IS FURNISHED ON AN "AS IS" BASIS.
+ * CARNEGIE MELLON UNIVERSITY MAKES NO WARRANTIES OF ANY KIND, EITHER
+ * EXPRESSED OR IMPLIED AS TO THE MATTER INCLUDING, BUT NOT LIMITED
+ * TO: WARRANTY OF FITNESS FOR PURPOSE OR MERCHANTABILITY, EXCLUSIVITY
+ * OF RESULTS OR RESULTS OBTAINED FROM USE OF THIS SOFTWARE. CARNEGIE
+ * MELLON UNIVERSITY DOES NOT MAKE ANY WARRANTY OF ANY KIND WITH RESPECT
+ * TO FREEDOM FROM PATENT, TRADEMARK, OR COPYRIGHT INFRINGEMENT.
+ * COPYRIGHT HOLDERS WILL BEAR NO LIABILITY FOR ANY USE OF THIS SOFTWARE
+ * OR DOCUMENTATION.
+ *
+ */
+
+#ifndef DISKSIM_CHECKPOINT_H
+#define DISKSIM_CHECKPOINT_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+/* A checkpoint file is a small header followed by a sequence of tagged  */
+/* sections, one per module instance.  All values are written as fixed  */
+/* size little-endian integers and IEEE doubles, so a checkpoint taken  */
+/* on one platform can be restored on another.  Bump the version        */
+/* whenever the contents of any section change.                         */
+
+#define CHECKPOINT_MAGIC	0x4b435344	/* "DSCK" */
+#define CHECKPOINT_VERSION	6
+
+typedef struct checkpoint {
+   FILE *file;
+   char *filename;
+   char  tag[5];	/* current section */
+   int   instance;
+   long  sectstart;	/* offset of current section's length field */
+   int   remaining;	/* bytes left in the current section (restore) */
+} checkpoint_t;
+
+/* used by the per-module save/restore functions */
+void   checkpoint_begin_section (checkpoint_t *ckpt, char *tag, int instance);
+void   checkpoint_end_section (checkpoint_t *ckpt);
+void   checkpoint_put_int (checkpoint_t *ckpt, int val);
+void   checkpoint_put_int64 (checkpoint_t *ckpt, int64_t val);
+void   checkpoint_put_double (checkpoint_t *ckpt, double val);
+void   checkpoint_put_ints (checkpoint_t *ckpt, int *vals, int cnt);
+void   checkpoint_put_bytes (checkpoint_t *ckpt, void *buf, int len);
+int    checkpoint_get_int (checkpoint_t *ckpt);
+int64_t checkpoint_get_int64 (checkpoint_t *ckpt);
+double checkpoint_get_double (checkpoint_t *ckpt);
+void   checkpoint_get_ints (checkpoint_t *ckpt, int *vals, int cnt);
+void   checkpoint_get_bytes (checkpoint_t *ckpt, void *buf, int len);
+void   checkpoint_check (checkpoint_t *ckpt, char *what, int saved, int current);
+void   checkpoint_mismatch (checkpoint_t *ckpt, char *what);
+
+/* take or restore a checkpoint of the whole simulator */
+int    checkpoint_write (char *filename);
+int    checkpoint_write_file (FILE *file, char *name);
+void   checkpoint_restore (char *filename);
+void   checkpoint_restore_file (FILE *file, char *name);
+
+#endif    /* DISKSIM_CHECKPOINT_H */
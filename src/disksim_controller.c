@@ -106,6 +106,7 @@
 #include "disksim_ioqueue.h"
 #include "disksim_cache.h"
 #include "disksim_bus.h"
+#include "disksim_checkpoint.h"
 #include "config.h"
 
 #include "modules/modules.h"
@@ -341,7 +342,7 @@ void controller_remove_type_from_buswait (controller *currctlr, int type)
       exit(1);
    } else {
       busno = controller_get_downward_busno(currctlr, tmp, NULL);
-      bus_remove_from_arbitration(busno, tmp);
+      bus_remove_from_arbitration(busno, controller_get_outslot(currctlr->ctlno, busno), tmp);
       addtoextraq((event *) tmp);
    }
 }
@@ -372,7 +373,7 @@ fprintf (outputfile, "Controller_bus_delay_complete - ctlno %d, busno %d, blkno
    if (busno == controller_get_upward_busno(currctlr, curr, &slotno)) {
       buswaitdir = UP;
       if (busno == -1) {
-         intr_request ((event *)curr);
+         bus_interrupt_host (curr);
       } else {
          bus_deliver_event(busno, slotno, curr);
       }
@@ -416,6 +417,10 @@ void controller_event_arrive (int ctlno, ioreq_event *curr)
                controller_smart_event_arrive(currctlr, curr);
                break;
 
+      case CTLR_MULTIQUEUE:
+               controller_mq_event_arrive(currctlr, curr);
+               break;
+
       default:
                fprintf(stderr, "Unknown controller type in controller_interrupt_arrive: %d\n", currctlr->type);
                exit(1);
@@ -712,11 +717,64 @@ void controller_initialize()
       currctlr->waitingforbus = 0.0;
       if (currctlr->type == CTLR_SMART) {
          controller_smart_initialize(currctlr);
+      } else if (currctlr->type == CTLR_MULTIQUEUE) {
+         controller_smart_initialize(currctlr);
+         controller_mq_initialize(currctlr);
+      }
+   }
+}
+
+
+/* Only smart controllers carry warm state: their per-device scheduler */
+/* position and their cache.  Multi-queue controllers are smart        */
+/* controllers whose engines must be idle at a checkpoint.             */
+
+void controller_checkpoint (checkpoint_t *ckpt)
+{
+   ctlrinfo_t *ctlrinfo = disksim->ctlrinfo;
+   int i, devno;
+
+   if (ctlrinfo == NULL) {
+      return;
+   }
+   for (i=0; i<ctlrinfo->numcontrollers; i++) {
+      controller *currctlr = getctlr(i);
+      if ((currctlr->type != CTLR_SMART) && (currctlr->type != CTLR_MULTIQUEUE)) {
+         continue;
+      }
+      if (currctlr->type == CTLR_MULTIQUEUE) {
+         ASSERT(controller_mq_idle(currctlr));
       }
+      checkpoint_begin_section(ckpt, "CTLR", i);
+      checkpoint_put_int(ckpt, currctlr->numdevices);
+      for (devno=0; devno<currctlr->numdevices; devno++) {
+         ioqueue_checkpoint(ckpt, currctlr->devices[devno].queue);
+      }
+      currctlr->cache->cache_checkpoint(currctlr->cache, ckpt);
+      checkpoint_end_section(ckpt);
    }
 }
 
 
+void controller_restore (checkpoint_t *ckpt, int ctlno)
+{
+   ctlrinfo_t *ctlrinfo = disksim->ctlrinfo;
+   controller *currctlr;
+   int devno;
+
+   if ((ctlrinfo == NULL) || (ctlno < 0) || (ctlno >= ctlrinfo->numcontrollers)
+       || (((currctlr = getctlr(ctlno))->type != CTLR_SMART)
+           && (currctlr->type != CTLR_MULTIQUEUE))) {
+      checkpoint_mismatch(ckpt, "controller number");
+   }
+   checkpoint_check(ckpt, "controller devices", checkpoint_get_int(ckpt), currctlr->numdevices);
+   for (devno=0; devno<currctlr->numdevices; devno++) {
+      ioqueue_restore(ckpt, currctlr->devices[devno].queue);
+   }
+   currctlr->cache->cache_restore(currctlr->cache, ckpt);
+}
+
+
 void controller_resetstats()
 {
    ctlrinfo_t *ctlrinfo = disksim->ctlrinfo;
@@ -727,6 +785,9 @@ void controller_resetstats()
       currctlr->waitingforbus = 0.0;
       if (currctlr->type == CTLR_SMART) {
          controller_smart_resetstats(currctlr);
+      } else if (currctlr->type == CTLR_MULTIQUEUE) {
+         controller_smart_resetstats(currctlr);
+         controller_mq_resetstats(currctlr);
       }
    }
 }
@@ -764,6 +825,11 @@ void controller_printstats()
             controller_smart_printstats(currctlr, prefix);
             break;
 
+         case CTLR_MULTIQUEUE:
+            controller_smart_printstats(currctlr, prefix);
+            controller_mq_printstats(currctlr, prefix);
+            break;
+
          default:
             fprintf(stderr, "Unknown controller type in controller_printstats: %d\n", currctlr->type);
             exit(1);
@@ -103,6 +103,8 @@
 
 /* exported disksim_controller.c functions */
 
+struct checkpoint;
+
 void  controller_read_toprints (FILE *parfile);
 void  controller_read_specs (FILE *parfile);
 void  controller_read_physorg (FILE *parfile);
@@ -113,6 +115,8 @@ void  controller_initialize (void);
 void  controller_resetstats (void);
 void  controller_printstats (void);
 void  controller_cleanstats (void);
+void  controller_checkpoint (struct checkpoint *ckpt);
+void  controller_restore (struct checkpoint *ckpt, int ctlno);
 int   controller_C700_based (int ctlno);
 int   controller_set_depth (int ctlno, int inbusno, int depth, int slotno);
 int   controller_get_numcontrollers (void);
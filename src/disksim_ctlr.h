@@ -113,7 +113,13 @@
 #define CTLR_PASSTHRU		1
 #define CTLR_BASED_ON_53C700	2
 #define CTLR_SMART		3
-#define MAXCTLTYPE		3
+#define CTLR_MULTIQUEUE		4
+#define MAXCTLTYPE		4
+
+/* Multi-queue controller: how host requests are assigned to engines */
+
+#define CTLR_MQ_MAP_REQUEST	0
+#define CTLR_MQ_MAP_DEVICE	1
 
 /* Controller states */
 
@@ -125,6 +131,30 @@
 #define RECONNECTING		6
 #define REQUEST_PENDING		7
 
+/* One processing engine (core) of a multi-queue controller.  Work for  */
+/* an engine is serialized through its submission queue; completions   */
+/* wait in its completion queue until an interrupt is raised for them. */
+
+typedef struct ctlr_engine {
+   int		busy;
+   ioreq_event *running;
+   ioreq_event *jobs;		/* submission queue */
+   ioreq_event *jobstail;
+   int		numjobs;
+   ioreq_event *completions;	/* completion queue */
+   ioreq_event *completionstail;
+   int		numcompletions;
+   int		intrpending;
+   timer_event *coalescetimer;
+   double	busytime;
+   double	waittime;
+   int		maxjobs;
+   int		commands;
+   int		devintrs;
+   int		posted;
+   int		interrupts;
+} ctlr_engine;
+
 /* Directions for buswaitdir */
 
 #define UP	1
@@ -170,6 +200,18 @@ typedef struct controller {
    int          outslot[MAXOUTBUSES];
    double	waitingforbus;
    char        *name;
+
+   /* multi-queue controller */
+   int		numengines;
+   int		queuemap;
+   double	cmd_time;
+   double	devintr_time;
+   double	post_time;
+   double	hostintr_time;
+   int		coalesce_count;
+   double	coalesce_time;
+   double	enginestatstart;
+   ctlr_engine *engines;
 } controller;
 
 
@@ -210,6 +252,16 @@ void controller_smart_resetstats (controller *currctlr);
 void controller_smart_read_specs (FILE *parfile, controller *controllers, int start, int copies);
 void controller_smart_printstats (controller *currctlr, char *prefix);
 
+/* disksim_ctlrmq.c functions */
+
+void controller_mq_event_arrive (controller *currctlr, ioreq_event *curr);
+void controller_mq_request_complete (controller *currctlr, ioreq_event *curr);
+void controller_mq_setcallbacks (void);
+void controller_mq_initialize (controller *currctlr);
+int  controller_mq_idle (controller *currctlr);
+void controller_mq_resetstats (controller *currctlr);
+void controller_mq_printstats (controller *currctlr, char *prefix);
+
 /* controller.c functions */
 
 INLINE controller * getctlr (int ctlrno);
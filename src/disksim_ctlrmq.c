@@ -0,0 +1,402 @@
+/*
+ * DiskSim Storage Subsystem Simulation Environment (Version 4.0)
+ * Revision Authors: John Bucy, Greg Ganger
+ * Contributors: John Griffin, Jiri Schindler, Steve Schlosser
+ *
+ * Copyright (c) of Carnegie Mellon University, 2001-2008.
+ *
+ * This software is being provided by the copyright holders under the
+ * following license. By obtaining, using and/or copying this software,
+ * you agree that you have read, understood, and will comply with the
+ * following terms and conditions:
+ *
+ * Permission to reproduce, use, and prepare derivative works of this
+ * software is granted provided the copyright and "No Warranty" statements
+ * are included with all reproductions and derivative works and associated
+ * documentation. This software may also be redistributed without charge
+ * provided that the copyright and "No Warranty" statements are included
+ * in all redistributions.
+ *
+ * NO WARRANTY. THIS SOFTWARE IS FURNISHED ON AN "AS IS" BASIS.
+ * CARNEGIE MELLON UNIVERSITY MAKES NO WARRANTIES OF ANY KIND, EITHER
+ * EXPRESSED OR IMPLIED AS TO THE MATTER INCLUDING, BUT NOT LIMITED
+ * TO: WARRANTY OF FITNESS FOR PURPOSE OR MERCHANTABILITY, EXCLUSIVITY
+ * OF RESULTS OR RESULTS OBTAINED FROM USE OF THIS SOFTWARE. CARNEGIE
+ * MELLON UNIVERSITY DOES NOT MAKE ANY WARRANTY OF ANY KIND WITH RESPECT
+ * TO FREEDOM FROM PATENT, TRADEMARK, OR COPYRIGHT INFRINGEMENT.
+ * COPYRIGHT HOLDERS WILL BEAR NO LIABILITY FOR ANY USE OF THIS SOFTWARE
+ * OR DOCUMENTATION.
+ *
+ */
+
+
+
+/***************************************************************************
+  A multi-queue controller: a smart controller (cache, per-device queues)
+  whose command processing is done by "Processing engines" cores rather
+  than being free.
+
+	1. Every host command and every device interrupt becomes a job on
+	   one engine's submission queue.  An engine runs one job at a
+	   time, so once the engines are saturated requests queue up in
+	   the controller rather than at the devices.
+
+	2. Host commands are assigned to engines by request or by device
+	   ("Queue mapping"); device interrupts go to the engine of the
+	   device that raised them.
+
+	3. A completed request costs its engine "Completion processing
+	   time" and then waits in that engine's completion queue.  An
+	   interrupt (costing "Interrupt processing time") is raised once
+	   "Interrupt coalescing count" completions are waiting or the
+	   oldest has waited "Interrupt coalescing time", and delivers all
+	   of them to the host.
+
+  All engine times are scaled by "Scale for delays".
+***************************************************************************/
+
+#include "disksim_global.h"
+#include "disksim_iosim.h"
+#include "disksim_controller.h"
+#include "disksim_ctlr.h"
+
+
+/* kinds of engine jobs */
+
+#define CTLR_MQ_JOB_COMMAND	1
+#define CTLR_MQ_JOB_DEVINTR	2
+#define CTLR_MQ_JOB_POST	3
+#define CTLR_MQ_JOB_INTERRUPT	4
+
+
+static int controller_mq_engine_for (controller *currctlr, ioreq_event *curr)
+{
+   if (currctlr->queuemap == CTLR_MQ_MAP_REQUEST) {
+      return ((unsigned int) curr->opid % currctlr->numengines);
+   }
+   return ((unsigned int) curr->devno % currctlr->numengines);
+}
+
+
+/* start the job at the head of the engine's submission queue, if idle */
+
+static void controller_mq_start (controller *currctlr, int engno)
+{
+   ctlr_engine *engine = &currctlr->engines[engno];
+   ioreq_event *job = engine->jobs;
+   timer_event *timer;
+
+   if ((engine->busy) || (job == NULL)) {
+      return;
+   }
+   engine->jobs = job->next;
+   if (engine->jobs == NULL) {
+      engine->jobstail = NULL;
+   }
+   engine->numjobs--;
+   job->next = NULL;
+
+   engine->busy = TRUE;
+   engine->running = job;
+   engine->waittime += simtime - job->start_time;
+   engine->busytime += job->time;
+
+   timer = (timer_event *) getfromextraq();
+   timer->type = TIMER_EXPIRED;
+   timer->func = &disksim->timerfunc_ctlrmq_engine;
+   timer->ptr = currctlr;
+   timer->val = engno;
+   timer->time = simtime + job->time;
+   addtointq((event *) timer);
+}
+
+
+static void controller_mq_submit (controller *currctlr, int engno, int kind, ioreq_event *curr, double cost)
+{
+   ctlr_engine *engine = &currctlr->engines[engno];
+   ioreq_event *job = (ioreq_event *) getfromextraq();
+
+   job->cause = kind;
+   job->tempptr1 = curr;
+   job->time = cost * currctlr->timescale;
+   job->start_time = simtime;
+   job->next = NULL;
+
+   if (engine->jobstail) {
+      engine->jobstail->next = job;
+   } else {
+      engine->jobs = job;
+   }
+   engine->jobstail = job;
+   engine->numjobs++;
+   engine->maxjobs = max(engine->maxjobs, engine->numjobs);
+
+   controller_mq_start(currctlr, engno);
+}
+
+
+static void controller_mq_cancel_coalescing (ctlr_engine *engine)
+{
+   if (engine->coalescetimer) {
+      removefromintq((event *) engine->coalescetimer);
+      addtoextraq((event *) engine->coalescetimer);
+      engine->coalescetimer = NULL;
+   }
+}
+
+
+static void controller_mq_raise_interrupt (controller *currctlr, int engno)
+{
+   ctlr_engine *engine = &currctlr->engines[engno];
+
+   controller_mq_cancel_coalescing(engine);
+   if (engine->intrpending) {
+      return;
+   }
+   engine->intrpending = TRUE;
+   controller_mq_submit(currctlr, engno, CTLR_MQ_JOB_INTERRUPT, NULL, currctlr->hostintr_time);
+}
+
+
+/* a completion has been posted to the engine's completion queue */
+
+static void controller_mq_post (controller *currctlr, int engno, ioreq_event *curr)
+{
+   ctlr_engine *engine = &currctlr->engines[engno];
+   timer_event *timer;
+
+   curr->next = NULL;
+   if (engine->completionstail) {
+      engine->completionstail->next = curr;
+   } else {
+      engine->completions = curr;
+   }
+   engine->completionstail = curr;
+   engine->numcompletions++;
+
+   if (engine->intrpending) {
+      /* will be delivered by the interrupt already on its way */
+      return;
+   }
+   if (engine->numcompletions >= currctlr->coalesce_count) {
+      controller_mq_raise_interrupt(currctlr, engno);
+   } else if (engine->coalescetimer == NULL) {
+      timer = (timer_event *) getfromextraq();
+      timer->type = TIMER_EXPIRED;
+      timer->func = &disksim->timerfunc_ctlrmq_coalesce;
+      timer->ptr = currctlr;
+      timer->val = engno;
+      timer->time = simtime + (currctlr->coalesce_time * currctlr->timescale);
+      addtointq((event *) timer);
+      engine->coalescetimer = timer;
+   }
+}
+
+
+/* the interrupt job has run: hand everything posted so far to the host */
+
+static void controller_mq_interrupt (controller *currctlr, int engno)
+{
+   ctlr_engine *engine = &currctlr->engines[engno];
+   ioreq_event *curr = engine->completions;
+   ioreq_event *next;
+
+   engine->completions = NULL;
+   engine->completionstail = NULL;
+   engine->numcompletions = 0;
+   engine->intrpending = FALSE;
+   controller_mq_cancel_coalescing(engine);
+
+   while (curr) {
+      next = curr->next;
+      curr->next = NULL;
+      controller_send_event_up_path(currctlr, curr, currctlr->ovrhd_complete);
+      curr = next;
+   }
+}
+
+
+static void controller_mq_engine_done (timer_event *timer)
+{
+   controller *currctlr = timer->ptr;
+   int engno = timer->val;
+   ctlr_engine *engine = &currctlr->engines[engno];
+   ioreq_event *job = engine->running;
+   ioreq_event *curr = job->tempptr1;
+   int kind = job->cause;
+
+   addtoextraq((event *) timer);
+   addtoextraq((event *) job);
+   engine->running = NULL;
+   engine->busy = FALSE;
+
+   switch (kind) {
+
+      case CTLR_MQ_JOB_COMMAND:
+         engine->commands++;
+         controller_smart_event_arrive(currctlr, curr);
+         break;
+
+      case CTLR_MQ_JOB_DEVINTR:
+         engine->devintrs++;
+         controller_smart_event_arrive(currctlr, curr);
+         break;
+
+      case CTLR_MQ_JOB_POST:
+         engine->posted++;
+         controller_mq_post(currctlr, engno, curr);
+         break;
+
+      case CTLR_MQ_JOB_INTERRUPT:
+         engine->interrupts++;
+         controller_mq_interrupt(currctlr, engno);
+         break;
+
+      default:
+         fprintf(stderr, "Unknown job kind in controller_mq_engine_done: %d\n", kind);
+         exit(1);
+   }
+
+   controller_mq_start(currctlr, engno);
+}
+
+
+static void controller_mq_coalesce_timeout (timer_event *timer)
+{
+   controller *currctlr = timer->ptr;
+   int engno = timer->val;
+   ctlr_engine *engine = &currctlr->engines[engno];
+
+   ASSERT(engine->coalescetimer == timer);
+   engine->coalescetimer = NULL;
+   addtoextraq((event *) timer);
+
+   if (engine->numcompletions) {
+      controller_mq_raise_interrupt(currctlr, engno);
+   }
+}
+
+
+/* called in place of sending a completion interrupt up the path */
+
+void controller_mq_request_complete (controller *currctlr, ioreq_event *curr)
+{
+   int engno = controller_mq_engine_for(currctlr, curr);
+   controller_mq_submit(currctlr, engno, CTLR_MQ_JOB_POST, curr, currctlr->post_time);
+}
+
+
+void controller_mq_event_arrive (controller *currctlr, ioreq_event *curr)
+{
+   switch (curr->type) {
+
+      case IO_ACCESS_ARRIVE:
+         controller_mq_submit(currctlr, controller_mq_engine_for(currctlr, curr), CTLR_MQ_JOB_COMMAND, curr, currctlr->cmd_time);
+         break;
+
+      case IO_INTERRUPT_ARRIVE:
+         controller_mq_submit(currctlr, ((unsigned int) curr->devno % currctlr->numengines), CTLR_MQ_JOB_DEVINTR, curr, currctlr->devintr_time);
+         break;
+
+      default:
+         controller_smart_event_arrive(currctlr, curr);
+   }
+}
+
+
+void controller_mq_setcallbacks ()
+{
+   disksim->timerfunc_ctlrmq_engine = controller_mq_engine_done;
+   disksim->timerfunc_ctlrmq_coalesce = controller_mq_coalesce_timeout;
+}
+
+
+void controller_mq_initialize (controller *currctlr)
+{
+   controller_mq_setcallbacks();
+   if (currctlr->numengines <= 0) {
+      currctlr->numengines = 1;
+   }
+   if (currctlr->coalesce_count <= 0) {
+      currctlr->coalesce_count = 1;
+   }
+   if (currctlr->engines == NULL) {
+      currctlr->engines = DISKSIM_malloc(currctlr->numengines * sizeof(ctlr_engine));
+      ASSERT(currctlr->engines != NULL);
+   }
+   bzero(currctlr->engines, currctlr->numengines * sizeof(ctlr_engine));
+   currctlr->enginestatstart = simtime;
+}
+
+
+int controller_mq_idle (controller *currctlr)
+{
+   int i;
+
+   for (i=0; i<currctlr->numengines; i++) {
+      ctlr_engine *engine = &currctlr->engines[i];
+      if ((engine->busy) || (engine->jobs) || (engine->completions)) {
+         return (FALSE);
+      }
+   }
+   return (TRUE);
+}
+
+
+void controller_mq_resetstats (controller *currctlr)
+{
+   int i;
+
+   for (i=0; i<currctlr->numengines; i++) {
+      ctlr_engine *engine = &currctlr->engines[i];
+      engine->busytime = 0.0;
+      engine->waittime = 0.0;
+      engine->maxjobs = engine->numjobs;
+      engine->commands = 0;
+      engine->devintrs = 0;
+      engine->posted = 0;
+      engine->interrupts = 0;
+   }
+   currctlr->enginestatstart = simtime;
+}
+
+
+void controller_mq_printstats (controller *currctlr, char *prefix)
+{
+   double elapsed = simtime - currctlr->enginestatstart;
+   double busytime = 0.0;
+   double waittime = 0.0;
+   int jobs = 0;
+   int posted = 0;
+   int interrupts = 0;
+   int maxjobs = 0;
+   int i;
+
+   for (i=0; i<currctlr->numengines; i++) {
+      ctlr_engine *engine = &currctlr->engines[i];
+      busytime += engine->busytime;
+      waittime += engine->waittime;
+      jobs += engine->commands + engine->devintrs + engine->posted + engine->interrupts;
+      posted += engine->posted;
+      interrupts += engine->interrupts;
+      maxjobs = max(maxjobs, engine->maxjobs);
+   }
+
+   fprintf (outputfile, "%sProcessing engines:     \t%d\n", prefix, currctlr->numengines);
+   fprintf (outputfile, "%sEngine utilization:     \t%f\n", prefix, ((elapsed > 0.0) ? (busytime / (elapsed * currctlr->numengines)) : 0.0));
+   fprintf (outputfile, "%sEngine jobs:            \t%d\n", prefix, jobs);
+   fprintf (outputfile, "%sEngine queue wait time: \t%f\n", prefix, ((jobs) ? (waittime / (double) jobs) : 0.0));
+   fprintf (outputfile, "%sEngine max queue length:\t%d\n", prefix, maxjobs);
+   fprintf (outputfile, "%sHost interrupts:        \t%d\n", prefix, interrupts);
+   fprintf (outputfile, "%sCompletions per interrupt:\t%f\n", prefix, ((interrupts) ? ((double) posted / (double) interrupts) : 0.0));
+
+   if (currctlr->numengines > 1) {
+      for (i=0; i<currctlr->numengines; i++) {
+         ctlr_engine *engine = &currctlr->engines[i];
+         fprintf (outputfile, "%sengine #%d utilization:\t%f\n", prefix, i, ((elapsed > 0.0) ? (engine->busytime / elapsed) : 0.0));
+         fprintf (outputfile, "%sengine #%d commands:   \t%d\n", prefix, i, engine->commands);
+         fprintf (outputfile, "%sengine #%d interrupts: \t%d\n", prefix, i, engine->devintrs);
+      }
+   }
+   fprintf (outputfile, "\n");
+}
@@ -205,6 +205,10 @@ fprintf (outputfile, "Request completed at smart controller: devno %d, blkno %d\
 
    curr->type = IO_INTERRUPT_ARRIVE;
    curr->cause = COMPLETION;
+   if (currctlr->type == CTLR_MULTIQUEUE) {
+      controller_mq_request_complete(currctlr, curr);
+      return;
+   }
    controller_send_event_up_path(currctlr, curr, currctlr->ovrhd_complete);
 }
 
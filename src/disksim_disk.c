@@ -103,6 +103,7 @@
 #include "disksim_stat.h"
 #include "disksim_disk.h"
 #include "disksim_ioqueue.h"
+#include "disksim_checkpoint.h"
 #include "config.h"
 
 #include "modules/modules.h"
@@ -1034,6 +1035,9 @@ void disk_initialize (void)
      currdisk->lastgen = -1;
      currdisk->busowned = -1;
      currdisk->numdirty = 0;
+     for (j = 0; j < DISK_LTOP_CACHE_SIZE; j++) {
+       currdisk->ltopcache[j].lbn = -1;
+     }
      if (currdisk->seglist == NULL) {
        currdisk->seglist = (segment *) DISKSIM_malloc(sizeof(segment));
        currdisk->seglist->next = NULL;
@@ -1082,6 +1086,133 @@ void disk_initialize (void)
 
 
 
+/* Saves the mechanical position and the buffer contents.  Only called */
+/* while the disk is idle, so no segment has requests attached.       */
+
+void disk_checkpoint (checkpoint_t *ckpt)
+{
+   int i;
+
+   if (disksim->diskinfo == NULL) {
+      return;
+   }
+   for (i=0; i<MAXDEVICES; i++) {
+      disk *currdisk = getdisk (i);
+      segment *seg;
+      int segno;
+      int writeseg = -1;
+
+      if (!currdisk) {
+         continue;
+      }
+      ASSERT(currdisk->outstate == DISK_IDLE);
+      ASSERT((currdisk->effectivehda == NULL) && (currdisk->currenthda == NULL));
+
+      checkpoint_begin_section(ckpt, "DISK", i);
+      checkpoint_put_int(ckpt, NUMDISKS);
+      checkpoint_put_int(ckpt, currdisk->model->dm_sectors);
+      checkpoint_put_int(ckpt, currdisk->mech_state.cyl);
+      checkpoint_put_int(ckpt, currdisk->mech_state.head);
+      checkpoint_put_int(ckpt, (int) currdisk->mech_state.theta);
+      checkpoint_put_double(ckpt, currdisk->currtime);
+      checkpoint_put_int64(ckpt, currdisk->currtime_i);
+      checkpoint_put_int(ckpt, currdisk->track_low);
+      checkpoint_put_int(ckpt, currdisk->track_high);
+      checkpoint_put_int(ckpt, currdisk->lastflags);
+      checkpoint_put_int(ckpt, currdisk->lastgen);
+      checkpoint_put_int(ckpt, currdisk->prev_readahead_min);
+      ioqueue_checkpoint(ckpt, currdisk->queue);
+
+      /* segments in list (i.e. replacement) order */
+      checkpoint_put_int(ckpt, currdisk->numsegs);
+      for (seg = currdisk->seglist, segno = 0; seg; seg = seg->next, segno++) {
+         ASSERT(seg->diskreqlist == NULL);
+         if (seg == currdisk->dedicatedwriteseg) {
+            writeseg = segno;
+         }
+         checkpoint_put_int(ckpt, seg->state);
+         checkpoint_put_double(ckpt, seg->time);
+         checkpoint_put_int(ckpt, seg->startblkno);
+         checkpoint_put_int(ckpt, seg->endblkno);
+         checkpoint_put_int(ckpt, seg->minreadaheadblkno);
+         checkpoint_put_int(ckpt, seg->maxreadaheadblkno);
+         checkpoint_put_int(ckpt, seg->size);
+         /* the last access steers the next one's segment handling */
+         /* (e.g. EXTRA_WRITE_DISCONNECT in disk_buffer_select_segment) */
+         checkpoint_put_int(ckpt, (seg->access != NULL));
+         if (seg->access) {
+            ASSERT(seg->access->type == NULL_EVENT);
+            checkpoint_put_int(ckpt, seg->access->flags);
+            checkpoint_put_int(ckpt, seg->access->blkno);
+            checkpoint_put_int(ckpt, seg->access->bcount);
+         }
+      }
+      checkpoint_put_int(ckpt, writeseg);
+      checkpoint_end_section(ckpt);
+   }
+}
+
+
+void disk_restore (checkpoint_t *ckpt, int diskno)
+{
+   disk *currdisk;
+   segment *seg;
+   int segno;
+   int writeseg;
+
+   if ((diskno < 0) || (diskno >= MAXDEVICES) || (disksim->diskinfo == NULL)
+       || ((currdisk = getdisk(diskno)) == NULL)) {
+      checkpoint_mismatch(ckpt, "disk number");
+   }
+   checkpoint_check(ckpt, "number of disks", checkpoint_get_int(ckpt), NUMDISKS);
+   checkpoint_check(ckpt, "disk size", checkpoint_get_int(ckpt), currdisk->model->dm_sectors);
+   currdisk->mech_state.cyl = checkpoint_get_int(ckpt);
+   currdisk->mech_state.head = checkpoint_get_int(ckpt);
+   currdisk->mech_state.theta = (dm_angle_t) checkpoint_get_int(ckpt);
+   currdisk->currtime = checkpoint_get_double(ckpt);
+   currdisk->currtime_i = checkpoint_get_int64(ckpt);
+   currdisk->track_low = checkpoint_get_int(ckpt);
+   currdisk->track_high = checkpoint_get_int(ckpt);
+   currdisk->lastflags = checkpoint_get_int(ckpt);
+   currdisk->lastgen = checkpoint_get_int(ckpt);
+   currdisk->prev_readahead_min = checkpoint_get_int(ckpt);
+   ioqueue_restore(ckpt, currdisk->queue);
+
+   checkpoint_check(ckpt, "number of cache segments", checkpoint_get_int(ckpt), currdisk->numsegs);
+   for (seg = currdisk->seglist; seg; seg = seg->next) {
+      seg->state = checkpoint_get_int(ckpt);
+      seg->time = checkpoint_get_double(ckpt);
+      seg->startblkno = checkpoint_get_int(ckpt);
+      seg->endblkno = checkpoint_get_int(ckpt);
+      seg->minreadaheadblkno = checkpoint_get_int(ckpt);
+      seg->maxreadaheadblkno = checkpoint_get_int(ckpt);
+      seg->size = checkpoint_get_int(ckpt);
+      if (seg->access) {
+         addtoextraq((event *) seg->access);
+         seg->access = NULL;
+      }
+      if (checkpoint_get_int(ckpt)) {
+         seg->access = (ioreq_event *) getfromextraq();
+         bzero ((char *) seg->access, sizeof(ioreq_event));
+         seg->access->type = NULL_EVENT;
+         seg->access->devno = diskno;
+         seg->access->flags = checkpoint_get_int(ckpt);
+         seg->access->blkno = checkpoint_get_int(ckpt);
+         seg->access->bcount = checkpoint_get_int(ckpt);
+      }
+   }
+   writeseg = checkpoint_get_int(ckpt);
+   if ((writeseg >= 0) != (currdisk->dedicatedwriteseg != NULL)) {
+      checkpoint_mismatch(ckpt, "dedicated write segment");
+   }
+   for (seg = currdisk->seglist, segno = 0; seg; seg = seg->next, segno++) {
+      if (segno == writeseg) {
+         currdisk->dedicatedwriteseg = seg;
+      }
+   }
+}
+
+
 void disk_acctimestats (disk *currdisk, int distance, double seektime,
 		        double latency, double xfertime, double acctime)
 {
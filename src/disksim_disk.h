@@ -189,6 +189,9 @@ typedef enum {
 #define MAXSTATS 10
 #define MAXDISKS 100
 
+/* entries in each disk's lbn->pbn translation cache (power of 2) */
+#define DISK_LTOP_CACHE_SIZE 64
+
 
 typedef struct seg {
    double       time;
@@ -469,6 +472,19 @@ typedef struct disk {
   // hasn't gotten to 0.
   int fpcheck;
 
+  // Media transfers translate the same few lbns over and over as they
+  // step sector by sector along a track (see disk_buffer_ltop()).
+  // Direct-mapped on lbn; lbn == -1 marks an empty entry.
+  struct {
+    int lbn;
+    int remapsector;
+    struct dm_pbn pbn;
+  } ltopcache[DISK_LTOP_CACHE_SIZE];
+
+  // "Analytic media transfer": step over runs of sectors on a track
+  // in one go (see disk_buffer_sector_run()).
+  int analytic_xfer;
+
 } disk;
 
 
@@ -610,6 +626,10 @@ int     disk_get_maxoutstanding(int diskno);
 
 int     disk_get_numdisks(void);
 
+struct checkpoint;
+void    disk_checkpoint(struct checkpoint *ckpt);
+void    disk_restore(struct checkpoint *ckpt, int diskno);
+
 
 double  disk_get_blktranstime(ioreq_event *curr);
 int     disk_get_avg_sectpercyl(int devno);
@@ -117,6 +117,10 @@ static void
 disk_buffer_seekdone (disk *currdisk, 
 		      ioreq_event *curr);
 
+static int 
+disk_buffer_sector_run (disk *currdisk, 
+			ioreq_event *curr);
+
 int  
 disk_enablement_function (ioreq_event *currioreq);
 
@@ -358,7 +362,7 @@ disk_bus_delay_complete(int devno,
   slotno.byte[depth] = slotno.byte[depth] >> 4;
   curr->time = 0.0;
   if(depth == 0) {
-    intr_request ((event *)curr);
+    bus_interrupt_host (curr);
   } 
   else {
     bus_deliver_event(busno.byte[depth], slotno.byte[depth], curr);
@@ -2964,6 +2968,60 @@ static void disk_interrupt_complete (ioreq_event *curr)
 
 
 
+/* A media transfer is a chain of DEVICE_BUFFER_SECTOR_DONE events, one
+ * per sector, with a DEVICE_BUFFER_SEEKDONE at each track switch; each
+ * handler reschedules the same event for the next step.  When that
+ * step comes out at the head of the intq, no other event (bus
+ * activity, arrivals, timers) can intervene before it, so handle it
+ * here rather than going back through the intq and the dispatch
+ * chain.  The per-sector work is unchanged, so results are identical.
+ * External control, trace pipes and pending checkpoints need to see
+ * every event, so those always take the long way.
+ *
+ * With "Analytic media transfer" set, a step that would only move
+ * wanted blocks along the current track is instead computed in one go
+ * by disk_buffer_sector_run(), up to the end of the track's run or the
+ * next event in the intq.  Timestamps then come from one
+ * multiplication instead of a chain of additions; the rounding
+ * differs, which can reorder events that are nearly simultaneous, so
+ * it is off by default.
+ */
+
+static void 
+disk_buffer_media_event (disk *currdisk, ioreq_event *curr)
+{
+  for(;;) {
+    if(curr->type == DEVICE_BUFFER_SEEKDONE) {
+      disk_buffer_seekdone(currdisk, curr);
+    }
+    else {
+      disk_buffer_sector_done(currdisk, curr);
+    }
+
+    if((disksim->intq != (event *) curr)
+       || ((curr->type != DEVICE_BUFFER_SECTOR_DONE)
+	   && (curr->type != DEVICE_BUFFER_SEEKDONE))
+       || disksim->external_control
+       || (disksim->trace_mode != DISKSIM_NONE)
+       || disksim->checkpoint_pending
+       || disksim->stop_sim)
+    {
+      return;
+    }
+
+    if(currdisk->analytic_xfer
+       && disk_buffer_sector_run(currdisk, curr)
+       && (disksim->intq != (event *) curr))
+    {
+      return;
+    }
+
+    removefromintq((event *) curr);
+    simtime = curr->time;
+  }
+}
+
+
 void disk_event_arrive (ioreq_event *curr)
 {
   disk *currdisk = getdisk (curr->devno);
@@ -2989,11 +3047,8 @@ void disk_event_arrive (ioreq_event *curr)
     break;
 
   case DEVICE_BUFFER_SEEKDONE:
-    disk_buffer_seekdone(currdisk, curr);
-    break;
-
   case DEVICE_BUFFER_SECTOR_DONE:
-    disk_buffer_sector_done(currdisk, curr);
+    disk_buffer_media_event(currdisk, curr);
     break;
 
   case DEVICE_GOTO_REMAPPED_SECTOR:
@@ -4176,6 +4231,83 @@ disk_buffer_seekdone(disk *currdisk, ioreq_event *curr)
 
 
 
+// Fill the translation cache with the rest of lbn's track run in
+// one call since the transfer is about to step through it.  Returns
+// 0 if the layout can't translate ranges or lbn isn't mapped.
+static int
+disk_buffer_ltop_run(disk *currdisk, int lbn)
+{
+  struct dm_layout_if *layout = currdisk->model->layout;
+  struct dm_track_run run;
+  int i;
+
+  if(!layout->dm_translate_ltop_range
+     || layout->dm_translate_ltop_range(currdisk->model, 
+					lbn, 
+					DISK_LTOP_CACHE_SIZE, 
+					MAP_FULL, 
+					&run, 
+					1) != 1)
+  {
+    return 0;
+  }
+
+  for(i = 0; i < run.len; i++) {
+    int idx = (lbn + i) & (DISK_LTOP_CACHE_SIZE - 1);
+    currdisk->ltopcache[idx].lbn = lbn + i;
+    currdisk->ltopcache[idx].pbn = run.pbn;
+    currdisk->ltopcache[idx].pbn.sector += i;
+    currdisk->ltopcache[idx].remapsector = run.remapped;
+  }
+
+  return 1;
+}
+
+
+// dm_translate_ltop(..., MAP_FULL, ...) through the disk's
+// translation cache.  As a transfer steps along a track,
+// disk_buffer_sector_done() asks for every lbn twice: once as the
+// next sector and again, two sectors later, as the previous one.
+// Like the layouts, this only ever sets *remapsector.
+static dm_ptol_result_t
+disk_buffer_ltop(disk *currdisk, 
+		 int lbn, 
+		 struct dm_pbn *pbn, 
+		 int *remapsector)
+{
+  int idx = lbn & (DISK_LTOP_CACHE_SIZE - 1);
+  int remap = 0;
+  dm_ptol_result_t rv;
+
+  if(currdisk->ltopcache[idx].lbn == lbn) {
+    *pbn = currdisk->ltopcache[idx].pbn;
+    remap = currdisk->ltopcache[idx].remapsector;
+  }
+  else if(disk_buffer_ltop_run(currdisk, lbn)) {
+    *pbn = currdisk->ltopcache[idx].pbn;
+    remap = currdisk->ltopcache[idx].remapsector;
+  }
+  else {
+    rv = currdisk->model->layout->dm_translate_ltop(currdisk->model,
+						    lbn,
+						    MAP_FULL,
+						    pbn,
+						    &remap);
+    if(rv != DM_OK) {
+      return rv;
+    }
+    currdisk->ltopcache[idx].lbn = lbn;
+    currdisk->ltopcache[idx].pbn = *pbn;
+    currdisk->ltopcache[idx].remapsector = remap;
+  }
+
+  if(remap && remapsector) {
+    *remapsector = 1;
+  }
+  return DM_OK;
+}
+
+
 // Factored out of disk_buffer_sector_done, rewritten to
 // make fewer layout assumptions.
 static int
@@ -4243,12 +4375,7 @@ dbsd_setup(disk *cd,
     *blkno = *last;
   }
 
-  rv = 
-    cd->model->layout->dm_translate_ltop(cd->model,
-					 *blkno,
-					 MAP_FULL,
-					 &pbn,
-					 remapsector);
+  rv = disk_buffer_ltop(cd, *blkno, &pbn, remapsector);
   ddbg_assert(rv == DM_OK);
   
   *cause = pbn.sector;
@@ -4334,6 +4461,174 @@ void dbsd_check_times(void)
 #endif
 }
 
+// Skip the DEVICE_BUFFER_SECTOR_DONE events for as many sectors of
+// the current track as would each just move the next wanted block
+// through the buffer (see "Analytic media transfer").  curr is the
+// pending sector event at the head of the intq.  A skipped sector
+// must not be remapped or slipped, hit zero-latency bookkeeping, a
+// bus transfer on the segment, a buffer stall, a watermark, the end
+// of the request or a readahead limit, and must pass before the next
+// event in the intq.  The disk state then advances as
+// disk_buffer_sector_done() would have over those sectors, and curr
+// is rescheduled for the first sector that needs the detailed path.
+// Returns the number of sectors skipped; 0 leaves everything as is.
+static int 
+disk_buffer_sector_run (disk *currdisk, ioreq_event *curr)
+{
+  diskreq *currdiskreq = currdisk->effectivehda;
+  diskreq *seg_owner;
+  segment *seg;
+  ioreq_event *tmpioreq;
+  event *nextev = curr->next;
+  struct dm_track_run run;
+  int reading;
+  int background;
+  int blkno;   // block the pending event transfers
+  int reqend;
+  int n;       // sectors to skip
+  double xfer;
+  double last; // time of the last skipped sector
+  dm_time_t diff_i;
+
+  if((curr->type != DEVICE_BUFFER_SECTOR_DONE) 
+     || (curr->bcount != 1) 
+     || !currdiskreq 
+     || currdisk->immed 
+     || currdisk->outwait
+     || (currdisk->stat.xfertime == (double) -1)
+     || !currdisk->model->layout->dm_translate_ltop_range) 
+  {
+    return 0;
+  }
+
+  seg = currdiskreq->seg;
+  if((curr != seg->access)
+     || (seg->recyclereq == currdiskreq) 
+     || (seg->outstate == BUFFER_TRANSFERING)
+     || (seg->outstate == BUFFER_PREEMPT))
+  {
+    return 0;
+  }
+
+  reading = (seg->state == BUFFER_READING);
+  background = curr->flags & BUFFER_BACKGROUND;
+  if(background && !reading) {
+    return 0;
+  }
+
+  blkno = curr->blkno - 1;
+  if((blkno < currdisk->track_low) 
+     || (blkno != (reading ? seg->endblkno : currdiskreq->inblkno))) 
+  {
+    return 0;
+  }
+
+  // stay on this track; the pending event ends up at curr->blkno + n
+  n = currdisk->track_high - curr->blkno;
+
+  // the last skipped sector must not finish the request ...
+  if(background) {
+    n = min(n, seg->maxreadaheadblkno - blkno - 1);
+    if(seg->minreadaheadblkno > blkno) {
+      n = min(n, seg->minreadaheadblkno - blkno - 1);
+    }
+  }
+  else {
+    tmpioreq = currdiskreq->ioreqlist;
+    while (tmpioreq->next) {
+      tmpioreq = tmpioreq->next;
+    }
+    reqend = tmpioreq->blkno + tmpioreq->bcount;
+    n = min(n, reqend - blkno - 1);
+
+    // ... or reach the watermark that brings in the bus ...
+    if(seg->outstate == BUFFER_IDLE) {
+      if(reading) {
+	n = min(n, currdiskreq->watermark + currdiskreq->outblkno - blkno - 1);
+      }
+      else if(seg->endblkno < reqend) {
+	n = min(n, seg->endblkno - blkno - currdiskreq->watermark - 1);
+      }
+    }
+  }
+
+  // ... or run out of buffer (see disk_buffer_block_available())
+  if(reading) {
+    seg_owner = disk_buffer_seg_owner(seg, TRUE);
+    if(seg_owner && !(seg_owner->flags & COMPLETION_SENT)) {
+      n = min(n, seg->size + seg_owner->outblkno - blkno - 1);
+    }
+  }
+  else {
+    n = min(n, seg->endblkno - blkno - 1);
+  }
+
+  if(currdisk->immedstart > blkno) {
+    n = min(n, currdisk->immedstart - blkno - 1);
+  }
+  n = min(n, currdisk->fpcheck - 2);
+
+  if(n < 2) {
+    return 0;
+  }
+
+  xfer = dm_time_itod(currdisk->model->mech->dm_xfertime(currdisk->model, 
+							  &currdisk->mech_state, 
+							  1));
+  if(nextev && ((curr->time + (n-1) * xfer) >= nextev->time)) {
+    n = (int) ((nextev->time - curr->time) / xfer);
+    if(n < 2) {
+      return 0;
+    }
+  }
+
+  // every block from blkno to the new pending one on consecutive
+  // sectors of this track
+  if((currdisk->model->layout->dm_translate_ltop_range(currdisk->model, 
+						       blkno, 
+						       n + 2, 
+						       MAP_FULL, 
+						       &run, 
+						       1) != 1)
+     || run.remapped
+     || (run.pbn.sector + 1 != curr->cause))
+  {
+    return 0;
+  }
+  n = min(n, run.len - 2);
+  if(n < 2) {
+    return 0;
+  }
+
+  last = curr->time + (n-1) * xfer;
+
+  currdisk->fpcheck -= n;
+
+  diff_i = dm_time_dtoi(last - seg->time);
+  currdisk->mech_state.theta += currdisk->model->mech->dm_rotate(currdisk->model, &diff_i);
+  currdisk->currtime = last;
+  currdisk->currtime_i = dm_time_dtoi(last);
+  currdisk->stat.xfertime += last - seg->time;
+
+  if(reading) {
+    seg->endblkno = blkno + n;
+  }
+  else {
+    currdiskreq->inblkno = blkno + n;
+  }
+  disk_buffer_segment_wrap(seg, seg->endblkno);
+  seg->time = last;
+
+  removefromintq((event *) curr);
+  curr->blkno += n;
+  curr->cause = run.pbn.sector + (curr->blkno - run.lbn);
+  curr->time = last + xfer;
+  addtointq((event *) curr);
+
+  return n;
+}
+
+
 // dbsd_next_sector
 
 static void 
@@ -4605,12 +4900,7 @@ disk_buffer_sector_done (disk *currdisk, ioreq_event *curr)
     //    ddbg_assert(curr->blkno != 54281913);
     ddbg_assert(curr->blkno <= currdisk->track_high);
 
-    rv = 
-      currdisk->model->layout->dm_translate_ltop(currdisk->model,
-						 curr->blkno,
-						 MAP_FULL,
-						 &pbn,
-						 &remapsector);
+    rv = disk_buffer_ltop(currdisk, curr->blkno, &pbn, &remapsector);
     // save this here
     currcause = curr->cause;
     curr->cause = pbn.sector;
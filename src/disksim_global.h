@@ -123,10 +123,6 @@
 #define int32_t         long
 #endif
 
-#ifndef _WIN32
-#define SUPPORT_CHECKPOINTS
-#endif
-
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
@@ -200,6 +196,8 @@ typedef      unsigned u_int;
 #define SYNCHRONOUS	DISKSIM_SYNC
 #define ASYNCHRONOUS	DISKSIM_ASYNC
 #define IO_FLAG_PAGEIO	DISKSIM_IO_FLAG_PAGEIO	
+#define FUA		DISKSIM_FUA
+#define BACKGROUND	DISKSIM_BACKGROUND
 #define SEQ		DISKSIM_SEQ		
 #define LOCAL           DISKSIM_LOCAL	     
 #define BATCH_COMPLETE  DISKSIM_BATCH_COMPLETE  
@@ -334,11 +332,20 @@ struct businfo;
 struct ctlrinfo;
 struct pf_info;
 struct synthio_info;
+struct synthfast_info;
 struct iotrace_info;
 struct rand48_info;
 
 typedef event*(*disksim_iodone_notify_t)(ioreq_event *, void *ctx);
 
+/* a what-if variant run from the warm state at the first checkpoint; */
+/* overrides are in the same form as on the command line               */
+typedef struct disksim_branch {
+   char **overrides;
+   int    overrides_len;
+   int    pid;
+} disksim_branch_t;
+
 typedef struct disksim {
    void * startaddr;
    int    totallength;
@@ -354,12 +361,23 @@ typedef struct disksim {
    int    checkpoint_iocnt;
    double checkpoint_interval;
    event *checkpoint_event;
+   int    checkpoint_stop;
+   int    checkpoint_pending;
+   int    checkpoint_restored;
+   char  *restorefilename;
+   int    checkpoint_warmup;
+   int    numbranches;
+   disksim_branch_t *branches;
+   int    branched;
+   int    branchno;		/* 0 unless this is a branch child */
+   FILE  *branchimage;
    int    traceformat;
    int    endian;
    int    traceendian;
    int    traceheader;
    int    iotrace;
    int    synthgen;
+   int    synthfast;		/* synthgen with a Synthfast block */
    int    external_control;
 
    disksim_iodone_notify_t external_io_done_notify;
@@ -395,14 +413,23 @@ typedef struct disksim {
    void         (*donefunc_ctlrsmart_write)(void *, ioreq_event *);
    void         (*donefunc_cachemem_empty) (void *, ioreq_event *);
    void         (*donefunc_cachedev_empty) (void *, ioreq_event *);
+   void         (*donefunc_cacheflash_empty) (void *, ioreq_event *);
    void         (*idlework_cachemem)       (void *, int);
    void         (*idlework_cachedev)       (void *, int);
+   void         (*idlework_cacheflash)     (void *, int);
+   void         (*idlework_ssd)            (void *, int);
    int          (*concatok_cachemem)       (void *, int, int, int, int);
    int          (*enablement_disk)         (ioreq_event *);
    void         (*timerfunc_disksim)       (timer_event *);
    void         (*timerfunc_ioqueue)       (timer_event *);
    void         (*timerfunc_cachemem)      (timer_event *);
    void         (*timerfunc_cachedev)      (timer_event *);
+   void         (*timerfunc_ssd_wbuf)      (timer_event *);
+   void         (*timerfunc_logorg)        (timer_event *);
+   void         (*timerfunc_ctlrmq_engine) (timer_event *);
+   void         (*timerfunc_ctlrmq_coalesce) (timer_event *);
+   void         (*timerfunc_bus_deliver)   (timer_event *);
+   void         (*timerfunc_bus_coalesce)  (timer_event *);
 
 /* opaque structures for different modules */
    struct iosim_info *iosim_info;
@@ -416,11 +443,14 @@ typedef struct disksim {
    struct ctlrinfo *ctlrinfo;
    struct pf_info *pf_info;
    struct synthio_info *synthio_info;
+   struct synthfast_info *synthfast_info;
    struct iotrace_info *iotrace_info;
    struct rand48_info *rand48_info;
 
    char **overrides;
    int overrides_len;
+   char **argv;
+   int argc;
    int verbosity;
 
   int tracepipes[2];
@@ -468,6 +498,9 @@ void intr_acknowledge (event *intrp);
 void resetstats (void);
 void disksim_simstop (void);
 void disksim_register_checkpoint (double atsimtime);
+struct lp_list;
+int  disksim_load_branches (struct lp_list *l);
+char * disksim_branch_filename (char *filename);
 INLINE void addtoextraq (event *temp);
 void addlisttoextraq (event **headptr);
 INLINE event * getfromextraq (void);
@@ -493,7 +526,6 @@ void disksim_cleanup_and_printstats (void);
 void disksim_cleanstats (void);
 void disksim_printstats2 (void);
 void disksim_simulate_event (int);
-void disksim_restore_from_checkpoint (char *filename);
 void disksim_run_simulation ();
 
 void disksim_printstats(void);
@@ -145,6 +145,9 @@ static void iodriver_send_event_down_path (ioreq_event *curr)
 /*
 fprintf (outputfile, "iodriver_send_event_down_path: busno %d, slotno %d\n", busno.byte[0], slotno.byte[0]);
 */
+   if (bus_queuepair_submit(busno.byte[0], curr)) {
+      return;
+   }
    bus_deliver_event(busno.byte[0], slotno.byte[0], curr);
 }
 
@@ -156,6 +159,12 @@ double iodriver_raise_priority (int iodriverno, int opid, int devno, int blkno,
 }
 
 
+int iodriver_get_number_of_blocks (int iodriverno, int devno)
+{
+   return(logorg_get_number_of_blocks(sysorgs, numsysorgs, devno));
+}
+
+
 static void schedule_disk_access (iodriver *curriodriver, ioreq_event *curr)
 {
    int queuectlr = curriodriver->devices[(curr->devno)].queuectlr;
@@ -514,21 +523,34 @@ void iodriver_access_complete (int iodriverno, intr_event *intrp)
       tmp->next = NULL;
       update_iodriver_statistics();
       if ((numreqs = logorg_mapcomplete(sysorgs, numsysorgs, tmp)) == COMPLETE) {
-
-	/* update up overall I/O system stats for this completed request */
-	ioreq_event *temp = ioqueue_get_specific_request (overallqueue, tmp);
-	ioreq_event *temp2 = ioqueue_physical_access_done (overallqueue, temp);
-	ASSERT (temp2 != NULL);
-	addtoextraq((event *)temp);
-	temp = NULL;
+	/* a gathered full-stripe write completes several requests at */
+	/* once; the others are chained from tmp                      */
+	ioreq_event *done = tmp;
+
+	while (done) {
+	  ioreq_event *more = done->next;
+
+	  /* update up overall I/O system stats for this completed request */
+	  ioreq_event *temp = ioqueue_get_specific_request (overallqueue, done);
+	  ioreq_event *temp2 = ioqueue_physical_access_done (overallqueue, temp);
+	  ASSERT (temp2 != NULL);
+	  iosim_sample_response(temp, (simtime - temp->start_time));
+	  addtoextraq((event *)temp);
+	  temp = NULL;
 	
-	if (iodrivers[iodriverno]->type != STANDALONE) {
-	  iodriver_add_to_intrp_eventlist(intrp, 
-					  io_done_notify(tmp), 
-					  iodrivers[iodriverno]->scale);
-         } else {
-            io_done_notify (tmp);
-         }
+	  done->next = NULL;
+	  if (iodrivers[iodriverno]->type != STANDALONE) {
+	    iodriver_add_to_intrp_eventlist(intrp, 
+					    io_done_notify(done), 
+					    iodrivers[iodriverno]->scale);
+	  } else {
+	    io_done_notify (done);
+	  }
+	  if (done != tmp) {
+	    addtoextraq((event *) done);
+	  }
+	  done = more;
+	}
       } 
       else if (numreqs > 0) {
 	for (i = 0; i < numreqs; i++) {
@@ -603,6 +625,7 @@ schedule_next:
 void iodriver_respond_to_device (int iodriverno, intr_event *intrp)
 {
    ioreq_event *req = NULL;
+   intchar busno;
    int devno;
    int cause;
 
@@ -617,10 +640,18 @@ void iodriver_respond_to_device (int iodriverno, intr_event *intrp)
 fprintf (outputfile, "%f, Responding to device - cause = %d, blkno %d\n", simtime, req->cause, req->blkno);
 */
    req->type = IO_INTERRUPT_COMPLETE;
+   busno.value = req->busno;
    devno = req->devno;
    cause = req->cause;
    switch (cause) {
       case COMPLETION:
+                           if (bus_is_queuepair(busno.byte[0])) {
+                              /* answered when the completion was posted */
+                              if (iodrivers[iodriverno]->type == STANDALONE) {
+                                 addtoextraq((event *) req);
+                              }
+                              break;
+                           }
                            if (iodrivers[iodriverno]->type != STANDALONE) {
                               req = ioreq_copy((ioreq_event *) intrp->infoptr);
                            }
@@ -727,6 +758,20 @@ fprintf (outputfile, "%f, Interrupt arriving - cause = %d, blkno %d\n", simtime,
 }
 
 
+/* number of requests issued by the host and not yet completed */
+
+int iodriver_get_number_outstanding ()
+{
+   return(ioqueue_get_number_in_queue(overallqueue));
+}
+
+
+int iodriver_models_failure ()
+{
+   return(logorg_models_failure(sysorgs, numsysorgs));
+}
+
+
 double iodriver_tick ()
 {
    int i, j;
@@ -760,18 +805,27 @@ event * iodriver_request (int iodriverno, ioreq_event *curr)
    fprintf (stderr, "Entered iodriver_request - simtime %f, devno %d, blkno %d, cause %d\n", simtime, curr->devno, curr->blkno, curr->cause);
 #endif
 
-   /* add to the overall queue to start tracking */
-   ret = ioreq_copy (curr);
-   ioqueue_add_new_request (overallqueue, ret);
-   ret = NULL;
+   /* add to the overall queue to start tracking; background I/O */
+   /* raised inside the storage system (logorg rebuild, or a flush   */
+   /* of writes the logorg had already accepted) is neither tracked  */
+   /* nor counted toward warmup and checkpoints                      */
+   if (!(curr->flags & BACKGROUND)) {
+      ret = ioreq_copy (curr);
+      ret->start_time = simtime;
+      ioqueue_add_new_request (overallqueue, ret);
+      ret = NULL;
  
-   disksim->totalreqs++;
-   if ((disksim->checkpoint_iocnt > 0) && ((disksim->totalreqs % disksim->checkpoint_iocnt) == 0)) {
-      disksim_register_checkpoint (simtime);
-   }
-   if (disksim->totalreqs == disksim->warmup_iocnt) {
-      warmuptime = simtime;
-      resetstats();
+      disksim->totalreqs++;
+      if ((disksim->checkpoint_iocnt > 0) && ((disksim->totalreqs % disksim->checkpoint_iocnt) == 0)) {
+         disksim_register_checkpoint (simtime);
+      }
+      if (disksim->totalreqs == disksim->warmup_iocnt) {
+         warmuptime = simtime;
+         resetstats();
+         if (disksim->checkpoint_warmup) {
+            disksim_register_checkpoint (simtime);
+         }
+      }
    }
    numreqs = logorg_maprequest(sysorgs, numsysorgs, curr);
    temp = curr->next;
@@ -875,12 +929,17 @@ static void iodriver_set_ctl_to_device (int iodriverno, device * dev)
 static void get_device_maxoutstanding (iodriver *curriodriver, device * dev)
 {
    ioreq_event *chk = (ioreq_event *) getfromextraq();
+   int limit = bus_get_queue_limit(dev->buspath.byte[0]);
 
    chk->busno = dev->buspath.value;
    chk->slotno = dev->slotpath.value;
    chk->devno = dev->devno;
    chk->type = IO_QLEN_MAXCHECK;
    iodriver_send_event_down_path(chk);
+   if (limit) {
+      /* queue pair interfaces bound what the host may keep in flight */
+      chk->tempint2 = min(chk->tempint2, limit);
+   }
    dev->queuectlr = chk->tempint1;
    dev->maxoutstanding = (chk->tempint1 == -1) ? chk->tempint2 : -1;
    if (chk->tempint1 != -1) {
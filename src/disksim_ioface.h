@@ -123,6 +123,8 @@ extern "C" {
 
 /* Provided by I/O subsystem */
 
+struct checkpoint;
+
 void    io_readparams (FILE *parfile);
 void    io_printstats (void);
 void    io_cleanstats (void);
@@ -132,9 +134,13 @@ void    io_initialize (int standalone);
 void    io_internal_event (ioreq_event *curr);
 event * io_get_next_external_event (FILE *tracefile);
 int     io_using_external_event (event *curr);
+void    io_checkpoint (struct checkpoint *ckpt);
+void    io_restore (struct checkpoint *ckpt, int instance);
 event * io_request (ioreq_event *curr);
 void    io_schedule (ioreq_event *curr);
 double  io_tick (void);
+int     io_get_number_outstanding (void);
+int     io_models_failure (void);
 double  io_raise_priority (int opid, int devno, int blkno, void *chan);
 void    io_interrupt_arrive (ioreq_event *intrp);
 void    io_interrupt_complete (ioreq_event *intrp);
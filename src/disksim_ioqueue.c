@@ -100,6 +100,7 @@
 
 
 #include "disksim_ioqueue.h"
+#include "disksim_checkpoint.h"
 
 
 #include "modules/modules.h"
@@ -308,6 +309,54 @@ int ioqueue_get_dist (ioqueue *queue, int blkno)
 }
 
 
+/* Translate curr->blkno with the given map type.  The result is kept */
+/* in the iobuf, so each request is translated at most once per map   */
+/* type no matter how many times the schedulers look at it.  With     */
+/* "Verify cached mappings" set, every hit is checked against a fresh */
+/* translation.                                                       */
+
+static void
+ioqueue_get_device_mapping(ioqueue *queue,
+			   iobuf *curr,
+			   int maptype,
+			   int *cylptr,
+			   int *surfptr,
+			   int *sectptr)
+{
+   int slot = (maptype == MAP_FULL) ? 1 : 0;
+   int cyl, surf, sect;
+
+   if ((curr->mapvalid & (1 << slot)) && (curr->map[slot].maptype == maptype)) {
+      if (queue->verifymaps) {
+	 device_get_mapping(maptype, curr->iolist->devno, curr->blkno, &cyl, &surf, &sect);
+	 if ((cyl != curr->map[slot].cylinder) ||
+	     (surf != curr->map[slot].surface) ||
+	     (sect != curr->map[slot].sector)) {
+	    fprintf(stderr, "Stale cached mapping for blkno %d at ioqueue_get_device_mapping: %d/%d/%d vs %d/%d/%d\n", curr->blkno, curr->map[slot].cylinder, curr->map[slot].surface, curr->map[slot].sector, cyl, surf, sect);
+	    exit(1);
+	 }
+      }
+   } else {
+      device_get_mapping(maptype, curr->iolist->devno, curr->blkno, &cyl, &surf, &sect);
+      curr->map[slot].maptype = maptype;
+      curr->map[slot].cylinder = cyl;
+      curr->map[slot].surface = surf;
+      curr->map[slot].sector = sect;
+      curr->mapvalid |= 1 << slot;
+   }
+
+   if (cylptr) {
+      *cylptr = curr->map[slot].cylinder;
+   }
+   if (surfptr) {
+      *surfptr = curr->map[slot].surface;
+   }
+   if (sectptr) {
+      *sectptr = curr->map[slot].sector;
+   }
+}
+
+
 static void 
 ioqueue_get_cylinder_mapping(ioqueue *queue, 
 			     iobuf *curr, 
@@ -328,6 +377,10 @@ ioqueue_get_cylinder_mapping(ioqueue *queue,
       case MAP_ZONEONLY:
       case MAP_ADDSLIPS:
       case MAP_FULL:
+	 if (blkno == curr->blkno) {
+	    ioqueue_get_device_mapping(queue, curr, cylmaptype, cylptr, surfptr, NULL);
+	    break;
+	 }
 	 device_get_mapping(cylmaptype,
 			    curr->iolist->devno, 
 			    blkno, 
@@ -485,6 +538,31 @@ static void ioqueue_update_subqueue_statistics (subqueue *queue)
    }
    queue->lastalt = simtime;
 }
+
+
+/* iobufs no longer fit in an event on every ABI (see map[] in  */
+/* disksim_ioqueue.h), so they are recycled on their own list   */
+static iobuf *ioqueue_iobuf_freelist = NULL;
+
+static iobuf * ioqueue_get_iobuf (void)
+{
+   iobuf *tmp = ioqueue_iobuf_freelist;
+
+   if (tmp) {
+      ioqueue_iobuf_freelist = tmp->next;
+   } else {
+      tmp = (iobuf *) calloc(1, sizeof(iobuf));
+      ASSERT(tmp != NULL);
+   }
+   return(tmp);
+}
+
+static void ioqueue_free_iobuf (iobuf *tmp)
+{
+   tmp->next = ioqueue_iobuf_freelist;
+   ioqueue_iobuf_freelist = tmp;
+}
+
 static void remove_tsps(iobuf *tmp);
 
 static void ioqueue_remove_from_subqueue (subqueue *queue, iobuf *tmp)
@@ -586,7 +664,7 @@ static void ioqueue_insert_batch_fcfs_to_queue (subqueue *queue, iobuf *new_iobu
       // queue->listlen--;
       // because we didn't actually add an iobuf to the queue after all
       queue->iobufcnt--;
-      addtoextraq((event *)new_iobuf);
+      ioqueue_free_iobuf(new_iobuf);
 
       // printf("ioqueue_insert_batch_fcfs_to_queue:: queue contents after\n");
       // print_batch_fcfs_queue(queue);
@@ -719,7 +797,7 @@ static int ioqueue_check_concat (subqueue *queue, iobuf *req1, iobuf *req2, int
       queue->list = req1;
    }
    queue->iobufcnt--;
-   addtoextraq((event *) req2);
+   ioqueue_free_iobuf(req2);
    return(1);
 }
 
@@ -1523,7 +1601,7 @@ static void calc_sp(iobuf **array, subqueue *queue, int checkcache, int no_reque
     test->devno = temp->iolist->devno;
     test->flags = temp->flags;
     test->time = simtime;
-    device_get_mapping(queue->bigqueue->cylmaptype, temp->iolist->devno, temp->blkno, NULL, NULL, &sector);
+    ioqueue_get_device_mapping(queue->bigqueue, temp, queue->bigqueue->cylmaptype, NULL, NULL, &sector);
     if(start == 0){
       start = 1;
       acc_time = device_get_acctime(test->devno, test, 100000);
@@ -3035,7 +3113,7 @@ fprintf (outputfile, "Entering remove_completed_request - %d\n", queue->listlen)
      }
    }
    // tmp->batch_next = NULL;
-   addtoextraq((event *) tmp);
+   ioqueue_free_iobuf(tmp);
 /*
 fprintf (outputfile, "Exiting remove_completed_request\n");
 */
@@ -3195,8 +3273,7 @@ fprintf (outputfile, "Entering ioqueue_add_new_request: %d\n", new->blkno);
 */
    new->time = simtime;
    ioqueue_update_arrival_stats(queue, new);
-   tmp = (iobuf *) getfromextraq();
-   StaticAssert (sizeof(iobuf) <= sizeof(event));
+   tmp = ioqueue_get_iobuf();
    tmp->starttime = -1.0;
    tmp->state = WAITING;
    tmp->next = NULL;
@@ -3213,6 +3290,7 @@ fprintf (outputfile, "Entering ioqueue_add_new_request: %d\n", new->blkno);
    tmp->opid = new->opid;
    tmp->batchno = new->batchno;
    tmp->batch_list = NULL;
+   tmp->mapvalid = 0;
    if (tmp->batchno == -1) {
      tmp->batch_complete = TRUE;
    } else {
@@ -3705,7 +3783,6 @@ void ioqueue_initialize (ioqueue *queue, int devno)
 {
   /*  fprintf(stderr, "ioqueue_initialize::  devno = %d\n", devno); */
 
-   StaticAssert (sizeof(iobuf) <= DISKSIM_EVENT_SIZE);
    ioqueue_setcallbacks();
    ioqueue_subqueue_initialize(&queue->base, devno);
    queue->base.bigqueue = queue;
@@ -3735,6 +3812,66 @@ void ioqueue_initialize (ioqueue *queue, int devno)
 }
 
 
+/* Only the scheduling position is saved; checkpoints are taken */
+/* with every queue empty.                                      */
+
+static void ioqueue_subqueue_checkpoint (checkpoint_t *ckpt, subqueue *queue)
+{
+   checkpoint_put_int(ckpt, queue->dir);
+   checkpoint_put_int(ckpt, queue->lastblkno);
+   checkpoint_put_int(ckpt, queue->lastsurface);
+   checkpoint_put_int(ckpt, queue->lastcylno);
+   checkpoint_put_int(ckpt, queue->optcylno);
+   checkpoint_put_int(ckpt, queue->optsurface);
+   checkpoint_put_int(ckpt, queue->sstfupdown);
+   checkpoint_put_int(ckpt, queue->sstfupdowncnt);
+   checkpoint_put_double(ckpt, queue->lastalt);
+}
+
+
+static void ioqueue_subqueue_restore (checkpoint_t *ckpt, subqueue *queue)
+{
+   queue->dir = checkpoint_get_int(ckpt);
+   queue->lastblkno = checkpoint_get_int(ckpt);
+   queue->lastsurface = checkpoint_get_int(ckpt);
+   queue->lastcylno = checkpoint_get_int(ckpt);
+   queue->optcylno = checkpoint_get_int(ckpt);
+   queue->optsurface = checkpoint_get_int(ckpt);
+   queue->sstfupdown = checkpoint_get_int(ckpt);
+   queue->sstfupdowncnt = checkpoint_get_int(ckpt);
+   queue->lastalt = checkpoint_get_double(ckpt);
+}
+
+
+void ioqueue_checkpoint (checkpoint_t *ckpt, ioqueue *queue)
+{
+   ASSERT(ioqueue_get_number_in_queue(queue) == 0);
+   ioqueue_subqueue_checkpoint(ckpt, &queue->base);
+   ioqueue_subqueue_checkpoint(ckpt, &queue->timeout);
+   ioqueue_subqueue_checkpoint(ckpt, &queue->priority);
+   checkpoint_put_int(ckpt, queue->lastsubqueue);
+   checkpoint_put_int(ckpt, queue->seqblkno);
+   checkpoint_put_int(ckpt, queue->seqflags);
+   checkpoint_put_double(ckpt, queue->lastarr);
+   checkpoint_put_double(ckpt, queue->lastread);
+   checkpoint_put_double(ckpt, queue->lastwrite);
+}
+
+
+void ioqueue_restore (checkpoint_t *ckpt, ioqueue *queue)
+{
+   ioqueue_subqueue_restore(ckpt, &queue->base);
+   ioqueue_subqueue_restore(ckpt, &queue->timeout);
+   ioqueue_subqueue_restore(ckpt, &queue->priority);
+   queue->lastsubqueue = checkpoint_get_int(ckpt);
+   queue->seqblkno = checkpoint_get_int(ckpt);
+   queue->seqflags = checkpoint_get_int(ckpt);
+   queue->lastarr = checkpoint_get_double(ckpt);
+   queue->lastread = checkpoint_get_double(ckpt);
+   queue->lastwrite = checkpoint_get_double(ckpt);
+}
+
+
 void ioqueue_cleanstats (ioqueue *queue)
 {
    double tpass;
@@ -137,6 +137,9 @@ void		ioqueue_set_idlework_function (struct ioq *queue, void (**idlework)(void *
 void		ioqueue_set_enablement_function (struct ioq *queue, int (**enablement)(ioreq_event *));
 void		ioqueue_reset_idledetecter (struct ioq *queue, int timechange);
 void		ioqueue_print_contents (struct ioq *queue);
+struct checkpoint;
+void		ioqueue_checkpoint (struct checkpoint *ckpt, struct ioq *queue);
+void		ioqueue_restore (struct checkpoint *ckpt, struct ioq *queue);
 
 
 /* Request scheduling algorithms */
@@ -173,6 +176,9 @@ void		ioqueue_print_contents (struct ioq *queue);
 #define MAXSCHED         28
 
 
+/* slot 0 caches the queue's own cylinder mapping, slot 1 MAP_FULL */
+#define IOBUF_MAPS	2
+
 typedef struct iob {
    double    starttime;
    int       state;
@@ -198,6 +204,15 @@ typedef struct iob {
    int       cylinder;
    int       surface;
    int       opid;
+   /* device mappings of blkno, filled in on first use and reused by */
+   /* the schedulers for as long as the request is queued            */
+   struct {
+      int    maptype;
+      int    cylinder;
+      int    surface;
+      int    sector;
+   } map[IOBUF_MAPS];
+   int       mapvalid;
 } iobuf;
 
 struct ioq;
@@ -259,7 +274,7 @@ typedef struct ioq {
    int		devno;
    void		(**idlework)(void *,int);
    void	*	idleworkparam;
-   int		idledelay;
+   double	idledelay;
    timer_event *idledetect;
    int		(**coalesceok)(void *,int,int,int,int);
    void *	coalesceokparam;
@@ -312,6 +327,7 @@ typedef struct ioq {
    int		printidlestats;
    int		printintarrstats;
    int		printsizestats;
+   int		verifymaps;
    char        *name;
 } ioqueue;
 
@@ -100,6 +100,7 @@
 
 
 #include "disksim_iosim.h"
+#include "disksim_checkpoint.h"
 
 #include "modules/modules.h"
 
@@ -116,6 +117,9 @@ void iosim_initialize_iosim_info (void)
    ioscale = 1.0;
    last_request_arrive = 0.0;
    constintarrtime = 0.0;
+   tracesamplerate = 1;
+   tracesampleunit = 2048;
+   tracepasses = 1;
 }
 
 
@@ -188,6 +192,18 @@ double io_tick()
 }
 
 
+int io_get_number_outstanding ()
+{
+   return (iodriver_get_number_outstanding());
+}
+
+
+int io_models_failure ()
+{
+   return (iodriver_models_failure());
+}
+
+
 double io_raise_priority (int opid, int devno, int blkno, void *chan)
 {
    return (iodriver_raise_priority(0, opid, devno, blkno, chan));
@@ -216,7 +232,19 @@ fprintf (outputfile, "%f: io_internal_event entered with event type %d, %f\n", c
 */
    switch (curr->type) {
    case IO_REQUEST_ARRIVE:
-     iodriver_request(0, curr);
+     {
+       /* a non-standalone driver returns the resulting accesses to */
+       /* its caller; requests raised inside the I/O subsystem (e.g., */
+       /* logorg rebuild) have no CPU to run them, so schedule here   */
+       ioreq_event *ret = (ioreq_event *) iodriver_request(0, curr);
+       while (ret) {
+	 ioreq_event *next = ret->next;
+	 ret->next = NULL;
+	 ret->time += simtime;
+	 addtointq((event *) ret);
+	 ret = next;
+       }
+     }
      break;
      
    case IO_ACCESS_ARRIVE:
@@ -260,6 +288,8 @@ fprintf (outputfile, "%f: io_internal_event entered with event type %d, %f\n", c
    case MEMS_BUS_UPDATE:
    case SSD_CLEAN_ELEMENT:
    case SSD_CLEAN_GANG:
+   case SSD_SCHED_ARRAY_DONE:
+   case SSD_WBUF_DONE:
      device_event_arrive(curr);
      break;
 
@@ -365,6 +395,11 @@ static int iosim_load_map(struct lp_block *b, int n) {
   //#include "modules/disksim_iomap_param.c"
   lp_loadparams((void *)n, b, &disksim_iomap_mod);
 
+  if ((tracemap5[n] > 1) && (tracemap6[n] <= 0)) {
+    fprintf(stderr, "*** error: iomap for trace device %d: stripeWidth needs a stripeUnit\n", tracemap[n]);
+    exit(1);
+  }
+
   if (tracemap2[n] == 512) {
     tracemap2[n] = 0;
   } 
@@ -402,6 +437,38 @@ int iosim_load_mappings(struct lp_list *l) {
   return 1;
 }
 
+void iosim_set_trace_filter (char *name)
+{
+   if (disksim->iosim_info == NULL) {
+      iosim_initialize_iosim_info();
+   }
+   if (!strcmp(name, "all")) {
+      tracefilter = TRACE_FILTER_ALL;
+   } else if (!strcmp(name, "reads")) {
+      tracefilter = TRACE_FILTER_READS;
+   } else if (!strcmp(name, "writes")) {
+      tracefilter = TRACE_FILTER_WRITES;
+   } else {
+      fprintf(stderr, "*** error: unknown I/O trace request filter %s (all, reads or writes)\n", name);
+      exit(1);
+   }
+}
+
+void iosim_set_trace_sample_method (char *name)
+{
+   if (disksim->iosim_info == NULL) {
+      iosim_initialize_iosim_info();
+   }
+   if (!strcmp(name, "stride")) {
+      tracesamplemethod = TRACE_SAMPLE_STRIDE;
+   } else if (!strcmp(name, "hash")) {
+      tracesamplemethod = TRACE_SAMPLE_HASH;
+   } else {
+      fprintf(stderr, "*** error: unknown I/O trace sampling method %s (stride or hash)\n", name);
+      exit(1);
+   }
+}
+
 int disksim_iomap_loadparams(struct lp_block *b) { 
   ddbg_assert2(0, "this is a dummy and isn't supposed to be called");
   return 0;
@@ -568,6 +635,12 @@ void io_map_trace_request (ioreq_event *temp)
 	    }
 	 }
 	 temp->bcount *= tracemap3[i];
+	 if (tracemap5[i] > 1) {
+	    /* whole requests go to the device holding their first block */
+	    int unitno = temp->blkno / tracemap6[i];
+	    temp->devno += unitno % tracemap5[i];
+	    temp->blkno = ((unitno / tracemap5[i]) * tracemap6[i]) + (temp->blkno % tracemap6[i]);
+	 }
 	 temp->blkno += tracemap4[i];
 	 if (tracestats) {
 	    stat_update(&tracestats[i], ((double) temp->tempint1 / (double) 1000));
@@ -588,6 +661,380 @@ void io_map_trace_request (ioreq_event *temp)
 }
 
 
+/* Reads the next trace record, starting the trace over at its end  */
+/* while passes remain.  Each new pass begins one average           */
+/* inter-arrival time after the last record of the previous one.    */
+
+static ioreq_event * io_read_trace_record (FILE *iotracefile)
+{
+   ioreq_event *temp;
+
+   if (!tracestarted) {
+      tracestart = ftell(iotracefile);
+      tracestarted = TRUE;
+   }
+   temp = iotrace_get_ioreq_event(iotracefile, disksim->traceformat, (ioreq_event *) getfromextraq());
+   while ((temp == NULL) && ((tracepass + 1) < tracepasses) && (tracepassrecords > 0)) {
+      if ((tracestart < 0) || fseek(iotracefile, (long) tracestart, SEEK_SET)) {
+         fprintf(stderr, "*** error: I/O trace cannot be rewound for another pass\n");
+         exit(1);
+      }
+      tracepass++;
+      tracenewpass = TRUE;
+      temp = iotrace_get_ioreq_event(iotracefile, disksim->traceformat, (ioreq_event *) getfromextraq());
+   }
+   if (temp == NULL) {
+      return(NULL);
+   }
+
+   if (tracenewpass) {
+      double gap = (tracepassrecords > 1) ? ((tracelasttime - tracefirsttime) / (double) (tracepassrecords - 1)) : 0.0;
+      tracepassoffset = tracelasttime + gap - temp->time;
+      tracenewpass = FALSE;
+   }
+   temp->time += tracepassoffset;
+   if (tracerecords == 0) {
+      tracefirsttime = temp->time;
+   }
+   if (tracepass == 0) {
+      tracepassrecords++;
+   }
+   tracelasttime = temp->time;
+   tracerecords++;
+   return(temp);
+}
+
+
+static int io_sampling (void)
+{
+   return((disksim->iosim_info != NULL) && (disksim->iotrace) && (tracesamplerate > 1));
+}
+
+
+/* splitmix64 finalizer over a (device, region) pair */
+
+static uint64_t io_sample_hash (int devno, int regionno)
+{
+   uint64_t z = ((uint64_t) (unsigned) devno << 32) | (unsigned) regionno;
+
+   z += 0x9e3779b97f4a7c15ULL;
+   z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+   z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+   return(z ^ (z >> 31));
+}
+
+
+/* Open-addressed table of the regions kept by hash sampling, giving */
+/* each its packed position on the device.  Empty slots have devno   */
+/* -1; the size is always a power of two and at most half full.      */
+
+static iosample_region * io_sample_slot (int devno, int regionno)
+{
+   int mask = tracesampletabsize - 1;
+   int i = (int) (io_sample_hash(devno, regionno) & mask);
+
+   while ((tracesampletab[i].devno != -1) &&
+          ((tracesampletab[i].devno != devno) || (tracesampletab[i].regionno != regionno))) {
+      i = (i + 1) & mask;
+   }
+   return(&tracesampletab[i]);
+}
+
+
+static void io_sample_insert (int devno, int regionno, int packed)
+{
+   iosample_region *ent;
+
+   if (((tracesampletabused + 1) * 2) > tracesampletabsize) {
+      iosample_region *old = tracesampletab;
+      int oldsize = tracesampletabsize;
+      int i;
+
+      tracesampletabsize = (oldsize) ? (2 * oldsize) : 1024;
+      tracesampletab = malloc(tracesampletabsize * sizeof(iosample_region));
+      ASSERT(tracesampletab != NULL);
+      for (i=0; i<tracesampletabsize; i++) {
+         tracesampletab[i].devno = -1;
+      }
+      for (i=0; i<oldsize; i++) {
+         if (old[i].devno != -1) {
+            *io_sample_slot(old[i].devno, old[i].regionno) = old[i];
+         }
+      }
+      if (old) {
+         free(old);
+      }
+   }
+   ent = io_sample_slot(devno, regionno);
+   if (ent->devno == -1) {
+      tracesampletabused++;
+   }
+   ent->devno = devno;
+   ent->regionno = regionno;
+   ent->packed = packed;
+}
+
+
+/* Kept regions are packed in the order they are first touched. */
+
+static int io_sample_packed_region (int devno, int regionno)
+{
+   iosample_region *ent;
+   int packed = 0;
+
+   if (tracesampletabsize) {
+      ent = io_sample_slot(devno, regionno);
+      if (ent->devno != -1) {
+         return(ent->packed);
+      }
+      ent = io_sample_slot(devno, -1);
+      if (ent->devno != -1) {
+         packed = ent->packed;
+      }
+   }
+   io_sample_insert(devno, -1, (packed + 1));
+   io_sample_insert(devno, regionno, packed);
+   return(packed);
+}
+
+
+/* Read/write filtering and 1-in-N spatial sampling of the trace. */
+/* Sampling keeps whole regions of "I/O trace sampling unit"      */
+/* blocks and packs the kept regions together, so each device's   */
+/* address space shrinks along with its load.                     */
+
+static int io_keep_trace_record (ioreq_event *temp)
+{
+   int regionno;
+   int packed;
+
+   if (((tracefilter == TRACE_FILTER_READS) && !(temp->flags & READ)) ||
+       ((tracefilter == TRACE_FILTER_WRITES) && (temp->flags & READ))) {
+      tracefiltered++;
+      return(FALSE);
+   }
+   if (tracesamplerate > 1) {
+      regionno = temp->blkno / tracesampleunit;
+      if (tracesamplemethod == TRACE_SAMPLE_HASH) {
+         if ((io_sample_hash(temp->devno, regionno) % tracesamplerate) != 0) {
+            tracesampledout++;
+            return(FALSE);
+         }
+         packed = io_sample_packed_region(temp->devno, regionno);
+      } else {
+         if (((regionno + temp->devno) % tracesamplerate) != 0) {
+            tracesampledout++;
+            return(FALSE);
+         }
+         packed = regionno / tracesamplerate;
+      }
+      temp->blkno = (packed * tracesampleunit) + (temp->blkno % tracesampleunit);
+   }
+   return(TRUE);
+}
+
+
+/* A scaled device holds only about 1/rate of the regions, but the */
+/* number kept varies (hash) or rounds up (stride), so a mapped    */
+/* request that would run past its device wraps back onto it, a    */
+/* whole number of sampling units down.                            */
+
+static void io_sample_bound_request (ioreq_event *temp)
+{
+   int capacity = iodriver_get_number_of_blocks(0, temp->devno);
+   int span = (capacity / tracesampleunit) * tracesampleunit;
+
+   if ((temp->blkno + temp->bcount) <= capacity) {
+      return;
+   }
+   tracesamplewrapped++;
+   if (span > 0) {
+      temp->blkno %= span;
+   }
+   if ((temp->blkno + temp->bcount) > capacity) {
+      temp->blkno = 0;
+   }
+}
+
+
+/* With "I/O trace sampling scales capacity" set, caches and SSDs */
+/* divide their capacities by this, so that they see the same     */
+/* fraction of the working set as the full-scale system would.    */
+
+int iosim_sample_capacity_divisor (void)
+{
+   if ((!io_sampling()) || (!tracesamplescale)) {
+      return(1);
+   }
+   return(tracesamplerate);
+}
+
+
+/* Results from a sampled trace are collected in replicate groups, */
+/* each a fixed hash-chosen subset of the address regions, and the */
+/* spread of the per-group estimates gives the confidence interval */
+/* (the method of random groups).                                  */
+
+static iosample_group * io_sample_group (ioreq_event *req)
+{
+   uint64_t hash = io_sample_hash(req->devno, (req->blkno / tracesampleunit));
+
+   return(&tracegroups[(int) ((hash >> 32) % TRACE_SAMPLE_GROUPS)]);
+}
+
+
+static double io_sample_binlow (int bin)
+{
+   return((bin == 0) ? 0.0 : (0.01 * pow(2.0, ((double) (bin - 1) / 4.0))));
+}
+
+
+void iosim_sample_response (ioreq_event *req, double resptime)
+{
+   iosample_group *grp;
+   int bin = 0;
+
+   if (!io_sampling()) {
+      return;
+   }
+   grp = io_sample_group(req);
+   grp->requests++;
+   grp->resptime += resptime;
+   if (resptime >= 0.01) {
+      bin = 1 + (int) (4.0 * log(resptime / 0.01) / log(2.0));
+      bin = min(bin, (TRACE_SAMPLE_BINS - 1));
+   }
+   grp->resphist[bin]++;
+}
+
+
+void iosim_sample_cache_access (ioreq_event *req, int hit)
+{
+   iosample_group *grp;
+
+   if (!io_sampling()) {
+      return;
+   }
+   grp = io_sample_group(req);
+   grp->cachereads++;
+   if (hit) {
+      grp->cachehits++;
+   }
+}
+
+
+/* The response time below which a fraction frac of the requests in */
+/* the histogram fall, interpolated geometrically within its bin.   */
+
+static double io_sample_percentile (int *hist, int count, double frac)
+{
+   double want = frac * (double) count;
+   double seen = 0.0;
+   double low, high;
+   int bin;
+
+   for (bin=0; bin<(TRACE_SAMPLE_BINS-1); bin++) {
+      if ((seen + hist[bin]) >= want) {
+         break;
+      }
+      seen += hist[bin];
+   }
+   low = io_sample_binlow(bin);
+   high = io_sample_binlow(bin + 1);
+   if (bin == 0) {
+      return(high * (want - seen) / (double) hist[0]);
+   }
+   if (hist[bin] == 0) {
+      return(low);
+   }
+   return(low * pow((high / low), ((want - seen) / (double) hist[bin])));
+}
+
+
+/* 95% confidence half-width from n replicate estimates */
+
+static double io_sample_halfwidth (double *est, int n)
+{
+   static double t975[TRACE_SAMPLE_GROUPS] = { 0.0, 12.706, 4.303, 3.182, 2.776,
+      2.571, 2.447, 2.365, 2.306, 2.262, 2.228, 2.201, 2.179, 2.160, 2.145, 2.131 };
+   double mean = 0.0;
+   double var = 0.0;
+   int i;
+
+   if (n < 2) {
+      return(0.0);
+   }
+   for (i=0; i<n; i++) {
+      mean += est[i];
+   }
+   mean /= (double) n;
+   for (i=0; i<n; i++) {
+      var += (est[i] - mean) * (est[i] - mean);
+   }
+   var /= (double) (n - 1);
+   return(t975[n-1] * sqrt(var / (double) n));
+}
+
+
+static void io_sample_printstats (void)
+{
+   static double fracs[3] = { 0.5, 0.9, 0.99 };
+   double est[TRACE_SAMPLE_GROUPS];
+   int hist[TRACE_SAMPLE_BINS];
+   int requests = 0;
+   int reads = 0;
+   int hits = 0;
+   double resptime = 0.0;
+   int i, j, n;
+
+   bzero(hist, sizeof(hist));
+   for (i=0; i<TRACE_SAMPLE_GROUPS; i++) {
+      iosample_group *grp = &tracegroups[i];
+      requests += grp->requests;
+      resptime += grp->resptime;
+      reads += grp->cachereads;
+      hits += grp->cachehits;
+      for (j=0; j<TRACE_SAMPLE_BINS; j++) {
+         hist[j] += grp->resphist[j];
+      }
+   }
+   if (requests == 0) {
+      return;
+   }
+
+   fprintf(outputfile, "Sampled estimates (1 in %d regions, %d groups, 95%% confidence):\n", tracesamplerate, TRACE_SAMPLE_GROUPS);
+   for (i=0; i<TRACE_SAMPLE_GROUPS; i++) {
+      est[i] = (double) tracegroups[i].requests * TRACE_SAMPLE_GROUPS * tracesamplerate;
+   }
+   fprintf(outputfile, "Estimated requests:       \t%d\t+/- %f\n", (requests * tracesamplerate), io_sample_halfwidth(est, TRACE_SAMPLE_GROUPS));
+
+   for (i=0, n=0; i<TRACE_SAMPLE_GROUPS; i++) {
+      if (tracegroups[i].requests) {
+         est[n++] = tracegroups[i].resptime / (double) tracegroups[i].requests;
+      }
+   }
+   fprintf(outputfile, "Estimated response time average:\t%f\t+/- %f\n", (resptime / (double) requests), io_sample_halfwidth(est, n));
+
+   for (j=0; j<3; j++) {
+      for (i=0, n=0; i<TRACE_SAMPLE_GROUPS; i++) {
+         if (tracegroups[i].requests) {
+            est[n++] = io_sample_percentile(tracegroups[i].resphist, tracegroups[i].requests, fracs[j]);
+         }
+      }
+      fprintf(outputfile, "Estimated response time %2d%%:\t%f\t+/- %f\n", (int) (fracs[j] * 100.0), io_sample_percentile(hist, requests, fracs[j]), io_sample_halfwidth(est, n));
+   }
+
+   if (reads) {
+      for (i=0, n=0; i<TRACE_SAMPLE_GROUPS; i++) {
+         if (tracegroups[i].cachereads) {
+            est[n++] = (double) tracegroups[i].cachehits / (double) tracegroups[i].cachereads;
+         }
+      }
+      fprintf(outputfile, "Estimated cache read hit ratio:\t%f\t+/- %f\n", ((double) hits / (double) reads), io_sample_halfwidth(est, n));
+   }
+}
+
+
 event * io_get_next_external_event (FILE *iotracefile)
 {
    ioreq_event *temp;
@@ -596,8 +1043,6 @@ event * io_get_next_external_event (FILE *iotracefile)
 
    //fprintf (outputfile, "Near beginning of io_get_next_external_event\n");
 
-   temp = (ioreq_event *) getfromextraq();
-
    switch (disksim->traceformat) {
       case VALIDATE: io_validate_do_stats1();
 		     break;
@@ -605,7 +1050,9 @@ event * io_get_next_external_event (FILE *iotracefile)
                 break;
    }
 
-   temp = iotrace_get_ioreq_event(iotracefile, disksim->traceformat, temp);
+   while ((temp = io_read_trace_record(iotracefile)) && (!io_keep_trace_record(temp))) {
+      addtoextraq((event *) temp);
+   }
    if (temp) {
       switch (disksim->traceformat) {
          case VALIDATE: io_validate_do_stats2 (temp);
@@ -617,6 +1064,13 @@ event * io_get_next_external_event (FILE *iotracefile)
 	 last_request_arrive = temp->time;
       }
       temp->time = (temp->time * ioscale) + tracebasetime;
+      if (tracemaxidle > 0.0) {
+         if ((temp->time - tracelastkept) > tracemaxidle) {
+            traceidleremoved += temp->time - tracelastkept - tracemaxidle;
+         }
+         tracelastkept = temp->time;
+         temp->time -= traceidleremoved;
+      }
       if ((temp->time < simtime) && (!disksim->closedios)) {
          fprintf(stderr, "Trace event appears out of time order in trace - simtime %f, time %f\n", simtime, temp->time);
 	 fprintf(stderr, "ioscale %f, tracebasetime %f\n", ioscale, tracebasetime);
@@ -626,6 +1080,9 @@ event * io_get_next_external_event (FILE *iotracefile)
       if (tracemappings) {
          io_map_trace_request(temp);
       }
+      if ((io_sampling()) && (tracesamplescale)) {
+         io_sample_bound_request(temp);
+      }
       io_extq = (event *)temp;
       io_extq_type = temp->type;
    }
@@ -647,6 +1104,111 @@ int io_using_external_event (event *curr)
 }
 
 
+/* Checkpoints are only taken between requests, so the one piece of */
+/* I/O state on the event queue is the next (already read) trace    */
+/* arrival.                                                         */
+
+void io_checkpoint (checkpoint_t *ckpt)
+{
+   ioreq_event *next = (ioreq_event *) io_extq;
+   int i;
+
+   checkpoint_begin_section(ckpt, "IOSM", 0);
+   checkpoint_put_double(ckpt, last_request_arrive);
+   checkpoint_put_int64(ckpt, tracestart);
+   checkpoint_put_int(ckpt, tracestarted);
+   checkpoint_put_int(ckpt, tracepass);
+   checkpoint_put_int(ckpt, tracenewpass);
+   checkpoint_put_double(ckpt, tracepassoffset);
+   checkpoint_put_double(ckpt, tracefirsttime);
+   checkpoint_put_double(ckpt, tracelasttime);
+   checkpoint_put_double(ckpt, tracelastkept);
+   checkpoint_put_double(ckpt, traceidleremoved);
+   checkpoint_put_int(ckpt, tracepassrecords);
+   checkpoint_put_int(ckpt, tracerecords);
+   checkpoint_put_int(ckpt, tracefiltered);
+   checkpoint_put_int(ckpt, tracesampledout);
+   checkpoint_put_int(ckpt, tracesamplewrapped);
+   checkpoint_put_int(ckpt, tracesampletabused);
+   for (i=0; i<tracesampletabsize; i++) {
+      if (tracesampletab[i].devno != -1) {
+         checkpoint_put_int(ckpt, tracesampletab[i].devno);
+         checkpoint_put_int(ckpt, tracesampletab[i].regionno);
+         checkpoint_put_int(ckpt, tracesampletab[i].packed);
+      }
+   }
+   checkpoint_put_int(ckpt, (next != NULL));
+   if (next) {
+      checkpoint_put_int(ckpt, io_extq_type);
+      checkpoint_put_double(ckpt, next->time);
+      checkpoint_put_int(ckpt, next->devno);
+      checkpoint_put_int(ckpt, next->blkno);
+      checkpoint_put_int(ckpt, next->bcount);
+      checkpoint_put_int(ckpt, next->flags);
+      checkpoint_put_int(ckpt, next->busno);
+      checkpoint_put_int(ckpt, next->slotno);
+      checkpoint_put_int(ckpt, next->opid);
+      checkpoint_put_int(ckpt, next->cause);
+      checkpoint_put_int(ckpt, next->tempint1);
+      checkpoint_put_int(ckpt, next->tempint2);
+      checkpoint_put_int(ckpt, next->batchno);
+      checkpoint_put_int(ckpt, next->batch_complete);
+   }
+   checkpoint_end_section(ckpt);
+}
+
+
+void io_restore (checkpoint_t *ckpt, int instance)
+{
+   ioreq_event *next;
+   int i;
+
+   last_request_arrive = checkpoint_get_double(ckpt);
+   tracestart = checkpoint_get_int64(ckpt);
+   tracestarted = checkpoint_get_int(ckpt);
+   tracepass = checkpoint_get_int(ckpt);
+   tracenewpass = checkpoint_get_int(ckpt);
+   tracepassoffset = checkpoint_get_double(ckpt);
+   tracefirsttime = checkpoint_get_double(ckpt);
+   tracelasttime = checkpoint_get_double(ckpt);
+   tracelastkept = checkpoint_get_double(ckpt);
+   traceidleremoved = checkpoint_get_double(ckpt);
+   tracepassrecords = checkpoint_get_int(ckpt);
+   tracerecords = checkpoint_get_int(ckpt);
+   tracefiltered = checkpoint_get_int(ckpt);
+   tracesampledout = checkpoint_get_int(ckpt);
+   tracesamplewrapped = checkpoint_get_int(ckpt);
+   for (i = checkpoint_get_int(ckpt); i > 0; i--) {
+      int devno = checkpoint_get_int(ckpt);
+      int regionno = checkpoint_get_int(ckpt);
+      io_sample_insert(devno, regionno, checkpoint_get_int(ckpt));
+   }
+   if (checkpoint_get_int(ckpt) == 0) {
+      return;
+   }
+   ASSERT(io_extq == NULL);
+   next = (ioreq_event *) getfromextraq();
+   memset(next, 0, sizeof(ioreq_event));
+   io_extq_type = checkpoint_get_int(ckpt);
+   next->type = NULL_EVENT;
+   next->time = checkpoint_get_double(ckpt);
+   next->devno = checkpoint_get_int(ckpt);
+   next->blkno = checkpoint_get_int(ckpt);
+   next->bcount = checkpoint_get_int(ckpt);
+   next->flags = checkpoint_get_int(ckpt);
+   next->busno = checkpoint_get_int(ckpt);
+   next->slotno = checkpoint_get_int(ckpt);
+   next->opid = checkpoint_get_int(ckpt);
+   next->cause = checkpoint_get_int(ckpt);
+   next->tempint1 = checkpoint_get_int(ckpt);
+   next->tempint2 = checkpoint_get_int(ckpt);
+   next->batchno = checkpoint_get_int(ckpt);
+   next->batch_complete = checkpoint_get_int(ckpt);
+   io_extq = (event *) next;
+   addtointq((event *) next);
+}
+
+
 void io_printstats()
 {
    int i;
@@ -658,6 +1220,20 @@ void io_printstats()
 
    iotrace_printstats (outputfile);
 
+   if ((tracefilter != TRACE_FILTER_ALL) || (tracesamplerate > 1) || (tracepasses > 1) || (tracemaxidle > 0.0)) {
+      fprintf(outputfile, "Trace records read:       \t%d\n", tracerecords);
+      fprintf(outputfile, "Trace records filtered:   \t%d\n", tracefiltered);
+      fprintf(outputfile, "Trace records sampled out:\t%d\n", tracesampledout);
+      if (tracesamplescale) {
+         fprintf(outputfile, "Trace records wrapped:    \t%d\n", tracesamplewrapped);
+      }
+      fprintf(outputfile, "Trace passes replayed:    \t%d\n", (tracerecords) ? (tracepass + 1) : 0);
+      fprintf(outputfile, "Trace idle time removed:  \t%f\n", traceidleremoved);
+   }
+   if (io_sampling()) {
+      io_sample_printstats();
+   }
+
    if ((tracestats) && (PRINTTRACESTATS)) {
       /* info relevant to HPL traces */
       for (i=0; i<tracemappings; i++) {
@@ -721,6 +1297,7 @@ void io_initialize (int standalone)
 
 void io_resetstats()
 {
+   bzero(tracegroups, sizeof(tracegroups));
    iodriver_resetstats();
    device_resetstats();
    bus_resetstats();
@@ -157,6 +157,8 @@
 
 #define SSD_CLEAN_ELEMENT		        301
 #define SSD_CLEAN_GANG			        302
+#define SSD_SCHED_ARRAY_DONE		        303
+#define SSD_WBUF_DONE			        304
 
 /* I/O Interrupt cause types */
 
@@ -241,6 +243,11 @@ ioreq_event * ioreq_copy (ioreq_event *old);
 int ioreq_compare (ioreq_event *first, ioreq_event *second);
 void iosim_get_path_to_controller (int iodriverno, int ctlno, intchar *buspath, intchar *slotpath);
 void iosim_get_path_to_device (int iodriverno, int devno, intchar *buspath, intchar *slotpath);
+void iosim_set_trace_filter (char *name);
+void iosim_set_trace_sample_method (char *name);
+int  iosim_sample_capacity_divisor (void);
+void iosim_sample_response (ioreq_event *req, double resptime);
+void iosim_sample_cache_access (ioreq_event *req, int hit);
 
 
 
@@ -256,6 +263,20 @@ void iosim_get_path_to_device (int iodriverno, int devno, intchar *buspath, intc
 
 #define TRACEMAPPINGS	MAXDEVICES
 
+/* trace request filters */
+#define TRACE_FILTER_ALL	0
+#define TRACE_FILTER_READS	1
+#define TRACE_FILTER_WRITES	2
+
+/* trace sampling methods */
+#define TRACE_SAMPLE_STRIDE	0
+#define TRACE_SAMPLE_HASH	1
+
+/* replicate groups and log-spaced response time bins (4 per doubling */
+/* from 0.01 ms) used for the estimates made from a sampled trace     */
+#define TRACE_SAMPLE_GROUPS	16
+#define TRACE_SAMPLE_BINS	96
+
 #define PRINTTRACESTATS		TRUE
 
 
@@ -270,6 +291,20 @@ static char *statdesc_traceaccwritestats =	"Trace write access time";
 static char *statdesc_traceaccdiffwritestats =	"Trace write access diff time";
 
 
+typedef struct iosample_region {
+   int     devno;
+   int     regionno;	/* -1 holds the device's next packed region */
+   int     packed;
+} iosample_region;
+
+typedef struct iosample_group {
+   int     requests;
+   double  resptime;
+   int     resphist[TRACE_SAMPLE_BINS];
+   int     cachereads;
+   int     cachehits;
+} iosample_group;
+
 typedef struct iosim_info {
    event * io_extq;
    int     io_extqlen;
@@ -284,6 +319,33 @@ typedef struct iosim_info {
    int     tracemap2[TRACEMAPPINGS];
    int     tracemap3[TRACEMAPPINGS];
    int     tracemap4[TRACEMAPPINGS];
+   int     tracemap5[TRACEMAPPINGS];
+   int     tracemap6[TRACEMAPPINGS];
+   double  tracemaxidle;
+   int     tracefilter;
+   int     tracesamplerate;
+   int     tracesampleunit;
+   int     tracesamplemethod;
+   int     tracesamplescale;
+   iosample_region *tracesampletab;
+   int     tracesampletabsize;
+   int     tracesampletabused;
+   iosample_group tracegroups[TRACE_SAMPLE_GROUPS];
+   int     tracepasses;
+   int     tracepass;
+   int64_t tracestart;
+   int     tracestarted;
+   int     tracenewpass;
+   double  tracepassoffset;
+   double  tracefirsttime;
+   double  tracelasttime;
+   double  tracelastkept;
+   double  traceidleremoved;
+   int     tracepassrecords;
+   int     tracerecords;
+   int     tracefiltered;
+   int     tracesampledout;
+   int     tracesamplewrapped;
    statgen *tracestats;
    statgen *tracestats1;
    statgen *tracestats2;
@@ -307,6 +369,33 @@ typedef struct iosim_info {
 #define tracemap2                (disksim->iosim_info->tracemap2)
 #define tracemap3                (disksim->iosim_info->tracemap3)
 #define tracemap4                (disksim->iosim_info->tracemap4)
+#define tracemap5                (disksim->iosim_info->tracemap5)
+#define tracemap6                (disksim->iosim_info->tracemap6)
+#define tracemaxidle             (disksim->iosim_info->tracemaxidle)
+#define tracefilter              (disksim->iosim_info->tracefilter)
+#define tracesamplerate          (disksim->iosim_info->tracesamplerate)
+#define tracesampleunit          (disksim->iosim_info->tracesampleunit)
+#define tracesamplemethod        (disksim->iosim_info->tracesamplemethod)
+#define tracesamplescale         (disksim->iosim_info->tracesamplescale)
+#define tracesampletab           (disksim->iosim_info->tracesampletab)
+#define tracesampletabsize       (disksim->iosim_info->tracesampletabsize)
+#define tracesampletabused       (disksim->iosim_info->tracesampletabused)
+#define tracegroups              (disksim->iosim_info->tracegroups)
+#define tracepasses              (disksim->iosim_info->tracepasses)
+#define tracepass                (disksim->iosim_info->tracepass)
+#define tracestart               (disksim->iosim_info->tracestart)
+#define tracestarted             (disksim->iosim_info->tracestarted)
+#define tracenewpass             (disksim->iosim_info->tracenewpass)
+#define tracepassoffset          (disksim->iosim_info->tracepassoffset)
+#define tracefirsttime           (disksim->iosim_info->tracefirsttime)
+#define tracelasttime            (disksim->iosim_info->tracelasttime)
+#define tracelastkept            (disksim->iosim_info->tracelastkept)
+#define traceidleremoved         (disksim->iosim_info->traceidleremoved)
+#define tracepassrecords         (disksim->iosim_info->tracepassrecords)
+#define tracerecords             (disksim->iosim_info->tracerecords)
+#define tracefiltered            (disksim->iosim_info->tracefiltered)
+#define tracesampledout          (disksim->iosim_info->tracesampledout)
+#define tracesamplewrapped       (disksim->iosim_info->tracesamplewrapped)
 #define tracestats               (disksim->iosim_info->tracestats)
 #define tracestats1              (disksim->iosim_info->tracestats1)
 #define tracestats2              (disksim->iosim_info->tracestats2)
@@ -103,6 +103,7 @@
 #include "disksim_global.h"
 #include "disksim_hptrace.h"
 #include "disksim_iotrace.h"
+#include "disksim_checkpoint.h"
 
 
 static void iotrace_initialize_iotrace_info ()
@@ -774,3 +775,66 @@ void iotrace_printstats (FILE *outfile)
    }
 }
 
+
+
+/* Saves the trace file position and the per-format conversion state. */
+
+void iotrace_checkpoint (checkpoint_t *ckpt)
+{
+   checkpoint_begin_section(ckpt, "IOTR", 0);
+   checkpoint_put_int(ckpt, disksim->traceformat);
+   checkpoint_put_int64(ckpt, ftell(disksim->iotracefile));
+   checkpoint_put_double(ckpt, tracebasetime);
+   checkpoint_put_int(ckpt, syncreads);
+   checkpoint_put_int(ckpt, syncwrites);
+   checkpoint_put_int(ckpt, asyncreads);
+   checkpoint_put_int(ckpt, asyncwrites);
+   checkpoint_put_int(ckpt, hpreads);
+   checkpoint_put_int(ckpt, hpwrites);
+   checkpoint_put_int(ckpt, firstio);
+   checkpoint_put_int(ckpt, basehighshort);
+   checkpoint_put_int(ckpt, basehighshort2);
+   checkpoint_put_int(ckpt, lasttime1);
+   checkpoint_put_double(ckpt, lasttime);
+   checkpoint_put_int(ckpt, baseyear);
+   checkpoint_put_int(ckpt, baseday);
+   checkpoint_put_int(ckpt, basesecond);
+   checkpoint_put_int(ckpt, basebigtime);
+   checkpoint_put_int(ckpt, basesmalltime);
+   checkpoint_put_double(ckpt, basesimtime);
+   checkpoint_put_double(ckpt, accumulated_event_time);
+   checkpoint_put_double(ckpt, lastaccesstime);
+   checkpoint_end_section(ckpt);
+}
+
+
+void iotrace_restore (checkpoint_t *ckpt, int instance)
+{
+   long offset;
+
+   checkpoint_check(ckpt, "trace format", checkpoint_get_int(ckpt), disksim->traceformat);
+   offset = (long) checkpoint_get_int64(ckpt);
+   if ((disksim->iotracefile == NULL) || fseek(disksim->iotracefile, offset, SEEK_SET)) {
+      checkpoint_mismatch(ckpt, "trace file");
+   }
+   tracebasetime = checkpoint_get_double(ckpt);
+   syncreads = checkpoint_get_int(ckpt);
+   syncwrites = checkpoint_get_int(ckpt);
+   asyncreads = checkpoint_get_int(ckpt);
+   asyncwrites = checkpoint_get_int(ckpt);
+   hpreads = checkpoint_get_int(ckpt);
+   hpwrites = checkpoint_get_int(ckpt);
+   firstio = checkpoint_get_int(ckpt);
+   basehighshort = checkpoint_get_int(ckpt);
+   basehighshort2 = checkpoint_get_int(ckpt);
+   lasttime1 = checkpoint_get_int(ckpt);
+   lasttime = checkpoint_get_double(ckpt);
+   baseyear = checkpoint_get_int(ckpt);
+   baseday = checkpoint_get_int(ckpt);
+   basesecond = checkpoint_get_int(ckpt);
+   basebigtime = checkpoint_get_int(ckpt);
+   basesmalltime = checkpoint_get_int(ckpt);
+   basesimtime = checkpoint_get_double(ckpt);
+   accumulated_event_time = checkpoint_get_double(ckpt);
+   lastaccesstime = checkpoint_get_double(ckpt);
+}
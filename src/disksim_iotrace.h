@@ -129,5 +129,9 @@ ioreq_event * iotrace_get_ioreq_event (FILE *tracefile, int traceformat, ioreq_e
 ioreq_event * iotrace_validate_get_ioreq_event(FILE *tracefile, ioreq_event *new);
 void iotrace_printstats (FILE *outfile);
 
+struct checkpoint;
+void iotrace_checkpoint (struct checkpoint *ckpt);
+void iotrace_restore (struct checkpoint *ckpt, int instance);
+
 #endif    /* DISKSIM_IOTRACE_H */
 
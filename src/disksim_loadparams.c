@@ -120,7 +120,13 @@ int disksim_loadparams(char *inputfile, int synthgen) {
   }
 
   // do this *after* logorgs get instantiated!
-  if(synthgen) {
+  if(synthgen && lp_lookup_spec("Synthfast")) {
+    // the fast generator replaces the process-flow one
+    disksim->synthgen = 0;
+    disksim->synthfast = 1;
+    lp_instantiate("Synthfast", "Synthfast");
+  }
+  else if(synthgen) {
     lp_instantiate("Proc", "Proc");
     lp_instantiate("Synthio", "Synthio");
   }
@@ -306,22 +306,8 @@ static void logorg_diffdist (double mydiff, int *dist)
 }
 
 
-static void logorg_maprequest_update_stats (logorg *currlogorg, ioreq_event *curr, outstand *req, int numreqs)
+static void logorg_update_size_stats (logorg *currlogorg, ioreq_event *curr)
 {
-   int i;
-   ioreq_event *temp;
-   int gen;
-   double tpass;
-   logorgdev *currdev;
-   int orgdevno = curr->devno - currlogorg->devs[0].devno;
-/*
-fprintf (outputfile, "Entering logorg_maprequest_update_stats - numreqs %d, orgdevno %d\n", numreqs, orgdevno);
-*/
-   currdev = &currlogorg->devs[orgdevno];
-   logorg_update_interfere_stats(currlogorg, curr);
-   logorg_update_intarr_stats(currlogorg, curr);
-   logorg_update_blocking_stats(currlogorg, curr);
-   
    if (currlogorg->printsizestats) {
       stat_update(&currlogorg->stat.sizestats, (double) curr->bcount);
       if (curr->flags & READ) {
@@ -330,6 +316,62 @@ fprintf (outputfile, "Entering logorg_maprequest_update_stats - numreqs %d, orgd
          stat_update(&currlogorg->stat.writesizestats, (double) curr->bcount);
       }
    }
+}
+
+
+static void logorg_update_devout_stats (logorg *currlogorg, ioreq_event *curr, int numreqs)
+{
+   int i;
+   ioreq_event *temp = curr;
+
+   for (i=0; i<numreqs; i++) {
+      currlogorg->devs[(temp->devno - currlogorg->devs[0].devno)].numout++;
+      temp = temp->next;
+   }
+}
+
+
+static void logorg_update_outstanding_stats (logorg *currlogorg, ioreq_event *curr, outstand *req)
+{
+   double tpass;
+
+   if (currlogorg->stat.outstanding > 0) {
+      currlogorg->stat.nonzeroouttime += simtime - currlogorg->stat.outtime;
+   } else {
+      tpass = simtime - currlogorg->stat.idlestart;
+      stat_update(&currlogorg->stat.idlestats, tpass);
+   }
+   currlogorg->stat.idlestart = simtime;
+   currlogorg->stat.runouttime += (double) currlogorg->stat.outstanding * (simtime - currlogorg->stat.outtime);
+   currlogorg->stat.outstanding++;
+   if (currlogorg->stat.outstanding >= MAX_QUEUE_LENGTH) {
+      fprintf(stderr,"Stopping simulation because of saturation: simtime %f, totalreqs %d\n", simtime, disksim->totalreqs);
+      fflush(stderr);
+      fprintf (outputfile, "Stopping simulation because of saturation: simtime %f, totalreqs %d\n", simtime, disksim->totalreqs);
+      fprintf (outputfile, "last request:  dev=%d, blk=%d, cnt=%d, %d (R==1)\n",curr->devno, curr->blkno, curr->bcount, (curr->flags & READ));
+      disksim_simstop();
+   }
+   if (req->flags & READ) {
+      currlogorg->stat.readoutstanding++;
+   }
+   if (currlogorg->stat.outstanding > currlogorg->stat.maxoutstanding) {
+      currlogorg->stat.maxoutstanding = currlogorg->stat.outstanding;
+   }
+   currlogorg->stat.outtime = simtime;
+}
+
+
+static void logorg_update_arrival_stats (logorg *currlogorg, ioreq_event *curr, outstand *req)
+{
+   int gen;
+   logorgdev *currdev;
+   int orgdevno = curr->devno - currlogorg->devs[0].devno;
+
+   currdev = &currlogorg->devs[orgdevno];
+   logorg_update_interfere_stats(currlogorg, curr);
+   logorg_update_intarr_stats(currlogorg, curr);
+   logorg_update_blocking_stats(currlogorg, curr);
+   logorg_update_size_stats(currlogorg, curr);
    if (curr->flags & TIME_CRITICAL) {
       if (curr->flags & READ) {
          currlogorg->stat.critreads++;
@@ -375,38 +417,17 @@ fprintf (outputfile, "Entering logorg_maprequest_update_stats - numreqs %d, orgd
    }
    currlogorg->stat.gens[gen] = curr->devno;
    logorg_streakstat(currlogorg, orgdevno);
+   logorg_update_outstanding_stats(currlogorg, curr, req);
+}
+
+
+static void logorg_maprequest_update_stats (logorg *currlogorg, ioreq_event *curr, outstand *req, int numreqs)
+{
 /*
-fprintf (outputfile, "Midway through stats\n");
+fprintf (outputfile, "Entering logorg_maprequest_update_stats - numreqs %d, devno %d\n", numreqs, curr->devno);
 */
-   temp = curr;
-   for (i=0; i<numreqs; i++) {
-      currlogorg->devs[(temp->devno - currlogorg->devs[0].devno)].numout++;
-      temp = temp->next;
-   }
-
-   if (currlogorg->stat.outstanding > 0) {
-      currlogorg->stat.nonzeroouttime += simtime - currlogorg->stat.outtime;
-   } else {
-      tpass = simtime - currlogorg->stat.idlestart;
-      stat_update(&currlogorg->stat.idlestats, tpass);
-   }
-   currlogorg->stat.idlestart = simtime;
-   currlogorg->stat.runouttime += (double) currlogorg->stat.outstanding * (simtime - currlogorg->stat.outtime);
-   currlogorg->stat.outstanding++;
-   if (currlogorg->stat.outstanding >= MAX_QUEUE_LENGTH) {
-      fprintf(stderr,"Stopping simulation because of saturation: simtime %f, totalreqs %d\n", simtime, disksim->totalreqs);
-      fflush(stderr);
-      fprintf (outputfile, "Stopping simulation because of saturation: simtime %f, totalreqs %d\n", simtime, disksim->totalreqs);
-      fprintf (outputfile, "last request:  dev=%d, blk=%d, cnt=%d, %d (R==1)\n",curr->devno, curr->blkno, curr->bcount, (curr->flags & READ));
-      disksim_simstop();
-   }
-   if (req->flags & READ) {
-      currlogorg->stat.readoutstanding++;
-   }
-   if (currlogorg->stat.outstanding > currlogorg->stat.maxoutstanding) {
-      currlogorg->stat.maxoutstanding = currlogorg->stat.outstanding;
-   }
-   currlogorg->stat.outtime = simtime;
+   logorg_update_arrival_stats(currlogorg, curr, req);
+   logorg_update_devout_stats(currlogorg, curr, numreqs);
 /*
 fprintf (outputfile, "Leaving maprequest_stats\n");
 */
@@ -421,7 +442,11 @@ static void logorg_mapcomplete_update_stats (logorg *currlogorg, ioreq_event *cu
    currlogorg->stat.outstanding--;
    if (req->flags & READ) {
       currlogorg->stat.readoutstanding--;
+   } else {
+      currlogorg->stat.hostwriteblks += req->bcount;
    }
+   currlogorg->stat.phaseresptime[currlogorg->failstate] += simtime - req->arrtime;
+   currlogorg->stat.phasecount[currlogorg->failstate]++;
    currlogorg->stat.outtime = simtime;
 }
 
@@ -470,46 +495,126 @@ void logorg_timestamp (ioreq_event *curr)
 }
 
 
+/* Outstanding requests are hashed on opid, which is how completions */
+/* find them, and also linked into a second table keyed on buf for    */
+/* logorg_raise_priority.  Both tables double together whenever the   */
+/* average chain would exceed two entries.                            */
+
+#define LOGORG_OPID_HASH(currlogorg, opid) \
+   ((u_int) (opid) & ((currlogorg)->hashsize - 1))
+
+static u_int logorg_buf_hash (logorg *currlogorg, void *buf)
+{
+   unsigned long key = (unsigned long) buf;
+
+   key ^= key >> 16;
+   return ((u_int) (key * 2654435761UL) >> 8) & (currlogorg->hashsize - 1);
+}
+
+
+static void logorg_outstand_allocate (logorg *currlogorg, int hashsize)
+{
+   currlogorg->hashsize = hashsize;
+   currlogorg->hashoutstand = (outstand **) DISKSIM_malloc(hashsize * sizeof(outstand *));
+   currlogorg->hashbuf = (outstand **) DISKSIM_malloc(hashsize * sizeof(outstand *));
+   ASSERT((currlogorg->hashoutstand != NULL) && (currlogorg->hashbuf != NULL));
+   bzero(currlogorg->hashoutstand, hashsize * sizeof(outstand *));
+   bzero(currlogorg->hashbuf, hashsize * sizeof(outstand *));
+}
+
+
+static void logorg_link_buf (logorg *currlogorg, outstand *temp)
+{
+   u_int bucket = logorg_buf_hash(currlogorg, temp->buf);
+
+   temp->bufprev = NULL;
+   temp->bufnext = currlogorg->hashbuf[bucket];
+   if (temp->bufnext) {
+      temp->bufnext->bufprev = temp;
+   }
+   currlogorg->hashbuf[bucket] = temp;
+}
+
+
+static void logorg_unlink_buf (logorg *currlogorg, outstand *temp)
+{
+   if (temp->bufprev) {
+      temp->bufprev->bufnext = temp->bufnext;
+   } else {
+      currlogorg->hashbuf[logorg_buf_hash(currlogorg, temp->buf)] = temp->bufnext;
+   }
+   if (temp->bufnext) {
+      temp->bufnext->bufprev = temp->bufprev;
+   }
+}
+
+
+static void logorg_outstand_grow (logorg *currlogorg)
+{
+   outstand **oldhash = currlogorg->hashoutstand;
+   int oldsize = currlogorg->hashsize;
+   outstand *run;
+   outstand *tmp;
+   int i;
+
+   free(currlogorg->hashbuf);
+   logorg_outstand_allocate(currlogorg, (2 * oldsize));
+   for (i = 0; i < oldsize; i++) {
+      run = oldhash[i];
+      while (run) {
+         tmp = run->next;
+         run->next = currlogorg->hashoutstand[LOGORG_OPID_HASH(currlogorg, run->opid)];
+         currlogorg->hashoutstand[LOGORG_OPID_HASH(currlogorg, run->opid)] = run;
+         logorg_link_buf(currlogorg, run);
+         run = tmp;
+      }
+   }
+   free(oldhash);
+}
+
+
 static void logorg_addnewtooutstandq (logorg *currlogorg, outstand *temp)
 {
    outstand *run = NULL;
 
+   if (currlogorg->outstandqlen >= (2 * currlogorg->hashsize)) {
+      logorg_outstand_grow(currlogorg);
+   }
    temp->next = NULL;
-   run = currlogorg->hashoutstand[(temp->opid % HASH_OUTSTAND)];
+   run = currlogorg->hashoutstand[LOGORG_OPID_HASH(currlogorg, temp->opid)];
    if (run == NULL) {
-      currlogorg->hashoutstand[(temp->opid % HASH_OUTSTAND)] = temp;
+      currlogorg->hashoutstand[LOGORG_OPID_HASH(currlogorg, temp->opid)] = temp;
    } else {
       while (run->next != NULL)
          run = run->next;
       run->next = temp;
    }
+   logorg_link_buf(currlogorg, temp);
    currlogorg->outstandqlen++;
 }
 
 
 static void logorg_addtooutstandq (logorg *currlogorg, outstand *temp)
 {
-   temp->next = currlogorg->hashoutstand[(temp->opid % HASH_OUTSTAND)];
-   currlogorg->hashoutstand[(temp->opid % HASH_OUTSTAND)] = temp;
+   if (currlogorg->outstandqlen >= (2 * currlogorg->hashsize)) {
+      logorg_outstand_grow(currlogorg);
+   }
+   temp->next = currlogorg->hashoutstand[LOGORG_OPID_HASH(currlogorg, temp->opid)];
+   currlogorg->hashoutstand[LOGORG_OPID_HASH(currlogorg, temp->opid)] = temp;
+   logorg_link_buf(currlogorg, temp);
    currlogorg->outstandqlen++;
 }
 
 
 static outstand *logorg_show_buf_from_outstandq (logorg *currlogorg, void *buf, int opid)
 {
-   int i;
    outstand *tmp;
 
-   for(i=0; i<HASH_OUTSTAND; i++) {
-      tmp = currlogorg->hashoutstand[i];
-      while ((tmp) && ((tmp->buf != buf) || ((opid != -1) && (tmp->reqopid != opid)))) {
-         tmp = tmp->next;
-      }
-      if (tmp) {
-         return(tmp);
-      }
+   tmp = currlogorg->hashbuf[logorg_buf_hash(currlogorg, buf)];
+   while ((tmp) && ((tmp->buf != buf) || ((opid != -1) && (tmp->reqopid != opid)))) {
+      tmp = tmp->bufnext;
    }
-   return(NULL);
+   return(tmp);
 }
 
 
@@ -520,27 +625,30 @@ static outstand * logorg_getfromoutstandq (logorg *currlogorg, int requestno)
    int i;
 
    if (requestno == -1) {
-      for(i=0; i<HASH_OUTSTAND; i++) {
+      for(i=0; i<currlogorg->hashsize; i++) {
          if (currlogorg->hashoutstand[i] != NULL) {
             temp = currlogorg->hashoutstand[i];
             currlogorg->hashoutstand[i] = temp->next;
+            logorg_unlink_buf(currlogorg, temp);
             currlogorg->outstandqlen--;
             return(temp);
          }
       }
    }
 
-   temp = currlogorg->hashoutstand[(requestno % HASH_OUTSTAND)];
+   temp = currlogorg->hashoutstand[LOGORG_OPID_HASH(currlogorg, requestno)];
    if (temp == NULL)
       return(NULL);
    if (temp->opid == requestno) {
       currlogorg->outstandqlen--;
-      currlogorg->hashoutstand[(requestno % HASH_OUTSTAND)] = temp->next;
+      currlogorg->hashoutstand[LOGORG_OPID_HASH(currlogorg, requestno)] = temp->next;
+      logorg_unlink_buf(currlogorg, temp);
    } else {
       while (temp->next != NULL) {
          if (temp->next->opid == requestno) {
             hold = temp->next;
             temp->next = temp->next->next;
+            logorg_unlink_buf(currlogorg, hold);
             currlogorg->outstandqlen--;
             return(hold);
          }
@@ -548,160 +656,939 @@ static outstand * logorg_getfromoutstandq (logorg *currlogorg, int requestno)
       }
       temp = NULL;
    }
-   return(temp);
+   return(temp);
+}
+
+
+static void logorg_mapideal (logorg *currlogorg, ioreq_event *curr)
+{
+   curr->devno = currlogorg->idealno;
+   curr->blkno = -1;
+   currlogorg->idealno = (currlogorg->idealno + 1) % currlogorg->numdisks;
+   curr->next = curr;
+}
+
+
+static void logorg_maprandom (logorg *currlogorg, ioreq_event *curr)
+{
+   curr->devno = (int)((double)currlogorg->numdisks * disksim_rng_uniform(&currlogorg->rng));
+   curr->blkno = -1;
+   curr->next = curr;
+}
+
+
+static int logorg_mapinterleaved (logorg *currlogorg, ioreq_event *curr)
+{
+   int numdisks;
+   int blkno;
+   int i;
+   ioreq_event *temp;
+
+   numdisks = currlogorg->numdisks;
+   blkno = curr->blkno / numdisks;
+   curr->bcount += curr->blkno - (blkno * numdisks);
+   curr->bcount = (curr->bcount + numdisks - 1) / numdisks;
+   curr->blkno = blkno;
+   curr->devno = 0;
+   temp = curr;
+   for (i = 1; i < numdisks; i++) {
+      temp->next = ioreq_copy(curr);
+      temp->next->devno = i;
+      temp = temp->next;
+   }
+   temp->next = curr;
+   return(numdisks);
+}
+
+
+static int logorg_mapstriped (logorg *currlogorg, ioreq_event *curr)
+{
+   int numdisks;
+   int stripeunit;
+   int unitno;
+   int stripeno;
+   int reqsize;
+   int numstripes = 2;
+   int numreqs = 1;
+   int startslop;
+   int devno;
+   int startdevno;
+   ioreq_event *newreq;
+   ioreq_event *temp;
+   int blkno;
+   int i;
+   int last = FALSE;
+
+   numdisks = currlogorg->numdisks;
+   stripeunit = currlogorg->stripeunit;
+
+   temp = curr;
+   if (currlogorg->addrbyparts) {
+      curr->blkno = (curr->devno * currlogorg->blksperpart) + curr->blkno;
+   }
+   if (stripeunit == 0) {
+      return(logorg_mapinterleaved(currlogorg, curr));
+   }
+   unitno = curr->blkno / stripeunit;
+   stripeno = unitno / numdisks;
+   if (stripeno == currlogorg->numfull) {
+      last = TRUE;
+      stripeunit = currlogorg->blksperpart - (currlogorg->numfull * stripeunit);
+      unitno = stripeno * numdisks;
+      unitno += (curr->blkno - (unitno * currlogorg->stripeunit)) / stripeunit;
+      curr->blkno -= stripeno * numdisks * currlogorg->stripeunit;
+   }
+   devno = unitno % numdisks;
+   curr->devno = devno;
+   curr->blkno = curr->blkno % stripeunit;
+   startslop = stripeunit - curr->blkno;
+   curr->blkno += stripeno * currlogorg->stripeunit;
+   if (startslop < curr->bcount) {
+      blkno = stripeno * currlogorg->stripeunit;
+      for (i=0; i<numdisks; i++) {
+         currlogorg->sizes[i] = 0;
+      }
+      currlogorg->sizes[devno] = startslop;
+      reqsize = curr->bcount - startslop;
+/*
+fprintf (outputfile, "Have a multi-disk request - bcount %d, startslop %d, stripeno %d, numfull %d\n", curr->bcount, startslop, stripeno, currlogorg->numfull);
+*/
+      startdevno = devno;
+      devno++;
+      if (devno == numdisks) {
+	 devno = 0;
+	 stripeno++;
+	 if (stripeno == currlogorg->numfull) {
+	    stripeunit = currlogorg->blksperpart - (stripeno * stripeunit);
+	 }
+      }
+      while (reqsize > stripeunit) {
+	 currlogorg->sizes[devno] += stripeunit;
+	 numstripes++;
+	 devno++;
+	 reqsize -= stripeunit;
+	 if (devno == numdisks) {
+	    devno = 0;
+	    stripeno++;
+	    if (stripeno == currlogorg->numfull) {
+	       stripeunit = currlogorg->blksperpart - (stripeno * stripeunit);
+	    }
+	 }
+      }
+      currlogorg->sizes[devno] += reqsize;
+      curr->bcount = currlogorg->sizes[startdevno];
+      numreqs = min(numstripes, numdisks);
+      for (i = (startdevno + 1); i < (startdevno + numreqs); i++) {
+         newreq = (ioreq_event *) getfromextraq();
+	 newreq->devno = i % numdisks;
+         newreq->time = curr->time;
+         newreq->blkno = blkno + (wrap(startdevno, newreq->devno) * currlogorg->stripeunit);
+         newreq->busno = curr->busno & 0x0000FFFF;
+         newreq->bcount = currlogorg->sizes[(i % numdisks)];
+         newreq->flags = curr->flags;
+	 newreq->next = NULL;
+	 newreq->prev = NULL;
+	 newreq->type = curr->type;
+	 newreq->opid = curr->opid;
+	 newreq->buf = curr->buf;
+         temp->next = newreq;
+	 temp = newreq;
+      }
+   }
+   temp->next = curr;
+   return(numreqs);
+}
+
+
+/* Rebuild of a failed member.  Each step reads one rebuild unit from the
+ * survivors and writes it to the replacement (REBUILD_DEDICATED, one step
+ * at a time) or to its distributed spare location (REBUILD_DISTRIBUTED,
+ * one step per survivor in flight).  The steps are background I/Os issued
+ * through the device driver like the deferred requests of a host
+ * operation, and "Rebuild rate" caps how fast new steps may start.
+ */
+
+static void logorg_rebuild_step (logorg *currlogorg)
+{
+   outstand *req;
+   ioreq_event *read;
+   ioreq_event *write;
+   depends *deplist = NULL;
+   int width = logorg_degraded_width(currlogorg);
+   int blkno = currlogorg->rebuildpos;
+   int bcount;
+   int slot;
+   int devno;
+   int i;
+
+   bcount = currlogorg->rebuildunit - (blkno % currlogorg->rebuildunit);
+   if (bcount > (currlogorg->rebuildend - blkno)) {
+      bcount = currlogorg->rebuildend - blkno;
+   }
+   currlogorg->rebuildpos += bcount;
+   for (slot = 0; currlogorg->rebuildstart[slot] >= 0; slot++) ;
+   currlogorg->rebuildstart[slot] = blkno;
+   currlogorg->rebuildsout++;
+   if (currlogorg->rebuildrate > 0.0) {
+      if (currlogorg->rebuildnext < simtime) {
+         currlogorg->rebuildnext = simtime;
+      }
+      currlogorg->rebuildnext += (double) bcount / currlogorg->rebuildrate;
+   }
+
+   write = (ioreq_event *) getfromextraq();
+   memset(write, 0, sizeof(ioreq_event));
+   write->devno = currlogorg->faileddev;
+   write->blkno = blkno;
+   write->bcount = bcount;
+   write->flags = WRITE | BACKGROUND;
+   write->batchno = -1;
+   if (currlogorg->rebuildmode == REBUILD_DISTRIBUTED) {
+      logorg_spare_location(currlogorg, write);
+   }
+
+   req = (outstand *) getfromextraq();
+   req->arrtime = simtime;
+   req->type = LOGORG_REBUILD_OP;
+   req->bcount = bcount;
+   req->blkno = blkno;
+   req->devno = currlogorg->faileddev;
+   req->flags = READ | BACKGROUND;
+   req->busno = 0;
+   req->buf = NULL;
+   req->opid = currlogorg->opid;
+   req->reqopid = slot;
+   req->numreqs = width + 1;
+
+   for (i = 0; i < width; i++) {
+      devno = logorg_survivor(currlogorg, i);
+      read = (ioreq_event *) getfromextraq();
+      memset(read, 0, sizeof(ioreq_event));
+      read->devno = devno;
+      read->blkno = blkno;
+      read->bcount = bcount;
+      logorg_add_dependency(&deplist, read, &write, 1);
+      read->devno = currlogorg->devs[devno].devno;
+      read->blkno += currlogorg->devs[devno].startblkno;
+      read->flags = READ | BACKGROUND | MAPPED;
+      read->batchno = -1;
+      read->type = IO_REQUEST_ARRIVE;
+      read->time = simtime;
+      read->opid = req->opid;
+      currlogorg->devs[devno].numout++;
+      addtointq((event *) read);
+   }
+   req->depend = deplist;
+   logorg_addnewtooutstandq(currlogorg, req);
+   currlogorg->opid++;
+}
+
+
+static void logorg_rebuild_issue (logorg *currlogorg)
+{
+   timer_event *timer;
+   int maxout = 1;
+
+   if (currlogorg->rebuildmode == REBUILD_DISTRIBUTED) {
+      maxout = currlogorg->actualnumdisks - 1;
+   }
+   while ((currlogorg->rebuildsout < maxout) && (currlogorg->rebuildpos < currlogorg->rebuildend)) {
+      if (simtime < currlogorg->rebuildnext) {
+         if (!currlogorg->rebuildwaiting) {
+            timer = (timer_event *) getfromextraq();
+            timer->type = TIMER_EXPIRED;
+            timer->func = &disksim->timerfunc_logorg;
+            timer->time = currlogorg->rebuildnext;
+            timer->val = LOGORG_TIMER_REBUILD;
+            timer->ptr = currlogorg;
+            addtointq((event *) timer);
+            currlogorg->rebuildwaiting = TRUE;
+         }
+         return;
+      }
+      logorg_rebuild_step(currlogorg);
+   }
+}
+
+
+/* Fires at the failure time (LOGORG_TIMER_FAILURE) and when the rebuild
+   rate allows the next step to start (LOGORG_TIMER_REBUILD) */
+
+static void logorg_rebuild_timer (timer_event *timer)
+{
+   logorg *currlogorg = (logorg *) timer->ptr;
+
+   if (timer->val == LOGORG_TIMER_FAILURE) {
+      currlogorg->faileddev = currlogorg->failmember;
+      currlogorg->failstate = 1;
+      currlogorg->rebuildpos = 0;
+      currlogorg->rebuilt = 0;
+      currlogorg->rebuildend = currlogorg->actualblksperpart;
+      currlogorg->rebuildnext = simtime;
+   } else {
+      currlogorg->rebuildwaiting = FALSE;
+   }
+   addtoextraq((event *) timer);
+   logorg_rebuild_issue(currlogorg);
+}
+
+
+static void logorg_rebuild_complete (logorg *currlogorg, outstand *req)
+{
+   int i;
+
+   currlogorg->rebuildstart[req->reqopid] = -1;
+   currlogorg->rebuildsout--;
+   addtoextraq((event *) req);
+   currlogorg->rebuilt = currlogorg->rebuildpos;
+   for (i = 0; i < currlogorg->actualnumdisks; i++) {
+      if ((currlogorg->rebuildstart[i] >= 0) && (currlogorg->rebuildstart[i] < currlogorg->rebuilt)) {
+         currlogorg->rebuilt = currlogorg->rebuildstart[i];
+      }
+   }
+   if ((currlogorg->rebuildsout == 0) && (currlogorg->rebuildpos >= currlogorg->rebuildend)) {
+      currlogorg->rebuilddone = simtime;
+      currlogorg->failstate = 2;
+      if (currlogorg->rebuildmode == REBUILD_DEDICATED) {
+         currlogorg->faileddev = -1;
+      }
+      return;
+   }
+   logorg_rebuild_issue(currlogorg);
+}
+
+
+static void logorg_rebuild_initialize (logorg *currlogorg)
+{
+   timer_event *timer;
+   int reduntype = currlogorg->reduntype;
+   int rows;
+   int i;
+
+   currlogorg->faileddev = -1;
+   currlogorg->failstate = 0;
+   currlogorg->spareblkno = 0;
+   currlogorg->spareblks = 0;
+   if (currlogorg->failtime < 0.0) {
+      return;
+   }
+   if ((reduntype != PARITY_DISK) && (reduntype != PARITY_ROTATED) &&
+       (reduntype != PARITY_TABLE) && (reduntype != PARITY_DUAL) &&
+       (reduntype != ERASURE_CODED)) {
+      fprintf(stderr, "*** error: device failure is only supported for parity-based logorgs\n");
+      exit(1);
+   }
+   if ((currlogorg->failmember < 0) || (currlogorg->failmember >= currlogorg->actualnumdisks)) {
+      fprintf(stderr, "*** error: failed device %d is not a member of logorg %s\n", currlogorg->failmember, currlogorg->name);
+      exit(1);
+   }
+   if (currlogorg->rebuildunit <= 0) {
+      currlogorg->rebuildunit = (currlogorg->stripeunit > 0) ? currlogorg->stripeunit : currlogorg->parityunit;
+   }
+   if (currlogorg->rebuildmode == REBUILD_DISTRIBUTED) {
+      rows = currlogorg->actualblksperpart / currlogorg->rebuildunit / currlogorg->actualnumdisks;
+      currlogorg->spareblkno = rows * (currlogorg->actualnumdisks - 1) * currlogorg->rebuildunit;
+      currlogorg->spareblks = rows * currlogorg->rebuildunit;
+      currlogorg->actualblksperpart = currlogorg->spareblkno;
+      currlogorg->blksperpart = currlogorg->spareblkno;
+   }
+   if (currlogorg->rebuildstart == NULL) {
+      currlogorg->rebuildstart = DISKSIM_malloc(currlogorg->actualnumdisks * sizeof(int));
+   }
+   for (i = 0; i < currlogorg->actualnumdisks; i++) {
+      currlogorg->rebuildstart[i] = -1;
+   }
+   currlogorg->rebuildsout = 0;
+   currlogorg->rebuildwaiting = FALSE;
+   currlogorg->rebuilddone = -1.0;
+
+   timer = (timer_event *) getfromextraq();
+   timer->type = TIMER_EXPIRED;
+   timer->func = &disksim->timerfunc_logorg;
+   timer->time = currlogorg->failtime;
+   timer->val = LOGORG_TIMER_FAILURE;
+   timer->ptr = currlogorg;
+   addtointq((event *) timer);
+}
+
+
+/* Maps a request that has been assigned to currlogorg onto its devices.
+   The resulting device requests are left in a circular list from curr,
+   and their number is returned.  arrival is FALSE when the host request
+   behind req has already been counted (a gathered or split write). */
+
+static int logorg_mapissue (logorg *currlogorg, ioreq_event *curr, outstand *req, int arrival)
+{
+   int numreqs = 1;
+   int maptype;
+   int reduntype;
+   int i;
+   ioreq_event *temp;
+   int orgdevno;
+
+   maptype = currlogorg->maptype;
+   reduntype = currlogorg->reduntype;
+
+   curr->opid = currlogorg->opid;
+   req->opid = currlogorg->opid;
+   curr->next = NULL;
+   curr->prev = NULL;
+
+   if (maptype == ASIS) {
+      curr->next = curr;
+   } 
+   else if (maptype == IDEAL) {
+      logorg_mapideal(currlogorg, curr);
+   } 
+   else if (maptype == RANDOM) {
+      logorg_maprandom(currlogorg, curr);
+   } 
+   else if (maptype == STRIPED) {
+      numreqs = logorg_mapstriped(currlogorg, curr);
+   } else {
+      fprintf(stderr, "Unknown maptype in use at logorg_mapissue - %d\n", maptype);
+      exit(1);
+   }
+
+   if (reduntype == NO_REDUN) {
+   } 
+   else if (reduntype == SHADOWED) {
+      numreqs = logorg_shadowed(currlogorg, curr, numreqs);
+   } 
+   else if (reduntype == PARITY_DISK) {
+      numreqs = logorg_parity_disk(currlogorg, curr, numreqs);
+   } 
+   else if (reduntype == PARITY_ROTATED) {
+      numreqs = logorg_parity_rotate(currlogorg, curr, numreqs);
+   } 
+   else if (reduntype == PARITY_TABLE) {
+      numreqs = logorg_parity_table(currlogorg, curr, numreqs);
+   } 
+   else if ((reduntype == PARITY_DUAL) || (reduntype == ERASURE_CODED)) {
+      numreqs = logorg_erasure_coded(currlogorg, curr, numreqs);
+   } 
+   else {
+      fprintf(stderr, "Unknown reduntype in use at logorg_mapissue - %d\n", reduntype);
+      exit(1);
+   }
+   if (currlogorg->faileddev >= 0) {
+      numreqs = logorg_degraded(currlogorg, curr, numreqs);
+   }
+/*
+fprintf (outputfile, "back from logorging: numreqs %d\n", numreqs);
+*/
+   orgdevno = curr->devno;
+   req->depend = (depends *) curr->prev;
+   curr->blkno += currlogorg->devs[orgdevno].startblkno;
+   curr->devno = currlogorg->devs[orgdevno].devno;
+   temp = curr->next;
+   i = 1;
+   while (temp != curr) {
+      temp->blkno += currlogorg->devs[(temp->devno)].startblkno;
+      temp->devno = currlogorg->devs[(temp->devno)].devno;
+      temp->opid = curr->opid;
+      temp = temp->next;
+      i++;
+   }
+   req->numreqs = numreqs;
+   logorg_addnewtooutstandq(currlogorg, req);
+   currlogorg->opid++;
+   if (arrival) {
+      logorg_maprequest_update_stats(currlogorg, curr, req, i);
+   } else {
+      logorg_update_devout_stats(currlogorg, curr, i);
+   }
+/*
+fprintf (outputfile, "Leaving logorg_mapissue: cnt %d, devno %d, blkno %d, opid %d\n", i, curr->devno, curr->blkno, curr->opid);
+*/
+   return(i);
+}
+
+
+
+
+/* Write gathering.  A write to part of one stripe of a striped parity
+   organization is held for up to gatherwindow, in case writes to the
+   rest of the stripe follow.  As soon as the held writes cover the whole
+   stripe they go out as one full-stripe write, which needs no pre-reads.
+   Held writes whose window expires first are issued as they arrived.  A
+   write that spans stripes is split at the stripe boundaries, and each
+   piece is gathered (or issued) on its own; the host request completes
+   with its last piece. */
+
+static int logorg_gather_lblk (logorg *currlogorg, ioreq_event *curr)
+{
+   if (currlogorg->addrbyparts) {
+      return(curr->devno * currlogorg->blksperpart + curr->blkno);
+   }
+   return(curr->blkno);
+}
+
+
+static void logorg_gather_setlblk (logorg *currlogorg, ioreq_event *curr, int lblk)
+{
+   if (currlogorg->addrbyparts) {
+      curr->devno = lblk / currlogorg->blksperpart;
+      curr->blkno = lblk % currlogorg->blksperpart;
+   } else {
+      curr->blkno = lblk;
+   }
+}
+
+
+/* Device I/Os needed to write units stripe units of one stripe on their
+   own, following the organization's RMW vs. reconstruct choice */
+
+static int logorg_gather_cost (logorg *currlogorg, int units)
+{
+   int checkunits = (currlogorg->reduntype == PARITY_TABLE) ? 1 : currlogorg->paritydisks;
+
+   if (units >= currlogorg->partsperstripe) {
+      return(units + checkunits);
+   } else if (units < currlogorg->rmwpoint) {
+      return(2 * (units + checkunits));
+   }
+   return(currlogorg->partsperstripe + checkunits);
+}
+
+
+static int logorg_gather_covered (logorg *currlogorg, gather *gath)
+{
+   ioreq_event *tmp;
+   int width = currlogorg->stripeunit * currlogorg->partsperstripe;
+   int end = gath->stripeno * width;
+   int covered = 0;
+   int lblk;
+
+   for (tmp = gath->reqs; tmp; tmp = tmp->next) {
+      lblk = logorg_gather_lblk(currlogorg, tmp);
+      if ((lblk + tmp->bcount) > end) {
+         covered += lblk + tmp->bcount - max(lblk, end);
+         end = lblk + tmp->bcount;
+      }
+   }
+   return(covered);
+}
+
+
+/* Can a write of [lblk, lblk + bcount), which lies within one stripe, be
+   held? */
+
+static int logorg_gather_holdable (logorg *currlogorg, int lblk, int bcount)
+{
+   int width = currlogorg->stripeunit * currlogorg->partsperstripe;
+   int stripeno = lblk / width;
+   gather *gath;
+
+   if ((stripeno >= currlogorg->gatherlimit) || (bcount >= width)) {
+      return(FALSE);
+   }
+   if ((currlogorg->addrbyparts) &&
+       (((stripeno * width) / currlogorg->blksperpart) != (((stripeno + 1) * width - 1) / currlogorg->blksperpart))) {
+      return(FALSE);
+   }
+   if (currlogorg->gathercount < currlogorg->gatherstripes) {
+      return(TRUE);
+   }
+   for (gath = currlogorg->gatherlist; gath; gath = gath->next) {
+      if (gath->stripeno == stripeno) {
+         return(TRUE);
+      }
+   }
+   return(FALSE);
+}
+
+
+static gather * logorg_gather_entry (logorg *currlogorg, int stripeno)
+{
+   gather **run = &currlogorg->gatherlist;
+   gather *gath;
+   timer_event *timer;
+
+   while ((*run) && ((*run)->stripeno != stripeno)) {
+      run = &(*run)->next;
+   }
+   if (*run) {
+      return(*run);
+   }
+   gath = (gather *) getfromextraq();
+   gath->stripeno = stripeno;
+   gath->deadline = simtime + currlogorg->gatherwindow;
+   gath->reqs = NULL;
+   gath->next = NULL;
+   *run = gath;
+   currlogorg->gathercount++;
+
+   timer = (timer_event *) getfromextraq();
+   timer->type = TIMER_EXPIRED;
+   timer->func = &disksim->timerfunc_logorg;
+   timer->time = gath->deadline;
+   timer->val = LOGORG_TIMER_GATHER;
+   timer->ptr = currlogorg;
+   addtointq((event *) timer);
+   return(gath);
+}
+
+
+static void logorg_gather_remove (logorg *currlogorg, gather *gath)
+{
+   gather **run = &currlogorg->gatherlist;
+
+   while (*run != gath) {
+      run = &(*run)->next;
+   }
+   *run = gath->next;
+   currlogorg->gathercount--;
+   addtoextraq((event *) gath);
+}
+
+
+/* Turns curr, the write that completed gath's stripe, into the
+   full-stripe write and *reqp into its LOGORG_GATHER_OP */
+
+static void logorg_gather_stripe (logorg *currlogorg, gather *gath, ioreq_event *curr, outstand **reqp)
+{
+   int stripeunit = currlogorg->stripeunit;
+   int width = stripeunit * currlogorg->partsperstripe;
+   int start = gath->stripeno * width;
+   ioreq_event *tmp;
+   outstand *req;
+   int lblk;
+   int saved = 0;
+
+   req = (outstand *) getfromextraq();
+   req->arrtime = simtime;
+   for (tmp = gath->reqs; tmp; tmp = tmp->next) {
+      lblk = logorg_gather_lblk(currlogorg, tmp) - start;
+      saved += logorg_gather_cost(currlogorg, ((lblk + tmp->bcount - 1) / stripeunit - lblk / stripeunit + 1));
+      req->arrtime = min(req->arrtime, ((outstand *) tmp->prev)->arrtime);
+   }
+   saved -= logorg_gather_cost(currlogorg, currlogorg->partsperstripe);
+   currlogorg->stat.gathersaved += (double) saved;
+   currlogorg->stat.gatherfull++;
+
+   logorg_gather_setlblk(currlogorg, curr, start);
+   curr->bcount = width;
+   req->bcount = curr->bcount;
+   req->blkno = curr->blkno;
+   req->devno = curr->devno;
+   req->flags = curr->flags;
+   req->busno = curr->busno;
+   req->buf = NULL;
+   req->reqopid = curr->opid;
+   req->type = LOGORG_GATHER_OP;
+   req->depend = NULL;
+   req->gathered = gath->reqs;
+   req->parent = NULL;
+   *reqp = req;
+}
+
+
+/* Holds curr, a write within one stripe, along with its outstand *reqp.
+   Returns FALSE if that completes the stripe, in which case curr has
+   become the full-stripe write and *reqp its LOGORG_GATHER_OP. */
+
+static int logorg_gather_hold (logorg *currlogorg, ioreq_event *curr, outstand **reqp)
+{
+   int width = currlogorg->stripeunit * currlogorg->partsperstripe;
+   int lblk = logorg_gather_lblk(currlogorg, curr);
+   gather *gath = logorg_gather_entry(currlogorg, (lblk / width));
+   ioreq_event **pos;
+
+   pos = &gath->reqs;
+   while ((*pos) && (logorg_gather_lblk(currlogorg, *pos) <= lblk)) {
+      pos = &(*pos)->next;
+   }
+   curr->next = *pos;
+   curr->prev = (ioreq_event *) *reqp;
+   *pos = curr;
+   currlogorg->stat.gatheredwrites++;
+   if (logorg_gather_covered(currlogorg, gath) < width) {
+      return(TRUE);
+   }
+
+   /* a copy of curr stays with the held writes */
+   *pos = ioreq_copy(curr);
+   logorg_gather_stripe(currlogorg, gath, curr, reqp);
+   logorg_gather_remove(currlogorg, gath);
+   return(FALSE);
+}
+
+
+/* Maps curr from outside the host request path.  Its requests are
+   already tracked (through their host request), so they enter the
+   driver as background I/O. */
+
+static void logorg_gather_inject (logorg *currlogorg, ioreq_event *curr, outstand *req)
+{
+   ioreq_event *temp = curr;
+   ioreq_event *next;
+   int numreqs;
+   int i;
+
+   numreqs = logorg_mapissue(currlogorg, curr, req, FALSE);
+   for (i = 0; i < numreqs; i++) {
+      next = temp->next;
+      temp->next = NULL;
+      temp->type = IO_REQUEST_ARRIVE;
+      temp->flags |= MAPPED | BACKGROUND;
+      temp->time = simtime;
+      addtointq((event *) temp);
+      temp = next;
+   }
+}
+
+
+/* Counts the arrival of a host write that is about to be held or split,
+   since its device requests will not be issued with it.  The per-device
+   statistics are charged to the first data unit it writes, just as an
+   ungathered write charges them to its first device request. */
+
+static void logorg_gather_arrival (logorg *currlogorg, ioreq_event *curr, outstand *req)
+{
+   int devno = curr->devno;
+   int blkno = curr->blkno;
+   int bcount = curr->bcount;
+   int lblk = logorg_gather_lblk(currlogorg, curr);
+   int stripeunit = currlogorg->stripeunit;
+   int dev;
+
+   logorg_data_location(currlogorg, lblk, &dev, &curr->blkno);
+   curr->blkno += currlogorg->devs[dev].startblkno;
+   curr->devno = currlogorg->devs[dev].devno;
+   curr->bcount = min(bcount, (stripeunit - (lblk % stripeunit)));
+   logorg_update_arrival_stats(currlogorg, curr, req);
+   curr->devno = devno;
+   curr->blkno = blkno;
+   curr->bcount = bcount;
+}
+
+
+/* Returns TRUE if curr is held, or split with every piece held (curr
+   itself is then freed).  Otherwise curr (possibly turned into a
+   full-stripe write or one piece of a split write, with *reqp replaced
+   to match) is to be issued. */
+
+static int logorg_gather_write (logorg *currlogorg, ioreq_event *curr, outstand **reqp)
+{
+   int width = currlogorg->stripeunit * currlogorg->partsperstripe;
+   int lblk;
+   int end;
+   int start;
+   int stop;
+   int split = FALSE;
+   outstand *parent;
+   outstand *req;
+   ioreq_event *piece;
+   ioreq_event *issue = NULL;
+   outstand *issuereq = NULL;
+
+   /* nobody waits on time-critical writes being delayed */
+   if (curr->flags & (READ | TIME_CRITICAL)) {
+      return(FALSE);
+   }
+   lblk = logorg_gather_lblk(currlogorg, curr);
+   end = lblk + curr->bcount;
+   if ((lblk / width) == ((end - 1) / width)) {
+      if (!logorg_gather_holdable(currlogorg, lblk, curr->bcount)) {
+         return(FALSE);
+      }
+      logorg_gather_arrival(currlogorg, curr, *reqp);
+      return(logorg_gather_hold(currlogorg, curr, reqp));
+   }
+
+   /* split at stripe boundaries only if some piece can be held */
+   for (start = lblk; start < end; start = stop) {
+      stop = min(end, ((start / width + 1) * width));
+      split |= logorg_gather_holdable(currlogorg, start, (stop - start));
+   }
+   if (!split) {
+      return(FALSE);
+   }
+   logorg_gather_arrival(currlogorg, curr, *reqp);
+   parent = *reqp;
+   parent->numreqs = 0;
+   for (start = lblk; start < end; start = stop) {
+      stop = min(end, ((start / width + 1) * width));
+      piece = ioreq_copy(curr);
+      logorg_gather_setlblk(currlogorg, piece, start);
+      piece->bcount = stop - start;
+      req = (outstand *) getfromextraq();
+      req->arrtime = simtime;
+      req->bcount = piece->bcount;
+      req->blkno = piece->blkno;
+      req->devno = piece->devno;
+      req->flags = parent->flags;
+      req->busno = parent->busno;
+      req->buf = parent->buf;
+      req->reqopid = parent->reqopid;
+      req->type = LOGORG_HOST_OP;
+      req->depend = NULL;
+      req->gathered = NULL;
+      req->parent = parent;
+      parent->numreqs++;
+      if ((logorg_gather_holdable(currlogorg, start, (stop - start))) &&
+          (logorg_gather_hold(currlogorg, piece, &req))) {
+         continue;
+      }
+      if (issue == NULL) {
+         issue = piece;
+         issuereq = req;
+      } else {
+         logorg_gather_inject(currlogorg, piece, req);
+      }
+   }
+   if (issue == NULL) {
+      /* only copies of curr are held */
+      addtoextraq((event *) curr);
+      return(TRUE);
+   }
+   memmove((char *) curr, (char *) issue, sizeof(ioreq_event));
+   addtoextraq((event *) issue);
+   *reqp = issuereq;
+   return(FALSE);
+}
+
+
+/* Issues the writes held for gath's stripe as they arrived */
+
+static void logorg_gather_release (logorg *currlogorg, gather *gath)
+{
+   ioreq_event *held;
+
+   currlogorg->stat.gatherpartial++;
+   while (gath->reqs) {
+      held = gath->reqs;
+      gath->reqs = held->next;
+      logorg_gather_inject(currlogorg, held, (outstand *) held->prev);
+   }
+   logorg_gather_remove(currlogorg, gath);
+}
+
+
+/* Issues the writes of every stripe whose window has expired */
+
+static void logorg_gather_flush (logorg *currlogorg)
+{
+   while ((currlogorg->gatherlist) && (currlogorg->gatherlist->deadline <= simtime)) {
+      logorg_gather_release(currlogorg, currlogorg->gatherlist);
+   }
 }
 
 
-static void logorg_mapideal (logorg *currlogorg, ioreq_event *curr)
+/* A held write whose priority is raised (see logorg_raise_priority)
+   becomes time-critical, and its stripe is released right away rather
+   than at the end of the window. */
+
+static void logorg_gather_raise (logorg *currlogorg, void *buf, int opid)
 {
-   curr->devno = currlogorg->idealno;
-   curr->blkno = -1;
-   currlogorg->idealno = (currlogorg->idealno + 1) % currlogorg->numdisks;
-   curr->next = curr;
+   gather *gath;
+   gather *next;
+   ioreq_event *held;
+   outstand *member;
+   int found;
+
+   for (gath = currlogorg->gatherlist; gath; gath = next) {
+      next = gath->next;
+      found = FALSE;
+      for (held = gath->reqs; held; held = held->next) {
+         member = (outstand *) held->prev;
+         if ((member->buf == buf) && ((opid == -1) || (member->reqopid == opid))) {
+            held->flags |= TIME_CRITICAL;
+            found = TRUE;
+         }
+      }
+      if (found) {
+         logorg_gather_release(currlogorg, gath);
+      }
+   }
 }
 
 
-static void logorg_maprandom (logorg *currlogorg, ioreq_event *curr)
+/* Releases the writes merged into the full-stripe write req.  Those that
+   finish a host request are handed back chained from curr. */
+
+static int logorg_gather_complete (logorg *currlogorg, ioreq_event *curr, outstand *req)
 {
-   curr->devno = (int)((double)currlogorg->numdisks * DISKSIM_drand48());
-   curr->blkno = -1;
-   curr->next = curr;
+   ioreq_event *held;
+   ioreq_event *next;
+   ioreq_event *tail = NULL;
+   outstand *member;
+   outstand *parent;
+
+   for (held = req->gathered; held; held = next) {
+      next = held->next;
+      member = (outstand *) held->prev;
+      if (member->parent) {
+         parent = member->parent;
+         addtoextraq((event *) member);
+         if (--parent->numreqs) {
+            addtoextraq((event *) held);
+            continue;
+         }
+         member = parent;
+      }
+      logorg_mapcomplete_update_stats(currlogorg, curr, member);
+      if (tail == NULL) {
+         addtoextraq((event *) held);
+         held = curr;
+      } else {
+         tail->next = held;
+      }
+      held->bcount = member->bcount;
+      held->blkno = member->blkno;
+      held->flags = member->flags;
+      held->busno = member->busno;
+      held->devno = member->devno;
+      held->opid = member->reqopid;
+      held->buf = member->buf;
+      held->next = NULL;
+      held->prev = NULL;
+      tail = held;
+      addtoextraq((event *) member);
+   }
+   addtoextraq((event *) req);
+   return((tail) ? COMPLETE : NOT_COMPLETE);
 }
 
 
-static int logorg_mapinterleaved (logorg *currlogorg, ioreq_event *curr)
+static void logorg_timer (timer_event *timer)
 {
-   int numdisks;
-   int blkno;
-   int i;
-   ioreq_event *temp;
+   if (timer->val == LOGORG_TIMER_GATHER) {
+      logorg *currlogorg = (logorg *) timer->ptr;
 
-   numdisks = currlogorg->numdisks;
-   blkno = curr->blkno / numdisks;
-   curr->bcount += curr->blkno - (blkno * numdisks);
-   curr->bcount = (curr->bcount + numdisks - 1) / numdisks;
-   curr->blkno = blkno;
-   curr->devno = 0;
-   temp = curr;
-   for (i = 1; i < numdisks; i++) {
-      temp->next = ioreq_copy(curr);
-      temp->next->devno = i;
-      temp = temp->next;
+      addtoextraq((event *) timer);
+      logorg_gather_flush(currlogorg);
+   } else {
+      logorg_rebuild_timer(timer);
    }
-   temp->next = curr;
-   return(numdisks);
 }
 
 
-static int logorg_mapstriped (logorg *currlogorg, ioreq_event *curr)
+static void logorg_gather_initialize (logorg *currlogorg)
 {
-   int numdisks;
-   int stripeunit;
-   int unitno;
-   int stripeno;
-   int reqsize;
-   int numstripes = 2;
-   int numreqs = 1;
-   int startslop;
-   int devno;
-   int startdevno;
-   ioreq_event *newreq;
-   ioreq_event *temp;
-   int blkno;
-   int i;
-   int last = FALSE;
-
-   numdisks = currlogorg->numdisks;
-   stripeunit = currlogorg->stripeunit;
+   int reduntype = currlogorg->reduntype;
 
-   temp = curr;
-   if (currlogorg->addrbyparts) {
-      curr->blkno = (curr->devno * currlogorg->blksperpart) + curr->blkno;
-   }
-   if (stripeunit == 0) {
-      return(logorg_mapinterleaved(currlogorg, curr));
-   }
-   unitno = curr->blkno / stripeunit;
-   stripeno = unitno / numdisks;
-   if (stripeno == currlogorg->numfull) {
-      last = TRUE;
-      stripeunit = currlogorg->blksperpart - (currlogorg->numfull * stripeunit);
-      unitno = stripeno * numdisks;
-      unitno += (curr->blkno - (unitno * currlogorg->stripeunit)) / stripeunit;
-      curr->blkno -= stripeno * numdisks * currlogorg->stripeunit;
+   currlogorg->gatherlist = NULL;
+   currlogorg->gathercount = 0;
+   currlogorg->gatherlimit = 0;
+   if (currlogorg->gatherwindow <= 0.0) {
+      return;
    }
-   devno = unitno % numdisks;
-   curr->devno = devno;
-   curr->blkno = curr->blkno % stripeunit;
-   startslop = stripeunit - curr->blkno;
-   curr->blkno += stripeno * currlogorg->stripeunit;
-   if (startslop < curr->bcount) {
-      blkno = stripeno * currlogorg->stripeunit;
-      for (i=0; i<numdisks; i++) {
-         currlogorg->sizes[i] = 0;
-      }
-      currlogorg->sizes[devno] = startslop;
-      reqsize = curr->bcount - startslop;
-/*
-fprintf (outputfile, "Have a multi-disk request - bcount %d, startslop %d, stripeno %d, numfull %d\n", curr->bcount, startslop, stripeno, currlogorg->numfull);
-*/
-      startdevno = devno;
-      devno++;
-      if (devno == numdisks) {
-	 devno = 0;
-	 stripeno++;
-	 if (stripeno == currlogorg->numfull) {
-	    stripeunit = currlogorg->blksperpart - (stripeno * stripeunit);
-	 }
-      }
-      while (reqsize > stripeunit) {
-	 currlogorg->sizes[devno] += stripeunit;
-	 numstripes++;
-	 devno++;
-	 reqsize -= stripeunit;
-	 if (devno == numdisks) {
-	    devno = 0;
-	    stripeno++;
-	    if (stripeno == currlogorg->numfull) {
-	       stripeunit = currlogorg->blksperpart - (stripeno * stripeunit);
-	    }
-	 }
-      }
-      currlogorg->sizes[devno] += reqsize;
-      curr->bcount = currlogorg->sizes[startdevno];
-      numreqs = min(numstripes, numdisks);
-      for (i = (startdevno + 1); i < (startdevno + numreqs); i++) {
-         newreq = (ioreq_event *) getfromextraq();
-	 newreq->devno = i % numdisks;
-         newreq->time = curr->time;
-         newreq->blkno = blkno + (wrap(startdevno, newreq->devno) * currlogorg->stripeunit);
-         newreq->busno = curr->busno & 0x0000FFFF;
-         newreq->bcount = currlogorg->sizes[(i % numdisks)];
-         newreq->flags = curr->flags;
-	 newreq->next = NULL;
-	 newreq->prev = NULL;
-	 newreq->type = curr->type;
-	 newreq->opid = curr->opid;
-	 newreq->buf = curr->buf;
-         temp->next = newreq;
-	 temp = newreq;
-      }
+   if ((reduntype != PARITY_TABLE) && (reduntype != PARITY_DUAL) &&
+       (reduntype != ERASURE_CODED)) {
+      fprintf(stderr, "*** error: write gathering requires a striped parity-based logorg\n");
+      exit(1);
    }
-   temp->next = curr;
-   return(numreqs);
+   currlogorg->gatherlimit = (currlogorg->blksperpart * currlogorg->numdisks) / (currlogorg->stripeunit * currlogorg->partsperstripe) - 1;
 }
 
-
 int logorg_maprequest (logorg **logorgs, int numlogorgs, ioreq_event *curr)
 {
-   int numreqs = 1;
-   int maptype;
-   int reduntype;
    int logorgno = -1;
    int i, j;
    outstand *req = NULL;
-   ioreq_event *temp;
-   int orgdevno;
+   outstand *host;
 /*
 fprintf (outputfile, "Entered logorg_maprequest - numlogorgs %d, devno %d, blkno %d, time %f\n", numlogorgs, curr->devno, curr->blkno, simtime);
 fprintf (outputfile, "flags %x, opid %d\n", curr->flags, curr->opid);
@@ -724,7 +1611,10 @@ fprintf (outputfile, "flags %x, opid %d\n", curr->flags, curr->opid);
    req->busno = curr->busno;
    req->buf = curr->buf;
    req->reqopid = curr->opid;
+   req->type = LOGORG_HOST_OP;
    req->depend = NULL;
+   req->gathered = NULL;
+   req->parent = NULL;
 
    for (i = 0; i < numlogorgs; i++) {
      // i.e. array
@@ -761,72 +1651,12 @@ fprintf (outputfile, "flags %x, opid %d\n", curr->flags, curr->opid);
       fprintf (stderr, "unexpected request location: devno %x, blkno %d, bcount %d\n", curr->devno, curr->blkno, curr->bcount);
    }
    ASSERT(logorgno != -1);
-   maptype = logorgs[logorgno]->maptype;
-   reduntype = logorgs[logorgno]->reduntype;
-
-   curr->opid = logorgs[logorgno]->opid;
-   req->opid = logorgs[logorgno]->opid;
-   curr->next = NULL;
-   curr->prev = NULL;
-
-   if (maptype == ASIS) {
-      curr->next = curr;
-   } 
-   else if (maptype == IDEAL) {
-      logorg_mapideal(logorgs[logorgno], curr);
-   } 
-   else if (maptype == RANDOM) {
-      logorg_maprandom(logorgs[logorgno], curr);
-   } 
-   else if (maptype == STRIPED) {
-      numreqs = logorg_mapstriped(logorgs[logorgno], curr);
-   } else {
-      fprintf(stderr, "Unknown maptype in use at logorg_maprequest - %d\n", maptype);
-      exit(1);
-   }
-
-   if (reduntype == NO_REDUN) {
-   } 
-   else if (reduntype == SHADOWED) {
-      numreqs = logorg_shadowed(logorgs[logorgno], curr, numreqs);
-   } 
-   else if (reduntype == PARITY_DISK) {
-      numreqs = logorg_parity_disk(logorgs[logorgno], curr, numreqs);
-   } 
-   else if (reduntype == PARITY_ROTATED) {
-      numreqs = logorg_parity_rotate(logorgs[logorgno], curr, numreqs);
-   } 
-   else if (reduntype == PARITY_TABLE) {
-      numreqs = logorg_parity_table(logorgs[logorgno], curr, numreqs);
-   } 
-   else {
-      fprintf(stderr, "Unknown reduntype in use at logorg_maprequest - %d\n", reduntype);
-      exit(1);
-   }
-/*
-fprintf (outputfile, "back from logorging: numreqs %d\n", numreqs);
-*/
-   orgdevno = curr->devno;
-   req->depend = (depends *) curr->prev;
-   curr->blkno += logorgs[logorgno]->devs[orgdevno].startblkno;
-   curr->devno = logorgs[logorgno]->devs[orgdevno].devno;
-   temp = curr->next;
-   i = 1;
-   while (temp != curr) {
-      temp->blkno += logorgs[logorgno]->devs[(temp->devno)].startblkno;
-      temp->devno = logorgs[logorgno]->devs[(temp->devno)].devno;
-      temp->opid = curr->opid;
-      temp = temp->next;
-      i++;
+   host = req;
+   if ((logorgs[logorgno]->gatherwindow > 0.0) &&
+       (logorg_gather_write(logorgs[logorgno], curr, &req))) {
+      return(0);
    }
-   req->numreqs = numreqs;
-   logorg_addnewtooutstandq(logorgs[logorgno], req);
-   logorgs[logorgno]->opid++;
-   logorg_maprequest_update_stats(logorgs[logorgno], curr, req, i);
-/*
-fprintf (outputfile, "Leaving logorg_maprequest: cnt %d, devno %d, blkno %d, opid %d\n", i, curr->devno, curr->blkno, curr->opid);
-*/
-   return(i);
+   return(logorg_mapissue(logorgs[logorgno], curr, req, (req == host)));
 }
 
 
@@ -847,7 +1677,7 @@ fprintf (outputfile, "Entered logorg_mapcomplete: %f, devno %d, blkno %d, opid %
    for (i = 0; i < numlogorgs; i++) {
       for (j = 0; j < logorgs[i]->actualnumdisks; j++) {
          if (curr->devno == logorgs[i]->devs[j].devno) {
-            if (logorg_overlap(logorgs[i], j, curr, logorgs[i]->actualblksperpart) == TRUE) {
+            if (logorg_overlap(logorgs[i], j, curr, (logorgs[i]->actualblksperpart + logorgs[i]->spareblks)) == TRUE) {
                logorgno = i;
                break;
             }
@@ -861,14 +1691,27 @@ fprintf (outputfile, "Entered logorg_mapcomplete: %f, devno %d, blkno %d, opid %
       exit(1);
    }
 
-   if (curr->flags & READ) {
-      logorgs[logorgno]->stat.reads++;
-   }
    logorgs[logorgno]->stat.idlestart = simtime;
    logorgs[logorgno]->devs[curr->devno].numout--;
    req = logorg_getfromoutstandq(logorgs[logorgno], curr->opid);
    ASSERT(req != NULL);
+   if ((curr->flags & READ) && (req->type != LOGORG_REBUILD_OP)) {
+      logorgs[logorgno]->stat.reads++;
+   }
    req->numreqs--;
+   if (req->type == LOGORG_REBUILD_OP) {
+      if (curr->flags & READ) {
+         logorgs[logorgno]->stat.rebuildreadblks += curr->bcount;
+      } else {
+         logorgs[logorgno]->stat.rebuildwriteblks += curr->bcount;
+      }
+   } else if (!(req->flags & READ)) {
+      if (curr->flags & READ) {
+         logorgs[logorgno]->stat.devwritereadblks += curr->bcount;
+      } else {
+         logorgs[logorgno]->stat.devwriteblks += curr->bcount;
+      }
+   }
    if (req->depend) {
       ret = logorg_check_dependencies(logorgs[logorgno], req, curr);
       temp = curr->next;
@@ -887,11 +1730,25 @@ fprintf (outputfile, "Entered logorg_mapcomplete: %f, devno %d, blkno %d, opid %
    if (req->numreqs) {
       logorg_addtooutstandq(logorgs[logorgno], req);
       return(ret);
+   } else if (req->type == LOGORG_REBUILD_OP) {
+      logorg_rebuild_complete(logorgs[logorgno], req);
+      return(NOT_COMPLETE);
+   } else if (req->type == LOGORG_GATHER_OP) {
+      return(logorg_gather_complete(logorgs[logorgno], curr, req));
    } else {
 /*
 fprintf (outputfile, "Request completion:  %2d %7d %4d %c %f  (opid %d)\n", req->devno, req->blkno, req->bcount, ((req->flags & READ) ? 'R' : 'W'), (simtime - req->arrtime), req->opid);
 */
 
+      if (req->parent) {
+         outstand *parent = req->parent;
+
+         addtoextraq((event *) req);
+         if (--parent->numreqs) {
+            return(NOT_COMPLETE);
+         }
+         req = parent;
+      }
       logorg_mapcomplete_update_stats(logorgs[logorgno], curr, req);
       curr->bcount = req->bcount;
       curr->blkno = req->blkno;
@@ -900,6 +1757,7 @@ fprintf (outputfile, "Request completion:  %2d %7d %4d %c %f  (opid %d)\n", req-
       curr->devno = req->devno;
       curr->opid = req->reqopid;
       curr->buf = req->buf;
+      curr->next = NULL;
       addtoextraq((event *) req);
       return(COMPLETE);
    }
@@ -909,6 +1767,39 @@ fprintf (outputfile, "Leaving logorg_mapcomplete\n");
 }
 
 
+/* Returns how many blocks a request to devno may address: the logical
+   size of the array devno names, or else the device's own size */
+
+int logorg_get_number_of_blocks (logorg **logorgs, int numlogorgs, int devno)
+{
+   int i;
+
+   for (i = 0; i < numlogorgs; i++) {
+      if ((!logorgs[i]->addrbyparts) && (logorgs[i]->arraydisk == devno)) {
+         /* logorg_maprequest keeps blkno + bcount below the array size */
+         return((logorgs[i]->blksperpart * logorgs[i]->numdisks) - 1);
+      }
+   }
+   return(device_get_number_of_blocks(devno));
+}
+
+
+/* Failure and rebuild state is not checkpointed, so a run that models a
+   device failure cannot be checkpointed */
+
+int logorg_models_failure (logorg **logorgs, int numlogorgs)
+{
+   int i;
+
+   for (i = 0; i < numlogorgs; i++) {
+      if (logorgs[i]->failtime >= 0.0) {
+         return(TRUE);
+      }
+   }
+   return(FALSE);
+}
+
+
 void logorg_raise_priority (logorg **logorgs, int numlogorgs, int opid, int devno, int blkno, void *buf)
 {
    int i, j;
@@ -943,6 +1834,7 @@ fprintf (outputfile, "Entered logorg_raise_priority: numlogorgs %d, devno %d, bl
       }
    }
    ASSERT(logorgno != -1);
+   logorg_gather_raise(logorgs[logorgno], buf, opid);
    tmp = logorg_show_buf_from_outstandq(logorgs[logorgno], buf, opid);
    if (tmp) {
       for (i=0; i<logorgs[logorgno]->actualnumdisks; i++) {
@@ -1065,6 +1957,23 @@ void logorg_resetstats (logorg **logorgs, int numlogorgs)
       logorgs[i]->stat.numlocal = 0;
       logorgs[i]->stat.seqdiskswitches = 0;
       logorgs[i]->stat.locdiskswitches = 0;
+      logorgs[i]->stat.hostwriteblks = 0.0;
+      logorgs[i]->stat.devwriteblks = 0.0;
+      logorgs[i]->stat.devwritereadblks = 0.0;
+      logorgs[i]->stat.fullstripewrites = 0;
+      logorgs[i]->stat.rmwstripes = 0;
+      logorgs[i]->stat.reconstripes = 0;
+      logorgs[i]->stat.degradedreads = 0;
+      logorgs[i]->stat.rebuildreadblks = 0.0;
+      logorgs[i]->stat.rebuildwriteblks = 0.0;
+      for (j=0; j<3; j++) {
+         logorgs[i]->stat.phaseresptime[j] = 0.0;
+         logorgs[i]->stat.phasecount[j] = 0;
+      }
+      logorgs[i]->stat.gatheredwrites = 0;
+      logorgs[i]->stat.gatherfull = 0;
+      logorgs[i]->stat.gatherpartial = 0;
+      logorgs[i]->stat.gathersaved = 0.0;
       if (logorgs[i]->stat.intdist) {
          for (j=0; j<(INTERFEREMAX*INTDISTMAX); j++) {
             logorgs[i]->stat.intdist[j] = 0;
@@ -1119,7 +2028,9 @@ void logorg_initialize (logorg **logorgs,
 
    StaticAssert (sizeof(depends) <= DISKSIM_EVENT_SIZE);
    StaticAssert (sizeof(outstand) <= DISKSIM_EVENT_SIZE);
+   StaticAssert (sizeof(gather) <= DISKSIM_EVENT_SIZE);
 
+   disksim->timerfunc_logorg = logorg_timer;
    logorg_postpass (logorgs, numlogorgs);
 
    for (i = 0; i < numlogorgs; i++) {
@@ -1132,6 +2043,9 @@ void logorg_initialize (logorg **logorgs,
      logorgs[i]->printstreakstats = printstreakstats;
      logorgs[i]->printstampstats = printstampstats;
      logorgs[i]->printsizestats = printsizestats;
+     disksim_rng_init(&logorgs[i]->rng, "logorg", i);
+
+      logorg_rebuild_initialize(logorgs[i]);
 
       if (logorgs[i]->reduntype == SHADOWED) {
          if ((logorgs[i]->numdisks % logorgs[i]->copies) != 0) {
@@ -1175,12 +2089,20 @@ void logorg_initialize (logorg **logorgs,
 	   (double) logorgs[i]->numdisks) 
 	  - logorgs[i]->parityunit;
       }
+      else if ((logorgs[i]->reduntype == PARITY_DUAL) || 
+	       (logorgs[i]->reduntype == ERASURE_CODED)) {
+	logorg_erasure_initialize(logorgs[i]);
+      }
+      logorg_gather_initialize(logorgs[i]);
 
       logorgs[i]->opid = 0;
       logorgs[i]->idealno = 0;
       logorgs[i]->reduntoggle = 0;
       logorgs[i]->lastdiskaccessed = logorgs[i]->actualnumdisks;
 
+      if (logorgs[i]->hashoutstand == NULL) {
+         logorg_outstand_allocate(logorgs[i], HASH_OUTSTAND);
+      }
       while (logorgs[i]->outstandqlen != 0) {
          addtoextraq((event *) logorg_getfromoutstandq(logorgs[i], -1));
       }
@@ -1198,6 +2120,11 @@ void logorg_initialize (logorg **logorgs,
 	   logorgs[i]->stripeunit;
 	 logorgs[i]->numfull *= logorgs[i]->stripeunit;
       } 
+      else if ((logorgs[i]->reduntype == PARITY_DUAL) || 
+	       (logorgs[i]->reduntype == ERASURE_CODED)) {
+         logorgs[i]->numfull = logorgs[i]->actualblksperpart / 
+	   logorgs[i]->stripeunit;
+      } 
       else {
 	 logorgs[i]->numfull = 0;
       }
@@ -1323,6 +2250,72 @@ static void logorg_printreqtimestats (logorg *currlogorg, char *prefix)
 }
 
 
+static void logorg_printredunstats (logorg *currlogorg, char *prefix)
+{
+   logorgstat *stat = &currlogorg->stat;
+   double hostblks = (stat->hostwriteblks > 0.0) ? stat->hostwriteblks : 1.0;
+
+   if (currlogorg->reduntype == NO_REDUN) {
+      return;
+   }
+   fprintf(outputfile, "%sHost blocks written:      %.0f\n", prefix, stat->hostwriteblks);
+   fprintf(outputfile, "%sDevice blocks written:    %.0f\n", prefix, stat->devwriteblks);
+   fprintf(outputfile, "%sDevice blocks read for writes: %.0f\n", prefix, stat->devwritereadblks);
+   fprintf(outputfile, "%sWrite amplification:      %f\n", prefix, (stat->devwriteblks / hostblks));
+   fprintf(outputfile, "%sWrite traffic amplification: %f\n", prefix, ((stat->devwriteblks + stat->devwritereadblks) / hostblks));
+   if ((currlogorg->reduntype == PARITY_DUAL) || (currlogorg->reduntype == ERASURE_CODED)) {
+      fprintf(outputfile, "%sFull-stripe writes:       %d\n", prefix, stat->fullstripewrites);
+      fprintf(outputfile, "%sRMW stripe writes:        %d\n", prefix, stat->rmwstripes);
+      fprintf(outputfile, "%sReconstruct stripe writes: %d\n", prefix, stat->reconstripes);
+   }
+}
+
+
+static void logorg_printrebuildstats (logorg *currlogorg, char *prefix)
+{
+   logorgstat *stat = &currlogorg->stat;
+   char *phases[3] = { "before failure", "during rebuild", "after rebuild" };
+   int i;
+
+   if (currlogorg->failtime < 0.0) {
+      return;
+   }
+   fprintf(outputfile, "%sFailed device:            %d\n", prefix, currlogorg->failmember);
+   if (currlogorg->failstate == 0) {
+      fprintf(outputfile, "%sDevice failure time:      none\n", prefix);
+   } else {
+      fprintf(outputfile, "%sDevice failure time:      %f\n", prefix, currlogorg->failtime);
+   }
+   if (currlogorg->failstate == 2) {
+      fprintf(outputfile, "%sRebuild time:             %f\n", prefix, (currlogorg->rebuilddone - currlogorg->failtime));
+   } else if (currlogorg->failstate == 1) {
+      fprintf(outputfile, "%sRebuild time:             incomplete (%f done)\n", prefix, ((double) currlogorg->rebuilt / (double) currlogorg->rebuildend));
+   }
+   fprintf(outputfile, "%sDegraded reads:           %d\n", prefix, stat->degradedreads);
+   fprintf(outputfile, "%sRebuild blocks read:      %.0f\n", prefix, stat->rebuildreadblks);
+   fprintf(outputfile, "%sRebuild blocks written:   %.0f\n", prefix, stat->rebuildwriteblks);
+   for (i=0; i<3; i++) {
+      fprintf(outputfile, "%sResponse time %s: %f  \t%d\n", prefix, phases[i], (stat->phaseresptime[i] / (double) max(1,stat->phasecount[i])), stat->phasecount[i]);
+   }
+}
+
+
+static void logorg_printgatherstats (logorg *currlogorg, char *prefix)
+{
+   logorgstat *stat = &currlogorg->stat;
+   int flushed = stat->gatherfull + stat->gatherpartial;
+
+   if (currlogorg->gatherwindow <= 0.0) {
+      return;
+   }
+   fprintf(outputfile, "%sGathered writes:          %d\n", prefix, stat->gatheredwrites);
+   fprintf(outputfile, "%sFull-stripe flushes:      %d\n", prefix, stat->gatherfull);
+   fprintf(outputfile, "%sWindow-expiry flushes:    %d\n", prefix, stat->gatherpartial);
+   fprintf(outputfile, "%sFull-stripe fraction:     %f\n", prefix, ((double) stat->gatherfull / (double) max(1,flushed)));
+   fprintf(outputfile, "%sDevice I/Os saved:        %.0f\n", prefix, stat->gathersaved);
+}
+
+
 static void logorg_printlocalitystats (logorg *currlogorg, char *prefix)
 {
    int i;
@@ -1485,6 +2478,9 @@ void logorg_printstats (logorg **logorgs, int numlogorgs, char *sourcestr)
       logorg_printreqtimestats(logorgs[i], prefix);
       fprintf (outputfile, "%sTime-critical reads:  %d\n", prefix, logorgs[i]->stat.critreads);
       fprintf (outputfile, "%sTime-critical writes: %d\n", prefix, logorgs[i]->stat.critwrites);
+      logorg_printredunstats(logorgs[i], prefix);
+      logorg_printrebuildstats(logorgs[i], prefix);
+      logorg_printgatherstats(logorgs[i], prefix);
       logorg_printlocalitystats(logorgs[i], prefix);
       logorg_printinterferestats(logorgs[i], prefix);
       logorg_printblockingstats(logorgs[i], prefix);
@@ -1577,6 +2573,12 @@ int logorg_redun(logorg *result, char *s) {
   else if(!strcmp(s, "Parity_rotated")) {
     result->reduntype = PARITY_ROTATED;
   }
+  else if(!strcmp(s, "Parity_dual")) {
+    result->reduntype = PARITY_DUAL;
+  }
+  else if(!strcmp(s, "Erasure_coded")) {
+    result->reduntype = ERASURE_CODED;
+  }
   else {
     fprintf(stderr, "*** error: %s is not a valid argument for logorg redundancy scheme\n", s);
     return -1;
@@ -1649,6 +2651,9 @@ struct logorg *disksim_logorg_loadparams(struct lp_block *b)
 
   result = malloc(sizeof(struct logorg));
   bzero(result, sizeof(struct logorg));
+  result->failtime = -1.0;
+  result->rebuildmode = REBUILD_DEDICATED;
+  result->gatherstripes = 16;
 
   //#include "modules/disksim_logorg_param.c"
   lp_loadparams(result, b, &disksim_logorg_mod);
@@ -1706,4 +2711,14 @@ void logorg_cleanup(logorg *l) {
     fclose(l->stampfile);
     l->stampfile = NULL;
   }
+  if(l->rebuildstart) {
+    free(l->rebuildstart);
+    l->rebuildstart = NULL;
+  }
+  if(l->hashoutstand) {
+    free(l->hashoutstand);
+    free(l->hashbuf);
+    l->hashoutstand = NULL;
+    l->hashbuf = NULL;
+  }
 }
@@ -123,6 +123,25 @@
 #define PARITY_DISK     	3
 #define PARITY_ROTATED  	4
 #define PARITY_TABLE		5
+#define PARITY_DUAL		6
+#define ERASURE_CODED		7
+
+/* Rebuild modes */
+
+#define REBUILD_DEDICATED	1
+#define REBUILD_DISTRIBUTED	2
+
+/* Outstanding operation types */
+
+#define LOGORG_HOST_OP		0
+#define LOGORG_REBUILD_OP	1
+#define LOGORG_GATHER_OP	2
+
+/* Logorg timer events */
+
+#define LOGORG_TIMER_FAILURE	0
+#define LOGORG_TIMER_REBUILD	1
+#define LOGORG_TIMER_GATHER	2
 
 /* Shadow disk read choices */
 
@@ -143,7 +162,7 @@
 #define LOGORG_PARITY_SEQGIVE	32
 #define MAXCOPIES	10
 #define NUMGENS 50
-#define HASH_OUTSTAND   20
+#define HASH_OUTSTAND   32	/* initial buckets; must be a power of two */
 
 #define BLOCKINGMAX	128
 #define INTERFEREMAX	32
@@ -173,8 +192,19 @@ typedef struct os {
    int    reqopid;
    void  *buf;
    depends *depend;
+   struct os *bufnext;
+   struct os *bufprev;
+   ioreq_event *gathered;	/* host writes merged into a LOGORG_GATHER_OP */
+   struct os *parent;		/* host request this stripe piece belongs to */
 } outstand;
 
+typedef struct gath {
+   double deadline;
+   int    stripeno;
+   ioreq_event *reqs;		/* held writes, by block number */
+   struct gath *next;
+} gather;
+
 typedef struct {
    double	outtime;
    double	runouttime;
@@ -209,6 +239,21 @@ typedef struct {
    statgen      intarrstats;
    statgen      readintarrstats;
    statgen      writeintarrstats;
+   double       hostwriteblks;
+   double       devwriteblks;
+   double       devwritereadblks;
+   int          fullstripewrites;
+   int          rmwstripes;
+   int          reconstripes;
+   int          degradedreads;
+   double       rebuildreadblks;
+   double       rebuildwriteblks;
+   double       phaseresptime[3];	/* healthy, rebuilding, rebuilt */
+   int          phasecount[3];
+   int          gatheredwrites;
+   int          gatherfull;
+   int          gatherpartial;
+   double       gathersaved;
 } logorgstat;
 
 typedef struct {
@@ -235,7 +280,9 @@ typedef struct {
 
 typedef struct logorg {
   char *name;
-   outstand * hashoutstand[HASH_OUTSTAND];
+   outstand **hashoutstand;
+   outstand **hashbuf;
+   int    hashsize;
    int    outstandqlen;
    int    opid;
    int    addrbyparts;
@@ -258,6 +305,29 @@ typedef struct logorg {
    tableentry *table;
    int    tablesize;
    int    partsperstripe;
+   int    paritydisks;
+   int    failmember;
+   double failtime;
+   int    rebuildmode;
+   int    rebuildunit;
+   double rebuildrate;
+   int    faileddev;		/* failed member, -1 while all are healthy */
+   int    failstate;		/* index into stat.phaseresptime */
+   int    rebuildpos;		/* next block of faileddev to rebuild */
+   int    rebuilt;		/* blocks of faileddev below this are rebuilt */
+   int    rebuildend;
+   int    rebuildsout;
+   int   *rebuildstart;		/* first block of each rebuild step in flight */
+   double rebuildnext;		/* earliest start of the next rebuild step */
+   double rebuilddone;
+   int    rebuildwaiting;
+   int    spareblkno;		/* start of the distributed spare space */
+   int    spareblks;
+   double gatherwindow;
+   int    gatherstripes;
+   int    gatherlimit;		/* stripes at or above this are never held */
+   int    gathercount;
+   gather *gatherlist;		/* oldest first */
    int    idealno;
    int    reduntoggle;
    int    lastdiskaccessed;
@@ -281,6 +351,7 @@ typedef struct logorg {
    /* rcohen's additions */
    int    startdev;
    int    enddev;
+   disksim_rng rng;		/* random mapping and copy selection */
 } logorg;
 
 /* exported disksim_logorg.c functions */
@@ -291,6 +362,14 @@ int  logorg_shadowed (logorg *currlogorg, ioreq_event *curr, int numreqs);
 int  logorg_parity_disk (logorg *currlogorg, ioreq_event *curr, int numreqs);
 int  logorg_parity_rotate (logorg *currlogorg, ioreq_event *curr, int numreqs);
 int  logorg_parity_table (logorg *currlogorg, ioreq_event *curr, int numreqs);
+int  logorg_erasure_coded (logorg *currlogorg, ioreq_event *curr, int numreqs);
+void logorg_erasure_initialize (logorg *currlogorg);
+void logorg_data_location (logorg *currlogorg, int lblk, int *devno, int *blkno);
+void logorg_add_dependency (depends **deplist, ioreq_event *read, ioreq_event **deps, int numdeps);
+int  logorg_degraded (logorg *currlogorg, ioreq_event *curr, int numreqs);
+int  logorg_degraded_width (logorg *currlogorg);
+int  logorg_survivor (logorg *currlogorg, int i);
+void logorg_spare_location (logorg *currlogorg, ioreq_event *curr);
 void logorg_create_table (logorg *currlogorg);
 int  logorg_tabular_rottype (int maptype, int reduntype, int rottype, int stripeunit);
 int  logorg_check_dependencies (logorg *currlogorg, outstand *req, ioreq_event *curr);
@@ -132,6 +132,8 @@ void  logorg_cleanstats (struct logorg **logorgs, int numlogorgs);
 int   logorg_maprequest (struct logorg **logorgs, int numlogorgs, ioreq_event *curr);
 int   logorg_mapcomplete (struct logorg **logorgs, int numlogorgs, ioreq_event *curr);
 void  logorg_raise_priority (struct logorg **logorgs, int numlogorgs, int opid, int devno, int blkno, void *buf);
+int   logorg_get_number_of_blocks (struct logorg **logorgs, int numlogorgs, int devno);
+int   logorg_models_failure (struct logorg **logorgs, int numlogorgs);
 void  logorg_timestamp (ioreq_event *curr);
 
 #endif   /* DISKSIM_ORGFACE_H */
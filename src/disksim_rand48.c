@@ -71,6 +71,8 @@
 #include "disksim_global.h"
 #include "disksim_rand48.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 
 /* FreeBSD's rand48.h */
@@ -89,6 +91,10 @@ typedef struct rand48_info {
    unsigned short _rand48_seed[3];
    unsigned short _rand48_mult[3];
    unsigned short _rand48_add;
+   int            rngkind;
+   int            rngjumps;
+   disksim_rng   *streams;
+   disksim_rng   *laststream;
 } rand48_into_t;
 
 
@@ -286,3 +292,233 @@ DISKSIM_srand48(long seed)
 	_rand48_add = RAND48_ADD;
 }
 
+
+
+/* Generator state as { seed[3], mult[3], add } */
+
+void
+DISKSIM_rand48_getstate(unsigned short state[7])
+{
+	int i;
+
+	disksim_rand48_initialize();
+	for (i = 0; i < 3; i++) {
+		state[i] = _rand48_seed[i];
+		state[3+i] = _rand48_mult[i];
+	}
+	state[6] = _rand48_add;
+}
+
+
+void
+DISKSIM_rand48_setstate(unsigned short state[7])
+{
+	int i;
+
+	disksim_rand48_initialize();
+	for (i = 0; i < 3; i++) {
+		_rand48_seed[i] = state[i];
+		_rand48_mult[i] = state[3+i];
+	}
+	_rand48_add = state[6];
+}
+
+
+/* Independent streams: xoshiro256** (Blackman and Vigna), seeded with */
+/* splitmix64 from the run seed and a hash of the stream name.  Index  */
+/* n of a name starts n 2^128-draw jumps into that name's sequence, so */
+/* the instances of one module never overlap.                          */
+
+static INLINE uint64_t disksim_rng_rotl (uint64_t x, int k)
+{
+   return((x << k) | (x >> (64 - k)));
+}
+
+
+static uint64_t disksim_rng_next (disksim_rng *rng)
+{
+   uint64_t *s = rng->s;
+   uint64_t result = disksim_rng_rotl(s[1] * 5, 7) * 9;
+   uint64_t t = s[1] << 17;
+
+   s[2] ^= s[0];
+   s[3] ^= s[1];
+   s[1] ^= s[2];
+   s[0] ^= s[3];
+   s[2] ^= t;
+   s[3] = disksim_rng_rotl(s[3], 45);
+   return(result);
+}
+
+
+static void disksim_rng_dojump (disksim_rng *rng, const uint64_t *poly)
+{
+   uint64_t t[4] = { 0, 0, 0, 0 };
+   int i, b, j;
+
+   for (i = 0; i < 4; i++) {
+      for (b = 0; b < 64; b++) {
+         if (poly[i] & ((uint64_t) 1 << b)) {
+            for (j = 0; j < 4; j++) {
+               t[j] ^= rng->s[j];
+            }
+         }
+         disksim_rng_next(rng);
+      }
+   }
+   for (j = 0; j < 4; j++) {
+      rng->s[j] = t[j];
+   }
+}
+
+
+void disksim_rng_jump (disksim_rng *rng)
+{
+   static const uint64_t jump[4] = {
+      0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+      0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL
+   };
+
+   if (rng->kind == DISKSIM_RNG_XOSHIRO) {
+      disksim_rng_dojump(rng, jump);
+   }
+}
+
+
+static void disksim_rng_longjump (disksim_rng *rng)
+{
+   static const uint64_t longjump[4] = {
+      0x76e15d3efefdcbbfULL, 0xc5004e441c522fb3ULL,
+      0x77710069854ee241ULL, 0x39109bb02acbe635ULL
+   };
+
+   disksim_rng_dojump(rng, longjump);
+}
+
+
+static uint64_t disksim_rng_splitmix (uint64_t *x)
+{
+   uint64_t z = (*x += 0x9e3779b97f4a7c15ULL);
+
+   z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+   z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+   return(z ^ (z >> 31));
+}
+
+
+void disksim_rng_setkind (char *name)
+{
+   disksim_rand48_initialize();
+   if (!strcmp(name, "rand48")) {
+      disksim->rand48_info->rngkind = DISKSIM_RNG_RAND48;
+   } else if (!strcmp(name, "xoshiro")) {
+      disksim->rand48_info->rngkind = DISKSIM_RNG_XOSHIRO;
+   } else {
+      fprintf(stderr, "*** error: unknown random number generator %s (rand48 or xoshiro)\n", name);
+      exit(1);
+   }
+}
+
+
+void disksim_rng_setjumps (int jumps)
+{
+   disksim_rand48_initialize();
+   if (jumps < 0) {
+      fprintf(stderr, "*** error: negative random stream jump count %d\n", jumps);
+      exit(1);
+   }
+   disksim->rand48_info->rngjumps = jumps;
+}
+
+
+void disksim_rng_init_kind (disksim_rng *rng, int kind, char *name, int index)
+{
+   rand48_into_t *info;
+   disksim_rng *tmp;
+   uint64_t x = (uint64_t) (unsigned int) disksim->seedval;
+   int registered = FALSE;
+   char *c;
+   int i;
+
+   disksim_rand48_initialize();
+   info = disksim->rand48_info;
+
+   for (tmp = info->streams; tmp; tmp = tmp->next) {
+      if (tmp == rng) {
+         registered = TRUE;
+         if (index < 0) {
+            index = rng->index;
+         }
+         break;
+      }
+   }
+   if (index < 0) {
+      index = 0;
+      for (tmp = info->streams; tmp; tmp = tmp->next) {
+         if (!strcmp(tmp->name, name)) {
+            index++;
+         }
+      }
+   }
+
+   rng->kind = kind;
+   rng->name = name;
+   rng->index = index;
+   for (c = name; *c; c++) {
+      x = (x ^ (unsigned char) *c) * 0x100000001b3ULL;
+   }
+   for (i = 0; i < 4; i++) {
+      rng->s[i] = disksim_rng_splitmix(&x);
+   }
+   if (kind == DISKSIM_RNG_XOSHIRO) {
+      for (i = 0; i < index; i++) {
+         disksim_rng_jump(rng);
+      }
+      for (i = 0; i < info->rngjumps; i++) {
+         disksim_rng_longjump(rng);
+      }
+   }
+
+   if (registered) {
+      return;
+   }
+   rng->next = NULL;
+   if (info->laststream) {
+      info->laststream->next = rng;
+   } else {
+      info->streams = rng;
+   }
+   info->laststream = rng;
+}
+
+
+void disksim_rng_init (disksim_rng *rng, char *name, int index)
+{
+   disksim_rand48_initialize();
+   disksim_rng_init_kind(rng, disksim->rand48_info->rngkind, name, index);
+}
+
+
+double disksim_rng_uniform (disksim_rng *rng)
+{
+   if (rng->kind == DISKSIM_RNG_RAND48) {
+      return(DISKSIM_drand48());
+   }
+   return((double) (disksim_rng_next(rng) >> 11) * (1.0 / 9007199254740992.0));
+}
+
+
+long disksim_rng_lrand (disksim_rng *rng)
+{
+   if (rng->kind == DISKSIM_RNG_RAND48) {
+      return(DISKSIM_lrand48());
+   }
+   return((long) (disksim_rng_next(rng) >> 33));
+}
+
+
+disksim_rng *disksim_rng_streams (void)
+{
+   disksim_rand48_initialize();
+   return(disksim->rand48_info->streams);
+}
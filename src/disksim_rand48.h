@@ -58,6 +58,8 @@
 #ifndef DISKSIM_RAND48_H
 #define DISKSIM_RAND48_H
 
+#include <stdint.h>
+
 /* To help with portability to Windowsy platforms, we've incorporated */
 /* the *rand48() functions from FreeBSD.  No better reason.           */
 
@@ -70,5 +72,52 @@ void DISKSIM_srand48 (long int __seedval);
 /* Return non-negative integer in range [0,2**31-1] */
 long DISKSIM_lrand48 (void);
 
+/* Get/set the complete generator state (seed, multiplier, addend), */
+/* e.g. for checkpoints.                                            */
+void DISKSIM_rand48_getstate (unsigned short state[7]);
+void DISKSIM_rand48_setstate (unsigned short state[7]);
+
+
+/* Independent random streams.  Each module that needs randomness keeps */
+/* its own disksim_rng, named by module and instance.  With the rand48  */
+/* kind (the default) every stream draws from the single sequence above */
+/* exactly as before, so validation output is unchanged.  With xoshiro  */
+/* each stream has private xoshiro256** state derived from the seed,    */
+/* the name and the index, so adding a generator or a device does not   */
+/* perturb any other stream.                                            */
+
+#define DISKSIM_RNG_RAND48	0
+#define DISKSIM_RNG_XOSHIRO	1
+
+typedef struct disksim_rng {
+   uint64_t s[4];
+   int      kind;
+   char    *name;
+   int      index;
+   struct disksim_rng *next;	/* registration order, for checkpoints */
+} disksim_rng;
+
+/* Selects the kind used by disksim_rng_init and the number of 2^192  */
+/* long jumps applied to every xoshiro stream, so that parallel runs  */
+/* sharing a seed can take disjoint subsequences.                     */
+void disksim_rng_setkind (char *name);
+void disksim_rng_setjumps (int jumps);
+
+/* A negative index numbers the stream after the others of that name, */
+/* in initialization order.                                            */
+void disksim_rng_init (disksim_rng *rng, char *name, int index);
+void disksim_rng_init_kind (disksim_rng *rng, int kind, char *name, int index);
+
+/* Advances an xoshiro stream by 2^128 draws. */
+void disksim_rng_jump (disksim_rng *rng);
+
+/* Uniform in [0.0,1.0) and non-negative in [0,2**31-1], like */
+/* DISKSIM_drand48() and DISKSIM_lrand48().                    */
+double disksim_rng_uniform (disksim_rng *rng);
+long   disksim_rng_lrand (disksim_rng *rng);
+
+/* All initialized streams, in initialization order. */
+disksim_rng *disksim_rng_streams (void);
+
 #endif
 
@@ -160,7 +160,7 @@ static void logorg_parity_rotate_random (logorg *currlogorg, ioreq_event *curr)
    }
    curr->next = ioreq_copy(curr);
    while (curr->next->devno == curr->devno) {
-      curr->next->devno = (int)((double)currlogorg->numdisks * DISKSIM_drand48());
+      curr->next->devno = (int)((double)currlogorg->numdisks * disksim_rng_uniform(&currlogorg->rng));
    }
 }
 
@@ -200,7 +200,7 @@ static int logorg_shadowed_get_short_dist (logorg *currlogorg, ioreq_event *curr
       fprintf(stderr, "Illegal condition in logorg_shadowed_get_short_dist\n");
       exit(1);
    } else if (j != -1) {
-      i = (int) (DISKSIM_drand48() * (double) (j+2));
+      i = (int) (disksim_rng_uniform(&currlogorg->rng) * (double) (j+2));
       if (i != 0) {
 	 shortdev = ties[(i-1)];
       }
@@ -243,7 +243,7 @@ static int logorg_shadowed_get_short_queue (logorg *currlogorg, ioreq_event *cur
       exit(1);
    } else if (j != -1) {
       if (def == 1) {
-         i = (int) (DISKSIM_drand48() * (double) (j+2));
+         i = (int) (disksim_rng_uniform(&currlogorg->rng) * (double) (j+2));
          if (i != 0) {
 	    shortdev = ties[(i-1)];
          }
@@ -275,7 +275,7 @@ int logorg_shadowed (logorg *currlogorg, ioreq_event *curr, int numreqs)
 /* May want to move head on secondary device */
 			  break;
 	    case SHADOW_RANDOM:
-			  temp->devno += currlogorg->numdisks * (int) (DISKSIM_drand48() * (double) currlogorg->copies);
+			  temp->devno += currlogorg->numdisks * (int) (disksim_rng_uniform(&currlogorg->rng) * (double) currlogorg->copies);
 			  break;
 	    case SHADOW_ROUNDROBIN:
 			  temp->devno += currlogorg->numdisks * currlogorg->reduntoggle;
@@ -1233,6 +1233,483 @@ void logorg_create_table (logorg *currlogorg)
 }
 
 
+/* Dual parity (Parity_dual) and general k+m erasure codes (Erasure_coded).
+ * Each stripe holds partsperstripe data units and paritydisks check units,
+ * one stripe unit per device.  The check units rotate left-symmetrically:
+ * the check units of stripe s start on device (k - s) mod N and the data
+ * units follow them.  Only the placement of the check units and the I/Os
+ * needed to keep them current are modelled, not the code itself.
+ */
+
+void logorg_erasure_initialize (logorg *currlogorg)
+{
+   int numfull;
+
+   if (currlogorg->reduntype == PARITY_DUAL) {
+      currlogorg->paritydisks = 2;
+   }
+   if ((currlogorg->paritydisks < 1) || (currlogorg->paritydisks >= currlogorg->numdisks)) {
+      fprintf(stderr, "*** error: %d parity devices per stripe is invalid for a %d-device logorg\n", currlogorg->paritydisks, currlogorg->numdisks);
+      exit(1);
+   }
+   if ((currlogorg->maptype != STRIPED) || (currlogorg->stripeunit <= 0)) {
+      fprintf(stderr, "*** error: erasure-coded logorgs require Striped distribution and a non-zero stripe unit\n");
+      exit(1);
+   }
+   currlogorg->maptype = ASIS;
+   currlogorg->partsperstripe = currlogorg->numdisks - currlogorg->paritydisks;
+   numfull = currlogorg->actualblksperpart / currlogorg->stripeunit;
+   currlogorg->blksperpart = (int) ((double) numfull * (double) currlogorg->stripeunit * (double) currlogorg->partsperstripe / (double) currlogorg->numdisks);
+}
+
+
+/* Slots 0 to paritydisks-1 are the check units, the data units follow */
+
+static int logorg_erasure_devno (logorg *currlogorg, int stripeno, int slot)
+{
+   int numdisks = currlogorg->numdisks;
+   int first;
+
+   first = (currlogorg->partsperstripe - (stripeno % numdisks) + numdisks) % numdisks;
+   return((first + slot) % numdisks);
+}
+
+
+/* Member and block (relative to the member's start) holding logical
+   block lblk of a table-mapped or erasure-coded logorg */
+
+void logorg_data_location (logorg *currlogorg, int lblk, int *devno, int *blkno)
+{
+   int stripeunit = currlogorg->stripeunit;
+   int partsperstripe = currlogorg->partsperstripe;
+   int unitno = lblk / stripeunit;
+   int stripeno = unitno / partsperstripe;
+   int tablestart;
+   int entryno;
+
+   if (currlogorg->reduntype == PARITY_TABLE) {
+      tablestart = (stripeno / currlogorg->tablestripes) * currlogorg->tablesize;
+      entryno = (stripeno % currlogorg->tablestripes) * (partsperstripe + 1) + (unitno % partsperstripe);
+      *devno = currlogorg->table[entryno].devno;
+      *blkno = tablestart + currlogorg->table[entryno].blkno + (lblk % stripeunit);
+   } else {
+      *devno = logorg_erasure_devno(currlogorg, stripeno, (currlogorg->paritydisks + (unitno % partsperstripe)));
+      *blkno = stripeno * stripeunit + (lblk % stripeunit);
+   }
+}
+
+
+static ioreq_event * logorg_erasure_newreq (ioreq_event *curr, int devno, int blkno, int bcount, int read)
+{
+   ioreq_event *newreq;
+
+   newreq = ioreq_copy(curr);
+   newreq->devno = devno;
+   newreq->blkno = blkno;
+   newreq->bcount = bcount;
+   newreq->flags = (read) ? (curr->flags | READ) : (curr->flags & ~READ);
+   newreq->opid = 0;
+   newreq->next = NULL;
+   newreq->prev = NULL;
+   return(newreq);
+}
+
+
+/* Makes the writes in deps wait for read.  logorg_check_dependencies steps
+ * onto a continuation node after every tenth dependent, so one is always
+ * present when numdeps is a multiple of ten.
+ */
+
+void logorg_add_dependency (depends **deplist, ioreq_event *read, ioreq_event **deps, int numdeps)
+{
+   depends *depend;
+   int i;
+
+   depend = (depends *) getfromextraq();
+   depend->devno = read->devno;
+   depend->blkno = read->blkno;
+   depend->numdeps = numdeps;
+   depend->cont = NULL;
+   depend->next = *deplist;
+   *deplist = depend;
+   for (i=0; i<numdeps; i++) {
+      if ((i) && ((i % 10) == 0)) {
+         depend->cont = (depends *) getfromextraq();
+         depend = depend->cont;
+         depend->cont = NULL;
+      }
+      depend->deps[(i % 10)] = deps[i];
+      deps[i]->opid++;
+   }
+   if ((numdeps % 10) == 0) {
+      depend->cont = (depends *) getfromextraq();
+      depend->cont->cont = NULL;
+   }
+}
+
+
+/* Generates the I/Os for a write covering [start[u], stop[u]) of each data
+ * unit u of one stripe.  Writes that wait on nothing go into reqs[] so that
+ * they can be joined with their neighbours; reads go straight onto curr's
+ * list.  Returns the number of reads plus the number of deferred writes.
+ */
+
+static int logorg_erasure_write_stripe (logorg *currlogorg, ioreq_event *curr, int stripeno, int *start, int *stop, ioreq_event **reqs, depends **deplist)
+{
+   int i, j;
+   int k = currlogorg->partsperstripe;
+   int m = currlogorg->paritydisks;
+   int stripeunit = currlogorg->stripeunit;
+   int blkno = stripeno * stripeunit;
+   int touched = 0;
+   int full = TRUE;
+   int low = stripeunit;
+   int high = 0;
+   int devno;
+   int numreads = 0;
+   int numwrites = 0;
+   int numdeps;
+   int rmw;
+   int reqcnt = 0;
+   ioreq_event *reads[(2*MAXDEVICES)];
+   int readunit[(2*MAXDEVICES)];
+   ioreq_event *writes[MAXDEVICES];
+   int writeunit[MAXDEVICES];
+   ioreq_event *deps[MAXDEVICES];
+
+   for (i=0; i<k; i++) {
+      if (stop[i] > start[i]) {
+         touched++;
+         if (start[i] < low) {
+            low = start[i];
+         }
+         if (stop[i] > high) {
+            high = stop[i];
+         }
+         if ((start[i] != 0) || (stop[i] != stripeunit)) {
+            full = FALSE;
+         }
+      } else {
+         full = FALSE;
+      }
+   }
+   for (i=0; i<k; i++) {
+      if (stop[i] > start[i]) {
+         devno = logorg_erasure_devno(currlogorg, stripeno, (m + i));
+         writeunit[numwrites] = i;
+         writes[numwrites++] = logorg_erasure_newreq(curr, devno, (blkno + start[i]), (stop[i] - start[i]), FALSE);
+      }
+   }
+   for (j=0; j<m; j++) {
+      devno = logorg_erasure_devno(currlogorg, stripeno, j);
+      writeunit[numwrites] = -1;
+      writes[numwrites++] = logorg_erasure_newreq(curr, devno, (blkno + low), (high - low), FALSE);
+   }
+
+   rmw = (touched < currlogorg->rmwpoint);
+   if (full) {
+      currlogorg->stat.fullstripewrites++;
+   } else if (rmw) {
+      currlogorg->stat.rmwstripes++;
+      for (i=0; i<numwrites; i++) {
+         readunit[numreads] = writeunit[i];
+         reads[numreads++] = logorg_erasure_newreq(curr, writes[i]->devno, writes[i]->blkno, writes[i]->bcount, TRUE);
+      }
+   } else {
+      currlogorg->stat.reconstripes++;
+      for (i=0; i<k; i++) {
+         devno = logorg_erasure_devno(currlogorg, stripeno, (m + i));
+         if (stop[i] <= start[i]) {
+            readunit[numreads] = -1;
+            reads[numreads++] = logorg_erasure_newreq(curr, devno, (blkno + low), (high - low), TRUE);
+            continue;
+         }
+         if (start[i] > low) {
+            readunit[numreads] = -1;
+            reads[numreads++] = logorg_erasure_newreq(curr, devno, (blkno + low), (start[i] - low), TRUE);
+         }
+         if (stop[i] < high) {
+            readunit[numreads] = -1;
+            reads[numreads++] = logorg_erasure_newreq(curr, devno, (blkno + stop[i]), (high - stop[i]), TRUE);
+         }
+      }
+   }
+
+   /* Check unit writes need every read; with synch writes the data writes
+      do too, otherwise an RMW data write waits only for its own old data */
+   for (i=0; i<numreads; i++) {
+      numdeps = 0;
+      for (j=0; j<numwrites; j++) {
+         if ((writeunit[j] == -1) || (currlogorg->writesync) || ((readunit[i] != -1) && (readunit[i] == writeunit[j]))) {
+            deps[numdeps++] = writes[j];
+         }
+      }
+      logorg_add_dependency(deplist, reads[i], deps, numdeps);
+      reads[i]->next = curr->next;
+      curr->next = reads[i];
+      reqcnt++;
+   }
+   for (i=0; i<numwrites; i++) {
+      if (writes[i]->opid) {
+         reqcnt++;
+      } else {
+         logorg_parity_table_insert(&reqs[writes[i]->devno], writes[i]);
+      }
+   }
+   return(reqcnt);
+}
+
+
+int logorg_erasure_coded (logorg *currlogorg, ioreq_event *curr, int numreqs)
+{
+   int i;
+   ioreq_event *reqs[MAXDEVICES];
+   int start[MAXDEVICES];
+   int stop[MAXDEVICES];
+   depends *deplist = NULL;
+   ioreq_event *temp;
+   int k = currlogorg->partsperstripe;
+   int m = currlogorg->paritydisks;
+   int stripeunit = currlogorg->stripeunit;
+   int reqcnt = 0;
+   int blkno;
+   int reqsize;
+   int stripeno;
+   int unitno;
+   int offset;
+   int size;
+
+   if (numreqs != 1) {
+      fprintf(stderr, "Multiple numreqs at logorg_erasure_coded is not acceptable - %d\n", numreqs);
+      exit(1);
+   }
+   if (currlogorg->addrbyparts) {
+      curr->blkno += curr->devno * currlogorg->blksperpart;
+   }
+   for (i=0; i<currlogorg->actualnumdisks; i++) {
+      reqs[i] = NULL;
+   }
+   curr->next = curr;
+   blkno = curr->blkno;
+   reqsize = curr->bcount;
+   while (reqsize > 0) {
+      unitno = blkno / stripeunit;
+      stripeno = unitno / k;
+      if (curr->flags & READ) {
+         offset = blkno % stripeunit;
+         size = (reqsize < (stripeunit - offset)) ? reqsize : (stripeunit - offset);
+         temp = logorg_erasure_newreq(curr, logorg_erasure_devno(currlogorg, stripeno, (m + (unitno % k))), (stripeno * stripeunit + offset), size, TRUE);
+         logorg_parity_table_insert(&reqs[temp->devno], temp);
+         blkno += size;
+         reqsize -= size;
+         continue;
+      }
+      for (i=0; i<k; i++) {
+         start[i] = stop[i] = 0;
+      }
+      while ((reqsize > 0) && ((blkno / stripeunit / k) == stripeno)) {
+         unitno = (blkno / stripeunit) % k;
+         offset = blkno % stripeunit;
+         size = (reqsize < (stripeunit - offset)) ? reqsize : (stripeunit - offset);
+         start[unitno] = offset;
+         stop[unitno] = offset + size;
+         blkno += size;
+         reqsize -= size;
+      }
+      reqcnt += logorg_erasure_write_stripe(currlogorg, curr, stripeno, start, stop, reqs, &deplist);
+   }
+   for (i=0; i<currlogorg->actualnumdisks; i++) {
+      reqcnt += logorg_join_seqreqs(reqs[i], curr, 0);
+   }
+   curr->prev = (ioreq_event *) deplist;
+
+   temp = curr->next;
+   if (temp == curr) {
+      fprintf(stderr, "Seem to have no requests when leaving logorg_erasure_coded\n");
+      exit(1);
+   }
+   curr->blkno = temp->blkno;
+   curr->devno = temp->devno;
+   curr->bcount = temp->bcount;
+   curr->flags = temp->flags;
+   curr->next = temp->next;
+   addtoextraq((event *) temp);
+   return(reqcnt);
+}
+
+
+/* Degraded mode.  Once a member has failed, a replacement takes its place
+ * (REBUILD_DEDICATED) or its contents move to spare space at the end of
+ * the other members (REBUILD_DISTRIBUTED).  Reads of blocks that have not
+ * been rebuilt yet are reconstructed from the same blocks on enough
+ * survivors to decode the stripe; every parity layout here keeps the units
+ * of a stripe at the same offset on each member.  Writes to the failed
+ * member are not dropped: they go to the replacement or spare location
+ * right away, and parity is updated as usual (pre-reads of unrebuilt
+ * blocks are reconstructed like any other read).
+ */
+
+int logorg_degraded_width (logorg *currlogorg)
+{
+   int checkunits = 1;
+
+   if ((currlogorg->reduntype == PARITY_DUAL) || (currlogorg->reduntype == ERASURE_CODED)) {
+      checkunits = currlogorg->paritydisks;
+   }
+   return(currlogorg->actualnumdisks - checkunits);
+}
+
+
+int logorg_survivor (logorg *currlogorg, int i)
+{
+   return((i < currlogorg->faileddev) ? i : (i + 1));
+}
+
+
+/* Spare units rotate across the survivors.  A request that straddles a
+   spare unit moves as a whole, starting at the spare for its first block */
+
+void logorg_spare_location (logorg *currlogorg, ioreq_event *curr)
+{
+   int unit = currlogorg->rebuildunit;
+   int survivors = currlogorg->actualnumdisks - 1;
+   int group = curr->blkno / unit;
+   int blkno;
+
+   blkno = currlogorg->spareblkno + (group / survivors) * unit + (curr->blkno % unit);
+   if ((blkno + curr->bcount) > (currlogorg->spareblkno + currlogorg->spareblks)) {
+      blkno = currlogorg->spareblkno + currlogorg->spareblks - curr->bcount;
+   }
+   curr->devno = logorg_survivor(currlogorg, (group % survivors));
+   curr->blkno = blkno;
+}
+
+
+static depends * logorg_find_dependency (depends *deplist, int devno, int blkno)
+{
+   while (deplist) {
+      if ((deplist->devno == devno) && (deplist->blkno == blkno)) {
+         return(deplist);
+      }
+      deplist = deplist->next;
+   }
+   return(NULL);
+}
+
+
+/* Makes the dependents of depend wait for read as well */
+
+static void logorg_copy_dependency (depends **deplist, depends *depend, ioreq_event *read)
+{
+   depends *newdep;
+   depends *tmpdep = depend;
+   int numdeps = depend->numdeps;
+   int i;
+
+   newdep = (depends *) getfromextraq();
+   newdep->devno = read->devno;
+   newdep->blkno = read->blkno;
+   newdep->numdeps = numdeps;
+   newdep->cont = NULL;
+   newdep->next = *deplist;
+   *deplist = newdep;
+   for (i=0; i<numdeps; i++) {
+      if ((i) && ((i % 10) == 0)) {
+         tmpdep = tmpdep->cont;
+         newdep->cont = (depends *) getfromextraq();
+         newdep = newdep->cont;
+         newdep->cont = NULL;
+      }
+      newdep->deps[(i % 10)] = tmpdep->deps[(i % 10)];
+      newdep->deps[(i % 10)]->opid++;
+   }
+   if ((numdeps % 10) == 0) {
+      newdep->cont = (depends *) getfromextraq();
+      newdep->cont->cont = NULL;
+   }
+}
+
+
+static int logorg_unrebuilt (logorg *currlogorg, ioreq_event *curr)
+{
+   return((curr->blkno + curr->bcount) > currlogorg->rebuilt);
+}
+
+
+/* Rewrites the requests produced for curr that touch the failed member.
+   Returns the new total number of requests. */
+
+int logorg_degraded (logorg *currlogorg, ioreq_event *curr, int numreqs)
+{
+   depends *deplist = (depends *) curr->prev;
+   depends *depend;
+   depends *tmpdep;
+   ioreq_event *temp;
+   ioreq_event *next;
+   ioreq_event *newreq;
+   int faileddev = currlogorg->faileddev;
+   int distributed = (currlogorg->rebuildmode == REBUILD_DISTRIBUTED);
+   int width;
+   int i;
+
+   /* Deferred requests can not be split, so a deferred read of an
+      unrebuilt block is charged to a single survivor */
+   for (depend = deplist; depend; depend = depend->next) {
+      tmpdep = depend;
+      for (i=0; i<depend->numdeps; i++) {
+         if ((i) && ((i % 10) == 0)) {
+            tmpdep = tmpdep->cont;
+         }
+         temp = tmpdep->deps[(i % 10)];
+         if (temp->devno != faileddev) {
+            continue;
+         }
+         if ((temp->flags & READ) && (logorg_unrebuilt(currlogorg, temp))) {
+            temp->devno = logorg_survivor(currlogorg, 0);
+         } else if (distributed) {
+            logorg_spare_location(currlogorg, temp);
+         }
+      }
+   }
+
+   width = logorg_degraded_width(currlogorg);
+   temp = curr;
+   do {
+      next = temp->next;
+      if (temp->devno == faileddev) {
+         depend = logorg_find_dependency(deplist, temp->devno, temp->blkno);
+         if ((temp->flags & READ) && (logorg_unrebuilt(currlogorg, temp))) {
+            currlogorg->stat.degradedreads++;
+            temp->devno = logorg_survivor(currlogorg, 0);
+            if (depend) {
+               depend->devno = temp->devno;
+            }
+            for (i=1; i<width; i++) {
+               newreq = ioreq_copy(temp);
+               newreq->devno = logorg_survivor(currlogorg, i);
+               newreq->prev = NULL;
+               newreq->next = temp->next;
+               temp->next = newreq;
+               if (depend) {
+                  logorg_copy_dependency(&deplist, depend, newreq);
+               }
+               numreqs++;
+            }
+         } else if (distributed) {
+            logorg_spare_location(currlogorg, temp);
+            if (depend) {
+               depend->devno = temp->devno;
+               depend->blkno = temp->blkno;
+            }
+         }
+      }
+      temp = next;
+   } while (temp != curr);
+   curr->prev = (ioreq_event *) deplist;
+   return(numreqs);
+}
+
+
 int logorg_check_dependencies (logorg *currlogorg, outstand *req, ioreq_event *curr)
 {
    int i;
@@ -44,6 +44,8 @@
 #define DISKSIM_SYNC	        0x00000080
 #define DISKSIM_ASYNC	        0x00000100
 #define DISKSIM_IO_FLAG_PAGEIO	0x00000200
+#define DISKSIM_FUA		0x00000400
+#define DISKSIM_BACKGROUND	0x00000800
 #define DISKSIM_SEQ		0x40000000
 #define DISKSIM_LOCAL		0x20000000
 #define DISKSIM_BATCH_COMPLETE  0x80000000
@@ -319,7 +319,7 @@ void simpledisk_bus_delay_complete (int devno, ioreq_event *curr, int sentbusno)
    slotno.byte[depth] = slotno.byte[depth] >> 4;
    curr->time = 0.0;
    if (depth == 0) {
-      intr_request ((event *)curr);
+      bus_interrupt_host (curr);
    } else {
       bus_deliver_event(busno.byte[depth], slotno.byte[depth], curr);
    }
@@ -0,0 +1,605 @@
+/*
+ * DiskSim Storage Subsystem Simulation Environment (Version 4.0)
+ * Revision Authors: John Bucy, Greg Ganger
+ * Contributors: John Griffin, Jiri Schindler, Steve Schlosser
+ *
+ * Copyright (c) of Carnegie Mellon University, 2001-2008.
+ *
+ * This software is being provided by the copyright holders under the
+ * following license. By obtaining, using and/or copying this software,
+ * you agree that you have read, understood, and will comply with the
+ * following terms and conditions:
+ *
+ * Permission to reproduce, use, and prepare derivative works of this
+ * software is granted provided the copyright and "No Warranty" statements
+ * are included with all reproductions and derivative works and associated
+ * documentation. This software may also be redistributed without charge
+ * provided that the copyright and "No Warranty" statements are included
+ * in all redistributions.
+ *
+ * NO WARRANTY. THIS SOFTWARE IS FURNISHED ON AN "AS IS" BASIS.
+ * CARNEGIE MELLON UNIVERSITY MAKES NO WARRANTIES OF ANY KIND, EITHER
+ * EXPRESSED OR IMPLIED AS TO THE MATTER INCLUDING, BUT NOT LIMITED
+ * TO: WARRANTY OF FITNESS FOR PURPOSE OR MERCHANTABILITY, EXCLUSIVITY
+ * OF RESULTS OR RESULTS OBTAINED FROM USE OF THIS SOFTWARE. CARNEGIE
+ * MELLON UNIVERSITY DOES NOT MAKE ANY WARRANTY OF ANY KIND WITH RESPECT
+ * TO FREEDOM FROM PATENT, TRADEMARK, OR COPYRIGHT INFRINGEMENT.
+ * COPYRIGHT HOLDERS WILL BEAR NO LIABILITY FOR ANY USE OF THIS SOFTWARE
+ * OR DOCUMENTATION.
+ *
+ */
+
+
+/***************************************************************************
+  A fast synthetic workload generator.  Unlike synthio, it does not run
+  through the process-flow simulator: each stream issues its requests
+  straight to the device driver (standalone, as for traces) and nothing
+  but the storage subsystem is modeled.
+
+	1. Each stream draws addresses, sizes and inter-arrival times from
+	   its own random number stream, "Batch size" requests at a time,
+	   so adding a stream does not change what the others generate.
+
+	2. Open-loop streams keep exactly one arrival on the event queue,
+	   as a NULL_EVENT like the next trace record; when it comes up,
+	   synthfast_request_arrive() turns it into the request and
+	   schedules the stream's next arrival.
+
+	3. Closed-loop streams ("Queue depth" > 0) start with that many
+	   requests and issue a new one "Think time" after each completion.
+	   The stream rides along in the request's buf.
+***************************************************************************/
+
+#include "disksim_synthfast.h"
+#include "modules/modules.h"
+
+#include <math.h>
+
+
+#define fastinfo	(disksim->synthfast_info)
+
+/* shortest mean burst, calm, on or off period accepted (ms) */
+#define SYNTHFAST_MIN_PERIOD	0.001
+
+
+/* Zipf ranks by rejection-inversion (Hoermann and Derflinger, "Rejection- */
+/* inversion to generate variates from monotone discrete distributions"), */
+/* which needs constant time and space however large the device is.       */
+
+static double synthfast_zipf_helper1 (double x)
+{
+   if (fabs(x) > 1e-8) {
+      return(log1p(x) / x);
+   }
+   return(1.0 - x * (0.5 - x * (1.0/3.0 - 0.25 * x)));
+}
+
+
+static double synthfast_zipf_helper2 (double x)
+{
+   if (fabs(x) > 1e-8) {
+      return(expm1(x) / x);
+   }
+   return(1.0 + x * 0.5 * (1.0 + x * (1.0/3.0) * (1.0 + 0.25 * x)));
+}
+
+
+static double synthfast_zipf_h (synthfast_stream *st, double x)
+{
+   return(exp(-st->addrparam[0] * log(x)));
+}
+
+
+static double synthfast_zipf_hint (synthfast_stream *st, double x)
+{
+   double logx = log(x);
+
+   return(synthfast_zipf_helper2((1.0 - st->addrparam[0]) * logx) * logx);
+}
+
+
+static double synthfast_zipf_hinv (synthfast_stream *st, double x)
+{
+   double t = x * (1.0 - st->addrparam[0]);
+
+   if (t < -1.0) {
+      t = -1.0;
+   }
+   return(exp(synthfast_zipf_helper1(t) * x));
+}
+
+
+static int synthfast_coprime (uint64_t a, uint64_t b)
+{
+   while (b) {
+      uint64_t t = a % b;
+      a = b;
+      b = t;
+   }
+   return(a == 1);
+}
+
+
+static void synthfast_zipf_setup (synthfast_stream *st)
+{
+   uint64_t n = st->blksperdisk;
+
+   st->zipf_hx1 = synthfast_zipf_hint(st, 1.5) - 1.0;
+   st->zipf_hxn = synthfast_zipf_hint(st, (double) n + 0.5);
+   st->zipf_s = 2.0 - synthfast_zipf_hinv(st, synthfast_zipf_hint(st, 2.5) - synthfast_zipf_h(st, 2.0));
+
+   /* any multiplier coprime to n permutes the ranks over the device */
+   st->zipf_mult = 0x9e3779b1ULL % n;
+   while ((n > 1) && ((st->zipf_mult == 0) || (!synthfast_coprime(n, st->zipf_mult)))) {
+      st->zipf_mult = (st->zipf_mult + 1) % n;
+   }
+}
+
+
+/* returns a rank in [0,blksperdisk), 0 being the most popular */
+
+static int synthfast_zipf (synthfast_stream *st)
+{
+   double u, x;
+   int k;
+
+   for (;;) {
+      u = st->zipf_hxn + disksim_rng_uniform(&st->rng) * (st->zipf_hx1 - st->zipf_hxn);
+      x = synthfast_zipf_hinv(st, u);
+      k = (int) (x + 0.5);
+      if (k < 1) {
+         k = 1;
+      } else if (k > st->blksperdisk) {
+         k = st->blksperdisk;
+      }
+      if (((k - x) <= st->zipf_s) ||
+          (u >= (synthfast_zipf_hint(st, k + 0.5) - synthfast_zipf_h(st, k)))) {
+         return(k - 1);
+      }
+   }
+}
+
+
+static int synthfast_next_blkno (synthfast_stream *st, int bcount)
+{
+   int maxblk = st->blksperdisk - bcount;
+   int blkno;
+   double u;
+
+   switch (st->addrtype) {
+      case SYNTHFAST_ADDR_SEQUENTIAL:
+         blkno = st->lastblkno + st->lastbcount;
+         if (blkno > maxblk) {
+            blkno = 0;
+         }
+         break;
+      case SYNTHFAST_ADDR_ZIPF:
+         blkno = (int) (((uint64_t) synthfast_zipf(st) * st->zipf_mult) % st->blksperdisk);
+         break;
+      case SYNTHFAST_ADDR_HOTSPOT:
+         u = disksim_rng_uniform(&st->rng);
+         if ((disksim_rng_uniform(&st->rng) < st->addrparam[1]) || (st->hotblks >= st->blksperdisk)) {
+            blkno = (int) (u * st->hotblks);
+         } else {
+            blkno = st->hotblks + (int) (u * (st->blksperdisk - st->hotblks));
+         }
+         break;
+      default:
+         blkno = (int) (disksim_rng_uniform(&st->rng) * st->blksperdisk);
+         break;
+   }
+   if (blkno > maxblk) {
+      blkno = maxblk;
+   }
+   st->lastblkno = blkno;
+   st->lastbcount = bcount;
+   return(blkno);
+}
+
+
+static double synthfast_exponential (synthfast_stream *st, double mean)
+{
+   return(-mean * log(1.0 - disksim_rng_uniform(&st->rng)));
+}
+
+
+/* time from the stream's previous arrival to its next one */
+
+static double synthfast_next_gap (synthfast_stream *st)
+{
+   double gap = 0.0;
+   double t;
+
+   switch (st->arrivetype) {
+      case SYNTHFAST_ARRIVE_CONSTANT:
+         return(1000.0 / st->rate);
+      case SYNTHFAST_ARRIVE_POISSON:
+         return(synthfast_exponential(st, 1000.0 / st->rate));
+   }
+
+   /* modulated: exponential gaps are memoryless, so one that runs past */
+   /* the end of the current state is simply redrawn in the next one    */
+   for (;;) {
+      if (st->staterate[st->state] > 0.0) {
+         t = synthfast_exponential(st, 1.0 / st->staterate[st->state]);
+         if (t < st->stateleft) {
+            st->stateleft -= t;
+            return(gap + t);
+         }
+      }
+      gap += st->stateleft;
+      st->state ^= 1;
+      st->stateleft = synthfast_exponential(st, st->statelen[st->state]);
+   }
+}
+
+
+static void synthfast_fill_batch (synthfast_stream *st)
+{
+   synthfast_req *req;
+   int bcount;
+   int i;
+
+   for (i = 0; i < st->batchlen; i++) {
+      req = &st->batch[i];
+      req->gap = (st->queuedepth) ? st->thinktime : synthfast_next_gap(st);
+      req->devno = st->devno[0];
+      if (st->numdisks > 1) {
+         req->devno = st->devno[(int) (disksim_rng_uniform(&st->rng) * st->numdisks)];
+      }
+      bcount = ((int) synthio_getrand(&st->sizedist, &st->rng) + st->blocksize - 1) / st->blocksize;
+      if (bcount <= 0) {
+         bcount = 1;
+      } else if (bcount > st->maxsize) {
+         bcount = st->maxsize;
+      }
+      req->bcount = bcount;
+      req->blkno = synthfast_next_blkno(st, bcount);
+      req->flags = (disksim_rng_uniform(&st->rng) < st->probread) ? READ : WRITE;
+   }
+   st->batchpos = 0;
+}
+
+
+static void synthfast_issue (synthfast_stream *st, double time)
+{
+   ioreq_event *new;
+   synthfast_req *req;
+
+   if (st->batchpos == st->batchlen) {
+      synthfast_fill_batch(st);
+   }
+   req = &st->batch[st->batchpos++];
+
+   new = (ioreq_event *) getfromextraq();
+   new->type = NULL_EVENT;
+   new->time = time + req->gap;
+   new->devno = req->devno;
+   new->blkno = req->blkno * st->blocksize;
+   new->bcount = req->bcount * st->blocksize;
+   new->flags = req->flags;
+   new->busno = 0;
+   new->cause = st->number;
+   new->opid = fastinfo->opid++;
+   new->buf = st;
+   addtointq((event *) new);
+
+   st->nexttime = new->time;
+}
+
+
+void synthfast_initialize (void)
+{
+   synthfast_stream *st;
+   int i, j;
+
+   fastinfo->iocnt = 0;
+   fastinfo->opid = 0;
+
+   for (i = 0; i < fastinfo->numstreams; i++) {
+      st = fastinfo->streams[i];
+      disksim_rng_init_kind(&st->rng, DISKSIM_RNG_XOSHIRO, "synthfast", i);
+
+      if (st->addrtype == SYNTHFAST_ADDR_ZIPF) {
+         synthfast_zipf_setup(st);
+      } else if (st->addrtype == SYNTHFAST_ADDR_HOTSPOT) {
+         st->hotblks = (int) (st->addrparam[0] * st->blksperdisk);
+         if (st->hotblks < 1) {
+            st->hotblks = 1;
+         }
+      }
+      st->lastblkno = 0;
+      st->lastbcount = 0;
+
+      /* start in each state in proportion to the time spent there */
+      st->state = (disksim_rng_uniform(&st->rng) * (st->statelen[0] + st->statelen[1]) >= st->statelen[0]);
+      st->stateleft = synthfast_exponential(st, st->statelen[st->state]);
+
+      if (st->batch == NULL) {
+         st->batch = DISKSIM_malloc(fastinfo->batchsize * sizeof(synthfast_req));
+      }
+      st->batchlen = fastinfo->batchsize;
+      st->batchpos = st->batchlen;
+
+      if (st->queuedepth) {
+         for (j = 0; j < st->queuedepth; j++) {
+            synthfast_issue(st, 0.0);
+         }
+      } else {
+         synthfast_issue(st, 0.0);
+      }
+   }
+   synthfast_resetstats();
+
+   fprintf (outputfile, "Initialized %d synthetic streams\n", fastinfo->numstreams);
+}
+
+
+/* curr, a NULL_EVENT from synthfast_issue, is now due */
+
+void synthfast_request_arrive (ioreq_event *curr)
+{
+   synthfast_stream *st = (synthfast_stream *) curr->buf;
+
+   curr->type = IO_REQUEST_ARRIVE;
+
+   st->reqs++;
+   st->sectors += curr->bcount;
+   if (curr->flags & READ) {
+      st->reads++;
+   }
+
+   fastinfo->iocnt++;
+   if ((simtime >= fastinfo->endtime) || (fastinfo->iocnt >= fastinfo->endiocnt)) {
+      disksim_simstop();
+      return;
+   }
+   if (st->queuedepth == 0) {
+      synthfast_issue(st, st->nexttime);
+   }
+}
+
+
+void synthfast_io_done_notify (ioreq_event *curr)
+{
+   synthfast_stream *st = (synthfast_stream *) curr->buf;
+
+   if ((st) && (st->queuedepth) && (!disksim->stop_sim)) {
+      synthfast_issue(st, simtime);
+   }
+}
+
+
+void synthfast_resetstats (void)
+{
+   int i;
+
+   for (i = 0; i < fastinfo->numstreams; i++) {
+      fastinfo->streams[i]->reqs = 0;
+      fastinfo->streams[i]->reads = 0;
+      fastinfo->streams[i]->sectors = 0.0;
+   }
+   fastinfo->statstart = simtime;
+}
+
+
+void synthfast_cleanstats (void)
+{
+}
+
+
+void synthfast_printstats (void)
+{
+   synthfast_stream *st;
+   double elapsed = simtime - fastinfo->statstart;
+   int i;
+
+   fprintf (outputfile, "\nSYNTHETIC STREAM STATISTICS\n");
+   fprintf (outputfile, "---------------------------\n\n");
+
+   for (i = 0; i < fastinfo->numstreams; i++) {
+      st = fastinfo->streams[i];
+      fprintf (outputfile, "Stream #%d requests:      \t%d\n", i, st->reqs);
+      fprintf (outputfile, "Stream #%d read fraction: \t%f\n", i,
+               (st->reqs) ? ((double) st->reads / (double) st->reqs) : 0.0);
+      fprintf (outputfile, "Stream #%d average size:  \t%f\n", i,
+               (st->reqs) ? (st->sectors / (double) st->reqs) : 0.0);
+      fprintf (outputfile, "Stream #%d request rate:  \t%f\n", i,
+               (elapsed > 0.0) ? ((double) st->reqs * 1000.0 / elapsed) : 0.0);
+   }
+}
+
+
+int disksim_synthfast_loadparams (struct lp_block *b)
+{
+   if (!disksim->synthfast_info) {
+      disksim->synthfast_info = DISKSIM_malloc (sizeof(synthfast_info_t));
+      bzero ((char *)disksim->synthfast_info, sizeof(synthfast_info_t));
+      fastinfo->batchsize = 64;
+   }
+
+   lp_loadparams(0, b, &disksim_synthfast_mod);
+
+   return 1;
+}
+
+
+/* this is a dummy that should never be called */
+int disksim_synthstream_loadparams (struct lp_block *b)
+{
+   ddbg_assert2(0, "this is a dummy that isn't supposed to be called");
+   return 0;
+}
+
+
+/* Converts the burst/calm (on/off) shape into per-state rates that */
+/* keep the long-run rate at "Request rate".                         */
+
+static void synthfast_set_state_rates (synthfast_stream *st)
+{
+   double m = st->arriveparam[0];
+   double rate = st->rate / 1000.0;
+   double tb, tc;
+
+   switch (st->arrivetype) {
+      case SYNTHFAST_ARRIVE_MMPP:
+         tb = st->arriveparam[1];
+         tc = st->arriveparam[2];
+         st->statelen[0] = tc;
+         st->statelen[1] = tb;
+         st->staterate[0] = rate * (tb + tc) / ((m * tb) + tc);
+         st->staterate[1] = m * st->staterate[0];
+         break;
+      case SYNTHFAST_ARRIVE_ONOFF:
+         st->statelen[0] = st->arriveparam[1];
+         st->statelen[1] = st->arriveparam[0];
+         st->staterate[0] = 0.0;
+         st->staterate[1] = rate * (st->statelen[0] + st->statelen[1]) / st->statelen[1];
+         break;
+   }
+}
+
+
+static void synthfast_load_stream (struct lp_block *b, synthfast_stream **result)
+{
+   (*result) = malloc(sizeof(synthfast_stream));
+   bzero((*result), sizeof(synthfast_stream));
+
+   lp_loadparams(result, b, &disksim_synthstream_mod);
+
+   (*result)->blksperdisk = (*result)->sectsperdisk / (*result)->blocksize;
+   if ((*result)->blksperdisk < 1) {
+      fprintf(stderr, "*** error: synthstream blocking factor is larger than its devices\n");
+      exit(1);
+   }
+   /* from here on in blocks */
+   (*result)->maxsize /= (*result)->blocksize;
+   if (((*result)->maxsize < 1) || ((*result)->maxsize > (*result)->blksperdisk)) {
+      (*result)->maxsize = (*result)->blksperdisk;
+   }
+   if (((*result)->queuedepth == 0) && ((*result)->rate <= 0.0)) {
+      fprintf(stderr, "*** error: an open-loop synthstream needs a request rate\n");
+      exit(1);
+   }
+   synthfast_set_state_rates(*result);
+}
+
+
+int synthfast_load_streams (struct lp_list *l)
+{
+   int c;
+   int slot = 0;
+
+   if (fastinfo->streams) {
+      fprintf(stderr, "*** error: tried to redefine synthetic streams.\n");
+      exit(1);
+   }
+
+   fastinfo->streams = malloc(l->values_len * sizeof(synthfast_stream *));
+   bzero(fastinfo->streams, l->values_len * sizeof(synthfast_stream *));
+
+   for (c = 0; c < l->values_len; c++) {
+      if (!l->values[c]) continue;
+
+      if (l->values[c]->t != BLOCK) {
+         fprintf(stderr, "*** error: bad synthetic stream spec -- must be a block.\n");
+         exit(1);
+      }
+      synthfast_load_stream(l->values[c]->v.b, &fastinfo->streams[slot]);
+      fastinfo->streams[slot]->number = slot;
+      slot++;
+   }
+
+   fastinfo->numstreams = slot;
+   return 0;
+}
+
+
+/* reads the numeric list items 1..cnt into vals */
+
+static int synthfast_load_numbers (struct lp_list *l, double *vals, int cnt)
+{
+   int c;
+
+   if (l->values_len < (cnt + 1)) {
+      return -1;
+   }
+   for (c = 1; c <= cnt; c++) {
+      if ((!l->values[c]) || ((l->values[c]->t != D) && (l->values[c]->t != I))) {
+         return -1;
+      }
+      vals[c-1] = (l->values[c]->t == D) ? l->values[c]->v.d : (double) l->values[c]->v.i;
+   }
+   return 0;
+}
+
+
+int synthfast_load_addresses (struct lp_list *l, synthfast_stream *st)
+{
+   char *type;
+
+   if ((!l->values_len) || (!l->values[0]) || (l->values[0]->t != S)) {
+      fprintf(stderr, "*** error: synthstream addresses must start with a distribution name\n");
+      exit(1);
+   }
+   type = l->values[0]->v.s;
+
+   if (!strcmp(type, "uniform")) {
+      st->addrtype = SYNTHFAST_ADDR_UNIFORM;
+   } else if (!strcmp(type, "sequential")) {
+      st->addrtype = SYNTHFAST_ADDR_SEQUENTIAL;
+   } else if (!strcmp(type, "zipf")) {
+      st->addrtype = SYNTHFAST_ADDR_ZIPF;
+      if ((synthfast_load_numbers(l, st->addrparam, 1)) || (st->addrparam[0] <= 0.0)) {
+         fprintf(stderr, "*** error: zipf addresses take a positive exponent\n");
+         exit(1);
+      }
+   } else if (!strcmp(type, "hotspot")) {
+      st->addrtype = SYNTHFAST_ADDR_HOTSPOT;
+      if ((synthfast_load_numbers(l, st->addrparam, 2)) ||
+          (!RANGE(st->addrparam[0],0.0,1.0)) || (!RANGE(st->addrparam[1],0.0,1.0))) {
+         fprintf(stderr, "*** error: hotspot addresses take a hot fraction and a probability\n");
+         exit(1);
+      }
+   } else {
+      fprintf(stderr, "*** error: unknown address distribution: %s\n", type);
+      exit(1);
+   }
+   return 0;
+}
+
+
+int synthfast_load_arrivals (struct lp_list *l, synthfast_stream *st)
+{
+   char *type;
+
+   if ((!l->values_len) || (!l->values[0]) || (l->values[0]->t != S)) {
+      fprintf(stderr, "*** error: synthstream arrival process must start with a name\n");
+      exit(1);
+   }
+   type = l->values[0]->v.s;
+
+   if (!strcmp(type, "poisson")) {
+      st->arrivetype = SYNTHFAST_ARRIVE_POISSON;
+   } else if (!strcmp(type, "constant")) {
+      st->arrivetype = SYNTHFAST_ARRIVE_CONSTANT;
+   } else if (!strcmp(type, "mmpp")) {
+      st->arrivetype = SYNTHFAST_ARRIVE_MMPP;
+      if ((synthfast_load_numbers(l, st->arriveparam, 3)) || (st->arriveparam[0] < 1.0) ||
+          (st->arriveparam[1] < SYNTHFAST_MIN_PERIOD) || (st->arriveparam[2] < SYNTHFAST_MIN_PERIOD)) {
+         fprintf(stderr, "*** error: mmpp arrivals take a burst rate multiplier (>= 1) and mean burst and calm times\n");
+         exit(1);
+      }
+   } else if (!strcmp(type, "onoff")) {
+      st->arrivetype = SYNTHFAST_ARRIVE_ONOFF;
+      if ((synthfast_load_numbers(l, st->arriveparam, 2)) ||
+          (st->arriveparam[0] < SYNTHFAST_MIN_PERIOD) || (st->arriveparam[1] < SYNTHFAST_MIN_PERIOD)) {
+         fprintf(stderr, "*** error: onoff arrivals take mean on and off times\n");
+         exit(1);
+      }
+   } else {
+      fprintf(stderr, "*** error: unknown arrival process: %s\n", type);
+      exit(1);
+   }
+   return 0;
+}
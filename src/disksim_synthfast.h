@@ -0,0 +1,133 @@
+/*
+ * DiskSim Storage Subsystem Simulation Environment (Version 4.0)
+ * Revision Authors: John Bucy, Greg Ganger
+ * Contributors: John Griffin, Jiri Schindler, Steve Schlosser
+ *
+ * Copyright (c) of Carnegie Mellon University, 2001-2008.
+ *
+ * This software is being provided by the copyright holders under the
+ * following license. By obtaining, using and/or copying this software,
+ * you agree that you have read, understood, and will comply with the
+ * following terms and conditions:
+ *
+ * Permission to reproduce, use, and prepare derivative works of this
+ * software is granted provided the copyright and "No Warranty" statements
+ * are included with all reproductions and derivative works and associated
+ * documentation. This software may also be redistributed without charge
+ * provided that the copyright and "No Warranty" statements are included
+ * in all redistributions.
+ *
+ * NO WARRANTY. THIS SOFTWARE IS FURNISHED ON AN "AS IS" BASIS.
+ * CARNEGIE MELLON UNIVERSITY MAKES NO WARRANTIES OF ANY KIND, EITHER
+ * EXPRESSED OR IMPLIED AS TO THE MATTER INCLUDING, BUT NOT LIMITED
+ * TO: WARRANTY OF FITNESS FOR PURPOSE OR MERCHANTABILITY, EXCLUSIVITY
+ * OF RESULTS OR RESULTS OBTAINED FROM USE OF THIS SOFTWARE. CARNEGIE
+ * MELLON UNIVERSITY DOES NOT MAKE ANY WARRANTY OF ANY KIND WITH RESPECT
+ * TO FREEDOM FROM PATENT, TRADEMARK, OR COPYRIGHT INFRINGEMENT.
+ * COPYRIGHT HOLDERS WILL BEAR NO LIABILITY FOR ANY USE OF THIS SOFTWARE
+ * OR DOCUMENTATION.
+ *
+ */
+
+
+#ifndef DISKSIM_SYNTHFAST_H
+#define DISKSIM_SYNTHFAST_H
+
+#include "disksim_global.h"
+#include "disksim_iosim.h"
+#include "disksim_synthio.h"
+
+/* address distributions */
+#define SYNTHFAST_ADDR_UNIFORM		0
+#define SYNTHFAST_ADDR_SEQUENTIAL	1
+#define SYNTHFAST_ADDR_ZIPF		2
+#define SYNTHFAST_ADDR_HOTSPOT		3
+
+/* arrival processes (open loop) */
+#define SYNTHFAST_ARRIVE_POISSON	0
+#define SYNTHFAST_ARRIVE_CONSTANT	1
+#define SYNTHFAST_ARRIVE_MMPP		2
+#define SYNTHFAST_ARRIVE_ONOFF		3
+
+
+/* one pre-generated request */
+typedef struct synthfast_req {
+   double gap;		/* since the stream's previous arrival */
+   int    devno;
+   int    blkno;
+   int    bcount;
+   int    flags;
+} synthfast_req;
+
+
+typedef struct synthfast_stream {
+   int            number;
+   int            numdisks;
+   int           *devno;
+   int            sectsperdisk;
+   int            blksperdisk;
+   int            blocksize;
+   double         probread;
+   synthio_distr  sizedist;
+   int            maxsize;
+   disksim_rng    rng;
+
+   int            addrtype;
+   double         addrparam[2];
+   int            hotblks;
+   double         zipf_hx1;	/* rejection-inversion constants */
+   double         zipf_hxn;
+   double         zipf_s;
+   uint64_t       zipf_mult;	/* scatters ranks over the device */
+   int            lastblkno;
+   int            lastbcount;
+
+   double         rate;		/* requests per second */
+   int            arrivetype;
+   double         arriveparam[3];
+   double         staterate[2];	/* per ms; state 0 is the calm/off one */
+   double         statelen[2];	/* mean ms in each state */
+   int            state;
+   double         stateleft;
+   int            queuedepth;	/* closed loop if non-zero */
+   double         thinktime;
+
+   synthfast_req *batch;
+   int            batchlen;
+   int            batchpos;
+   double         nexttime;
+
+   int            reqs;
+   int            reads;
+   double         sectors;
+} synthfast_stream;
+
+
+typedef struct synthfast_info {
+   synthfast_stream **streams;
+   int    numstreams;
+   int    batchsize;
+   int    iocnt;
+   int    endiocnt;
+   double endtime;
+   int    opid;
+   double statstart;
+} synthfast_info_t;
+
+
+/* functions exported by disksim_synthfast.c */
+
+void   synthfast_initialize (void);
+void   synthfast_request_arrive (ioreq_event *curr);
+void   synthfast_io_done_notify (ioreq_event *curr);
+void   synthfast_resetstats (void);
+void   synthfast_cleanstats (void);
+void   synthfast_printstats (void);
+
+struct lp_list;
+int    synthfast_load_streams (struct lp_list *l);
+int    synthfast_load_addresses (struct lp_list *l, synthfast_stream *st);
+int    synthfast_load_arrivals (struct lp_list *l, synthfast_stream *st);
+
+
+#endif    /* DISKSIM_SYNTHFAST_H */
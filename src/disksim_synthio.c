@@ -107,41 +107,47 @@
 #define SYNTHIO_EXPONENTIAL	2
 #define SYNTHIO_POISSON		3
 #define SYNTHIO_TWOVALUE	4
+#define SYNTHIO_PARETO		5
+#define SYNTHIO_LOGNORMAL	6
 
+#ifndef M_PI
+#define M_PI		3.14159265358979323846
+#endif
 
-static double synthio_get_uniform (synthio_distr *fromdistr)
+
+static double synthio_get_uniform (synthio_distr *fromdistr, disksim_rng *rng)
 {
-   return(((fromdistr->var - fromdistr->base) * DISKSIM_drand48()) + fromdistr->base);
+   return(((fromdistr->var - fromdistr->base) * disksim_rng_uniform(rng)) + fromdistr->base);
 }
 
 
-static double synthio_get_normal (synthio_distr *fromdistr)
+static double synthio_get_normal (synthio_distr *fromdistr, disksim_rng *rng)
 {
    double y1, y2;
    double y = 0;
 
    while (y <= 0.0) {
-      y2 = - log((double) 1.0 - DISKSIM_drand48());
-      y1 = - log((double) 1.0 - DISKSIM_drand48());
+      y2 = - log((double) 1.0 - disksim_rng_uniform(rng));
+      y1 = - log((double) 1.0 - disksim_rng_uniform(rng));
       y = y2 - ((y1 - (double) 1.0) * (y1 - (double) 1.0)) / 2;
    }
-   if (DISKSIM_drand48() < 0.5) {
+   if (disksim_rng_uniform(rng) < 0.5) {
       y1 = -y1;
    }
    return((fromdistr->var * y1) + fromdistr->mean);
 }
 
 
-static double synthio_get_exponential (synthio_distr *fromdistr)
+static double synthio_get_exponential (synthio_distr *fromdistr, disksim_rng *rng)
 {
    double dtmp;
 
-   dtmp = log((double) 1.0 - DISKSIM_drand48());
+   dtmp = log((double) 1.0 - disksim_rng_uniform(rng));
    return((fromdistr->base - (fromdistr->mean * dtmp)));
 }
 
 
-static double synthio_get_poisson (synthio_distr *fromdistr)
+static double synthio_get_poisson (synthio_distr *fromdistr, disksim_rng *rng)
 {
    double dtmp = 1.0;
    int count = 0;
@@ -149,7 +155,7 @@ static double synthio_get_poisson (synthio_distr *fromdistr)
 
    stop = exp(-fromdistr->mean);
    while (dtmp >= stop) {
-      dtmp *= DISKSIM_drand48();
+      dtmp *= disksim_rng_uniform(rng);
       count++;
    }
    count--;
@@ -157,9 +163,9 @@ static double synthio_get_poisson (synthio_distr *fromdistr)
 }
 
 
-static double synthio_get_twovalue (synthio_distr *fromdistr)
+static double synthio_get_twovalue (synthio_distr *fromdistr, disksim_rng *rng)
 {
-   if (DISKSIM_drand48() < fromdistr->var) {
+   if (disksim_rng_uniform(rng) < fromdistr->var) {
       return(fromdistr->mean);
    } else {
       return(fromdistr->base);
@@ -167,19 +173,44 @@ static double synthio_get_twovalue (synthio_distr *fromdistr)
 }
 
 
-static double synthio_getrand (synthio_distr *fromdistr)
+/* base is the minimum value, var the shape (alpha) */
+
+static double synthio_get_pareto (synthio_distr *fromdistr, disksim_rng *rng)
+{
+   return(fromdistr->base / pow((double) 1.0 - disksim_rng_uniform(rng), (double) 1.0 / fromdistr->var));
+}
+
+
+/* base and var are mu and sigma of the underlying normal, precomputed */
+/* by loaddistn from the requested mean and standard deviation         */
+
+static double synthio_get_lognormal (synthio_distr *fromdistr, disksim_rng *rng)
+{
+   double u1 = (double) 1.0 - disksim_rng_uniform(rng);
+   double u2 = disksim_rng_uniform(rng);
+   double z = sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+
+   return(exp(fromdistr->base + (fromdistr->var * z)));
+}
+
+
+double synthio_getrand (synthio_distr *fromdistr, disksim_rng *rng)
 {
    switch (fromdistr->type) {
       case SYNTHIO_UNIFORM:
-	                return(synthio_get_uniform(fromdistr));
+	                return(synthio_get_uniform(fromdistr, rng));
       case SYNTHIO_NORMAL:
-                        return(synthio_get_normal(fromdistr));
+                        return(synthio_get_normal(fromdistr, rng));
       case SYNTHIO_EXPONENTIAL:
-			return(synthio_get_exponential(fromdistr));
+			return(synthio_get_exponential(fromdistr, rng));
       case SYNTHIO_POISSON:
-			return(synthio_get_poisson(fromdistr));
+			return(synthio_get_poisson(fromdistr, rng));
       case SYNTHIO_TWOVALUE:
-			return(synthio_get_twovalue(fromdistr));
+			return(synthio_get_twovalue(fromdistr, rng));
+      case SYNTHIO_PARETO:
+			return(synthio_get_pareto(fromdistr, rng));
+      case SYNTHIO_LOGNORMAL:
+			return(synthio_get_lognormal(fromdistr, rng));
       default:
 	                fprintf(stderr, "Unrecognized distribution type - %d\n", fromdistr->type);
 	                exit(1);
@@ -246,7 +277,7 @@ static void synthio_appendio (process *procp, ioreq_event *tmp)
 	new->next = (ioreq_event *) procp->eventlist;
 	newsleep->time = -1.0;
 	while (newsleep->time < 0.0) {
-	  newsleep->time = synthio_getrand (&gen->tmlimit);
+	  newsleep->time = synthio_getrand(&gen->tmlimit, &gen->rng);
 	}
 	newsleep->time += new->time;
 	limittmp = gen->limits;
@@ -320,23 +351,24 @@ void synthio_initialize_generator (process *procp)
       fprintf(stderr, "Process with no synthetic generator in synthio_initialize\n");
       exit(1);
    }
+   disksim_rng_init(&gen->rng, "synthio", gen->number);
    tmp = (ioreq_event *) getfromextraq();
    tmp->time = -1.0;
    while (tmp->time < 0.0) {
-      tmp->time = synthio_getrand(&gen->genintr);
+      tmp->time = synthio_getrand(&gen->genintr, &gen->rng);
    }
    tmp->flags = 0;
    tmp->cause = gen->number;
-   tmp->devno = gen->devno[(int) (DISKSIM_drand48() * (double) gen->numdisks)];
+   tmp->devno = gen->devno[(int) (disksim_rng_uniform(&gen->rng) * (double) gen->numdisks)];
    tmp->blkno = tmp->bcount = gen->blksperdisk;
    while (((tmp->blkno + tmp->bcount) >= gen->blksperdisk) || (tmp->bcount == 0)) {
-      tmp->blkno = (int) (DISKSIM_drand48() * (double) gen->blksperdisk);
-      tmp->bcount = ((int) synthio_getrand(&gen->sizedist) + gen->blocksize - 1) / gen->blocksize;
+      tmp->blkno = (int) (disksim_rng_uniform(&gen->rng) * (double) gen->blksperdisk);
+      tmp->bcount = ((int) synthio_getrand(&gen->sizedist, &gen->rng) + gen->blocksize - 1) / gen->blocksize;
    }
-   if (DISKSIM_drand48() < gen->probread) {
+   if (disksim_rng_uniform(&gen->rng) < gen->probread) {
       tmp->flags |= READ;
    }
-   reqclass = DISKSIM_drand48() - gen->probtmcrit;
+   reqclass = disksim_rng_uniform(&gen->rng) - gen->probtmcrit;
    if (reqclass < 0.0) {
       tmp->flags |= TIME_CRITICAL;
    } else if (reqclass < gen->probtmlim) {
@@ -376,7 +408,7 @@ static int synthio_generatenextio (synthio_generator *gen)
       return 1;
    }
 
-   type = DISKSIM_drand48();
+   type = disksim_rng_uniform(&gen->rng);
 
    if ((type < gen->probseq) && 
        ((tmp->blkno + 2*tmp->bcount) < gen->blksperdisk)) {
@@ -384,7 +416,7 @@ static int synthio_generatenextio (synthio_generator *gen)
      tmp->time = -1.0;
 
      while (tmp->time < 0.0) {
-       tmp->time = synthio_getrand(&gen->seqintr);
+       tmp->time = synthio_getrand(&gen->seqintr, &gen->rng);
      }
 
      tmp->flags = SEQ | (tmp->flags & READ);
@@ -396,7 +428,7 @@ static int synthio_generatenextio (synthio_generator *gen)
 
      tmp->time = -1.0;
      while (tmp->time < 0.0) {
-       tmp->time = synthio_getrand(&gen->locintr);
+       tmp->time = synthio_getrand(&gen->locintr, &gen->rng);
      }
      tmp->flags = LOCAL;
      tmp->cause = gen->number;
@@ -406,39 +438,39 @@ static int synthio_generatenextio (synthio_generator *gen)
 	    || (tmp->bcount <= 0)) 
        {
 	 blkno = tmp->blkno + 
-	   (int)synthio_getrand(&gen->locdist) / gen->blocksize;
-	 tmp->bcount = ((int) synthio_getrand(&gen->sizedist) + 
+	   (int)synthio_getrand(&gen->locdist, &gen->rng) / gen->blocksize;
+	 tmp->bcount = ((int) synthio_getrand(&gen->sizedist, &gen->rng) + 
 			gen->blocksize - 1) / gen->blocksize;
        }
      tmp->blkno = blkno;
-     if (DISKSIM_drand48() < gen->probread) {
+     if (disksim_rng_uniform(&gen->rng) < gen->probread) {
        tmp->flags |= READ;
      }
    } 
    else {
       tmp->time = -1.0;
       while (tmp->time < 0.0) {
-	tmp->time = synthio_getrand(&gen->genintr);
+	tmp->time = synthio_getrand(&gen->genintr, &gen->rng);
       }
       tmp->flags = 0;
       tmp->cause = gen->number;
-      tmp->devno = gen->devno[(int)(DISKSIM_drand48() * 
+      tmp->devno = gen->devno[(int)(disksim_rng_uniform(&gen->rng) * 
 				    (double)gen->numdisks)];
 
       tmp->blkno = tmp->bcount = gen->blksperdisk;
       while (((tmp->blkno + tmp->bcount) >= gen->blksperdisk) || 
 	     (tmp->bcount <= 0)) {
 
-	tmp->blkno = (int) (DISKSIM_drand48() * (double)gen->blksperdisk);
-	tmp->bcount = ((int) synthio_getrand(&gen->sizedist) + 
+	tmp->blkno = (int) (disksim_rng_uniform(&gen->rng) * (double)gen->blksperdisk);
+	tmp->bcount = ((int) synthio_getrand(&gen->sizedist, &gen->rng) + 
 		       gen->blocksize - 1) / gen->blocksize;
       }
 
-      if (DISKSIM_drand48() < gen->probread) {
+      if (disksim_rng_uniform(&gen->rng) < gen->probread) {
 	tmp->flags = READ;
       }
    }
-   reqclass = DISKSIM_drand48() - gen->probtmcrit;
+   reqclass = disksim_rng_uniform(&gen->rng) - gen->probtmcrit;
 
    if (reqclass < 0.0) {
      tmp->flags |= TIME_CRITICAL;
@@ -755,12 +787,14 @@ static char *distnames[] = {
   "normal",
   "exponential",
   "poisson",
-  "twovalue"
+  "twovalue",
+  "pareto",
+  "lognormal"
 };
 
 static int distname(char *name) {
   int c;
-  for(c = SYNTHIO_UNIFORM; c <= SYNTHIO_TWOVALUE; c++) {
+  for(c = SYNTHIO_UNIFORM; c <= SYNTHIO_LOGNORMAL; c++) {
     if(!strcmp(name, distnames[c])) return c;
   }
   return -1;
@@ -851,6 +885,40 @@ int loaddistn(struct lp_list *l, struct dist *result) {
     }
     break;
 
+  case SYNTHIO_PARETO:
+    if((l->values_len < 3) || !l->values[1] || !l->values[2]
+       || (l->values[1]->t != D) || (l->values[2]->t != D)) {
+      fprintf(stderr, "*** error: pareto takes a minimum and a shape\n");
+      return -1;
+    }
+
+    result->base = l->values[1]->v.d;
+    result->var = l->values[2]->v.d;
+    if((result->base <= 0.0) || (result->var <= 0.0)) {
+      fprintf(stderr, "*** error: pareto minimum and shape must be positive\n");
+      return -1;
+    }
+    break;
+
+  case SYNTHIO_LOGNORMAL:
+    if((l->values_len < 3) || !l->values[1] || !l->values[2]
+       || (l->values[1]->t != D) || (l->values[2]->t != D)) {
+      fprintf(stderr, "*** error: lognormal takes a mean and a standard deviation\n");
+      return -1;
+    }
+
+    result->mean = l->values[1]->v.d;
+    if((result->mean <= 0.0) || (l->values[2]->v.d < 0.0)) {
+      fprintf(stderr, "*** error: lognormal mean must be positive\n");
+      return -1;
+    }
+    // mu and sigma of the underlying normal
+    result->var = log(1.0 + (l->values[2]->v.d * l->values[2]->v.d)
+		      / (result->mean * result->mean));
+    result->base = log(result->mean) - (result->var / 2.0);
+    result->var = sqrt(result->var);
+    break;
+
   default:
     fprintf(stderr, "*** error: unknown distribution: %s\n", type);
     return -1;
@@ -885,16 +953,17 @@ static int loadgen(struct lp_block *b, synthio_generator **result) {
 
 
 
+/* shared with the fast generator's streams */
 int 
-loadsynthdevs(synthio_generator *result, struct lp_list *l)
+synthio_load_devices(struct lp_list *l, int **devno, int *numdisks)
 {
   int c;
   int num, type;
   char *name;
   int slot = 0;
 
-  result->devno = malloc(l->values_len * sizeof(int));
-  bzero(result->devno, l->values_len * sizeof(int));
+  (*devno) = malloc(l->values_len * sizeof(int));
+  bzero((*devno), l->values_len * sizeof(int));
   
   for(c = 0; c < l->values_len; c++) {
     if(!l->values[c]) continue;
@@ -911,11 +980,18 @@ loadsynthdevs(synthio_generator *result, struct lp_list *l)
       }
     }
 
-    result->devno[slot++] = num;
+    (*devno)[slot++] = num;
   }
 
 
-  result->numdisks = slot;
+  (*numdisks) = slot;
 
   return 0;
 }
+
+
+int 
+loadsynthdevs(synthio_generator *result, struct lp_list *l)
+{
+  return synthio_load_devices(l, &result->devno, &result->numdisks);
+}
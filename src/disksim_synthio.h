@@ -130,6 +130,11 @@ typedef struct dist {
 } synthio_distr;
 
 
+double synthio_getrand (synthio_distr *fromdistr, disksim_rng *rng);
+int    loaddistn (struct lp_list *l, struct dist *result);
+int    synthio_load_devices (struct lp_list *l, int **devno, int *numdisks);
+
+
 typedef struct gen {
    FILE          *tracefile;
    double         probseq;
@@ -152,6 +157,7 @@ typedef struct gen {
    synthio_distr  locintr;
    synthio_distr  locdist;
    synthio_distr  sizedist;
+   disksim_rng    rng;
 } synthio_generator;
 
 
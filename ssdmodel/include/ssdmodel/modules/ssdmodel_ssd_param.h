@@ -42,10 +42,25 @@ typedef enum {
    SSDMODEL_SSD_ELEMENTS_PER_GANG,
    SSDMODEL_SSD_CLEANING_IN_BACKGROUND,
    SSDMODEL_SSD_GANG_SHARE,
-   SSDMODEL_SSD_ALLOCATION_POOL_LOGIC
+   SSDMODEL_SSD_ALLOCATION_POOL_LOGIC,
+   SSDMODEL_SSD_SCHEDULING_POLICY,
+   SSDMODEL_SSD_FLASH_CHANNELS,
+   SSDMODEL_SSD_PROGRAM_SUSPEND_LIMIT,
+   SSDMODEL_SSD_ERASE_SUSPEND_LIMIT,
+   SSDMODEL_SSD_PROGRAM_SUSPEND_LATENCY,
+   SSDMODEL_SSD_ERASE_SUSPEND_LATENCY,
+   SSDMODEL_SSD_RESUME_LATENCY,
+   SSDMODEL_SSD_IDLE_CLEANING_DELAY,
+   SSDMODEL_SSD_IDLE_CLEANING_WATERMARK,
+   SSDMODEL_SSD_IDLE_CLEANING_BUDGET,
+   SSDMODEL_SSD_WRITE_BUFFER_SIZE,
+   SSDMODEL_SSD_WRITE_BUFFER_FLUSH_WATERMARK,
+   SSDMODEL_SSD_WRITE_BUFFER_LATENCY,
+   SSDMODEL_SSD_WRITE_BUFFER_IDLE_FLUSH_DELAY,
+   SSDMODEL_SSD_WRITE_BUFFER_POWER_PROTECTED
 } ssdmodel_ssd_param_t;
 
-#define SSDMODEL_SSD_MAX_PARAM		SSDMODEL_SSD_ALLOCATION_POOL_LOGIC
+#define SSDMODEL_SSD_MAX_PARAM		SSDMODEL_SSD_WRITE_BUFFER_POWER_PROTECTED
 extern void * SSDMODEL_SSD_loaders[];
 extern lp_paramdep_t SSDMODEL_SSD_deps[];
 
@@ -82,9 +97,24 @@ static struct lp_varspec ssdmodel_ssd_params [] = {
    {"Cleaning in background", I, 1 },
    {"Gang share", I, 1 },
    {"Allocation pool logic", I, 1 },
+   {"Scheduling policy", I, 0 },
+   {"Flash channels", I, 0 },
+   {"Program suspend limit", I, 0 },
+   {"Erase suspend limit", I, 0 },
+   {"Program suspend latency", D, 0 },
+   {"Erase suspend latency", D, 0 },
+   {"Resume latency", D, 0 },
+   {"Idle cleaning delay", D, 0 },
+   {"Idle cleaning watermark", I, 0 },
+   {"Idle cleaning budget", I, 0 },
+   {"Write buffer size", I, 0 },
+   {"Write buffer flush watermark", I, 0 },
+   {"Write buffer latency", D, 0 },
+   {"Write buffer idle flush delay", D, 0 },
+   {"Write buffer power protected", I, 0 },
    {0,0,0}
 };
-#define SSDMODEL_SSD_MAX 31
+#define SSDMODEL_SSD_MAX 46
 static struct lp_mod ssdmodel_ssd_mod = { "ssdmodel_ssd", ssdmodel_ssd_params, SSDMODEL_SSD_MAX, (lp_modloader_t)ssdmodel_ssd_loadparams,  0, 0, SSDMODEL_SSD_loaders, SSDMODEL_SSD_deps };
 
 
@@ -6,6 +6,8 @@
 #include "ssd_clean.h"
 #include "ssd_gang.h"
 #include "ssd_init.h"
+#include "ssd_sched.h"
+#include "ssd_wbuf.h"
 #include "modules/ssdmodel_ssd_param.h"
 
 #ifndef sprintf_s
@@ -295,7 +297,7 @@ void ssd_bus_delay_complete (int devno, ioreq_event *curr, int sentbusno)
    slotno.byte[depth] = slotno.byte[depth] >> 4;
    curr->time = 0.0;
    if (depth == 0) {
-      intr_request ((event *)curr);
+      bus_interrupt_host (curr);
    } else {
       bus_deliver_event(busno.byte[depth], slotno.byte[depth], curr);
    }
@@ -320,6 +322,10 @@ static void ssd_request_complete(ioreq_event *curr)
       exit(1);
    }
 
+   if ((currdisk->params.wbuf_pages > 0) && (ioqueue_get_number_in_queue(currdisk->queue) == 0)) {
+      ssd_wbuf_idle(currdisk);
+   }
+
    /* send completion interrupt */
    curr->type = IO_INTERRUPT_ARRIVE;
    curr->cause = COMPLETION;
@@ -395,7 +401,37 @@ double _ssd_invoke_element_cleaning(int elem_num, ssd_t *s)
     return clean_cost;
 }
 
-static int ssd_invoke_element_cleaning(int elem_num, ssd_t *s)
+/*
+ * the element stays busy until the cleaning that takes 'cost' is over.
+ */
+static void ssd_schedule_element_cleaning(int elem_num, ssd_t *s, double cost)
+{
+    ssd_element *elem = &s->elements[elem_num];
+    ioreq_event *tmp;
+
+    elem->media_busy = 1;
+
+    // we use the 'blkno' field to store the element number
+    tmp = (ioreq_event *)getfromextraq();
+    tmp->devno = s->devno;
+    tmp->time = simtime + cost;
+    tmp->blkno = elem_num;
+    tmp->ssd_elem_num = elem_num;
+    tmp->type = SSD_CLEAN_ELEMENT;
+    tmp->flags = SSD_CLEAN_ELEMENT;
+    tmp->busno = -1;
+    tmp->bcount = -1;
+    addtointq ((event *)tmp);
+
+    // the flash-aware scheduler may suspend the cleaning for reads
+    elem->sched.cleaning = tmp;
+    elem->sched.clean_suspensions = 0;
+
+    // stat
+    elem->stat.tot_clean_time += cost;
+}
+
+int ssd_invoke_element_cleaning(int elem_num, ssd_t *s)
 {
     double max_cost = 0;
     int cleaning_invoked = 0;
@@ -410,31 +446,54 @@ static int ssd_invoke_element_cleaning(int elem_num, ssd_t *s)
     // the next operation on this elem only after the cleaning
     // gets over.
     if (max_cost > 0) {
-        ioreq_event *tmp;
-
-        elem->media_busy = 1;
         cleaning_invoked = 1;
-
-        // we use the 'blkno' field to store the element number
-        tmp = (ioreq_event *)getfromextraq();
-        tmp->devno = s->devno;
-        tmp->time = simtime + max_cost;
-        tmp->blkno = elem_num;
-        tmp->ssd_elem_num = elem_num;
-        tmp->type = SSD_CLEAN_ELEMENT;
-        tmp->flags = SSD_CLEAN_ELEMENT;
-        tmp->busno = -1;
-        tmp->bcount = -1;
         stat_update (&s->stat.acctimestats, max_cost);
-        addtointq ((event *)tmp);
-
-        // stat
-        elem->stat.tot_clean_time += max_cost;
+        ssd_schedule_element_cleaning(elem_num, s, max_cost);
     }
 
     return cleaning_invoked;
 }
 
+/*
+ * takes the next idle cleaning step on an element that has nothing
+ * else to do. returns 1 if the element is now busy cleaning.
+ */
+int ssd_idle_clean_element(ssd_t *s, int elem_num)
+{
+    ssd_idle_clean *ic = &s->idle_clean;
+    double cost;
+    int blocks;
+
+    ASSERT(s->elements[elem_num].media_busy == FALSE);
+
+    if ((!ic->active) || (ic->tokens[elem_num] == 0)) {
+        return 0;
+    }
+
+    cost = ssd_clean_element_idle(s, elem_num, &blocks);
+    if (cost <= 0) {
+        // back above the watermark, so we're done for this idle period
+        ic->tokens[elem_num] = 0;
+        return 0;
+    }
+
+    if (ic->tokens[elem_num] > 0) {
+        ic->tokens[elem_num] -= blocks;
+        if (ic->tokens[elem_num] < 0) {
+            ic->tokens[elem_num] = 0;
+        }
+    }
+    ic->cleaning[elem_num] = 1;
+
+    // stat
+    ic->steps ++;
+    ic->blocks += blocks;
+    ic->time += cost;
+
+    ssd_schedule_element_cleaning(elem_num, s, cost);
+    return 1;
+}
+
 static void ssd_activate_elem(ssd_t *currdisk, int elem_num)
 {
     ioreq_event *req;
@@ -451,6 +510,11 @@ static void ssd_activate_elem(ssd_t *currdisk, int elem_num)
 
     ssd_element *elem = &currdisk->elements[elem_num];
 
+    if (currdisk->params.sched_policy == SSD_SCHED_PARUNIT) {
+        ssd_sched_activate_elem(currdisk, elem_num);
+        return;
+    }
+
     // if the media is busy, we can't do anything, so return
     if (elem->media_busy == TRUE) {
         return;
@@ -470,6 +534,12 @@ static void ssd_activate_elem(ssd_t *currdisk, int elem_num)
 
     ASSERT(elem->metadata.reqs_waiting == ioqueue_get_number_in_queue(elem->queue));
 
+    // nothing to do, so see if we can clean while the device is idle
+    if (elem->metadata.reqs_waiting == 0) {
+        ssd_idle_clean_element(currdisk, elem_num);
+        return;
+    }
+
     if (elem->metadata.reqs_waiting > 0) {
 
         // invoke cleaning in foreground when there are requests waiting
@@ -617,38 +687,76 @@ static void ssd_activate_elem(ssd_t *currdisk, int elem_num)
 }
 
 
+/*
+ * queues a page-sized sub-request on its element
+ */
+void ssd_element_request(ssd_t *currdisk, ioreq_event *tmp)
+{
+   // find the element (package) to direct the request
+   int elem_num = currdisk->timing_t->choose_element(currdisk->timing_t, tmp->blkno);
+   ssd_element *elem = &currdisk->elements[elem_num];
+
+   elem->metadata.reqs_waiting ++;
+   if (currdisk->idle_clean.cleaning[elem_num]) {
+       currdisk->idle_clean.delayed ++;
+   }
+
+   // add the request to the corresponding element's queue
+   ioqueue_add_new_request(elem->queue, (ioreq_event *)tmp);
+   ssd_activate_elem(currdisk, elem_num);
+}
+
 static void ssd_media_access_request_element (ioreq_event *curr)
 {
    ssd_t *currdisk = getssd(curr->devno);
    int blkno = curr->blkno;
    int count = curr->bcount;
+   int buffered = 0;
 
    /* **** CAREFUL ... HIJACKING tempint2 and tempptr2 fields here **** */
    curr->tempint2 = count;
-   while (count != 0) {
 
-       // find the element (package) to direct the request
-       int elem_num = currdisk->timing_t->choose_element(currdisk->timing_t, blkno);
-       ssd_element *elem = &currdisk->elements[elem_num];
+   // the write buffer takes most writes
+   if ((currdisk->params.wbuf_pages > 0) && (!(curr->flags & READ))) {
+       if (ssd_wbuf_write(currdisk, curr)) {
+           return;
+       }
+   }
+
+   while (count != 0) {
+       ioreq_event *tmp;
+       int bcount = ssd_choose_aligned_count(currdisk->params.page_size, blkno, count);
+       ASSERT(bcount == currdisk->params.page_size);
+
+       // pages held in the write buffer are read from there
+       if ((currdisk->params.wbuf_pages > 0) && (curr->flags & READ) &&
+           (ssd_wbuf_read_hit(currdisk, blkno))) {
+           buffered += bcount;
+           blkno += bcount;
+           count -= bcount;
+           continue;
+       }
 
        // create a new sub-request for the element
-       ioreq_event *tmp = (ioreq_event *)getfromextraq();
+       tmp = (ioreq_event *)getfromextraq();
        tmp->devno = curr->devno;
        tmp->busno = curr->busno;
        tmp->flags = curr->flags;
        tmp->blkno = blkno;
-       tmp->bcount = ssd_choose_aligned_count(currdisk->params.page_size, blkno, count);
-       ASSERT(tmp->bcount == currdisk->params.page_size);
+       tmp->bcount = bcount;
 
        tmp->tempptr2 = curr;
        blkno += tmp->bcount;
        count -= tmp->bcount;
 
-       elem->metadata.reqs_waiting ++;
+       ssd_element_request(currdisk, tmp);
+   }
 
-       // add the request to the corresponding element's queue
-       ioqueue_add_new_request(elem->queue, (ioreq_event *)tmp);
-       ssd_activate_elem(currdisk, elem_num);
+   if ((currdisk->params.wbuf_pages > 0) && (curr->flags & READ)) {
+       iosim_sample_cache_access(curr, (buffered == curr->tempint2));
+   }
+   if (buffered > 0) {
+       ssd_wbuf_complete(currdisk, curr, buffered);
    }
 }
 
@@ -720,6 +828,12 @@ static void ssd_request_arrive (ioreq_event *curr)
 
    currdisk = getssd(curr->devno);
 
+   // the idle period (if any) is over
+   currdisk->idle_clean.active = 0;
+   if (currdisk->params.wbuf_pages > 0) {
+      ssd_wbuf_arrive(currdisk);
+   }
+
    /* verify that request is valid. */
    if ((curr->blkno < 0) || (curr->bcount <= 0) ||
        ((curr->blkno + curr->bcount) > currdisk->numblocks)) {
@@ -768,6 +882,8 @@ static void ssd_clean_element_complete(ioreq_event *curr)
 
    // release this event
    addtoextraq((event *) curr);
+   currdisk->elements[elem_num].sched.cleaning = NULL;
+   currdisk->idle_clean.cleaning[elem_num] = 0;
 
    // activate the gang to serve the next set of requests
    currdisk->elements[elem_num].media_busy = 0;
@@ -819,12 +935,19 @@ static void ssd_access_complete_element(ioreq_event *curr)
       exit(1);
    }
 
-   // all the reqs are over
-   if (ioqueue_get_reqoutstanding(elem->queue) == 0) {
+   if (currdisk->params.sched_policy == SSD_SCHED_PARUNIT) {
+    ssd_sched_access_done(currdisk, curr);
+   } else if (ioqueue_get_reqoutstanding(elem->queue) == 0) {
+    // all the reqs are over
     elem->media_busy = FALSE;
    }
 
-   ssd_complete_parent(curr, currdisk);
+   if (curr->tempptr2 == NULL) {
+       // a page flushed from the write buffer
+       ssd_wbuf_flush_done(currdisk, curr);
+   } else {
+       ssd_complete_parent(curr, currdisk);
+   }
    addtoextraq((event *) curr);
    ssd_activate_elem(currdisk, elem_num);
 }
@@ -962,6 +1085,14 @@ void ssd_event_arrive (ioreq_event *curr)
           ssd_clean_element_complete(curr);
           break;
 
+      case SSD_SCHED_ARRAY_DONE:
+          ssd_sched_array_done(curr);
+          break;
+
+      case SSD_WBUF_DONE:
+          ssd_wbuf_done(curr);
+          break;
+
         default:
          fprintf(stderr, "Unrecognized event type at ssd_event_arrive\n");
          exit(1);
@@ -1057,8 +1188,37 @@ void ssd_cleanstats (void)
    }
 }
 
+/*
+ * the device has had no requests for the idle cleaning delay. let
+ * every element that has nothing to do start cleaning.
+ */
+static void ssd_idlework_callback(void *idleworkparam, int idledevno)
+{
+    ssd_t *currdisk = idleworkparam;
+    ssd_idle_clean *ic = &currdisk->idle_clean;
+    int budget;
+    int i;
+
+    ASSERT(idledevno == currdisk->devno);
+
+    if (ioqueue_get_number_in_queue(currdisk->queue) != 0) {
+        return;
+    }
+
+    budget = (currdisk->params.idle_clean_budget > 0) ? currdisk->params.idle_clean_budget : -1;
+
+    ic->active = 1;
+    ic->periods ++;
+    for (i = 0; i < currdisk->params.nelements; i ++) {
+        ic->tokens[i] = budget;
+        ssd_activate_elem(currdisk, i);
+    }
+}
+
 void ssd_setcallbacks ()
 {
+   disksim->idlework_ssd = ssd_idlework_callback;
+   ssd_wbuf_setcallbacks();
    ioqueue_setcallbacks();
 }
 
@@ -1148,6 +1308,39 @@ static void ssd_acctime_printstats (int *set, int setsize, char *prefix)
 }
 
 
+static void ssd_idle_clean_printstats (int *set, int setsize, char *prefix)
+{
+   int i;
+   int enabled = 0;
+   int periods = 0;
+   int steps = 0;
+   int blocks = 0;
+   int delayed = 0;
+   double time = 0.0;
+
+   for (i=0; i<setsize; i++) {
+      ssd_t *currdisk = getssd (set[i]);
+      if (currdisk->params.idle_clean_delay > 0) {
+         enabled = 1;
+      }
+      periods += currdisk->idle_clean.periods;
+      steps += currdisk->idle_clean.steps;
+      blocks += currdisk->idle_clean.blocks;
+      delayed += currdisk->idle_clean.delayed;
+      time += currdisk->idle_clean.time;
+   }
+
+   if (!enabled) {
+      return;
+   }
+
+   fprintf(outputfile, "%sIdle periods with cleaning: %d\n", prefix, periods);
+   fprintf(outputfile, "%sIdle cleaning steps: %d\n", prefix, steps);
+   fprintf(outputfile, "%sBlocks cleaned while idle: %d\n", prefix, blocks);
+   fprintf(outputfile, "%sIdle cleaning time: %f\n", prefix, time);
+   fprintf(outputfile, "%sPages delayed by idle cleaning: %d\n", prefix, delayed);
+}
+
 static void ssd_other_printstats (int *set, int setsize, char *prefix)
 {
    int i;
@@ -1162,6 +1355,9 @@ static void ssd_other_printstats (int *set, int setsize, char *prefix)
 
    fprintf(outputfile, "%sTotal bus wait time: %f\n", prefix, waitingforbus);
    fprintf(outputfile, "%sNumber of bus waits: %d\n", prefix, numbuswaits);
+
+   ssd_idle_clean_printstats(set, setsize, prefix);
+   ssd_wbuf_printstats(set, setsize, prefix);
 }
 
 void ssd_print_block_lifetime_distribution(int elem_num, ssd_t *s, int ssdno, double avg_lifetime, char *sourcestr)
@@ -1465,6 +1661,7 @@ void ssd_printstats (void)
           q = currdisk->elements[j].queue;
           ioqueue_printstats(&q, 1, pprefix);
       }
+      ssd_sched_printstats(currdisk, prefix);
       ssd_acctime_printstats(&set[i], 1, prefix);
       ssd_other_printstats(&set[i], 1, prefix);
       fprintf (outputfile, "\n\n");
@@ -13,6 +13,11 @@
 
 struct ssd *getssd (int devno);
 
+// checkpoint support (ssd_init.c)
+struct checkpoint;
+void ssd_checkpoint (struct checkpoint *ckpt);
+void ssd_restore (struct checkpoint *ckpt, int devno);
+
 /* default ssd dev header */
 extern struct device_header ssd_hdr_initializer;
 
@@ -30,6 +35,7 @@ typedef struct {
    double  requestedbus;
    double  waitingforbus;
    int     numbuswaits;
+   double  statstart;       // when the statistics were last reset
 } ssd_stat_t;
 
 /*
@@ -175,6 +181,74 @@ typedef struct _ssd_plane {
 } ssd_plane;
 
 
+/*
+ * a flash operation issued by the flash-aware scheduler (ssd_sched.c):
+ * a (multi-plane) read or program on one parallel unit. the pages of a
+ * read wait in reqs for the channel once the array access is over.
+ */
+typedef struct _ssd_flash_op {
+    int          numreqs;                           // pages in the operation
+    int          pending;                           // pages not yet done
+    int          is_write;                          // a program rather than a read
+    int          suspensions;                       // times a program has been suspended
+    double       start;                             // when the operation was issued
+    double       program_start;                     // when a program left the channel
+    double       done;                              // when a program will be over
+    ioreq_event *reqs[SSD_MAX_PLANES_PER_ELEM];     // the pages themselves
+} ssd_flash_op;
+
+/*
+ * state kept by the flash-aware scheduler for each parallel unit of an
+ * element. an operation holds the unit from the time it is issued until
+ * its last page is done. a read may suspend a program; the program is
+ * then parked in susp and resumes when the read is over.
+ */
+typedef struct _ssd_parunit_sched {
+    int          busy;                              // an operation holds this unit
+    ssd_flash_op op;                                // the operation holding it
+    int          suspended;                         // a program is parked in susp
+    ssd_flash_op susp;
+    double       remaining;                         // program time left in susp
+} ssd_parunit_sched;
+
+/*
+ * requests staged at an element by the flash-aware scheduler. they are
+ * kept in the order the element queue hands them out, reads apart from
+ * writes so that a read never waits behind a program.
+ */
+typedef struct _ssd_element_sched {
+    ioreq_event *reads;
+    ioreq_event *readstail;
+    ioreq_event *writes;
+    ioreq_event *writestail;
+    ssd_parunit_sched parunit[SSD_MAX_PARUNITS_PER_ELEM];
+
+    ioreq_event *cleaning;                      // pending SSD_CLEAN_ELEMENT event, if any
+    int    clean_suspended;                     // cleaning is suspended for reads
+    int    clean_suspensions;                   // times the current cleaning was suspended
+    double clean_remaining;                     // cleaning time left while suspended
+    double reads_from;                          // reads may use the array from this time
+
+    int    busy_units;                          // units holding an operation
+    double busy_start;                          // when busy_units last left zero
+    double busy_time;                           // time with at least one unit busy
+    int    ops;                                 // flash operations issued
+    int    multiplane_ops;                      // operations covering more than one plane
+    int    pages;                               // pages covered by those operations
+    int    reads_ahead;                         // reads issued while writes were waiting
+    int    program_suspends;                    // programs suspended for reads
+    int    erase_suspends;                      // cleanings suspended for reads
+} ssd_element_sched;
+
+/*
+ * a flash channel is the data bus shared by the elements wired to it.
+ * transfers to and from those elements are serialized on it.
+ */
+typedef struct _ssd_channel {
+    double free;                                // reserved until this time
+    double busy_time;                           // time spent transferring data
+} ssd_channel;
+
 /*
  * the ssd element (a single package) internally consists of multiple
  * planes and the entire package has only one set of pins. so, when
@@ -191,8 +265,69 @@ typedef struct _ssd_element {
    int pin_busy;                                // state to hold the busy state of the package pins
    int num_planes;                              // number of planes in this package
    ssd_plane plane[SSD_MAX_PLANES_PER_ELEM];    // an array of flash planes
+   ssd_element_sched sched;                     // flash-aware scheduler state
 } ssd_element;
 
+/*
+ * idle-time cleaning. once the device has had no requests for the idle
+ * cleaning delay, each element cleans a block at a time until it is
+ * back above the idle watermark, it spends its budget or a request
+ * arrives.
+ */
+typedef struct _ssd_idle_clean {
+    int    active;                              // still in the idle period that started cleaning
+    int    tokens[SSD_MAX_ELEMENTS];            // blocks each element may still clean (-1 = no limit)
+    int    cleaning[SSD_MAX_ELEMENTS];          // element is busy with an idle cleaning step
+
+    // stats
+    int    periods;                             // idle periods that started cleaning
+    int    steps;                               // idle cleaning steps
+    int    blocks;                              // blocks cleaned while idle
+    int    delayed;                             // pages that arrived during an idle step
+    double time;                                // time spent cleaning while idle
+} ssd_idle_clean;
+
+/*
+ * dram write buffer. pages are hashed on their page number; dirty pages
+ * are kept on a list in the order they were last written, and the
+ * oldest are flushed first.
+ */
+typedef struct _ssd_wbuf_page {
+    int    pageno;                              // page number, -1 if the entry is free
+    int    flushing;                            // being written to flash
+    int    redirty;                             // written again while being flushed
+    int    hnext;                               // next entry in the hash chain
+    int    prev;                                // dirty list (or free list, with next)
+    int    next;
+} ssd_wbuf_page;
+
+typedef struct _ssd_wbuf {
+    ssd_wbuf_page *pages;
+    int    *hash;                               // heads of the hash chains
+    int    hashmask;
+    int    oldest;                              // dirty list head
+    int    newest;                              // dirty list tail
+    int    freelist;
+    int    used;                                // entries holding data
+    int    flushing;                            // entries being flushed
+    int    draining;                            // flush everything, the device is idle
+    ioreq_event *stalled;                       // writes waiting for space
+    ioreq_event *stalledtail;
+    timer_event *idledetect;
+
+    // stats
+    int    writes;                              // writes acknowledged from the buffer
+    int    pages_written;
+    int    absorbed;                            // pages overwritten before they were flushed
+    int    read_hits;                           // pages read from the buffer
+    int    read_misses;
+    int    fua_writes;                          // writes that went straight to flash
+    int    stalls;                              // writes that waited for space
+    double stall_time;
+    int    flushed;                             // pages written to flash
+    int    max_used;
+} ssd_wbuf;
+
 typedef struct _ssd_elem_number {
     int e:SSD_BITS_ELEMS_PER_GANG;
 } ssd_elem_number;
@@ -279,6 +414,10 @@ typedef struct _gang_metadata {
 #define SSD_ALLOC_POOL_CHIP                     1   // each element is an allocation pool
 #define SSD_ALLOC_POOL_PLANE                    2
 
+// how requests are issued to the elements
+#define SSD_SCHED_ELEMENT                       0   // in batches, one batch per element at a time
+#define SSD_SCHED_PARUNIT                       1   // per parallel unit, tracking channels and planes
+
 // what do the gangs share?
 #define SSD_SHARED_BUS_GANG                     1  // shares both data and control
 #define SSD_SHARED_CONTROL_GANG                 2  // shares only the control
@@ -326,6 +465,27 @@ typedef struct _ssd_timing_params {
     int     cleaning_in_background;     // do we want to do the cleaning in foreground/background?
 
     int     alloc_pool_logic;           // static or dynamic allocation
+
+    int     sched_policy;               // how requests are issued to the elements
+                                        // (e.g., SSD_SCHED_PARUNIT)
+
+    int     nchannels;                  // flash channels shared by the elements
+
+    int     program_suspend_limit;      // times a program may be suspended for reads
+    int     erase_suspend_limit;        // times cleaning may be suspended for reads
+    double  program_suspend_latency;    // time to suspend a program
+    double  erase_suspend_latency;      // time to suspend an erase
+    double  resume_latency;             // time to resume a suspended program or erase
+
+    double  idle_clean_delay;           // idle time before cleaning starts (0 = never)
+    int     idle_clean_watermark;       // clean while idle up to this free blocks percentage
+    int     idle_clean_budget;          // blocks an element may clean per idle period (0 = no limit)
+
+    int     wbuf_pages;                 // pages in the dram write buffer (0 = none)
+    int     wbuf_watermark;             // flush when more than this percentage is used
+    double  wbuf_latency;               // time to move a request to/from the write buffer
+    double  wbuf_idle_delay;            // idle time before the buffer drains (0 = never)
+    int     wbuf_protected;             // buffer survives power loss (capacitor backed)
 } ssd_timing_params;
 
 struct _ssd_timing_t;    // forward def for timing module.
@@ -348,6 +508,10 @@ typedef struct ssd {
    struct ioq *queue;
 
    ssd_element elements[SSD_MAX_ELEMENTS];
+   ssd_channel channels[SSD_MAX_ELEMENTS];
+   ssd_idle_clean idle_clean;
+   ssd_wbuf wbuf;
+   disksim_rng rng;                     // for wear-aware and random cleaning
 
    // for ganging elements
    unsigned int data_pages_per_elem;    // number of pages that can be used to store data
@@ -451,6 +615,9 @@ void    ssd_assert_plane_freebits(int plane_num, int elem_num, ssd_element_metad
 double  ssd_read_policy_simple(int count, ssd_t *s);
 void    ssd_complete_parent(ioreq_event *curr, ssd_t *currdisk);
 double _ssd_invoke_element_cleaning(int elem_num, ssd_t *s);
+int     ssd_invoke_element_cleaning(int elem_num, ssd_t *s);
+int     ssd_idle_clean_element(ssd_t *s, int elem_num);
+void    ssd_element_request(ssd_t *currdisk, ioreq_event *tmp);
 int     ssd_already_present(ssd_req **reqs, int total, ioreq_event *req);
 
 #endif   /* DISKSIM_ssd_H */
@@ -156,11 +156,11 @@ void ssd_update_free_block_status(int blk, int plane_num, ssd_element_metadata *
  * definition
  */
 #ifdef CAMERA_READY
-int ssd_rate_limit(int block_life, double avg_lifetime)
+int ssd_rate_limit(int block_life, double avg_lifetime, ssd_t *s)
 {
     double percent_rem = (block_life * 1.0) / avg_lifetime;
     double temp = (percent_rem - (SSD_LIFETIME_THRESHOLD_X-SSD_RATELIMIT_WINDOW)) / (SSD_LIFETIME_THRESHOLD_X - percent_rem);
-    double rand_no = DISKSIM_drand48();
+    double rand_no = disksim_rng_uniform(&s->rng);
 
     // i can use this block
     if (rand_no < temp) {
@@ -172,11 +172,11 @@ int ssd_rate_limit(int block_life, double avg_lifetime)
     }
 }
 #else
-int ssd_rate_limit(int block_life, double avg_lifetime)
+int ssd_rate_limit(int block_life, double avg_lifetime, ssd_t *s)
 {
     double percent_rem = (block_life * 1.0) / avg_lifetime;
     double temp = percent_rem / SSD_LIFETIME_THRESHOLD_X;
-    double rand_no = DISKSIM_drand48();
+    double rand_no = disksim_rng_uniform(&s->rng);
 
     // i can use this block
     if (rand_no < temp) {
@@ -260,7 +260,7 @@ int ssd_pick_wear_aware(int blk, int block_life, double avg_lifetime, ssd_t *s)
             //printf("Rate limiting block %d (block life %d avg life %f\n",
             //  blk, block_life, avg_lifetime);
 
-            if (ssd_rate_limit(block_life, avg_lifetime)) {
+            if (ssd_rate_limit(block_life, avg_lifetime, s)) {
                 // skip this block and go to the next one
                 return 0;
             }
@@ -291,7 +291,7 @@ int ssd_pick_wear_aware(int blk, int block_life, double avg_lifetime, ssd_t *s)
         //printf("Rate limiting block %d (block life %d avg life %f\n",
         //  blk, block_life, avg_lifetime);
 
-        if (ssd_rate_limit(block_life, avg_lifetime)) {
+        if (ssd_rate_limit(block_life, avg_lifetime, s)) {
             // skip this block and go to the next one
             return 0;
         }
@@ -768,7 +768,7 @@ static double ssd_clean_blocks_random(int plane_num, int elem_num, ssd_t *s)
 
     do {
         // get a random number to select a block
-        blk = DISKSIM_lrand48() % s->params.blocks_per_element;
+        blk = disksim_rng_lrand(&s->rng) % s->params.blocks_per_element;
 
         // if this is plane specific cleaning, then skip all the
         // blocks that don't belong to this plane.
@@ -868,7 +868,7 @@ static double ssd_clean_blocks_greedy(int plane_num, int elem_num, ssd_t *s)
                         printf("Rate limiting block %d (block life %d avg life %f\n",
                             blk, block_life, avg_lifetime);
 
-                        if (ssd_rate_limit(block_life, avg_lifetime)) {
+                        if (ssd_rate_limit(block_life, avg_lifetime, s)) {
                             // skip this block and go to the next one
                             continue;
                         }
@@ -1013,6 +1013,88 @@ double ssd_clean_element(ssd_t *s, int elem_num)
     return cost;
 }
 
+/*
+ * is there a block in this plane (or element, if plane_num is -1)
+ * whose cleaning frees at least a page?
+ */
+static int ssd_idle_clean_gains(int plane_num, int elem_num, ssd_element_metadata *metadata, ssd_t *s)
+{
+    int i;
+
+    for (i = 0; i < s->params.blocks_per_element; i ++) {
+        if ((_ssd_pick_block_to_clean(i, plane_num, elem_num, metadata, s)) &&
+            (metadata->block_usage[i].num_valid < s->params.pages_per_block - 1)) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * one step of idle-time cleaning. without copy back, one block of the
+ * element is cleaned. with copy back, one block in the emptiest plane
+ * of each parallel unit is cleaned, all the units in parallel. only the
+ * element (planes) below the idle watermark are cleaned. returns the
+ * cost and, in 'blocks', the number of blocks cleaned.
+ */
+double ssd_clean_element_idle(ssd_t *s, int elem_num, int *blocks)
+{
+    ssd_element_metadata *metadata = &s->elements[elem_num].metadata;
+    double max_cleaning_cost = 0;
+    double mcost = 0;
+    int blk;
+    int i;
+
+    *blocks = 0;
+
+    if (s->params.copy_back == SSD_COPY_BACK_DISABLE) {
+        if ((metadata->tot_free_blocks >= IDLE_WATERMARK_PER_ELEMENT(s)) ||
+            (!ssd_idle_clean_gains(-1, elem_num, metadata, s))) {
+            return 0;
+        }
+
+        blk = ssd_pick_block_to_clean(-1, elem_num, &mcost, metadata, s);
+        *blocks = 1;
+        return (mcost + _ssd_clean_block_fully(blk, metadata->block_usage[blk].plane_num, elem_num, metadata, s));
+    }
+
+    for (i = 0; i < SSD_PARUNITS_PER_ELEM(s); i ++) {
+        double cleaning_cost;
+        int plane_num = -1;
+        int j;
+
+        for (j = i*SSD_PLANES_PER_PARUNIT(s); j < (i+1)*SSD_PLANES_PER_PARUNIT(s); j ++) {
+            plane_metadata *pm = &metadata->plane_meta[j];
+
+            if ((pm->free_blocks < IDLE_WATERMARK_PER_PLANE(s)) &&
+                ((plane_num == -1) || (pm->free_blocks < metadata->plane_meta[plane_num].free_blocks)) &&
+                (ssd_idle_clean_gains(j, elem_num, metadata, s))) {
+                plane_num = j;
+            }
+        }
+
+        if (plane_num == -1) {
+            continue;
+        }
+
+        if (metadata->plane_meta[plane_num].clean_in_progress) {
+            metadata->plane_meta[plane_num].clean_in_progress = 0;
+            metadata->plane_meta[plane_num].clean_in_block = -1;
+        }
+
+        metadata->active_page = metadata->plane_meta[plane_num].active_page;
+        cleaning_cost = ssd_clean_plane_copyback(plane_num, elem_num, s);
+        (*blocks) ++;
+
+        if (max_cleaning_cost < cleaning_cost) {
+            max_cleaning_cost = cleaning_cost;
+        }
+    }
+
+    return max_cleaning_cost;
+}
+
 int ssd_next_plane_in_parunit(int plane_num, int parunit_num, int elem_num, ssd_t *s)
 {
     return (parunit_num*SSD_PLANES_PER_PARUNIT(s) + (plane_num+1)%SSD_PLANES_PER_PARUNIT(s));
@@ -42,6 +42,10 @@
 
 #endif
 
+// idle-time cleaning goes on up to these
+#define IDLE_WATERMARK_PER_ELEMENT(s)   ((s)->params.blocks_per_element * ((1.0*(s)->params.idle_clean_watermark)/100.0))
+#define IDLE_WATERMARK_PER_PLANE(s)     ((s)->params.blocks_per_plane * ((1.0*(s)->params.idle_clean_watermark)/100.0))
+
 
 typedef struct _usage_table {
     int len;
@@ -57,6 +61,7 @@ void ssd_assert_plane_freebits(int plane_num, int elem_num, ssd_element_metadata
 
 double _ssd_clean_block_fully(int blk, int plane_num, int elem_num, ssd_element_metadata *metadata, ssd_t *s);
 double ssd_clean_element(ssd_t *s, int elem_num);
+double ssd_clean_element_idle(ssd_t *s, int elem_num, int *blocks);
 int ssd_next_plane_in_parunit(int plane_num, int parunit_num, int elem_num, ssd_t *s);
 int ssd_start_cleaning_parunit(int parunit_num, int elem_num, ssd_t *s);
 int ssd_start_cleaning(int plane_num, int elem_num, ssd_t *s);
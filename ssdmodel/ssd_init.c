@@ -1,11 +1,14 @@
 // DiskSim SSD support
-// 2008 Microsoft Corporation. All Rights Reserved
+// �2008 Microsoft Corporation. All Rights Reserved
 
 #include "ssd.h"
 #include "ssd_timing.h"
 #include "ssd_clean.h"
 #include "ssd_utils.h"
 #include "ssd_init.h"
+#include "ssd_sched.h"
+#include "ssd_wbuf.h"
+#include "disksim_checkpoint.h"
 
 /* read-only globals used during readparams phase */
 static char *statdesc_acctimestats  =   "Access time";
@@ -24,6 +27,13 @@ static void ssd_statinit (int devno, int firsttime)
    currdisk->stat.requestedbus = 0.0;
    currdisk->stat.waitingforbus = 0.0;
    currdisk->stat.numbuswaits = 0;
+   currdisk->idle_clean.periods = 0;
+   currdisk->idle_clean.steps = 0;
+   currdisk->idle_clean.blocks = 0;
+   currdisk->idle_clean.delayed = 0;
+   currdisk->idle_clean.time = 0.0;
+   ssd_wbuf_resetstats(currdisk);
+   ssd_sched_resetstats(currdisk);
 }
 
 void ssd_initialize_diskinfo ()
@@ -419,6 +429,17 @@ void ssd_verify_parameters(ssd_t *currdisk)
     if (currdisk->params.alloc_pool_logic == 2) { // plane specific
         ASSERT(currdisk->params.copy_back == SSD_COPY_BACK_ENABLE); // we can do GC only w/in a plane
     }
+
+    // idle cleaning works on elements and must aim above the
+    // threshold that triggers the regular cleaning
+    if (currdisk->params.idle_clean_delay > 0) {
+        ASSERT(currdisk->params.alloc_pool_logic != SSD_ALLOC_POOL_GANG);
+        ASSERT(currdisk->params.idle_clean_watermark > currdisk->params.min_freeblks_percent);
+        ASSERT(currdisk->params.idle_clean_watermark < currdisk->params.reserve_blocks);
+    }
+
+    ssd_wbuf_verify_parameters(currdisk);
+    ssd_sched_verify_parameters(currdisk);
 }
 
 void ssd_alloc_queues(ssd_t *t)
@@ -447,6 +468,7 @@ void ssd_initialize (void)
 {
     static print1 = 1;
    int i, j;
+   int scale;
 
    if (disksim->ssdinfo == NULL) {
       ssd_initialize_diskinfo ();
@@ -463,6 +485,14 @@ fprintf (outputfile, "Entered ssd_initialize - numssds %d\n", numssds);
       ssd_t *currdisk = getssd (i);
       ssd_alloc_queues(currdisk);
 
+      // a spatially sampled trace sees proportionally less flash; the
+      // write buffer keeps its size as it absorbs the (unsampled) write rate
+      scale = iosim_sample_capacity_divisor();
+      if (scale > 1) {
+          currdisk->params.blocks_per_plane = (currdisk->params.blocks_per_plane + scale - 1) / scale;
+          currdisk->params.blocks_per_element = currdisk->params.planes_per_pkg * currdisk->params.blocks_per_plane;
+      }
+
       //vp - some verifications:
       ssd_verify_parameters(currdisk);
 
@@ -475,12 +505,26 @@ fprintf (outputfile, "Entered ssd_initialize - numssds %d\n", numssds);
                    currdisk->params.blocks_per_element *
                    currdisk->params.pages_per_block *
                    currdisk->params.page_size;
+         // the osr ftl maps only the exported pages of each element (the
+         // reserve is kept for cleaning), so that is all the host may address
+         if (currdisk->params.write_policy == DISKSIM_SSD_WRITE_POLICY_OSR) {
+             currdisk->numblocks = currdisk->params.nelements *
+                   ssd_elem_export_size(currdisk) *
+                   currdisk->params.page_size;
+         }
          currdisk->reconnect_reason = -1;
          addlisttoextraq ((event **) &currdisk->buswait);
          currdisk->busowned = -1;
          currdisk->completion_queue = NULL;
          /* hack to init queue structure */
          ioqueue_initialize (currdisk->queue, i);
+         memset(&currdisk->idle_clean, 0, sizeof(ssd_idle_clean));
+         ssd_wbuf_init(currdisk);
+         disksim_rng_init(&currdisk->rng, "ssd", i);
+         if (currdisk->params.idle_clean_delay > 0) {
+             ioqueue_set_idlework_function(currdisk->queue, &disksim->idlework_ssd,
+                 currdisk, currdisk->params.idle_clean_delay);
+         }
          ssd_statinit(i, TRUE);
          currdisk->timing_t = ssd_new_timing_t(&currdisk->params);
 
@@ -520,7 +564,10 @@ fprintf (outputfile, "Entered ssd_initialize - numssds %d\n", numssds);
 
             //vp - initialize the stat structure
             memset(&elem->stat, 0, sizeof(ssd_element_stat));
+
+            memset(&elem->sched, 0, sizeof(ssd_element_sched));
          }
+         memset(currdisk->channels, 0, sizeof(currdisk->channels));
 /*        } */
    }
 }
@@ -542,3 +589,204 @@ void ssd_resetstats (void)
    }
 }
 
+
+/*
+ * checkpoints save the flash translation state -- mapping tables, block
+ * usage, wear and allocation positions -- so that a device filled up
+ * to steady state once can be reused by later runs. they are only taken
+ * while the ssd is idle, so nothing is being cleaned or transferred.
+ * the restoring configuration must have the same geometry; timing,
+ * scheduling and cleaning parameters may differ. pages still in the
+ * write buffer are saved too and must fit in the restoring buffer.
+ */
+static void ssd_checkpoint_geometry(checkpoint_t *ckpt, ssd_t *s)
+{
+    checkpoint_put_int(ckpt, numssds);
+    checkpoint_put_int(ckpt, s->params.nelements);
+    checkpoint_put_int(ckpt, s->params.elements_per_gang);
+    checkpoint_put_int(ckpt, s->params.planes_per_pkg);
+    checkpoint_put_int(ckpt, s->params.num_parunits);
+    checkpoint_put_int(ckpt, s->params.blocks_per_element);
+    checkpoint_put_int(ckpt, s->params.pages_per_block);
+    checkpoint_put_int(ckpt, s->params.write_policy);
+    checkpoint_put_int(ckpt, s->data_pages_per_elem);
+}
+
+static void ssd_restore_geometry(checkpoint_t *ckpt, ssd_t *s)
+{
+    checkpoint_check(ckpt, "number of ssds", checkpoint_get_int(ckpt), numssds);
+    checkpoint_check(ckpt, "number of elements", checkpoint_get_int(ckpt), s->params.nelements);
+    checkpoint_check(ckpt, "elements per gang", checkpoint_get_int(ckpt), s->params.elements_per_gang);
+    checkpoint_check(ckpt, "planes per package", checkpoint_get_int(ckpt), s->params.planes_per_pkg);
+    checkpoint_check(ckpt, "parallel units", checkpoint_get_int(ckpt), s->params.num_parunits);
+    checkpoint_check(ckpt, "blocks per element", checkpoint_get_int(ckpt), s->params.blocks_per_element);
+    checkpoint_check(ckpt, "pages per block", checkpoint_get_int(ckpt), s->params.pages_per_block);
+    checkpoint_check(ckpt, "write policy", checkpoint_get_int(ckpt), s->params.write_policy);
+    checkpoint_check(ckpt, "exported pages per element", checkpoint_get_int(ckpt), s->data_pages_per_elem);
+}
+
+static void ssd_checkpoint_element(checkpoint_t *ckpt, ssd_t *s, ssd_element_metadata *metadata)
+{
+    int i;
+
+    checkpoint_put_ints(ckpt, metadata->lba_table, s->data_pages_per_elem);
+    checkpoint_put_bytes(ckpt, metadata->free_blocks, s->params.blocks_per_element / 8);
+    checkpoint_put_int(ckpt, metadata->tot_free_blocks);
+    checkpoint_put_int(ckpt, metadata->active_page);
+    checkpoint_put_int(ckpt, metadata->bsn);
+    checkpoint_put_int(ckpt, metadata->plane_to_clean);
+    checkpoint_put_int(ckpt, metadata->plane_to_write);
+    checkpoint_put_int(ckpt, metadata->block_alloc_pos);
+    checkpoint_put_int(ckpt, metadata->reqs_waiting);
+    checkpoint_put_int(ckpt, metadata->tot_migrations);
+    checkpoint_put_int(ckpt, metadata->tot_pgs_migrated);
+    checkpoint_put_double(ckpt, metadata->mig_cost);
+
+    for (i = 0; i < s->params.planes_per_pkg; i ++) {
+        plane_metadata *pm = &metadata->plane_meta[i];
+
+        ASSERT(pm->clean_in_progress == 0);
+        checkpoint_put_int(ckpt, pm->free_blocks);
+        checkpoint_put_int(ckpt, pm->valid_pages);
+        checkpoint_put_int(ckpt, pm->active_page);
+        checkpoint_put_int(ckpt, pm->clean_in_block);
+        checkpoint_put_int(ckpt, pm->block_alloc_pos);
+        checkpoint_put_int(ckpt, pm->num_cleans);
+    }
+
+    for (i = 0; i < s->params.num_parunits; i ++) {
+        checkpoint_put_int(ckpt, metadata->parunits[i].plane_to_clean);
+    }
+
+    for (i = 0; i < s->params.blocks_per_element; i ++) {
+        block_metadata *b = &metadata->block_usage[i];
+
+        checkpoint_put_ints(ckpt, b->page, s->params.pages_per_block);
+        checkpoint_put_int(ckpt, b->num_valid);
+        checkpoint_put_int(ckpt, b->rem_lifetime);
+        checkpoint_put_double(ckpt, b->time_of_last_erasure);
+        checkpoint_put_int(ckpt, b->state);
+        checkpoint_put_int(ckpt, b->bsn);
+    }
+}
+
+static void ssd_restore_element(checkpoint_t *ckpt, ssd_t *s, ssd_element_metadata *metadata)
+{
+    int i;
+
+    checkpoint_get_ints(ckpt, metadata->lba_table, s->data_pages_per_elem);
+    checkpoint_get_bytes(ckpt, metadata->free_blocks, s->params.blocks_per_element / 8);
+    metadata->tot_free_blocks = checkpoint_get_int(ckpt);
+    metadata->active_page = checkpoint_get_int(ckpt);
+    metadata->bsn = checkpoint_get_int(ckpt);
+    metadata->plane_to_clean = checkpoint_get_int(ckpt);
+    metadata->plane_to_write = checkpoint_get_int(ckpt);
+    metadata->block_alloc_pos = checkpoint_get_int(ckpt);
+    metadata->reqs_waiting = checkpoint_get_int(ckpt);
+    metadata->tot_migrations = checkpoint_get_int(ckpt);
+    metadata->tot_pgs_migrated = checkpoint_get_int(ckpt);
+    metadata->mig_cost = checkpoint_get_double(ckpt);
+
+    for (i = 0; i < s->params.planes_per_pkg; i ++) {
+        plane_metadata *pm = &metadata->plane_meta[i];
+
+        pm->free_blocks = checkpoint_get_int(ckpt);
+        pm->valid_pages = checkpoint_get_int(ckpt);
+        pm->active_page = checkpoint_get_int(ckpt);
+        pm->clean_in_block = checkpoint_get_int(ckpt);
+        pm->block_alloc_pos = checkpoint_get_int(ckpt);
+        pm->num_cleans = checkpoint_get_int(ckpt);
+        pm->clean_in_progress = 0;
+    }
+
+    for (i = 0; i < s->params.num_parunits; i ++) {
+        metadata->parunits[i].plane_to_clean = checkpoint_get_int(ckpt);
+    }
+
+    for (i = 0; i < s->params.blocks_per_element; i ++) {
+        block_metadata *b = &metadata->block_usage[i];
+
+        checkpoint_get_ints(ckpt, b->page, s->params.pages_per_block);
+        b->num_valid = checkpoint_get_int(ckpt);
+        b->rem_lifetime = checkpoint_get_int(ckpt);
+        b->time_of_last_erasure = checkpoint_get_double(ckpt);
+        b->state = checkpoint_get_int(ckpt);
+        b->bsn = checkpoint_get_int(ckpt);
+    }
+}
+
+void ssd_checkpoint(checkpoint_t *ckpt)
+{
+    int i, j, k;
+
+    if (disksim->ssdinfo == NULL) {
+        return;
+    }
+
+    for (i = 0; i < MAXDEVICES; i ++) {
+        ssd_t *s = getssd(i);
+        int gang_pages;
+
+        if (!s) {
+            continue;
+        }
+        gang_pages = s->data_pages_per_elem * s->params.elements_per_gang;
+
+        checkpoint_begin_section(ckpt, "SSD ", i);
+        ssd_checkpoint_geometry(ckpt, s);
+        ioqueue_checkpoint(ckpt, s->queue);
+
+        for (j = 0; j < SSD_NUM_GANG(s); j ++) {
+            gang_metadata *g = &s->gang_meta[j];
+
+            ASSERT(!g->busy && !g->cleaning);
+            checkpoint_put_int(ckpt, g->reqs_waiting);
+            checkpoint_put_double(ckpt, g->oldest);
+            checkpoint_put_ints(ckpt, g->elem_free_pages, s->params.nelements);
+            for (k = 0; k < gang_pages; k ++) {
+                checkpoint_put_int(ckpt, g->pg2elem[k].e);
+            }
+        }
+
+        if (s->params.write_policy == DISKSIM_SSD_WRITE_POLICY_OSR) {
+            for (j = 0; j < s->params.nelements; j ++) {
+                ssd_checkpoint_element(ckpt, s, &s->elements[j].metadata);
+            }
+        }
+        ssd_wbuf_checkpoint(ckpt, s);
+        checkpoint_end_section(ckpt);
+    }
+}
+
+void ssd_restore(checkpoint_t *ckpt, int devno)
+{
+    ssd_t *s;
+    int gang_pages;
+    int j, k;
+
+    if ((devno < 0) || (devno >= MAXDEVICES) || (disksim->ssdinfo == NULL)
+        || ((s = getssd(devno)) == NULL)) {
+        checkpoint_mismatch(ckpt, "ssd number");
+    }
+    ssd_restore_geometry(ckpt, s);
+    ioqueue_restore(ckpt, s->queue);
+
+    gang_pages = s->data_pages_per_elem * s->params.elements_per_gang;
+    for (j = 0; j < SSD_NUM_GANG(s); j ++) {
+        gang_metadata *g = &s->gang_meta[j];
+
+        g->reqs_waiting = checkpoint_get_int(ckpt);
+        g->oldest = checkpoint_get_double(ckpt);
+        checkpoint_get_ints(ckpt, g->elem_free_pages, s->params.nelements);
+        for (k = 0; k < gang_pages; k ++) {
+            g->pg2elem[k].e = checkpoint_get_int(ckpt);
+        }
+    }
+
+    if (s->params.write_policy == DISKSIM_SSD_WRITE_POLICY_OSR) {
+        for (j = 0; j < s->params.nelements; j ++) {
+            ssd_restore_element(ckpt, s, &s->elements[j].metadata);
+        }
+    }
+    ssd_wbuf_restore(ckpt, s);
+}
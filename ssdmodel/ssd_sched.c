@@ -0,0 +1,692 @@
+// DiskSim SSD support
+// 2008 Microsoft Corporation. All Rights Reserved
+
+#include "ssd.h"
+#include "ssd_timing.h"
+#include "ssd_clean.h"
+#include "ssd_sched.h"
+#include "modules/ssdmodel_ssd_param.h"
+
+//////////////////////////////////////////////////////////////////////////////
+//                Flash-aware scheduling of element requests
+//////////////////////////////////////////////////////////////////////////////
+
+/*
+ * the default element scheduler (ssd_activate_elem) waits until an element
+ * is completely idle, takes a batch of requests off its queue, and keeps
+ * the whole element busy until the slowest request in the batch is over.
+ * this scheduler instead tracks each resource on its own:
+ *
+ *  - a parallel unit (a die or plane group, see "Number of parallel
+ *    units") is held by one flash operation at a time. when a unit frees
+ *    up, requests waiting for it are issued right away, reads before
+ *    writes. pages headed for different planes of the unit are combined
+ *    into one multi-plane operation that pays for a single array access.
+ *
+ *  - a channel is the data bus shared by the elements wired to it. page
+ *    transfers are serialized on the channel, so array accesses on one
+ *    element overlap with transfers for another (die interleaving).
+ *
+ * a read holds its unit for the array access and then for its transfers,
+ * which are booked on the channel when the array access is over. a write
+ * books its transfers as soon as it is issued and then programs. cleaning
+ * still takes the whole element; once cleaning is due, new operations are
+ * held back until the element drains.
+ *
+ * reads may suspend a program on their unit, or the cleaning of their
+ * element, within the configured limits (see "Program suspend limit").
+ * the read starts once the suspend latency has passed, and the program
+ * or cleaning picks up where it left off, plus the resume latency, once
+ * the unit (or, for cleaning, every unit) has no more reads to serve.
+ *
+ * the element queue still orders requests; the scheduler takes them off
+ * as they arrive and stages them per element.
+ *
+ * **** CAREFUL ... HIJACKING the tempint1 field of element requests here ****
+ * it holds the parallel unit serving the request.
+ */
+
+static ssd_channel *ssd_sched_channel(ssd_t *s, int elem_num)
+{
+    return &s->channels[elem_num % s->params.nchannels];
+}
+
+static double ssd_sched_page_xfer(ssd_t *s)
+{
+    return ssd_data_transfer_cost(s, s->params.page_size);
+}
+
+void ssd_sched_verify_parameters(ssd_t *s)
+{
+    if (s->params.sched_policy != SSD_SCHED_PARUNIT) {
+        return;
+    }
+
+    // the scheduler places pages on planes itself, which needs the
+    // osr write policy with one active page per plane
+    ASSERT(s->params.write_policy == DISKSIM_SSD_WRITE_POLICY_OSR);
+    ASSERT(s->params.copy_back == SSD_COPY_BACK_ENABLE);
+    ASSERT(s->params.alloc_pool_logic != SSD_ALLOC_POOL_GANG);
+
+    if (s->params.nchannels == 0) {
+        s->params.nchannels = s->params.nelements;
+    }
+    ASSERT(s->params.nchannels <= s->params.nelements);
+}
+
+/*
+ * move everything the element queue will hand out to the staging lists
+ */
+static void ssd_sched_stage(ssd_t *s, int elem_num)
+{
+    ssd_element *elem = &s->elements[elem_num];
+    ssd_element_sched *sc = &elem->sched;
+    ioreq_event *req;
+
+    while ((req = ioqueue_get_next_request(elem->queue)) != NULL) {
+        elem->metadata.reqs_waiting --;
+        req->next = NULL;
+
+        if (req->flags & READ) {
+            if (sc->readstail) {
+                sc->readstail->next = req;
+            } else {
+                sc->reads = req;
+            }
+            sc->readstail = req;
+        } else {
+            if (sc->writestail) {
+                sc->writestail->next = req;
+            } else {
+                sc->writes = req;
+            }
+            sc->writestail = req;
+        }
+    }
+}
+
+static void ssd_sched_unstage(ioreq_event **head, ioreq_event **tail, ioreq_event *prev, ioreq_event *req)
+{
+    if (prev) {
+        prev->next = req->next;
+    } else {
+        *head = req->next;
+    }
+    if (*tail == req) {
+        *tail = prev;
+    }
+    req->next = NULL;
+}
+
+/*
+ * is cleaning due anywhere on this element?
+ */
+static int ssd_sched_cleaning_due(ssd_t *s, int elem_num)
+{
+    int i;
+
+    for (i = 0; i < SSD_PLANES_PER_ELEM(s); i ++) {
+        if (ssd_start_cleaning(i, elem_num, s)) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * the plane holding the current copy of the page a read wants
+ */
+static int ssd_sched_read_plane(ssd_t *s, int elem_num, ioreq_event *req)
+{
+    ssd_element_metadata *metadata = &s->elements[elem_num].metadata;
+    int lpn = ssd_logical_pageno(req->blkno, s);
+    int page = metadata->lba_table[lpn];
+
+    ASSERT(page != -1);
+    return metadata->block_usage[SSD_PAGE_TO_BLOCK(page, s)].plane_num;
+}
+
+/*
+ * pick a plane of the given unit for a write. the new copy must carry a
+ * later version than the old one (see ssd_pick_parunits), and planes
+ * already used by this operation are skipped. among the rest we take the
+ * one with the most free pages. returns -1 if the write can't go here.
+ */
+static int ssd_sched_write_plane(ssd_t *s, int elem_num, int parunit_num, ioreq_event *req, int taken)
+{
+    ssd_element_metadata *metadata = &s->elements[elem_num].metadata;
+    int ppu = SSD_PLANES_PER_PARUNIT(s);
+    int lpn = ssd_logical_pageno(req->blkno, s);
+    int prev_page = metadata->lba_table[lpn];
+    int prev_block;
+    int prev_bsn;
+    int plane_num = -1;
+    int max_free = 0;
+    int i;
+
+    ASSERT(prev_page != -1);
+    prev_block = SSD_PAGE_TO_BLOCK(prev_page, s);
+    prev_bsn = metadata->block_usage[prev_block].bsn;
+
+    if (s->params.alloc_pool_logic == SSD_ALLOC_POOL_PLANE) {
+        // pages never leave their plane
+        plane_num = metadata->block_usage[prev_block].plane_num;
+        if ((metadata->plane_meta[plane_num].parunit_num != parunit_num) ||
+            (taken & (1 << plane_num))) {
+            return -1;
+        }
+        return plane_num;
+    }
+
+    for (i = 0; i < ppu; i ++) {
+        int j = parunit_num * ppu + (metadata->plane_to_write + i) % ppu;
+        plane_metadata *pm = &metadata->plane_meta[j];
+        int active_block = SSD_PAGE_TO_BLOCK(pm->active_page, s);
+        int active_bsn = metadata->block_usage[active_block].bsn;
+        int free_pages;
+
+        ASSERT(pm->parunit_num == parunit_num);
+        if (taken & (1 << j)) {
+            continue;
+        }
+
+        if ((active_bsn > prev_bsn) ||
+            ((active_bsn == prev_bsn) && (pm->active_page > (unsigned int)prev_page))) {
+            free_pages = pm->free_blocks * s->params.pages_per_block +
+                s->params.pages_per_block - (pm->active_page % s->params.pages_per_block);
+
+            if ((plane_num == -1) || (max_free < free_pages)) {
+                max_free = free_pages;
+                plane_num = j;
+            }
+        }
+    }
+
+    if (plane_num != -1) {
+        metadata->plane_to_write = (plane_num + 1) % s->params.planes_per_pkg;
+    }
+
+    return plane_num;
+}
+
+static void ssd_sched_hold_unit(ssd_t *s, int elem_num, int parunit_num, int numreqs, int is_write)
+{
+    ssd_element_sched *sc = &s->elements[elem_num].sched;
+    ssd_parunit_sched *u = &sc->parunit[parunit_num];
+
+    ASSERT(!u->busy);
+    u->busy = 1;
+    u->op.pending = numreqs;
+    u->op.numreqs = numreqs;
+    u->op.is_write = is_write;
+    u->op.suspensions = 0;
+    u->op.start = simtime;
+
+    if (sc->busy_units == 0) {
+        sc->busy_start = simtime;
+    }
+    sc->busy_units ++;
+
+    sc->ops ++;
+    sc->pages += numreqs;
+    if (numreqs > 1) {
+        sc->multiplane_ops ++;
+    }
+    s->elements[elem_num].stat.tot_reqs_issued += numreqs;
+}
+
+static void ssd_sched_release_unit(ssd_t *s, int elem_num, int parunit_num)
+{
+    ssd_element_sched *sc = &s->elements[elem_num].sched;
+
+    ASSERT(sc->parunit[parunit_num].busy);
+    sc->parunit[parunit_num].busy = 0;
+    sc->busy_units --;
+    if (sc->busy_units == 0) {
+        sc->busy_time += simtime - sc->busy_start;
+    }
+}
+
+static void ssd_sched_finish_page(int elem_num, int parunit_num, ioreq_event *req, double when)
+{
+    req->time = when;
+    req->ssd_elem_num = elem_num;
+    req->tempint1 = parunit_num;
+    req->type = DEVICE_ACCESS_COMPLETE;
+    addtointq ((event *)req);
+}
+
+/*
+ * is a staged read waiting for this unit?
+ */
+static int ssd_sched_read_waiting(ssd_t *s, int elem_num, int parunit_num)
+{
+    ssd_element_metadata *metadata = &s->elements[elem_num].metadata;
+    ioreq_event *req;
+
+    for (req = s->elements[elem_num].sched.reads; req != NULL; req = req->next) {
+        int plane_num = ssd_sched_read_plane(s, elem_num, req);
+        if (metadata->plane_meta[plane_num].parunit_num == parunit_num) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * issue a (multi-plane) read on a free unit: one array access for up to
+ * one page per plane, starting no earlier than 'from'. returns the number
+ * of pages issued.
+ */
+static int ssd_sched_issue_reads(ssd_t *s, int elem_num, int parunit_num, double from)
+{
+    ssd_element_sched *sc = &s->elements[elem_num].sched;
+    ssd_parunit_sched *u = &sc->parunit[parunit_num];
+    ssd_element_metadata *metadata = &s->elements[elem_num].metadata;
+    ioreq_event *reqs[SSD_MAX_PLANES_PER_ELEM];
+    ioreq_event *prev = NULL;
+    ioreq_event *req = sc->reads;
+    ioreq_event *tmp;
+    int taken = 0;
+    int n = 0;
+    int i;
+
+    while ((req != NULL) && (n < SSD_PLANES_PER_PARUNIT(s))) {
+        ioreq_event *next = req->next;
+        int plane_num = ssd_sched_read_plane(s, elem_num, req);
+
+        if ((metadata->plane_meta[plane_num].parunit_num == parunit_num) &&
+            !(taken & (1 << plane_num))) {
+            taken |= 1 << plane_num;
+            ssd_sched_unstage(&sc->reads, &sc->readstail, prev, req);
+            reqs[n ++] = req;
+        } else {
+            prev = req;
+        }
+        req = next;
+    }
+
+    if (n == 0) {
+        return 0;
+    }
+
+    if (sc->writes) {
+        sc->reads_ahead += n;
+    }
+
+    ssd_sched_hold_unit(s, elem_num, parunit_num, n, FALSE);
+    for (i = 0; i < n; i ++) {
+        u->op.reqs[i] = reqs[i];
+    }
+
+    // the transfers are booked when the array access is over
+    tmp = (ioreq_event *)getfromextraq();
+    tmp->devno = s->devno;
+    tmp->time = max(from, simtime) + s->params.page_read_latency;
+    tmp->type = SSD_SCHED_ARRAY_DONE;
+    tmp->ssd_elem_num = elem_num;
+    tmp->tempint1 = parunit_num;
+    tmp->busno = -1;
+    tmp->bcount = -1;
+    addtointq ((event *)tmp);
+
+    return n;
+}
+
+/*
+ * issue a (multi-plane) program on a free unit: the pages go over the
+ * channel first and are then programmed together. returns the number of
+ * pages issued.
+ */
+static int ssd_sched_issue_writes(ssd_t *s, int elem_num, int parunit_num)
+{
+    ssd_element_sched *sc = &s->elements[elem_num].sched;
+    ssd_parunit_sched *u = &sc->parunit[parunit_num];
+    ssd_element_metadata *metadata = &s->elements[elem_num].metadata;
+    ssd_channel *ch = ssd_sched_channel(s, elem_num);
+    ioreq_event *reqs[SSD_MAX_PLANES_PER_ELEM];
+    ioreq_event *prev = NULL;
+    ioreq_event *req = sc->writes;
+    double program = 0;
+    double xfer;
+    int taken = 0;
+    int n = 0;
+    int i;
+
+    while ((req != NULL) && (n < SSD_PLANES_PER_PARUNIT(s))) {
+        ioreq_event *next = req->next;
+        int plane_num = ssd_sched_write_plane(s, elem_num, parunit_num, req, taken);
+
+        if (plane_num != -1) {
+            double cost;
+
+            // if this is the last page on the block, allocate a new block
+            if (ssd_last_page_in_block(metadata->plane_meta[plane_num].active_page, s)) {
+                _ssd_alloc_active_block(plane_num, elem_num, s);
+            }
+            metadata->active_page = metadata->plane_meta[plane_num].active_page;
+            cost = _ssd_write_page_osr(s, metadata, ssd_logical_pageno(req->blkno, s));
+            if (program < cost) {
+                program = cost;
+            }
+
+            taken |= 1 << plane_num;
+            ssd_sched_unstage(&sc->writes, &sc->writestail, prev, req);
+            reqs[n ++] = req;
+        } else {
+            prev = req;
+        }
+        req = next;
+    }
+
+    if (n == 0) {
+        return 0;
+    }
+
+    ssd_sched_hold_unit(s, elem_num, parunit_num, n, TRUE);
+
+    xfer = n * ssd_sched_page_xfer(s);
+    ch->free = max(ch->free, simtime) + xfer;
+    ch->busy_time += xfer;
+    u->op.program_start = ch->free;
+    u->op.done = ch->free + program;
+
+    for (i = 0; i < n; i ++) {
+        u->op.reqs[i] = reqs[i];
+        ssd_sched_finish_page(elem_num, parunit_num, reqs[i], u->op.done);
+    }
+
+    return n;
+}
+
+/*
+ * the array access of a read is over; move its pages out over the channel
+ */
+void ssd_sched_array_done(ioreq_event *curr)
+{
+    ssd_t *s = getssd(curr->devno);
+    int elem_num = curr->ssd_elem_num;
+    int parunit_num = curr->tempint1;
+    ssd_parunit_sched *u = &s->elements[elem_num].sched.parunit[parunit_num];
+    ssd_channel *ch = ssd_sched_channel(s, elem_num);
+    double xfer = ssd_sched_page_xfer(s);
+    int i;
+
+    addtoextraq((event *) curr);
+    ASSERT(u->busy && !u->op.is_write && (u->op.pending == u->op.numreqs));
+
+    ch->free = max(ch->free, simtime);
+    for (i = 0; i < u->op.numreqs; i ++) {
+        ch->free += xfer;
+        ch->busy_time += xfer;
+        ssd_sched_finish_page(elem_num, parunit_num, u->op.reqs[i], ch->free);
+    }
+}
+
+/*
+ * suspend the program on a unit so that a waiting read can use the array.
+ * returns the time from which the read may start, or -1 if the program
+ * can't be suspended.
+ */
+static double ssd_sched_suspend_program(ssd_t *s, int elem_num, int parunit_num)
+{
+    ssd_element_sched *sc = &s->elements[elem_num].sched;
+    ssd_parunit_sched *u = &sc->parunit[parunit_num];
+    double from = simtime + s->params.program_suspend_latency;
+    int i;
+
+    // only a program that has left the channel, and only one at a time
+    if (!u->busy || !u->op.is_write || u->suspended ||
+        (simtime < u->op.program_start) ||
+        (u->op.suspensions >= s->params.program_suspend_limit) ||
+        (u->op.done <= from) ||
+        !ssd_sched_read_waiting(s, elem_num, parunit_num)) {
+        return -1;
+    }
+
+    for (i = 0; i < u->op.numreqs; i ++) {
+        removefromintq((event *)u->op.reqs[i]);
+    }
+    u->op.suspensions ++;
+    u->susp = u->op;
+    u->remaining = u->op.done - from;
+    u->suspended = 1;
+    sc->program_suspends ++;
+
+    ssd_sched_release_unit(s, elem_num, parunit_num);
+    return from;
+}
+
+/*
+ * the read that suspended a program is over; pick the program up again
+ */
+static void ssd_sched_resume_program(ssd_t *s, int elem_num, int parunit_num)
+{
+    ssd_parunit_sched *u = &s->elements[elem_num].sched.parunit[parunit_num];
+    int i;
+
+    ASSERT(u->busy && u->suspended);
+    u->op = u->susp;
+    u->suspended = 0;
+    u->op.program_start = simtime;
+    u->op.done = simtime + s->params.resume_latency + u->remaining;
+
+    for (i = 0; i < u->op.numreqs; i ++) {
+        ssd_sched_finish_page(elem_num, parunit_num, u->op.reqs[i], u->op.done);
+    }
+}
+
+/*
+ * suspend the cleaning of an element so that waiting reads can be
+ * served. returns TRUE if it was suspended.
+ */
+static int ssd_sched_suspend_cleaning(ssd_t *s, int elem_num)
+{
+    ssd_element_sched *sc = &s->elements[elem_num].sched;
+    double from = simtime + s->params.erase_suspend_latency;
+
+    if ((sc->cleaning == NULL) || (sc->reads == NULL) ||
+        (sc->clean_suspensions >= s->params.erase_suspend_limit) ||
+        (sc->cleaning->time <= from)) {
+        return FALSE;
+    }
+
+    removefromintq((event *)sc->cleaning);
+    sc->clean_remaining = sc->cleaning->time - from;
+    sc->clean_suspended = 1;
+    sc->clean_suspensions ++;
+    sc->reads_from = from;
+    sc->erase_suspends ++;
+
+    return TRUE;
+}
+
+static void ssd_sched_resume_cleaning(ssd_t *s, int elem_num)
+{
+    ssd_element_sched *sc = &s->elements[elem_num].sched;
+
+    ASSERT(sc->clean_suspended && (sc->busy_units == 0));
+    sc->clean_suspended = 0;
+    sc->cleaning->time = simtime + s->params.resume_latency + sc->clean_remaining;
+    addtointq ((event *)sc->cleaning);
+}
+
+/*
+ * the element is being cleaned; serve reads if the cleaning is (or can
+ * be) suspended and resume it once they are all done.
+ */
+static void ssd_sched_activate_cleaning_elem(ssd_t *s, int elem_num)
+{
+    ssd_element_sched *sc = &s->elements[elem_num].sched;
+    int i;
+
+    if (!sc->clean_suspended && !ssd_sched_suspend_cleaning(s, elem_num)) {
+        return;
+    }
+
+    for (i = 0; i < SSD_PARUNITS_PER_ELEM(s); i ++) {
+        if (!sc->parunit[i].busy) {
+            ssd_sched_issue_reads(s, elem_num, i, sc->reads_from);
+        }
+    }
+
+    if (sc->busy_units == 0) {
+        ssd_sched_resume_cleaning(s, elem_num);
+    }
+}
+
+/*
+ * a page is done; the unit is released with the last page of its operation
+ */
+void ssd_sched_access_done(ssd_t *s, ioreq_event *curr)
+{
+    int elem_num = curr->ssd_elem_num;
+    int parunit_num = curr->tempint1;
+    ssd_parunit_sched *u = &s->elements[elem_num].sched.parunit[parunit_num];
+
+    ASSERT(u->busy && (u->op.pending > 0));
+    stat_update (&s->stat.acctimestats, simtime - u->op.start);
+
+    u->op.pending --;
+    if (u->op.pending == 0) {
+        if (u->suspended) {
+            ssd_sched_resume_program(s, elem_num, parunit_num);
+        } else {
+            ssd_sched_release_unit(s, elem_num, parunit_num);
+        }
+    }
+}
+
+void ssd_sched_activate_elem(ssd_t *s, int elem_num)
+{
+    ssd_element *elem = &s->elements[elem_num];
+    ssd_element_sched *sc = &elem->sched;
+    int i;
+
+    ssd_sched_stage(s, elem_num);
+
+    // cleaning holds the whole element
+    if (elem->media_busy == TRUE) {
+        ssd_sched_activate_cleaning_elem(s, elem_num);
+        return;
+    }
+
+    if (sc->busy_units == 0) {
+        // same rules as the batch scheduler: clean in the background
+        // whenever the element is idle, or in the foreground when
+        // requests are waiting
+        if (s->params.cleaning_in_background || sc->reads || sc->writes) {
+            if (ssd_invoke_element_cleaning(elem_num, s)) {
+                ssd_sched_activate_cleaning_elem(s, elem_num);
+                return;
+            }
+        }
+
+        // nothing to do, so see if we can clean while the device is idle
+        if (!sc->reads && !sc->writes) {
+            ssd_idle_clean_element(s, elem_num);
+            return;
+        }
+    } else if (ssd_sched_cleaning_due(s, elem_num)) {
+        // let the element drain so that the cleaner can have it
+        return;
+    }
+
+    for (i = 0; i < SSD_PARUNITS_PER_ELEM(s); i ++) {
+        if (sc->parunit[i].busy) {
+            double from = ssd_sched_suspend_program(s, elem_num, i);
+            if (from >= 0) {
+                ssd_sched_issue_reads(s, elem_num, i, from);
+            }
+            continue;
+        }
+        if (!ssd_sched_issue_reads(s, elem_num, i, simtime)) {
+            ssd_sched_issue_writes(s, elem_num, i);
+        }
+    }
+}
+
+void ssd_sched_resetstats(ssd_t *s)
+{
+    int i;
+
+    s->stat.statstart = simtime;
+
+    for (i = 0; i < s->params.nelements; i ++) {
+        ssd_element_sched *sc = &s->elements[i].sched;
+
+        sc->busy_start = simtime;
+        sc->busy_time = 0;
+        sc->ops = 0;
+        sc->multiplane_ops = 0;
+        sc->pages = 0;
+        sc->reads_ahead = 0;
+        sc->program_suspends = 0;
+        sc->erase_suspends = 0;
+    }
+
+    for (i = 0; i < SSD_MAX_ELEMENTS; i ++) {
+        s->channels[i].busy_time = 0;
+    }
+}
+
+void ssd_sched_printstats(ssd_t *s, char *prefix)
+{
+    double elapsed = simtime - s->stat.statstart;
+    double chan_busy = 0;
+    double elem_busy = 0;
+    int ops = 0;
+    int multiplane_ops = 0;
+    int pages = 0;
+    int reads_ahead = 0;
+    int program_suspends = 0;
+    int erase_suspends = 0;
+    int i;
+
+    if (s->params.sched_policy != SSD_SCHED_PARUNIT) {
+        return;
+    }
+
+    for (i = 0; i < s->params.nchannels; i ++) {
+        double busy = s->channels[i].busy_time;
+
+        // transfers can be booked past the end of the run
+        busy = min(busy, elapsed);
+        chan_busy += busy;
+        fprintf(outputfile, "%sChannel #%d utilization: \t%f\n",
+            prefix, i, (elapsed > 0) ? busy / elapsed : 0.0);
+    }
+
+    for (i = 0; i < s->params.nelements; i ++) {
+        ssd_element_sched *sc = &s->elements[i].sched;
+        double busy = sc->busy_time;
+
+        if (sc->busy_units > 0) {
+            busy += simtime - sc->busy_start;
+        }
+        elem_busy += busy;
+        ops += sc->ops;
+        multiplane_ops += sc->multiplane_ops;
+        pages += sc->pages;
+        reads_ahead += sc->reads_ahead;
+        program_suspends += sc->program_suspends;
+        erase_suspends += sc->erase_suspends;
+
+        fprintf(outputfile, "%selem #%d utilization: \t%f\n",
+            prefix, i, (elapsed > 0) ? busy / elapsed : 0.0);
+    }
+
+    fprintf(outputfile, "%sAverage channel utilization: \t%f\n",
+        prefix, (elapsed > 0) ? chan_busy / (elapsed * s->params.nchannels) : 0.0);
+    fprintf(outputfile, "%sAverage element utilization: \t%f\n",
+        prefix, (elapsed > 0) ? elem_busy / (elapsed * s->params.nelements) : 0.0);
+    fprintf(outputfile, "%sFlash operations: \t%d\n", prefix, ops);
+    fprintf(outputfile, "%sMulti-plane operations: \t%d\n", prefix, multiplane_ops);
+    fprintf(outputfile, "%sPages per operation: \t%f\n",
+        prefix, (ops > 0) ? (double) pages / ops : 0.0);
+    fprintf(outputfile, "%sReads issued ahead of writes: \t%d\n", prefix, reads_ahead);
+    fprintf(outputfile, "%sPrograms suspended for reads: \t%d\n", prefix, program_suspends);
+    fprintf(outputfile, "%sCleanings suspended for reads: \t%d\n", prefix, erase_suspends);
+}
@@ -0,0 +1,17 @@
+// DiskSim SSD support
+// 2008 Microsoft Corporation. All Rights Reserved
+
+#ifndef _DISKSIM_SSD_SCHED_H
+#define _DISKSIM_SSD_SCHED_H
+
+#include "ssd.h"
+#include "modules/ssdmodel_ssd_param.h"
+
+void ssd_sched_verify_parameters(ssd_t *s);
+void ssd_sched_activate_elem(ssd_t *s, int elem_num);
+void ssd_sched_array_done(ioreq_event *curr);
+void ssd_sched_access_done(ssd_t *s, ioreq_event *curr);
+void ssd_sched_resetstats(ssd_t *s);
+void ssd_sched_printstats(ssd_t *s, char *prefix);
+
+#endif
@@ -0,0 +1,555 @@
+// DiskSim SSD support
+// �2008 Microsoft Corporation. All Rights Reserved
+
+#include "ssd.h"
+#include "ssd_wbuf.h"
+#include "modules/ssdmodel_ssd_param.h"
+
+//////////////////////////////////////////////////////////////////////////////
+//                      DRAM write buffer of the device
+//////////////////////////////////////////////////////////////////////////////
+
+/*
+ * writes are acknowledged once they are in the buffer and written to
+ * flash later, a page at a time, oldest first. a page written again
+ * before it is flushed costs no extra program. reads are served from
+ * the buffer for the pages it holds and from flash for the rest.
+ *
+ * the buffer is flushed while it is fuller than the flush watermark,
+ * while writes are waiting for space, and, once the device has been
+ * idle for the idle flush delay, until it is empty. at most one page
+ * per parallel unit is being flushed at a time.
+ *
+ * a volatile buffer loses its contents on power failure, so writes
+ * with the FUA flag bypass it and complete only when they are on
+ * flash. a capacitor-backed buffer takes them like any other write.
+ *
+ * flushes are element requests without a parent (tempptr2 is NULL).
+ */
+
+static int ssd_wbuf_pageno(ssd_t *s, int blkno)
+{
+    return blkno / s->params.page_size;
+}
+
+static int ssd_wbuf_lookup(ssd_t *s, int pageno)
+{
+    ssd_wbuf *wb = &s->wbuf;
+    int i;
+
+    for (i = wb->hash[pageno & wb->hashmask]; i != -1; i = wb->pages[i].hnext) {
+        if (wb->pages[i].pageno == pageno) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+static void ssd_wbuf_append(ssd_t *s, int i)
+{
+    ssd_wbuf *wb = &s->wbuf;
+
+    wb->pages[i].prev = wb->newest;
+    wb->pages[i].next = -1;
+    if (wb->newest != -1) {
+        wb->pages[wb->newest].next = i;
+    } else {
+        wb->oldest = i;
+    }
+    wb->newest = i;
+}
+
+static void ssd_wbuf_unlink(ssd_t *s, int i)
+{
+    ssd_wbuf *wb = &s->wbuf;
+    ssd_wbuf_page *p = &wb->pages[i];
+
+    if (p->prev != -1) {
+        wb->pages[p->prev].next = p->next;
+    } else {
+        wb->oldest = p->next;
+    }
+    if (p->next != -1) {
+        wb->pages[p->next].prev = p->prev;
+    } else {
+        wb->newest = p->prev;
+    }
+    p->prev = p->next = -1;
+}
+
+static int ssd_wbuf_alloc(ssd_t *s, int pageno)
+{
+    ssd_wbuf *wb = &s->wbuf;
+    int h = pageno & wb->hashmask;
+    int i = wb->freelist;
+
+    ASSERT(i != -1);
+    wb->freelist = wb->pages[i].next;
+
+    wb->pages[i].pageno = pageno;
+    wb->pages[i].flushing = 0;
+    wb->pages[i].redirty = 0;
+    wb->pages[i].hnext = wb->hash[h];
+    wb->hash[h] = i;
+
+    wb->used ++;
+    if (wb->max_used < wb->used) {
+        wb->max_used = wb->used;
+    }
+
+    return i;
+}
+
+static void ssd_wbuf_release(ssd_t *s, int i)
+{
+    ssd_wbuf *wb = &s->wbuf;
+    int *link = &wb->hash[wb->pages[i].pageno & wb->hashmask];
+
+    while (*link != i) {
+        link = &wb->pages[*link].hnext;
+    }
+    *link = wb->pages[i].hnext;
+
+    wb->pages[i].pageno = -1;
+    wb->pages[i].next = wb->freelist;
+    wb->freelist = i;
+    wb->used --;
+}
+
+static void ssd_wbuf_reset(ssd_t *s)
+{
+    ssd_wbuf *wb = &s->wbuf;
+    int i;
+
+    for (i = 0; i <= wb->hashmask; i ++) {
+        wb->hash[i] = -1;
+    }
+    for (i = 0; i < s->params.wbuf_pages; i ++) {
+        wb->pages[i].pageno = -1;
+        wb->pages[i].prev = -1;
+        wb->pages[i].next = (i + 1 < s->params.wbuf_pages) ? i + 1 : -1;
+    }
+
+    wb->freelist = 0;
+    wb->oldest = wb->newest = -1;
+    wb->used = 0;
+    wb->flushing = 0;
+    wb->draining = 0;
+    wb->stalled = wb->stalledtail = NULL;
+    wb->idledetect = NULL;
+}
+
+void ssd_wbuf_verify_parameters(ssd_t *s)
+{
+    if (s->params.wbuf_pages == 0) {
+        return;
+    }
+
+    // flushes are issued to the elements like host requests
+    ASSERT(s->params.alloc_pool_logic != SSD_ALLOC_POOL_GANG);
+}
+
+void ssd_wbuf_init(ssd_t *s)
+{
+    ssd_wbuf *wb = &s->wbuf;
+    int hsize = 1;
+
+    if (wb->pages) {
+        free(wb->pages);
+        free(wb->hash);
+    }
+    memset(wb, 0, sizeof(ssd_wbuf));
+
+    if (s->params.wbuf_pages == 0) {
+        return;
+    }
+
+    while (hsize < 2 * s->params.wbuf_pages) {
+        hsize <<= 1;
+    }
+
+    wb->pages = (ssd_wbuf_page *) malloc(s->params.wbuf_pages * sizeof(ssd_wbuf_page));
+    wb->hash = (int *) malloc(hsize * sizeof(int));
+    wb->hashmask = hsize - 1;
+    ssd_wbuf_reset(s);
+}
+
+/*
+ * number of pages of this write that are not in the buffer yet
+ */
+static int ssd_wbuf_pages_needed(ssd_t *s, ioreq_event *curr)
+{
+    int first = ssd_wbuf_pageno(s, curr->blkno);
+    int last = ssd_wbuf_pageno(s, curr->blkno + curr->bcount - 1);
+    int needed = 0;
+    int p;
+
+    for (p = first; p <= last; p ++) {
+        if (ssd_wbuf_lookup(s, p) == -1) {
+            needed ++;
+        }
+    }
+
+    return needed;
+}
+
+static int ssd_wbuf_fits(ssd_t *s, ioreq_event *curr)
+{
+    return (ssd_wbuf_pages_needed(s, curr) <= s->params.wbuf_pages - s->wbuf.used);
+}
+
+static void ssd_wbuf_insert(ssd_t *s, ioreq_event *curr)
+{
+    ssd_wbuf *wb = &s->wbuf;
+    int first = ssd_wbuf_pageno(s, curr->blkno);
+    int last = ssd_wbuf_pageno(s, curr->blkno + curr->bcount - 1);
+    int p;
+
+    for (p = first; p <= last; p ++) {
+        int i = ssd_wbuf_lookup(s, p);
+
+        if (i == -1) {
+            i = ssd_wbuf_alloc(s, p);
+            ssd_wbuf_append(s, i);
+        } else if (wb->pages[i].flushing) {
+            // the flash copy will be stale, so flush it again afterwards
+            if (wb->pages[i].redirty) {
+                wb->absorbed ++;
+            }
+            wb->pages[i].redirty = 1;
+        } else {
+            wb->absorbed ++;
+            ssd_wbuf_unlink(s, i);
+            ssd_wbuf_append(s, i);
+        }
+    }
+
+    wb->writes ++;
+    wb->pages_written += last - first + 1;
+}
+
+/*
+ * a write going straight to flash supersedes what the buffer holds
+ */
+static void ssd_wbuf_invalidate(ssd_t *s, ioreq_event *curr)
+{
+    ssd_wbuf *wb = &s->wbuf;
+    int first = ssd_wbuf_pageno(s, curr->blkno);
+    int last = ssd_wbuf_pageno(s, curr->blkno + curr->bcount - 1);
+    int p;
+
+    for (p = first; p <= last; p ++) {
+        int i = ssd_wbuf_lookup(s, p);
+
+        if (i == -1) {
+            continue;
+        }
+        if (wb->pages[i].flushing) {
+            wb->pages[i].redirty = 0;
+        } else {
+            ssd_wbuf_unlink(s, i);
+            ssd_wbuf_release(s, i);
+        }
+    }
+}
+
+static void ssd_wbuf_flush(ssd_t *s)
+{
+    ssd_wbuf *wb = &s->wbuf;
+    int depth = s->params.nelements * SSD_PARUNITS_PER_ELEM(s);
+    double limit = s->params.wbuf_pages * (s->params.wbuf_watermark / 100.0);
+
+    while ((wb->oldest != -1) && (wb->flushing < depth) &&
+           ((wb->draining) || (wb->stalled) || (wb->used > limit))) {
+        int i = wb->oldest;
+        ioreq_event *tmp;
+
+        ssd_wbuf_unlink(s, i);
+        wb->pages[i].flushing = 1;
+        wb->flushing ++;
+
+        tmp = (ioreq_event *)getfromextraq();
+        tmp->devno = s->devno;
+        tmp->busno = 0;
+        tmp->flags = WRITE;
+        tmp->blkno = wb->pages[i].pageno * s->params.page_size;
+        tmp->bcount = s->params.page_size;
+        tmp->tempptr2 = NULL;
+        ssd_element_request(s, tmp);
+    }
+}
+
+/*
+ * takes a host write. returns 1 if the buffer will complete it,
+ * 0 if it has to go to flash.
+ */
+int ssd_wbuf_write(ssd_t *s, ioreq_event *curr)
+{
+    ssd_wbuf *wb = &s->wbuf;
+
+    if ((curr->flags & FUA) && (!s->params.wbuf_protected)) {
+        wb->fua_writes ++;
+        ssd_wbuf_invalidate(s, curr);
+        return 0;
+    }
+
+    // too big to ever fit
+    if (curr->bcount > s->params.wbuf_pages * s->params.page_size) {
+        ssd_wbuf_invalidate(s, curr);
+        return 0;
+    }
+
+    if ((wb->stalled) || (!ssd_wbuf_fits(s, curr))) {
+        // wait for the flushes to make room
+        curr->next = NULL;
+        curr->start_time = simtime;
+        if (wb->stalledtail) {
+            wb->stalledtail->next = curr;
+        } else {
+            wb->stalled = curr;
+        }
+        wb->stalledtail = curr;
+        wb->stalls ++;
+    } else {
+        ssd_wbuf_insert(s, curr);
+        ssd_wbuf_complete(s, curr, curr->bcount);
+    }
+
+    ssd_wbuf_flush(s);
+    return 1;
+}
+
+int ssd_wbuf_read_hit(ssd_t *s, int blkno)
+{
+    if (ssd_wbuf_lookup(s, ssd_wbuf_pageno(s, blkno)) != -1) {
+        s->wbuf.read_hits ++;
+        return 1;
+    }
+
+    s->wbuf.read_misses ++;
+    return 0;
+}
+
+/*
+ * 'bcount' sectors of the host request are done once they have been
+ * moved to (from) the buffer
+ */
+void ssd_wbuf_complete(ssd_t *s, ioreq_event *parent, int bcount)
+{
+    ioreq_event *tmp = (ioreq_event *)getfromextraq();
+
+    tmp->devno = parent->devno;
+    tmp->busno = parent->busno;
+    tmp->flags = parent->flags;
+    tmp->blkno = parent->blkno;
+    tmp->bcount = bcount;
+    tmp->tempptr2 = parent;
+    tmp->type = SSD_WBUF_DONE;
+    tmp->time = simtime + s->params.wbuf_latency;
+    addtointq((event *)tmp);
+}
+
+void ssd_wbuf_done(ioreq_event *curr)
+{
+    ssd_complete_parent(curr, getssd(curr->devno));
+    addtoextraq((event *)curr);
+}
+
+void ssd_wbuf_flush_done(ssd_t *s, ioreq_event *curr)
+{
+    ssd_wbuf *wb = &s->wbuf;
+    int i = ssd_wbuf_lookup(s, ssd_wbuf_pageno(s, curr->blkno));
+
+    ASSERT((i != -1) && (wb->pages[i].flushing));
+    wb->pages[i].flushing = 0;
+    wb->flushing --;
+    wb->flushed ++;
+
+    if (wb->pages[i].redirty) {
+        wb->pages[i].redirty = 0;
+        ssd_wbuf_append(s, i);
+    } else {
+        ssd_wbuf_release(s, i);
+    }
+
+    while ((wb->stalled) && (ssd_wbuf_fits(s, wb->stalled))) {
+        ioreq_event *req = wb->stalled;
+
+        wb->stalled = req->next;
+        if (wb->stalled == NULL) {
+            wb->stalledtail = NULL;
+        }
+        wb->stall_time += simtime - req->start_time;
+
+        ssd_wbuf_insert(s, req);
+        ssd_wbuf_complete(s, req, req->bcount);
+    }
+
+    ssd_wbuf_flush(s);
+}
+
+/*
+ * idle flush. the device goes idle when its last request completes
+ * and busy again when the next one arrives.
+ */
+static void ssd_wbuf_idledetected(timer_event *timer)
+{
+    ssd_t *s = (ssd_t *)timer->ptr;
+
+    s->wbuf.idledetect = NULL;
+    s->wbuf.draining = 1;
+    addtoextraq((event *)timer);
+    ssd_wbuf_flush(s);
+}
+
+void ssd_wbuf_setcallbacks(void)
+{
+    disksim->timerfunc_ssd_wbuf = ssd_wbuf_idledetected;
+}
+
+void ssd_wbuf_idle(ssd_t *s)
+{
+    ssd_wbuf *wb = &s->wbuf;
+
+    if ((s->params.wbuf_idle_delay <= 0) || (wb->oldest == -1)) {
+        return;
+    }
+
+    if (wb->idledetect) {
+        if (!removefromintq((event *)wb->idledetect)) {
+            fprintf(stderr, "ssd write buffer idle timer not on intq\n");
+            exit(1);
+        }
+    } else {
+        wb->idledetect = (timer_event *)getfromextraq();
+        wb->idledetect->type = TIMER_EXPIRED;
+        wb->idledetect->func = &disksim->timerfunc_ssd_wbuf;
+        wb->idledetect->ptr = s;
+    }
+    wb->idledetect->time = simtime + s->params.wbuf_idle_delay;
+    addtointq((event *)wb->idledetect);
+}
+
+void ssd_wbuf_arrive(ssd_t *s)
+{
+    ssd_wbuf *wb = &s->wbuf;
+
+    wb->draining = 0;
+    if (wb->idledetect) {
+        if (!removefromintq((event *)wb->idledetect)) {
+            fprintf(stderr, "ssd write buffer idle timer not on intq\n");
+            exit(1);
+        }
+        addtoextraq((event *)wb->idledetect);
+        wb->idledetect = NULL;
+    }
+}
+
+void ssd_wbuf_resetstats(ssd_t *s)
+{
+    ssd_wbuf *wb = &s->wbuf;
+
+    wb->writes = 0;
+    wb->pages_written = 0;
+    wb->absorbed = 0;
+    wb->read_hits = 0;
+    wb->read_misses = 0;
+    wb->fua_writes = 0;
+    wb->stalls = 0;
+    wb->stall_time = 0;
+    wb->flushed = 0;
+    wb->max_used = wb->used;
+}
+
+void ssd_wbuf_printstats(int *set, int setsize, char *prefix)
+{
+    int enabled = 0;
+    int writes = 0;
+    int pages_written = 0;
+    int absorbed = 0;
+    int read_hits = 0;
+    int read_misses = 0;
+    int fua_writes = 0;
+    int stalls = 0;
+    double stall_time = 0;
+    int flushed = 0;
+    int max_used = 0;
+    int i;
+
+    for (i = 0; i < setsize; i ++) {
+        ssd_t *s = getssd(set[i]);
+        ssd_wbuf *wb = &s->wbuf;
+
+        if (s->params.wbuf_pages > 0) {
+            enabled = 1;
+        }
+        writes += wb->writes;
+        pages_written += wb->pages_written;
+        absorbed += wb->absorbed;
+        read_hits += wb->read_hits;
+        read_misses += wb->read_misses;
+        fua_writes += wb->fua_writes;
+        stalls += wb->stalls;
+        stall_time += wb->stall_time;
+        flushed += wb->flushed;
+        if (max_used < wb->max_used) {
+            max_used = wb->max_used;
+        }
+    }
+
+    if (!enabled) {
+        return;
+    }
+
+    fprintf(outputfile, "%sWrite buffer writes: %d\n", prefix, writes);
+    fprintf(outputfile, "%sWrite buffer pages written: %d\n", prefix, pages_written);
+    fprintf(outputfile, "%sWrite buffer pages absorbed: %d\n", prefix, absorbed);
+    fprintf(outputfile, "%sWrite buffer pages flushed: %d\n", prefix, flushed);
+    fprintf(outputfile, "%sWrite buffer read hit pages: %d\n", prefix, read_hits);
+    fprintf(outputfile, "%sWrite buffer read miss pages: %d\n", prefix, read_misses);
+    fprintf(outputfile, "%sWrite buffer FUA bypasses: %d\n", prefix, fua_writes);
+    fprintf(outputfile, "%sWrite buffer full stalls: %d\n", prefix, stalls);
+    fprintf(outputfile, "%sWrite buffer stall time: %f\n", prefix, stall_time);
+    fprintf(outputfile, "%sWrite buffer maximum pages used: %d\n", prefix, max_used);
+}
+
+/*
+ * checkpoints are taken with nothing in flight, so the buffer only
+ * holds dirty pages. they are saved oldest first.
+ */
+void ssd_wbuf_checkpoint(checkpoint_t *ckpt, ssd_t *s)
+{
+    ssd_wbuf *wb = &s->wbuf;
+    int i;
+
+    ASSERT((wb->flushing == 0) && (wb->stalled == NULL));
+
+    checkpoint_put_int(ckpt, wb->used);
+    for (i = wb->oldest; i != -1; i = wb->pages[i].next) {
+        checkpoint_put_int(ckpt, wb->pages[i].pageno);
+    }
+}
+
+void ssd_wbuf_restore(checkpoint_t *ckpt, ssd_t *s)
+{
+    int used = checkpoint_get_int(ckpt);
+    int i;
+
+    if (used > s->params.wbuf_pages) {
+        checkpoint_mismatch(ckpt, "write buffer contents");
+    }
+
+    if (s->params.wbuf_pages > 0) {
+        ssd_wbuf_reset(s);
+    }
+    for (i = 0; i < used; i ++) {
+        int pageno = checkpoint_get_int(ckpt);
+        ssd_wbuf_append(s, ssd_wbuf_alloc(s, pageno));
+    }
+
+    /* restart the idle flush for the restored dirty pages */
+    if (used > 0) {
+        ssd_wbuf_idle(s);
+    }
+}
@@ -0,0 +1,26 @@
+// DiskSim SSD support
+// 2008 Microsoft Corporation. All Rights Reserved
+
+#ifndef _DISKSIM_SSD_WBUF_H
+#define _DISKSIM_SSD_WBUF_H
+
+#include "ssd.h"
+#include "disksim_checkpoint.h"
+#include "modules/ssdmodel_ssd_param.h"
+
+void ssd_wbuf_verify_parameters(ssd_t *s);
+void ssd_wbuf_init(ssd_t *s);
+void ssd_wbuf_setcallbacks(void);
+int  ssd_wbuf_write(ssd_t *s, ioreq_event *curr);
+int  ssd_wbuf_read_hit(ssd_t *s, int blkno);
+void ssd_wbuf_complete(ssd_t *s, ioreq_event *parent, int bcount);
+void ssd_wbuf_done(ioreq_event *curr);
+void ssd_wbuf_flush_done(ssd_t *s, ioreq_event *curr);
+void ssd_wbuf_arrive(ssd_t *s);
+void ssd_wbuf_idle(ssd_t *s);
+void ssd_wbuf_resetstats(ssd_t *s);
+void ssd_wbuf_printstats(int *set, int setsize, char *prefix);
+void ssd_wbuf_checkpoint(checkpoint_t *ckpt, ssd_t *s);
+void ssd_wbuf_restore(checkpoint_t *ckpt, ssd_t *s);
+
+#endif